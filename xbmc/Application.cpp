@@ -74,6 +74,7 @@
 #include "cores/DllLoader/DllLoaderContainer.h"
 #include "GUIUserMessages.h"
 #include "filesystem/DirectoryCache.h"
+#include "filesystem/HttpCache.h"
 #include "filesystem/StackDirectory.h"
 #include "filesystem/SpecialProtocol.h"
 #include "filesystem/DllLibCurl.h"
@@ -3543,6 +3544,7 @@ void CApplication::Stop(int exitCode)
 #endif
 
     CLog::Log(LOGNOTICE, "clean cached files!");
+    CHttpCache::Get().Flush();
 #ifdef HAS_FILESYSTEM_RAR
     g_RarManager.ClearCache(true);
 #endif
@@ -64,6 +64,7 @@
 #include "music/dialogs/GUIDialogMusicInfo.h"
 #include "storage/MediaManager.h"
 #include "utils/TimeUtils.h"
+#include "utils/Crc32.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 
@@ -106,6 +107,11 @@ CGUIInfoManager::CGUIInfoManager(void) :
   m_frameCounter = 0;
   m_lastFPSTime = 0;
   m_updateTime = 1;
+  for (unsigned int i = 0; i < SIGNAL_MAX; i++)
+    m_signals[i] = m_updateTime;
+  m_boolEvaluations = 0;
+  m_signalPlaying = false;
+  m_signalMinute = 0;
   ResetLibraryBools();
 }
 
@@ -1943,20 +1949,26 @@ unsigned int CGUIInfoManager::Register(const CStdString &expression, int context
   if (condition.IsEmpty())
     return 0;
 
+  Crc32 crc;
+  crc.ComputeFromLowerCase(condition);
+  crc.Compute((const char *)&context, sizeof(context));
+
   CSingleLock lock(m_critInfo);
   // do we have the boolean expression already registered?
   InfoBool test(condition, context);
-  for (unsigned int i = 0; i < m_bools.size(); ++i)
+  for (multimap<uint32_t, unsigned int>::const_iterator i = m_boolsLookup.lower_bound(crc); i != m_boolsLookup.end() && i->first == crc; ++i)
   {
-    if (*m_bools[i] == test)
-      return i+1;
+    if (*m_bools[i->second - 1] == test)
+      return i->second;
   }
 
+  // note: expressions register their operands as they're parsed
   if (condition.find_first_of("|+[]!") != condition.npos)
     m_bools.push_back(new InfoExpression(condition, context));
   else
     m_bools.push_back(new InfoSingle(condition, context));
 
+  m_boolsLookup.insert(make_pair((uint32_t)crc, (unsigned int)m_bools.size()));
   return m_bools.size();
 }
 
@@ -1990,10 +2002,128 @@ bool CGUIInfoManager::EvaluateBool(const CStdString &expression, int contextWind
 bool CGUIInfoManager::GetBoolValue(unsigned int expression, const CGUIListItem *item)
 {
   if (expression && --expression < m_bools.size())
-    return m_bools[expression]->Get(m_updateTime, item);
+  {
+    InfoBool *info = m_bools[expression];
+    if (!item && !info->IsDirty(m_signals))
+      return info->GetValue();
+    m_boolEvaluations++;
+    return info->Get(m_updateTime, item);
+  }
   return false;
 }
 
+unsigned int CGUIInfoManager::GetBoolDependencies(unsigned int expression) const
+{
+  if (expression && --expression < m_bools.size())
+    return m_bools[expression]->GetDependencies();
+  return 1 << SIGNAL_FRAME;
+}
+
+unsigned int CGUIInfoManager::GetConditionDependencies(int condition) const
+{
+  condition = abs(condition);
+
+  if (condition >= MULTI_INFO_START && condition <= MULTI_INFO_END)
+  {
+    switch (abs(m_multiInfo[condition - MULTI_INFO_START].m_info))
+    {
+    case SKIN_BOOL:
+    case SKIN_STRING:
+      return 1 << SIGNAL_SKIN;
+    case WINDOW_NEXT:
+    case WINDOW_PREVIOUS:
+    case WINDOW_IS_VISIBLE:
+    case WINDOW_IS_TOPMOST:
+    case WINDOW_IS_ACTIVE:
+      return 1 << SIGNAL_WINDOW;
+    case SYSTEM_TIME:
+    case SYSTEM_DATE:
+      return 1 << SIGNAL_TIME;
+    case CONTAINER_SCROLL_PREVIOUS:
+    case CONTAINER_MOVE_PREVIOUS:
+    case CONTAINER_MOVE_NEXT:
+    case CONTAINER_SCROLL_NEXT:
+      return 1 << SIGNAL_CONTAINER_MOVES;
+    case SYSTEM_HAS_CORE_ID:
+      return 0;
+    default:
+      return 1 << SIGNAL_FRAME;
+    }
+  }
+
+  switch (condition)
+  {
+  case SYSTEM_ALWAYS_TRUE:
+  case SYSTEM_ALWAYS_FALSE:
+  case SYSTEM_ETHERNET_LINK_ACTIVE:
+  case SYSTEM_PLATFORM_LINUX:
+  case SYSTEM_PLATFORM_WINDOWS:
+  case SYSTEM_PLATFORM_DARWIN:
+  case SYSTEM_PLATFORM_DARWIN_OSX:
+  case SYSTEM_PLATFORM_DARWIN_IOS:
+  case SYSTEM_PLATFORM_DARWIN_ATV2:
+  case SYSTEM_HAS_PVR:
+    return 0;
+  case WINDOW_IS_MEDIA:
+    return 1 << SIGNAL_WINDOW;
+  case PLAYER_SHOWINFO:
+  case PLAYER_SHOWCODEC:
+  // the following are only true while playing (see GetBool)
+  case PLAYER_HAS_MEDIA:
+  case PLAYER_HAS_AUDIO:
+  case PLAYER_HAS_VIDEO:
+  case PLAYER_PLAYING:
+  case PLAYER_PAUSED:
+  case PLAYER_REWINDING:
+  case PLAYER_FORWARDING:
+  case PLAYER_REWINDING_2x:
+  case PLAYER_REWINDING_4x:
+  case PLAYER_REWINDING_8x:
+  case PLAYER_REWINDING_16x:
+  case PLAYER_REWINDING_32x:
+  case PLAYER_FORWARDING_2x:
+  case PLAYER_FORWARDING_4x:
+  case PLAYER_FORWARDING_8x:
+  case PLAYER_FORWARDING_16x:
+  case PLAYER_FORWARDING_32x:
+  case PLAYER_CAN_RECORD:
+  case PLAYER_RECORDING:
+  case PLAYER_DISPLAY_AFTER_SEEK:
+  case PLAYER_CACHING:
+  case PLAYER_SEEKBAR:
+  case PLAYER_SEEKING:
+  case PLAYER_SHOWTIME:
+  case PLAYER_PASSTHROUGH:
+  case PLAYER_HASDURATION:
+  case MUSICPM_ENABLED:
+  case AUDIOSCROBBLER_ENABLED:
+  case LASTFM_RADIOPLAYING:
+  case LASTFM_CANLOVE:
+  case LASTFM_CANBAN:
+  case MUSICPLAYER_HASPREVIOUS:
+  case MUSICPLAYER_HASNEXT:
+  case MUSICPLAYER_PLAYLISTPLAYING:
+  case VIDEOPLAYER_USING_OVERLAYS:
+  case VIDEOPLAYER_ISFULLSCREEN:
+  case VIDEOPLAYER_HASMENU:
+  case VIDEOPLAYER_HASTELETEXT:
+  case VIDEOPLAYER_HASSUBTITLES:
+  case VIDEOPLAYER_SUBTITLESENABLED:
+  case VIDEOPLAYER_HAS_EPG:
+  case PLAYLIST_ISRANDOM:
+  case PLAYLIST_ISREPEAT:
+  case PLAYLIST_ISREPEATONE:
+  case VISUALISATION_LOCKED:
+  case VISUALISATION_ENABLED:
+    return 1 << SIGNAL_PLAYER;
+  default:
+    break;
+  }
+  if (condition >= CONTAINER_SCROLL_PREVIOUS && condition <= CONTAINER_SCROLL_NEXT)
+    return (1 << SIGNAL_CONTAINER_MOVES) | (1 << SIGNAL_WINDOW);
+  return 1 << SIGNAL_FRAME;
+}
+
 // checks the condition and returns it as necessary.  Currently used
 // for toggle button controls and visibility of images.
 bool CGUIInfoManager::GetBool(int condition1, int contextWindow, const CGUIListItem *item)
@@ -4034,6 +4164,7 @@ void CGUIInfoManager::Clear()
   for (unsigned int i = 0; i < m_bools.size(); ++i)
     delete m_bools[i];
   m_bools.clear();
+  m_boolsLookup.clear();
 
   m_skinVariableStrings.clear();
 }
@@ -4933,8 +5064,35 @@ bool CGUIInfoManager::GetItemBool(const CGUIListItem *item, int condition) const
 void CGUIInfoManager::ResetCache()
 {
   // reset any animation triggers as well
-  m_containerMoves.clear();
-  m_updateTime++;
+  if (!m_containerMoves.empty())
+  {
+    m_containerMoves.clear();
+    Signal(SIGNAL_CONTAINER_MOVES);
+  }
+
+  // raise the signals whose state has changed.  The player state changes all the time
+  // while playing, so just raise it every frame until playback has stopped.
+  bool playing = g_application.IsPlaying();
+  if (playing || m_signalPlaying)
+    Signal(SIGNAL_PLAYER);
+  m_signalPlaying = playing;
+
+  time_t minute = time(NULL) / 60;
+  if (minute != m_signalMinute)
+  {
+    m_signalMinute = minute;
+    Signal(SIGNAL_TIME);
+  }
+
+  vector<int> windows;
+  g_windowManager.GetActiveWindowState(windows);
+  if (windows != m_signalWindows)
+  {
+    m_signalWindows.swap(windows);
+    Signal(SIGNAL_WINDOW);
+  }
+
+  Signal(SIGNAL_FRAME);
 }
 
 // Called from tuxbox service thread to update current status
@@ -34,6 +34,7 @@
 #include "XBDateTime.h"
 #include "utils/Observer.h"
 #include "interfaces/info/SkinVariable.h"
+#include "interfaces/info/InfoBool.h"
 
 #include <list>
 #include <map>
@@ -691,6 +692,27 @@ public:
    */
   bool GetBoolValue(unsigned int expression, const CGUIListItem *item = NULL);
 
+  /*! \brief Get the signals a previously registered boolean expression depends on
+   \return a mask of (1 << INFO::InfoSignal)
+   \sa Register, GetConditionDependencies
+   */
+  unsigned int GetBoolDependencies(unsigned int expression) const;
+
+  /*! \brief Get the signals a single condition depends on
+   Conditions that read state we don't track the changes of depend on INFO::SIGNAL_FRAME.
+   \param condition the condition, as returned from TranslateSingleString
+   \return a mask of (1 << INFO::InfoSignal)
+   */
+  unsigned int GetConditionDependencies(int condition) const;
+
+  /*! \brief Raise a signal, so that the conditions that depend on it are re-evaluated
+   */
+  void Signal(INFO::InfoSignal signal) { m_signals[signal] = ++m_updateTime; };
+
+  /*! \brief Get the number of times boolean expressions have been evaluated since startup
+   */
+  unsigned int GetBoolEvaluations() const { return m_boolEvaluations; };
+
   /*! \brief Evaluate a boolean expression
    \param expression the expression to evaluate
    \param context the context in which to evaluate the expression (currently windows)
@@ -756,10 +778,10 @@ public:
   void SetDisplayAfterSeek(unsigned int timeOut = 2500, int seekOffset = 0);
   void SetSeeking(bool seeking) { m_playerSeeking = seeking; };
   void SetShowTime(bool showtime) { m_playerShowTime = showtime; };
-  void SetShowCodec(bool showcodec) { m_playerShowCodec = showcodec; };
-  void SetShowInfo(bool showinfo) { m_playerShowInfo = showinfo; };
-  void ToggleShowCodec() { m_playerShowCodec = !m_playerShowCodec; };
-  bool ToggleShowInfo() { m_playerShowInfo = !m_playerShowInfo; return m_playerShowInfo; };
+  void SetShowCodec(bool showcodec) { m_playerShowCodec = showcodec; Signal(INFO::SIGNAL_PLAYER); };
+  void SetShowInfo(bool showinfo) { m_playerShowInfo = showinfo; Signal(INFO::SIGNAL_PLAYER); };
+  void ToggleShowCodec() { m_playerShowCodec = !m_playerShowCodec; Signal(INFO::SIGNAL_PLAYER); };
+  bool ToggleShowInfo() { m_playerShowInfo = !m_playerShowInfo; Signal(INFO::SIGNAL_PLAYER); return m_playerShowInfo; };
   bool m_performingSeek;
 
   std::string GetSystemHeatInfo(int info);
@@ -768,8 +790,8 @@ public:
   void UpdateFPS();
   inline float GetFPS() const { return m_fps; };
 
-  void SetNextWindow(int windowID) { m_nextWindowID = windowID; };
-  void SetPreviousWindow(int windowID) { m_prevWindowID = windowID; };
+  void SetNextWindow(int windowID) { m_nextWindowID = windowID; Signal(INFO::SIGNAL_WINDOW); };
+  void SetPreviousWindow(int windowID) { m_prevWindowID = windowID; Signal(INFO::SIGNAL_WINDOW); };
 
   void ResetCache();
   bool GetItemInt(int &value, const CGUIListItem *item, int info) const;
@@ -788,6 +810,7 @@ public:
   {
     // magnitude 2 indicates a scroll, sign indicates direction
     m_containerMoves[id] = (next ? 1 : -1) * (scrolling ? 2 : 1);
+    Signal(INFO::SIGNAL_CONTAINER_MOVES);
   }
 
   void SetLibraryBool(int condition, bool value);
@@ -891,8 +914,16 @@ protected:
   int m_prevWindowID;
 
   std::vector<INFO::InfoBool*> m_bools;
+  std::multimap<uint32_t, unsigned int> m_boolsLookup; ///< registered expressions by crc of their expression and context
   std::vector<INFO::CSkinVariableString> m_skinVariableStrings;
   unsigned int m_updateTime;
+  unsigned int m_signals[INFO::SIGNAL_MAX];  ///< update time at which each of the signals was last raised
+  unsigned int m_boolEvaluations;
+
+  // state tracked to raise signals
+  bool m_signalPlaying;
+  time_t m_signalMinute;
+  std::vector<int> m_signalWindows;
 
   int m_libraryHasMusic;
   int m_libraryHasMovies;
@@ -29,13 +29,18 @@
 #include "guilib/GraphicContext.h"
 #include "utils/log.h"
 #include "TextureCache.h"
+#include "Application.h"
+
+#include <algorithm>
 
 using namespace std;
 
 
-CImageLoader::CImageLoader(const CStdString &path)
+CImageLoader::CImageLoader(const CStdString &path, unsigned int width, unsigned int height)
 {
   m_path = path;
+  m_width = width;
+  m_height = height;
   m_texture = NULL;
 }
 
@@ -60,9 +65,16 @@ bool CImageLoader::DoWork()
   }
   if (!loadPath.IsEmpty())
   {
-    // direct route - load the image
+    // direct route - load the image, at no more than the size of the screen
+    unsigned int width = g_graphicsContext.GetWidth();
+    unsigned int height = g_graphicsContext.GetHeight();
+    if (m_width && m_height)
+    {
+      width = std::min(width, m_width);
+      height = std::min(height, m_height);
+    }
     unsigned int start = XbmcThreads::SystemClockMillis();
-    m_texture = CBaseTexture::LoadFromFile(loadPath, g_graphicsContext.GetWidth(), g_graphicsContext.GetHeight(), g_guiSettings.GetBool("pictures.useexifrotation"));
+    m_texture = CBaseTexture::LoadFromFile(loadPath, width, height, g_guiSettings.GetBool("pictures.useexifrotation"));
     if (!m_texture)
       return false;
     if (XbmcThreads::SystemClockMillis() - start > 100)
@@ -74,11 +86,17 @@ bool CImageLoader::DoWork()
   return true;
 }
 
-CGUILargeTextureManager::CLargeTexture::CLargeTexture(const CStdString &path)
+CGUILargeTextureManager::CLargeTexture::CLargeTexture(const CStdString &path, unsigned int width, unsigned int height)
 {
   m_path = path;
+  m_width = width;
+  m_height = height;
   m_refCount = 1;
   m_timeToDelete = 0;
+  m_jobID = 0;
+  m_distance = 0;
+  m_distanceFrame = 0;
+  m_uploaded = false;
 }
 
 CGUILargeTextureManager::CLargeTexture::~CLargeTexture()
@@ -124,8 +142,34 @@ void CGUILargeTextureManager::CLargeTexture::SetTexture(CBaseTexture* texture)
     m_texture.Set(texture, texture->GetWidth(), texture->GetHeight());
 }
 
+void CGUILargeTextureManager::CLargeTexture::Upload()
+{
+  for (unsigned int i = 0; i < m_texture.m_textures.size(); i++)
+    m_texture.m_textures[i]->LoadToGPU();
+  m_uploaded = true;
+}
+
+bool CGUILargeTextureManager::CLargeTexture::Matches(const CStdString &path, unsigned int width, unsigned int height) const
+{
+  return m_width == width && m_height == height && m_path == path;
+}
+
+void CGUILargeTextureManager::CLargeTexture::SetDistance(float distance)
+{
+  // we may be shown by more than one control, so keep the nearest for this frame
+  unsigned int frameTime = CTimeUtils::GetFrameTime();
+  if (m_distanceFrame != frameTime || distance < m_distance)
+  {
+    m_distance = distance;
+    m_distanceFrame = frameTime;
+  }
+}
+
 CGUILargeTextureManager::CGUILargeTextureManager()
 {
+  m_loading = 0;
+  m_uploadFrame = 0;
+  m_uploadTime = 0;
 }
 
 CGUILargeTextureManager::~CGUILargeTextureManager()
@@ -149,34 +193,39 @@ void CGUILargeTextureManager::CleanupUnusedImages(bool immediately)
 
 // if available, increment reference count, and return the image.
 // else, add to the queue list if appropriate.
-bool CGUILargeTextureManager::GetImage(const CStdString &path, CTextureArray &texture, bool firstRequest)
+bool CGUILargeTextureManager::GetImage(const CStdString &path, CTextureArray &texture, bool firstRequest, unsigned int width, unsigned int height, float distance)
 {
+  RoundLoadSize(width, height);
+
   CSingleLock lock(m_listSection);
   for (listIterator it = m_allocated.begin(); it != m_allocated.end(); ++it)
   {
     CLargeTexture *image = *it;
-    if (image->GetPath() == path)
+    if (image->Matches(path, width, height))
     {
       if (firstRequest)
         image->AddRef();
+      if (!image->IsUploaded() && !UploadImage(image))
+        return true; // no time left this frame, so try again next frame
       texture = image->GetTexture();
       return texture.size() > 0;
     }
   }
 
-  if (firstRequest)
-    QueueImage(path);
+  QueueImage(path, width, height, distance, firstRequest);
 
   return true;
 }
 
-void CGUILargeTextureManager::ReleaseImage(const CStdString &path, bool immediately)
+void CGUILargeTextureManager::ReleaseImage(const CStdString &path, bool immediately, unsigned int width, unsigned int height)
 {
+  RoundLoadSize(width, height);
+
   CSingleLock lock(m_listSection);
   for (listIterator it = m_allocated.begin(); it != m_allocated.end(); ++it)
   {
     CLargeTexture *image = *it;
-    if (image->GetPath() == path)
+    if (image->Matches(path, width, height))
     {
       if (image->DecrRef(immediately) && immediately)
         m_allocated.erase(it);
@@ -185,36 +234,102 @@ void CGUILargeTextureManager::ReleaseImage(const CStdString &path, bool immediat
   }
   for (queueIterator it = m_queued.begin(); it != m_queued.end(); ++it)
   {
-    unsigned int id = it->first;
-    CLargeTexture *image = it->second;
-    if (image->GetPath() == path && image->DecrRef(true))
+    CLargeTexture *image = *it;
+    unsigned int id = image->GetJobID();
+    if (image->Matches(path, width, height) && image->DecrRef(true))
     {
-      // cancel this job
-      CJobManager::GetInstance().CancelJob(id);
+      // cancel this job, if it's been started
+      if (id)
+      {
+        CJobManager::GetInstance().CancelJob(id);
+        m_loading--;
+      }
       m_queued.erase(it);
+      QueueJobs();
       return;
     }
   }
 }
 
 // queue the image, and start the background loader if necessary
-void CGUILargeTextureManager::QueueImage(const CStdString &path)
+void CGUILargeTextureManager::QueueImage(const CStdString &path, unsigned int width, unsigned int height, float distance, bool firstRequest)
 {
   CSingleLock lock(m_listSection);
   for (queueIterator it = m_queued.begin(); it != m_queued.end(); ++it)
   {
-    CLargeTexture *image = it->second;
-    if (image->GetPath() == path)
+    CLargeTexture *image = *it;
+    if (image->Matches(path, width, height))
     {
-      image->AddRef();
+      if (firstRequest)
+        image->AddRef();
+      image->SetDistance(distance);
       return; // already queued
     }
   }
 
+  if (!firstRequest)
+    return;
+
   // queue the item
-  CLargeTexture *image = new CLargeTexture(path);
-  unsigned int jobID = CJobManager::GetInstance().AddJob(new CImageLoader(path), this, CJob::PRIORITY_NORMAL);
-  m_queued.push_back(make_pair(jobID, image));
+  CLargeTexture *image = new CLargeTexture(path, width, height);
+  image->SetDistance(distance);
+  m_queued.push_back(image);
+  QueueJobs();
+}
+
+void CGUILargeTextureManager::QueueJobs()
+{
+  // start loading the images nearest to the screen, in the order they were requested
+  while (m_loading < MAX_LOADING)
+  {
+    CLargeTexture *next = NULL;
+    for (queueIterator it = m_queued.begin(); it != m_queued.end(); ++it)
+    {
+      CLargeTexture *image = *it;
+      if (!image->GetJobID() && (!next || image->GetDistance() < next->GetDistance()))
+        next = image;
+    }
+    if (!next)
+      break;
+
+    next->SetJobID(CJobManager::GetInstance().AddJob(new CImageLoader(next->GetPath(), next->GetWidth(), next->GetHeight()), this, CJob::PRIORITY_NORMAL));
+    m_loading++;
+  }
+}
+
+bool CGUILargeTextureManager::UploadImage(CLargeTexture *image)
+{
+  // textures requested off the render thread are uploaded as they're first rendered
+  if (!g_application.IsCurrentThread())
+    return true;
+
+  // always upload one image each frame, so that large images aren't held back forever
+  unsigned int frameTime = CTimeUtils::GetFrameTime();
+  if (m_uploadFrame != frameTime)
+  {
+    m_uploadFrame = frameTime;
+    m_uploadTime = 0;
+  }
+  else if (m_uploadTime >= (int64_t)UPLOAD_TIME_PER_FRAME * CurrentHostFrequency() / 1000)
+    return false;
+
+  int64_t start = CurrentHostCounter();
+  image->Upload();
+  m_uploadTime += CurrentHostCounter() - start;
+  return true;
+}
+
+void CGUILargeTextureManager::RoundLoadSize(unsigned int &width, unsigned int &height)
+{
+  // round up to the next power of 2 so that controls of similar sizes share images, and there's some
+  // room for zooming. Images are loaded at no more than the size of the screen regardless.
+  if (!width || !height)
+    width = height = 0;
+  else
+  {
+    width = CBaseTexture::PadPow2(width);
+    height = CBaseTexture::PadPow2(height);
+  }
 }
 
 void CGUILargeTextureManager::OnJobComplete(unsigned int jobID, bool success, CJob *job)
@@ -223,18 +338,17 @@ void CGUILargeTextureManager::OnJobComplete(unsigned int jobID, bool success, CJ
   CSingleLock lock(m_listSection);
   for (queueIterator it = m_queued.begin(); it != m_queued.end(); ++it)
   {
-    if (it->first == jobID)
+    CLargeTexture *image = *it;
+    if (image->GetJobID() == jobID)
     { // found our job
       CImageLoader *loader = (CImageLoader *)job;
-      CLargeTexture *image = it->second;
       image->SetTexture(loader->m_texture);
       loader->m_texture = NULL; // we want to keep the texture, and jobs are auto-deleted.
       m_queued.erase(it);
       m_allocated.push_back(image);
+      m_loading--;
+      QueueJobs();
       return;
     }
   }
 }
-
-
-
@@ -36,7 +36,7 @@
 class CImageLoader : public CJob
 {
 public:
-  CImageLoader(const CStdString &path);
+  CImageLoader(const CStdString &path, unsigned int width = 0, unsigned int height = 0);
   virtual ~CImageLoader();
 
   /*!
@@ -45,6 +45,8 @@ public:
   virtual bool DoWork();
 
   CStdString    m_path; ///< path of image to load
+  unsigned int  m_width; ///< ideal width to load the image at, or 0 for the screen width
+  unsigned int  m_height; ///< ideal height to load the image at, or 0 for the screen height
   CBaseTexture *m_texture; ///< Texture object to load the image into \sa CBaseTexture.
 };
 
@@ -55,6 +57,11 @@ public:
  Used to load textures for the user interface asynchronously, allowing fluid framerates
  while background loading textures.
 
+ Only a few images are loaded at a time, with those nearest to being on screen loaded first,
+ so that images that are scrolled past before their turn comes are never loaded at all.
+ Images are loaded at about the size they're shown at, and uploaded to the GPU as they're
+ requested, in no more than UPLOAD_TIME_PER_FRAME milliseconds each frame.
+
  \sa IJobCallback, CGUITexture
  */
 class CGUILargeTextureManager : public IJobCallback
@@ -83,10 +90,13 @@ public:
    \param texture texture object to hold the resulting texture
    \param orientation orientation of resulting texture
    \param firstRequest true if this is the first time we are requesting this texture
+   \param width the width in pixels the texture is shown at, or 0 if unknown.
+   \param height the height in pixels the texture is shown at, or 0 if unknown.
+   \param distance how far in pixels the texture is from being on screen, used to order loading.
    \return true if the image exists, else false.
    \sa CGUITextureArray and CGUITexture
    */
-  bool GetImage(const CStdString &path, CTextureArray &texture, bool firstRequest);
+  bool GetImage(const CStdString &path, CTextureArray &texture, bool firstRequest, unsigned int width = 0, unsigned int height = 0, float distance = 0);
 
   /*!
    \brief Request a texture to be unloaded.
@@ -98,8 +108,10 @@ public:
    \param path path of the image to release.
    \param immediately if set true the image is immediately unloaded once its reference count reaches zero
                       rather than being unloaded after a delay.
+   \param width the width the image was requested at.
+   \param height the height the image was requested at.
    */
-  void ReleaseImage(const CStdString &path, bool immediately = false);
+  void ReleaseImage(const CStdString &path, bool immediately = false, unsigned int width = 0, unsigned int height = 0);
 
   /*!
    \brief Cleanup images that are no longer in use.
@@ -116,15 +128,25 @@ private:
   class CLargeTexture
   {
   public:
-    CLargeTexture(const CStdString &path);
+    CLargeTexture(const CStdString &path, unsigned int width, unsigned int height);
     virtual ~CLargeTexture();
 
     void AddRef();
     bool DecrRef(bool deleteImmediately);
     bool DeleteIfRequired(bool deleteImmediately = false);
     void SetTexture(CBaseTexture* texture);
+    void Upload();
+
+    bool Matches(const CStdString &path, unsigned int width, unsigned int height) const;
+    void SetDistance(float distance);
+    void SetJobID(unsigned int jobID) { m_jobID = jobID; };
 
     const CStdString &GetPath() const { return m_path; };
+    unsigned int GetWidth() const { return m_width; };
+    unsigned int GetHeight() const { return m_height; };
+    float GetDistance() const { return m_distance; };
+    unsigned int GetJobID() const { return m_jobID; };
+    bool IsUploaded() const { return m_uploaded; };
     const CTextureArray &GetTexture() const { return m_texture; };
 
   private:
@@ -132,16 +154,32 @@ private:
 
     unsigned int m_refCount;
     CStdString m_path;
+    unsigned int m_width;
+    unsigned int m_height;
     CTextureArray m_texture;
     unsigned int m_timeToDelete;
+    unsigned int m_jobID;          ///< job loading us, or 0 if we're waiting for our turn
+    float m_distance;              ///< nearest distance from the screen we were requested at
+    unsigned int m_distanceFrame;  ///< frame that m_distance was set in
+    bool m_uploaded;
   };
 
-  void QueueImage(const CStdString &path);
+  static const unsigned int MAX_LOADING = 4;            ///< images to load at once
+  static const unsigned int UPLOAD_TIME_PER_FRAME = 5;  ///< milliseconds to spend uploading images each frame
 
-  std::vector< std::pair<unsigned int, CLargeTexture *> > m_queued;
+  void QueueImage(const CStdString &path, unsigned int width, unsigned int height, float distance, bool firstRequest);
+  void QueueJobs();
+  bool UploadImage(CLargeTexture *image);
+  static void RoundLoadSize(unsigned int &width, unsigned int &height);
+
+  std::vector<CLargeTexture *> m_queued;     ///< images waiting to be loaded, or loading if they have a job
   std::vector<CLargeTexture *> m_allocated;
   typedef std::vector<CLargeTexture *>::iterator listIterator;
-  typedef std::vector< std::pair<unsigned int, CLargeTexture *> >::iterator queueIterator;
+  typedef std::vector<CLargeTexture *>::iterator queueIterator;
+
+  unsigned int m_loading;       ///< number of images being loaded
+  unsigned int m_uploadFrame;   ///< frame time that m_uploadTime is for
+  int64_t m_uploadTime;         ///< host counter ticks spent uploading images in this frame
 
   CCriticalSection m_listSection;
 };
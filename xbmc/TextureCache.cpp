@@ -77,6 +77,12 @@ bool CTextureCache::HasCachedImage(const CStdString &url)
 }
 
 CStdString CTextureCache::GetCachedImage(const CStdString &image, CStdString &cachedHash, bool trackUsage)
+{
+  CTextureDetails details;
+  return GetCachedImage(image, cachedHash, details, trackUsage);
+}
+
+CStdString CTextureCache::GetCachedImage(const CStdString &image, CStdString &cachedHash, CTextureDetails &details, bool trackUsage)
 {
   cachedHash.clear();
   CStdString url = UnwrapImageURL(image);
@@ -85,7 +91,6 @@ CStdString CTextureCache::GetCachedImage(const CStdString &image, CStdString &ca
     return url;
 
   // lookup the item in the database
-  CTextureDetails details;
   if (GetCachedTexture(url, details))
   {
     if (trackUsage)
@@ -134,7 +139,8 @@ CStdString CTextureCache::UnwrapImageURL(const CStdString &image)
 CStdString CTextureCache::CheckCachedImage(const CStdString &url, bool returnDDS, bool &needsRecaching)
 {
   CStdString cachedHash;
-  CStdString path(GetCachedImage(url, cachedHash, true));
+  CTextureDetails details;
+  CStdString path(GetCachedImage(url, cachedHash, details, true));
   needsRecaching = !cachedHash.IsEmpty();
   if (!path.IsEmpty())
   {
@@ -143,6 +149,16 @@ CStdString CTextureCache::CheckCachedImage(const CStdString &url, bool returnDDS
       CStdString ddsPath = URIUtils::ReplaceExtension(path, ".dds");
       if (CFile::Exists(ddsPath))
         return ddsPath;
+      if (g_advancedSettings.m_usePackedTextures)
+      { // check for packed version
+        CStdString xbtPath = URIUtils::ReplaceExtension(path, ".xbt");
+        if (CFile::Exists(xbtPath))
+          return xbtPath;
+        // fanart and the like aren't packed, which the size kept in the database tells without decoding them
+        // again each time they're shown. images of unknown size are left to the job to check.
+        if (details.height <= (unsigned int)g_advancedSettings.m_imageRes)
+          AddJob(new CTextureXBTJob(path));
+      }
       if (g_advancedSettings.m_useDDSFanart)
         AddJob(new CTextureDDSJob(path));
     }
@@ -201,9 +217,12 @@ void CTextureCache::ClearCachedImage(const CStdString &url, bool deleteSource /*
     path = GetCachedPath(cachedFile);
   if (CFile::Exists(path))
     CFile::Delete(path);
-  path = URIUtils::ReplaceExtension(path, ".dds");
-  if (CFile::Exists(path))
-    CFile::Delete(path);
+  CStdString ddsPath = URIUtils::ReplaceExtension(path, ".dds");
+  if (CFile::Exists(ddsPath))
+    CFile::Delete(ddsPath);
+  CStdString xbtPath = URIUtils::ReplaceExtension(path, ".xbt");
+  if (CFile::Exists(xbtPath))
+    CFile::Delete(xbtPath);
 }
 
 bool CTextureCache::GetCachedTexture(const CStdString &url, CTextureDetails &details)
@@ -266,7 +285,13 @@ void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
     if (job->m_oldHash == job->m_details.hash)
       SetCachedTextureValid(job->m_url, job->m_details.updateable);
     else
+    {
       AddCachedTexture(job->m_url, job->m_details);
+      // a packed copy of the image it replaces is stale now
+      CStdString xbtPath = URIUtils::ReplaceExtension(GetCachedPath(job->m_details.file), ".xbt");
+      if (!job->m_oldHash.IsEmpty() && CFile::Exists(xbtPath))
+        CFile::Delete(xbtPath);
+    }
   }
 
   { // remove from our processing list
@@ -281,6 +306,8 @@ void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
   // TODO: call back to the UI indicating that it can update it's image...
   if (success && g_advancedSettings.m_useDDSFanart && !job->m_details.file.empty())
     AddJob(new CTextureDDSJob(GetCachedPath(job->m_details.file)));
+  if (success && g_advancedSettings.m_usePackedTextures && !job->m_details.file.empty())
+    AddJob(new CTextureXBTJob(GetCachedPath(job->m_details.file)));
 }
 
 void CTextureCache::OnJobComplete(unsigned int jobID, bool success, CJob *job)
@@ -170,6 +170,13 @@ private:
    */
   CStdString GetCachedImage(const CStdString &image, CStdString &cacheHash, bool trackUsage = false);
 
+  /*! \brief retrieve the cached version of the given image (if it exists) along with its details
+   \param details [out] the details of the cached image from the database, left as they are for an image
+   that is itself in the cache.
+   \sa GetCachedImage
+   */
+  CStdString GetCachedImage(const CStdString &image, CStdString &cacheHash, CTextureDetails &details, bool trackUsage = false);
+
   /*! \brief Get an image from the database
    Thread-safe wrapper of CTextureDatabase::GetCachedTexture
    \param image url of the original image
@@ -23,6 +23,7 @@
 #include "TextureCache.h"
 #include "guilib/Texture.h"
 #include "guilib/DDSImage.h"
+#include "guilib/XBTF.h"
 #include "settings/Settings.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/GUISettings.h"
@@ -35,6 +36,9 @@
 #include "FileItem.h"
 #include "ThumbLoader.h"
 #include "music/tags/MusicInfoTag.h"
+#include "utils/EndianSwap.h"
+
+#include <lzo/lzo1x.h>
 
 CTextureCacheJob::CTextureCacheJob(const CStdString &url, const CStdString &oldHash)
 {
@@ -256,6 +260,106 @@ bool CTextureDDSJob::DoWork()
   return false;
 }
 
+CTextureXBTJob::CTextureXBTJob(const CStdString &original)
+{
+  m_original = original;
+}
+
+bool CTextureXBTJob::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(),GetType()) == 0)
+  {
+    const CTextureXBTJob* xbtJob = dynamic_cast<const CTextureXBTJob*>(job);
+    if (xbtJob && xbtJob->m_original == m_original)
+      return true;
+  }
+  return false;
+}
+
+static void AppendU32(std::string &data, uint32_t value)
+{
+  value = Endian_SwapLE32(value);
+  data.append((const char *)&value, sizeof(value));
+}
+
+static void AppendU64(std::string &data, uint64_t value)
+{
+  value = Endian_SwapLE64(value);
+  data.append((const char *)&value, sizeof(value));
+}
+
+bool CTextureXBTJob::DoWork()
+{
+  if (URIUtils::GetExtension(m_original).Equals(".xbt") || URIUtils::GetExtension(m_original).Equals(".dds"))
+    return false;
+  CBaseTexture *texture = CBaseTexture::LoadFromFile(m_original);
+  if (!texture)
+    return false;
+  if (!texture->GetPixels() || texture->GetHeight() > (unsigned int)g_advancedSettings.m_imageRes)
+  { // fanart and the like are too big to be worth keeping unpacked
+    delete texture;
+    return false;
+  }
+
+  // copy out the image without any padding of the texture
+  unsigned int width = texture->GetWidth();
+  unsigned int height = texture->GetHeight();
+  unsigned int pitch = width * 4;
+  std::vector<unsigned char> pixels(pitch * height);
+  for (unsigned int y = 0; y < height; y++)
+    memcpy(&pixels[y * pitch], texture->GetPixels() + y * texture->GetPitch(), pitch);
+  uint32_t format = XB_FMT_A8R8G8B8 | (texture->HasAlpha() ? 0 : XB_FMT_OPAQUE);
+  delete texture;
+
+  // pack with lzo, which unpacks many times faster than jpg or png can be decoded
+  std::vector<unsigned char> packed(pixels.size() + pixels.size() / 16 + 64 + 3);
+  std::vector<unsigned char> work(LZO1X_1_MEM_COMPRESS);
+  lzo_uint packedSize = packed.size();
+  if (lzo_init() != LZO_E_OK ||
+      lzo1x_1_compress(&pixels[0], pixels.size(), &packed[0], &packedSize, &work[0]) != LZO_E_OK ||
+      packedSize >= pixels.size())
+  { // store it unpacked
+    packed.swap(pixels);
+    packedSize = packed.size();
+  }
+
+  // a single file of a single frame, as read by CXBTFReader
+  std::string data;
+  data.append(XBTF_MAGIC, 4);
+  data.append(XBTF_VERSION, 1);
+  AppendU32(data, 1);
+  char path[256] = "texture";
+  data.append(path, sizeof(path));
+  AppendU32(data, 0);        // loop
+  AppendU32(data, 1);        // frames
+  AppendU32(data, width);
+  AppendU32(data, height);
+  AppendU32(data, format);
+  AppendU64(data, packedSize);
+  AppendU64(data, pitch * height);
+  AppendU32(data, 0);        // duration
+  AppendU64(data, data.size() + sizeof(uint64_t));
+  data.append((const char *)&packed[0], packedSize);
+
+  // write to a temporary file first, so that the texture cache never sees a partial file
+  CStdString xbtPath = URIUtils::ReplaceExtension(m_original, ".xbt");
+  CStdString tempPath = xbtPath + ".tmp";
+  CLog::Log(LOGDEBUG, "Creating packed version of: %s", m_original.c_str());
+  XFILE::CFile file;
+  if (!file.OpenForWrite(tempPath, true))
+    return false;
+  bool written = file.Write(data.c_str(), data.size()) == (int)data.size();
+  file.Close();
+  if (written && XFILE::CFile::Exists(xbtPath))
+    XFILE::CFile::Delete(xbtPath); // rename doesn't replace an existing file on all platforms
+  if (!written || !XFILE::CFile::Rename(tempPath, xbtPath))
+  {
+    XFILE::CFile::Delete(tempPath);
+    return false;
+  }
+  return true;
+}
+
 CTextureUseCountJob::CTextureUseCountJob(const std::vector<CTextureDetails> &textures) : m_textures(textures)
 {
 }
@@ -135,6 +135,23 @@ public:
   CStdString m_original;
 };
 
+/* \brief Job class for creating lzo packed .xbt versions of textures
+ The texture is stored as it's uploaded, so loading it needs no decoding beyond unpacking.
+ Only images up to the size of cached thumbs and covers are packed, as larger
+ images are better served by .dds (see <useddsfanart>).
+ */
+class CTextureXBTJob : public CJob
+{
+public:
+  CTextureXBTJob(const CStdString &original);
+
+  virtual const char* GetType() const { return "xbtpack"; };
+  virtual bool operator==(const CJob *job) const;
+  virtual bool DoWork();
+
+  CStdString m_original;
+};
+
 /* \brief Job class for storing the use count of textures
  */
 class CTextureUseCountJob : public CJob
@@ -39,6 +39,9 @@
 #include "music/tags/MusicInfoTagLoaderFactory.h"
 #include "music/infoscanner/MusicInfoScanner.h"
 #include "music/Artist.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/CPUInfo.h"
 
 using namespace XFILE;
 using namespace std;
@@ -69,6 +72,42 @@ void CThumbLoader::SetCachedImage(const CFileItem &item, const CStdString &type,
     db.SetTextureForPath(item.GetPath(), type, image);
 }
 
+// how often the rate of extraction is logged while extracting (ms)
+#define EXTRACTION_LOG_INTERVAL 60000
+
+static CCriticalSection g_extractionSection;
+static unsigned int g_extractionStart = 0;  ///< start of the current logging interval
+static unsigned int g_extractedThumbs = 0;  ///< thumbs extracted this interval
+static unsigned int g_extractedFlags = 0;   ///< stream details extracted this interval
+static unsigned int g_extractionsFailed = 0;
+static unsigned int g_extractionTime = 0;   ///< time spent extracting this interval (ms)
+
+static void LogExtraction(bool thumb, bool success, unsigned int elapsed)
+{
+  CSingleLock lock(g_extractionSection);
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  if (!g_extractedThumbs && !g_extractedFlags && !g_extractionsFailed)
+    g_extractionStart = now - elapsed;
+
+  if (!success)
+    g_extractionsFailed++;
+  else if (thumb)
+    g_extractedThumbs++;
+  else
+    g_extractedFlags++;
+  g_extractionTime += elapsed;
+
+  unsigned int interval = now - g_extractionStart;
+  if (interval >= EXTRACTION_LOG_INTERVAL)
+  {
+    unsigned int count = g_extractedThumbs + g_extractedFlags + g_extractionsFailed;
+    CLog::Log(LOGDEBUG, "%s - %.1f thumbs/min: extracted %u thumbs and %u stream details (%u failed) in %u s, taking %u ms each",
+              __FUNCTION__, g_extractedThumbs * 60000.0f / interval, g_extractedThumbs, g_extractedFlags, g_extractionsFailed,
+              interval / 1000, g_extractionTime / count);
+    g_extractedThumbs = g_extractedFlags = g_extractionsFailed = g_extractionTime = 0;
+  }
+}
+
 CThumbExtractor::CThumbExtractor(const CFileItem& item, const CStdString& listpath, bool thumb, const CStdString& target)
 {
   m_listpath = listpath;
@@ -116,6 +155,7 @@ bool CThumbExtractor::DoWork()
   if (URIUtils::IsRemote(m_path) && !URIUtils::IsOnLAN(m_path))
     return false;
 
+  unsigned int start = XbmcThreads::SystemClockMillis();
   bool result=false;
   if (m_thumb)
   {
@@ -138,29 +178,60 @@ bool CThumbExtractor::DoWork()
     result = CDVDFileInfo::GetFileStreamDetails(&m_item);
   }
 
+  LogExtraction(m_thumb, result, XbmcThreads::SystemClockMillis() - start);
   return result;
 }
 
 CVideoThumbLoader::CVideoThumbLoader() :
-  CThumbLoader(1), CJobQueue(true), m_pStreamDetailsObs(NULL)
+  CThumbLoader(1), CJobQueue(true, std::max(1, g_cpuInfo.getCPUCount() / 2)), m_pStreamDetailsObs(NULL)
 {
   m_database = new CVideoDatabase();
+  m_holdExtractions = false;
 }
 
 CVideoThumbLoader::~CVideoThumbLoader()
 {
   StopThread();
   delete m_database;
+
+  for (vector<CThumbExtractor*>::iterator i = m_heldThumbs.begin(); i != m_heldThumbs.end(); ++i)
+    delete *i;
+  for (vector<CThumbExtractor*>::iterator i = m_heldFlags.begin(); i != m_heldFlags.end(); ++i)
+    delete *i;
 }
 
 void CVideoThumbLoader::OnLoaderStart()
 {
   m_database->Open();
+
+  CSingleLock lock(m_extractionSection);
+  m_holdExtractions = true;
 }
 
 void CVideoThumbLoader::OnLoaderFinish()
 {
   m_database->Close();
+
+  // the queue is last in, first out, so queue the least wanted first
+  CSingleLock lock(m_extractionSection);
+  m_holdExtractions = false;
+  for (vector<CThumbExtractor*>::reverse_iterator i = m_heldFlags.rbegin(); i != m_heldFlags.rend(); ++i)
+    AddJob(*i);
+  for (vector<CThumbExtractor*>::reverse_iterator i = m_heldThumbs.rbegin(); i != m_heldThumbs.rend(); ++i)
+    AddJob(*i);
+  m_heldFlags.clear();
+  m_heldThumbs.clear();
+}
+
+void CVideoThumbLoader::QueueExtraction(CThumbExtractor *extractor)
+{
+  CSingleLock lock(m_extractionSection);
+  if (!m_holdExtractions)
+    AddJob(extractor);
+  else if (extractor->m_thumb)
+    m_heldThumbs.push_back(extractor);
+  else
+    m_heldFlags.push_back(extractor);
 }
 
 static void SetupRarOptions(CFileItem& item, const CStdString& path)
@@ -271,7 +342,7 @@ bool CVideoThumbLoader::LoadItem(CFileItem* pItem)
           SetupRarOptions(item,path);
 
         CThumbExtractor* extract = new CThumbExtractor(item, path, true, thumbURL);
-        AddJob(extract);
+        QueueExtraction(extract);
 
         m_database->Close();
         return true;
@@ -291,7 +362,7 @@ bool CVideoThumbLoader::LoadItem(CFileItem* pItem)
     if (URIUtils::IsInRAR(item.GetPath()))
       SetupRarOptions(item,path);
     CThumbExtractor* extract = new CThumbExtractor(item,path,false);
-    AddJob(extract);
+    QueueExtraction(extract);
   }
 
   m_database->Close();
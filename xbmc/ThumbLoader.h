@@ -127,8 +127,20 @@ protected:
   virtual void OnLoaderStart() ;
   virtual void OnLoaderFinish() ;
 
+  /*! \brief Queue a thumb or stream details extraction.
+   While items are being loaded in the background, extractions are held back until all are
+   loaded and then queued thumbs first, in the order of the list, so that the items at the
+   top of the list (those most likely on screen) get their thumbs first.
+   */
+  void QueueExtraction(CThumbExtractor *extractor);
+
   IStreamDetailsObserver *m_pStreamDetailsObs;
   CVideoDatabase *m_database;
+
+  bool m_holdExtractions;
+  std::vector<CThumbExtractor*> m_heldThumbs; ///< thumb extractions held back while loading, in list order
+  std::vector<CThumbExtractor*> m_heldFlags;  ///< stream details extractions held back while loading, in list order
+  CCriticalSection m_extractionSection;
 };
 
 class CProgramThumbLoader : public CThumbLoader
@@ -22,6 +22,8 @@
 #include "Repository.h"
 #include "utils/XBMCTinyXML.h"
 #include "filesystem/File.h"
+#include "filesystem/CurlFile.h"
+#include "filesystem/HttpCache.h"
 #include "AddonDatabase.h"
 #include "settings/Settings.h"
 #include "FileItem.h"
@@ -91,6 +93,16 @@ CStdString CRepository::Checksum()
 CStdString CRepository::FetchChecksum(const CStdString& url)
 {
   CSingleLock lock(m_critSection);
+  if (URIUtils::IsInternetStream(CURL(url)))
+  {
+    CCurlFile http;
+    CStdString checksum;
+    // always revalidated, as it is what tells us the repository has changed
+    if (!CHttpCache::Get().Fetch(http, url, checksum, true))
+      return "";
+    return checksum;
+  }
+
   CFile file;
   file.Open(url);
   try
@@ -147,7 +159,16 @@ VECADDONS CRepository::Parse()
     file = url.Get();
   }
 
-  doc.LoadFile(file);
+  if (URIUtils::IsInternetStream(CURL(file)))
+  {
+    CCurlFile http;
+    CStdString xml;
+    // only parsed once the checksum has changed, so a cached copy that is still fresh is likely out of date
+    if (CHttpCache::Get().Fetch(http, file, xml, true))
+      doc.Parse(xml);
+  }
+  else
+    doc.LoadFile(file);
   if (doc.RootElement())
   {
     CAddonMgr::Get().AddonsFromRepoXML(doc.RootElement(), result);
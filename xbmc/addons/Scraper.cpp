@@ -125,7 +125,7 @@ static void CheckScraperError(const TiXmlElement *pxeRoot)
   throw CScraperError(sTitle, sMessage);
 }
 
-CScraper::CScraper(const cp_extension_t *ext) : CAddon(ext), m_fLoaded(false)
+CScraper::CScraper(const cp_extension_t *ext) : CAddon(ext), m_fLoaded(false), m_maxLookups(0)
 {
   if (ext)
   {
@@ -134,6 +134,7 @@ CScraper::CScraper(const cp_extension_t *ext) : CAddon(ext), m_fLoaded(false)
     CStdString persistence = CAddonMgr::Get().GetExtValue(ext->configuration, "@cachepersistence");
     if (!persistence.IsEmpty())
       m_persistence.SetFromTimeString(persistence);
+    m_maxLookups = atoi(CAddonMgr::Get().GetExtValue(ext->configuration, "@maxlookups").c_str());
   }
   switch (Type())
   {
@@ -169,6 +170,7 @@ CScraper::CScraper(const CScraper &rhs, const AddonPtr &self)
   m_pathContent = rhs.m_pathContent;
   m_persistence = rhs.m_persistence;
   m_requiressettings = rhs.m_requiressettings;
+  m_maxLookups = rhs.m_maxLookups;
   m_language = rhs.m_language;
 }
 
@@ -82,7 +82,7 @@ private:
 class CScraper : public CAddon
 {
 public:
-  CScraper(const AddonProps &props) : CAddon(props), m_fLoaded(false) {}
+  CScraper(const AddonProps &props) : CAddon(props), m_fLoaded(false), m_maxLookups(0) {}
   CScraper(const cp_extension_t *ext);
   virtual ~CScraper() {}
   virtual AddonPtr Clone(const AddonPtr &self) const;
@@ -114,6 +114,9 @@ public:
   CONTENT_TYPE Content() const { return m_pathContent; }
   const CStdString& Language() const { return m_language; }
   bool RequiresSettings() const { return m_requiressettings; }
+  /*! \brief Maximum number of lookups to run against the scraper's site at once, or 0 if the scraper sets no limit.
+   */
+  int MaxLookups() const { return m_maxLookups; }
   bool Supports(const CONTENT_TYPE &content) const;
 
   bool IsInUse() const;
@@ -158,6 +161,7 @@ private:
   bool m_fLoaded;
   CStdString m_language;
   bool m_requiressettings;
+  int m_maxLookups;
   CDateTimeSpan m_persistence;
   CONTENT_TYPE m_pathContent;
   CScraperParser m_parser;
@@ -180,9 +180,14 @@ void CSkinInfo::LoadIncludes()
   m_includes.LoadIncludes(includesPath);
 }
 
-void CSkinInfo::ResolveIncludes(TiXmlElement *node)
+bool CSkinInfo::ResolveIncludes(TiXmlElement *node)
 {
-  m_includes.ResolveIncludes(node);
+  return m_includes.ResolveIncludes(node);
+}
+
+bool CSkinInfo::ResolveIncludesInBackground(TiXmlElement *node)
+{
+  return m_includes.ResolveIncludesInBackground(node);
 }
 
 int CSkinInfo::GetStartWindow() const
@@ -92,7 +92,8 @@ public:
    */
   static bool TranslateResolution(const CStdString &name, RESOLUTION_INFO &res);
 
-  void ResolveIncludes(TiXmlElement *node);
+  bool ResolveIncludes(TiXmlElement *node);
+  bool ResolveIncludesInBackground(TiXmlElement *node);
 
   float GetEffectsSlowdown() const { return m_effectsSlowDown; };
 
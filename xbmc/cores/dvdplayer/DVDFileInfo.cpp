@@ -50,10 +50,20 @@
 #include "DllSwScale.h"
 #include "filesystem/File.h"
 #include "TextureCache.h"
+#include "video/StreamDetailsDatabase.h"
 
 
 bool CDVDFileInfo::GetFileDuration(const CStdString &path, int& duration)
 {
+  CStdString stamp;
+  if (CStreamDetailsDatabase::GetFileStamp(path, stamp))
+  {
+    CStreamDetailsDatabase db;
+    CStreamDetails details;
+    if (db.Open() && db.GetStreamDetails(path, stamp, details, duration))
+      return duration > 0;
+  }
+
   std::auto_ptr<CDVDInputStream> input;
   std::auto_ptr<CDVDDemux> demux;
 
@@ -90,8 +100,80 @@ int DegreeToOrientation(int degrees)
   }
 }
 
+/*!
+ \brief Use the thumb extracted from an unchanged file before, along with its stream details if wanted.
+ \return true if the thumb is in the texture cache at details.file.
+ */
+static bool GetCachedThumb(const CStdString &strPath, const CStdString &stamp, CTextureDetails &details, CStreamDetails *pStreamDetails)
+{
+  CStreamDetailsDatabase db;
+  CTextureDetails thumb;
+  int duration;
+  if (!db.Open() || !db.GetThumb(strPath, stamp, thumb))
+    return false;
+  if (pStreamDetails && !db.GetStreamDetails(strPath, stamp, *pStreamDetails, duration))
+    return false;
+
+  // the thumb may since have been removed from the texture cache, or be cached for another url
+  CStdString cachedPath = CTextureCache::GetCachedPath(thumb.file);
+  struct __stat64 info;
+  if (XFILE::CFile::Stat(cachedPath, &info) != 0 || info.st_size <= 0)
+    return false;
+  if (thumb.file != details.file)
+  {
+    if (!XFILE::CFile::Cache(cachedPath, CTextureCache::GetCachedPath(details.file)))
+      return false;
+    thumb.file = details.file;
+    db.SetThumb(strPath, stamp, thumb);
+  }
+
+  details.width = thumb.width;
+  details.height = thumb.height;
+  CLog::Log(LOGDEBUG, "%s - using the thumb extracted previously from unchanged file %s", __FUNCTION__, strPath.c_str());
+  return true;
+}
+
+/*!
+ \brief Open a software decoder for extracting a thumb.
+ \param fast whether to decode keyframes alone, at the lowest resolution the codec can manage that is still big enough.
+ */
+static CDVDVideoCodec *OpenThumbCodec(CDVDStreamInfo &hint, bool fast)
+{
+  CDVDCodecOptions options;
+  options.m_formats.push_back(RENDER_FMT_YUV420P);
+  if (fast)
+  {
+    options.m_keys.push_back(CDVDCodecOption("skip_frame", "nokey"));
+
+    int lowres = 0;
+    DllAvCodec dllAvCodec;
+    if (dllAvCodec.Load())
+    {
+      AVCodec *codec = dllAvCodec.avcodec_find_decoder(hint.codec);
+      int maxLowres = codec ? codec->max_lowres : 0;
+      while (lowres < maxLowres && (unsigned int)(hint.width >> (lowres + 1)) >= g_advancedSettings.GetThumbSize())
+        lowres++;
+      dllAvCodec.Unload();
+    }
+    if (lowres > 0)
+    {
+      CStdString value;
+      value.Format("%d", lowres);
+      options.m_keys.push_back(CDVDCodecOption("lowres", value));
+    }
+  }
+
+  // always ffmpeg: libmpeg2 isn't thread safe, and the decoder must take the options above
+  return CDVDFactoryCodec::OpenCodec(new CDVDVideoCodecFFmpeg(), hint, options);
+}
+
 bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, CTextureDetails &details, CStreamDetails *pStreamDetails)
 {
+  CStdString stamp;
+  bool cacheable = CStreamDetailsDatabase::GetFileStamp(strPath, stamp);
+  if (cacheable && GetCachedThumb(strPath, stamp, details, pStreamDetails))
+    return true;
+
   unsigned int nTime = XbmcThreads::SystemClockMillis();
   CDVDInputStream *pInputStream = CDVDFactoryInputStream::CreateInputStream(NULL, strPath, "");
   if (!pInputStream)
@@ -136,6 +218,7 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, CTextureDetails &deta
     return false;
   }
 
+  int nDuration = pDemuxer->GetStreamLength();
   if (pStreamDetails)
     DemuxerToStreamDetails(pInputStream, pDemuxer, *pStreamDetails, strPath);
 
@@ -158,24 +241,19 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, CTextureDetails &deta
 
   if (nVideoStream != -1)
   {
-    CDVDVideoCodec *pVideoCodec;
-
     CDVDStreamInfo hint(*pDemuxer->GetStream(nVideoStream), true);
     hint.software = true;
 
-    if (hint.codec == CODEC_ID_MPEG2VIDEO || hint.codec == CODEC_ID_MPEG1VIDEO)
+    // a thumb needs neither every frame nor the full resolution, so first decode keyframes alone,
+    // at a lower resolution where the codec can. some streams have no frames ffmpeg takes for
+    // keyframes, so if that gets us no picture we try again, decoding everything.
+    bool bSeekFailed = false;
+    for (int attempt = 0; attempt < 2 && !bOk && !bSeekFailed; attempt++)
     {
-      // libmpeg2 is not thread safe so use ffmepg for mpeg2/mpeg1 thumb extraction
-      CDVDCodecOptions dvdOptions;
-      pVideoCodec = CDVDFactoryCodec::OpenCodec(new CDVDVideoCodecFFmpeg(), hint, dvdOptions);
-    }
-    else
-    {
-      pVideoCodec = CDVDFactoryCodec::CreateVideoCodec( hint );
-    }
+      CDVDVideoCodec *pVideoCodec = OpenThumbCodec(hint, attempt == 0);
+      if (!pVideoCodec)
+        continue;
 
-    if (pVideoCodec)
-    {
       int nTotalLen = pDemuxer->GetStreamLength();
       int nSeekTo = nTotalLen / 3;
 
@@ -261,6 +339,8 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, CTextureDetails &deta
           CLog::Log(LOGDEBUG,"%s - decode failed in %s after %d packets.", __FUNCTION__, strPath.c_str(), packetsTried);
         }
       }
+      else
+        bSeekFailed = true;
       delete pVideoCodec;
     }
   }
@@ -277,6 +357,18 @@ bool CDVDFileInfo::ExtractThumb(const CStdString &strPath, CTextureDetails &deta
       file.Close();
   }
 
+  if (cacheable)
+  { // remember what we found, in case the file is probed again
+    CStreamDetailsDatabase db;
+    if (db.Open())
+    {
+      if (pStreamDetails)
+        db.SetStreamDetails(strPath, stamp, *pStreamDetails, nDuration);
+      if (bOk)
+        db.SetThumb(strPath, stamp, details);
+    }
+  }
+
   unsigned int nTotalTime = XbmcThreads::SystemClockMillis() - nTime;
   CLog::Log(LOGDEBUG,"%s - measured %u ms to extract thumb from file <%s> in %d packets. ", __FUNCTION__, nTotalTime, strPath.c_str(), packetsTried);
   return bOk;
@@ -301,6 +393,18 @@ bool CDVDFileInfo::GetFileStreamDetails(CFileItem *pItem)
   if (URIUtils::IsStack(playablePath))
     playablePath = XFILE::CStackDirectory::GetFirstStackedFile(playablePath);
 
+  // stacks aren't cached, as their duration depends on all their parts
+  CStdString stamp;
+  bool cacheable = CStreamDetailsDatabase::GetFileStamp(strFileNameAndPath, stamp);
+  if (cacheable)
+  {
+    CStreamDetailsDatabase db;
+    CStreamDetails &details = pItem->GetVideoInfoTag()->m_streamDetails;
+    int duration;
+    if (db.Open() && db.GetStreamDetails(strFileNameAndPath, stamp, details, duration))
+      return details.HasItems();
+  }
+
   CDVDInputStream *pInputStream = CDVDFactoryInputStream::CreateInputStream(NULL, playablePath, "");
   if (!pInputStream)
     return false;
@@ -315,6 +419,12 @@ bool CDVDFileInfo::GetFileStreamDetails(CFileItem *pItem)
   if (pDemuxer)
   {
     bool retVal = DemuxerToStreamDetails(pInputStream, pDemuxer, pItem->GetVideoInfoTag()->m_streamDetails, strFileNameAndPath);
+    if (cacheable)
+    {
+      CStreamDetailsDatabase db;
+      if (db.Open())
+        db.SetStreamDetails(strFileNameAndPath, stamp, pItem->GetVideoInfoTag()->m_streamDetails, pDemuxer->GetStreamLength());
+    }
     delete pDemuxer;
     delete pInputStream;
     return retVal;
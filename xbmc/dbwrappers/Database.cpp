@@ -19,6 +19,9 @@
  *
  */
 
+#include <map>
+#include <set>
+
 #include "Database.h"
 #include "settings/Settings.h"
 #include "settings/AdvancedSettings.h"
@@ -30,6 +33,10 @@
 #include "utils/URIUtils.h"
 #include "sqlitedataset.h"
 #include "DatabaseManager.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
 
 #ifdef HAS_MYSQL
 #include "mysqldataset.h"
@@ -40,6 +47,71 @@ using namespace dbiplus;
 
 #define MAX_COMPRESS_COUNT 20
 
+// WAL size (in pages) at which a writer checkpoints inline, should the
+// background checkpoint not have caught up (sqlite's default is 1000)
+#define WAL_AUTOCHECKPOINT_PAGES 16384
+// minimum time between background checkpoints of the same database
+#define WAL_CHECKPOINT_INTERVAL_MS 30000
+
+/*!
+ \brief Checkpoints the write-ahead log of a sqlite database in the background.
+
+ Uses its own connection and a passive checkpoint, so it never blocks readers
+ or writers. Checkpoints of the same database file are rate limited.
+ */
+class CDatabaseCheckpointJob : public CJob
+{
+public:
+  static void Queue(const std::string &file)
+  {
+    {
+      CSingleLock lock(m_section);
+      unsigned int now = XbmcThreads::SystemClockMillis();
+      std::map<std::string, unsigned int>::iterator it = m_lastQueued.find(file);
+      if (it != m_lastQueued.end() && now - it->second < WAL_CHECKPOINT_INTERVAL_MS)
+        return;
+      m_lastQueued[file] = now;
+    }
+    CJobManager::GetInstance().AddJob(new CDatabaseCheckpointJob(file), NULL, CJob::PRIORITY_LOW);
+  }
+
+  virtual const char *GetType() const { return "dbcheckpoint"; }
+
+  virtual bool DoWork()
+  {
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(m_file.c_str(), &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK)
+    {
+      CLog::Log(LOGWARNING, "%s - unable to open %s: %s", __FUNCTION__, m_file.c_str(), db ? sqlite3_errmsg(db) : "out of memory");
+      sqlite3_close(db);
+      return false;
+    }
+    int log = 0, checkpointed = 0;
+    int ret = sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_PASSIVE, &log, &checkpointed);
+    if (ret != SQLITE_OK)
+      CLog::Log(LOGWARNING, "%s - unable to checkpoint %s: %s", __FUNCTION__, m_file.c_str(), sqlite3_errmsg(db));
+    sqlite3_close(db);
+    if (ret != SQLITE_OK)
+      return false;
+    CLog::Log(LOGDEBUG, "%s - %s: checkpointed %i of %i pages", __FUNCTION__, m_file.c_str(), checkpointed, log);
+    return true;
+  }
+
+private:
+  CDatabaseCheckpointJob(const std::string &file) : m_file(file) {}
+
+  std::string m_file;
+  static std::map<std::string, unsigned int> m_lastQueued;
+  static CCriticalSection m_section;
+};
+
+std::map<std::string, unsigned int> CDatabaseCheckpointJob::m_lastQueued;
+CCriticalSection CDatabaseCheckpointJob::m_section;
+
+// sqlite database files whose journal mode has been checked this run
+static std::set<std::string> s_journalModeChecked;
+static CCriticalSection s_journalModeSection;
+
 CDatabase::CDatabase(void)
 {
   m_openCount = 0;
@@ -396,6 +468,9 @@ bool CDatabase::Connect(const CStdString &dbName, const DatabaseSettings &dbSett
   if (!dbSettings.pass.IsEmpty())
     m_pDB->setPasswd(dbSettings.pass.c_str());
 
+  if (!dbSettings.replicahost.IsEmpty())
+    m_pDB->setReplica(dbSettings.replicahost.c_str(), dbSettings.replicaport.c_str());
+
   // database name is always required
   m_pDB->setDatabase(dbName.c_str());
 
@@ -429,9 +504,39 @@ bool CDatabase::Connect(const CStdString &dbName, const DatabaseSettings &dbSett
     // sqlite3 post connection operations
     if (dbSettings.type.Equals("sqlite3"))
     {
-      m_pDS->exec("PRAGMA cache_size=4096\n");
+      m_pDS->exec(PrepareSQL("PRAGMA cache_size=%i\n", g_advancedSettings.m_sqliteCacheSize));
       m_pDS->exec("PRAGMA synchronous='NORMAL'\n");
       m_pDS->exec("PRAGMA count_changes='OFF'\n");
+      // with a write-ahead log readers don't wait on writers, and commits don't sync
+      // the database file.  journal_mode is persistent, so it is only checked the first
+      // time a database is opened (at startup), and only switched (back, if disabled)
+      // when it differs, as switching fails while another connection has it open.
+      if (g_advancedSettings.m_sqliteWAL)
+        m_pDS->exec(PrepareSQL("PRAGMA wal_autocheckpoint=%i\n", WAL_AUTOCHECKPOINT_PAGES));
+      CSingleLock lock(s_journalModeSection);
+      if (s_journalModeChecked.insert(URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase())).second)
+      {
+        CStdString mode = g_advancedSettings.m_sqliteWAL ? "wal" : "delete";
+        CStdString current;
+        if (m_pDS->query("PRAGMA journal_mode\n") && !m_pDS->eof())
+          current = m_pDS->fv(0).get_asString();
+        m_pDS->close();
+        if (!current.Equals(mode))
+        {
+          try
+          {
+            m_pDS->exec(PrepareSQL("PRAGMA journal_mode=%s\n", mode.c_str()));
+          }
+          catch (DbErrors &error)
+          {
+            CLog::Log(LOGWARNING, "%s - unable to switch %s from journal_mode %s to %s: %s", __FUNCTION__,
+                      m_pDB->getDatabase(), current.c_str(), mode.c_str(), error.getMsg());
+          }
+        }
+      }
+      lock.Leave();
+      // ignored by sqlite versions without memory mapped I/O
+      m_pDS->exec(PrepareSQL("PRAGMA mmap_size=%u\n", g_advancedSettings.m_sqliteMmapSize));
     }
   }
   catch (DbErrors &error)
@@ -511,6 +616,11 @@ void CDatabase::Close()
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
   m_pDB->disconnect();
+
+  // we're idle with this database now, so fold its write-ahead log back in
+  if (m_sqlite && g_advancedSettings.m_sqliteWAL)
+    CDatabaseCheckpointJob::Queue(URIUtils::AddFileToFolder(m_pDB->getHostName(), m_pDB->getDatabase()));
+
   m_pDB.reset();
   m_pDS.reset();
   m_pDS2.reset();
@@ -46,7 +46,7 @@ public:
 
   void BeginTransaction();
   virtual bool CommitTransaction();
-  void RollbackTransaction();
+  virtual void RollbackTransaction();
   bool InTransaction();
 
   static CStdString FormatSQL(CStdString strStmt, ...);
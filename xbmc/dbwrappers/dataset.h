@@ -107,6 +107,8 @@ public:
   const char *getSequenceTable(void) { return sequence_table.c_str(); }
 /* Get the default character set */
   const char *getDefaultCharset(void) { return default_charset.c_str(); }
+/* sets a read-only replica that queries may be routed to (not supported by all backends) */
+  virtual void setReplica(const char *newHost, const char *newPort) {}
 
 /* virtual methods that must be overloaded in derived classes */
 
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <string>
 #include <set>
+#include <algorithm>
 
 #include "utils/log.h"
 #include "system.h" // for GetLastError()
@@ -29,6 +30,8 @@
 #ifdef HAS_MYSQL
 #include "mysqldataset.h"
 #include "mysql/errmsg.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #ifdef _WIN32
 #pragma comment(lib, "mysqlclient.lib")
 #endif
@@ -37,10 +40,113 @@
 #define MYSQL_OK          0
 #define ER_BAD_DB_ERROR   1049
 
+// idle connections are closed after this long in the pool
+#define POOL_IDLE_TIMEOUT_MS   60000
+// maximum number of idle connections kept per server/login
+#define POOL_MAX_IDLE          4
+// after a write by any connection of this process, reads stay on the primary for this long so we see our own changes
+#define REPLICA_WRITE_GRACE_MS 10000
+
 using namespace std;
 
 namespace dbiplus {
 
+//************* MysqlConnectionPool implementation ***************
+
+MysqlConnectionPool &MysqlConnectionPool::Get() {
+  static MysqlConnectionPool pool;
+  return pool;
+}
+
+MysqlConnectionPool::~MysqlConnectionPool() {
+  Evict(true);
+}
+
+string MysqlConnectionPool::MakeKey(const string &host, const string &port,
+                                    const string &login, const string &passwd) {
+  return host + ":" + port + "|" + login + "|" + passwd;
+}
+
+MYSQL *MysqlConnectionPool::Acquire(const string &host, const string &port,
+                                    const string &login, const string &passwd, string &charset) {
+  string key = MakeKey(host, port, login, passwd);
+  MYSQL *conn = NULL;
+  {
+    CSingleLock lock(m_section);
+    Evict();
+    // take the most recently released connection, it's the least likely to have timed out
+    for (vector<IdleConnection>::reverse_iterator i = m_idle.rbegin(); i != m_idle.rend(); ++i)
+    {
+      if (i->key == key)
+      {
+        conn = i->conn;
+        charset = i->charset;
+        m_idle.erase(--(i.base()));
+        break;
+      }
+    }
+  }
+  // health check outside of the lock, as it's a round trip to the server
+  if (conn && mysql_ping(conn) != 0)
+  {
+    CLog::Log(LOGDEBUG, "%s - dropping stale pooled connection to %s", __FUNCTION__, host.c_str());
+    mysql_close(conn);
+    conn = NULL;
+  }
+  return conn;
+}
+
+void MysqlConnectionPool::Release(MYSQL *conn, const string &host, const string &port,
+                                  const string &login, const string &passwd, const string &charset) {
+  if (conn == NULL)
+    return;
+
+  IdleConnection idle;
+  idle.key = MakeKey(host, port, login, passwd);
+  idle.conn = conn;
+  idle.charset = charset;
+  idle.released = XbmcThreads::SystemClockMillis();
+
+  CSingleLock lock(m_section);
+  unsigned int count = 0;
+  for (vector<IdleConnection>::const_iterator i = m_idle.begin(); i != m_idle.end(); ++i)
+    if (i->key == idle.key)
+      count++;
+  if (count >= POOL_MAX_IDLE)
+  {
+    mysql_close(conn);
+    return;
+  }
+  m_idle.push_back(idle);
+}
+
+void MysqlConnectionPool::Evict(bool all) {
+  CSingleLock lock(m_section);
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  for (vector<IdleConnection>::iterator i = m_idle.begin(); i != m_idle.end();)
+  {
+    if (all || now - i->released > POOL_IDLE_TIMEOUT_MS)
+    {
+      mysql_close(i->conn);
+      i = m_idle.erase(i);
+    }
+    else
+      ++i;
+  }
+}
+
+void MysqlConnectionPool::SetWritten(const string &host, const string &port, const string &db) {
+  CSingleLock lock(m_section);
+  // 0 means "never written"
+  m_lastWrite[host + ":" + port + "|" + db] = std::max(XbmcThreads::SystemClockMillis(), 1u);
+}
+
+bool MysqlConnectionPool::WrittenWithin(const string &host, const string &port, const string &db, unsigned int ms) {
+  CSingleLock lock(m_section);
+  map<string, unsigned int>::const_iterator i = m_lastWrite.find(host + ":" + port + "|" + db);
+  return i != m_lastWrite.end() && XbmcThreads::SystemClockMillis() - i->second < ms;
+}
+
 //************* MysqlDatabase implementation ***************
 
 MysqlDatabase::MysqlDatabase() {
@@ -55,6 +161,7 @@ MysqlDatabase::MysqlDatabase() {
   login = "root";
   passwd = "null";
   conn = NULL;
+  read_conn = NULL;
   default_charset = "";
 }
 
@@ -117,21 +224,33 @@ int MysqlDatabase::connect(bool create_new) {
   {
     disconnect();
 
+    // reuse an already authenticated connection if we have one
+    bool pooled = false;
+    if (conn == NULL)
+    {
+      conn = MysqlConnectionPool::Get().Acquire(host, port, login, passwd, default_charset);
+      pooled = conn != NULL;
+    }
+
     if (conn == NULL)
       conn = mysql_init(conn);
 
     // establish connection with just user credentials
-    if (mysql_real_connect(conn, host.c_str(),login.c_str(),passwd.c_str(), NULL, atoi(port.c_str()),NULL,0) != NULL)
+    if (pooled || mysql_real_connect(conn, host.c_str(),login.c_str(),passwd.c_str(), NULL, atoi(port.c_str()),NULL,0) != NULL)
     {
       // disable mysql autocommit since we handle it
       //mysql_autocommit(conn, false);
 
-      // enforce utf8 charset usage
-      default_charset = mysql_character_set_name(conn);
-      if(mysql_set_character_set(conn, "utf8")) // returns 0 on success
+      // enforce utf8 charset usage (pooled connections already have it set, and
+      // hand back the charset they were given along with them)
+      if (!pooled)
       {
-        CLog::Log(LOGERROR, "Unable to set utf8 charset: %s [%d](%s)",
-                  db.c_str(), mysql_errno(conn), mysql_error(conn));
+        default_charset = mysql_character_set_name(conn);
+        if(mysql_set_character_set(conn, "utf8")) // returns 0 on success
+        {
+          CLog::Log(LOGERROR, "Unable to set utf8 charset: %s [%d](%s)",
+                    db.c_str(), mysql_errno(conn), mysql_error(conn));
+        }
       }
 
       // check existence
@@ -154,6 +273,7 @@ int MysqlDatabase::connect(bool create_new) {
       if (mysql_select_db(conn, db.c_str()) == 0)
       {
         active = true;
+        connectReplica();
         return DB_CONNECTION_OK;
       }
     }
@@ -186,13 +306,76 @@ int MysqlDatabase::connect(bool create_new) {
 void MysqlDatabase::disconnect(void) {
   if (conn != NULL)
   {
-    mysql_close(conn);
+    // only hand back connections that are known to be in a clean state
+    if (active && !_in_transaction)
+      MysqlConnectionPool::Get().Release(conn, host, port, login, passwd, default_charset);
+    else
+      mysql_close(conn);
     conn = NULL;
   }
+  if (read_conn != NULL)
+  {
+    if (active)
+      MysqlConnectionPool::Get().Release(read_conn, replica_host, replica_port, login, passwd, replica_charset);
+    else
+      mysql_close(read_conn);
+    read_conn = NULL;
+  }
 
   active = false;
 }
 
+void MysqlDatabase::setReplica(const char *newHost, const char *newPort) {
+  replica_host = newHost;
+  replica_port = (newPort && *newPort) ? newPort : port;
+}
+
+void MysqlDatabase::connectReplica() {
+  if (replica_host.empty() || read_conn != NULL)
+    return;
+
+  read_conn = MysqlConnectionPool::Get().Acquire(replica_host, replica_port, login, passwd, replica_charset);
+  if (read_conn == NULL)
+  {
+    read_conn = mysql_init(NULL);
+    bool connected = mysql_real_connect(read_conn, replica_host.c_str(), login.c_str(), passwd.c_str(), NULL, atoi(replica_port.c_str()), NULL, 0) != NULL;
+    if (connected)
+      replica_charset = mysql_character_set_name(read_conn);
+    if (!connected || mysql_set_character_set(read_conn, "utf8") != 0)
+    {
+      CLog::Log(LOGWARNING, "Unable to connect to replica %s, reading from the primary: [%d](%s)",
+                replica_host.c_str(), mysql_errno(read_conn), mysql_error(read_conn));
+      dropReplica();
+      return;
+    }
+  }
+  if (mysql_select_db(read_conn, db.c_str()) != 0)
+  {
+    CLog::Log(LOGWARNING, "Unable to open database %s on replica %s, reading from the primary",
+              db.c_str(), replica_host.c_str());
+    dropReplica();
+  }
+}
+
+void MysqlDatabase::dropReplica() {
+  if (read_conn != NULL)
+  {
+    mysql_close(read_conn);
+    read_conn = NULL;
+  }
+}
+
+MYSQL *MysqlDatabase::getReadHandle() {
+  if (read_conn == NULL || _in_transaction ||
+      MysqlConnectionPool::Get().WrittenWithin(host, port, db, REPLICA_WRITE_GRACE_MS))
+    return conn;
+  return read_conn;
+}
+
+void MysqlDatabase::setWritten() {
+  MysqlConnectionPool::Get().SetWritten(host, port, db);
+}
+
 int MysqlDatabase::create() {
   return connect(true);
 }
@@ -1227,6 +1410,7 @@ void MysqlDataset::make_query(StringList &_sql) {
   {
     if (autocommit) db->start_transaction();
 
+    static_cast<MysqlDatabase *>(db)->setWritten();
     for (list<string>::iterator i =_sql.begin(); i!=_sql.end(); i++)
     {
       query = *i;
@@ -1370,6 +1554,7 @@ int MysqlDataset::exec(const string &sql) {
 
   CLog::Log(LOGDEBUG,"Mysql execute: %s", qry.c_str());
 
+  static_cast<MysqlDatabase *>(db)->setWritten();
   if (db->setErr( static_cast<MysqlDatabase *>(db)->query_with_reconnect(qry.c_str()), qry.c_str()) != MYSQL_OK)
   {
     throw DbErrors(db->getErrorMsg());
@@ -1402,10 +1587,23 @@ bool MysqlDataset::query(const char *query) {
 
   MYSQL_RES *stmt = NULL;
 
-  if ( static_cast<MysqlDatabase*>(db)->setErr(static_cast<MysqlDatabase*>(db)->query_with_reconnect(query), query) != MYSQL_OK )
-    throw DbErrors(db->getErrorMsg());
+  // selects may be served by the replica, falling back to the primary if it fails
+  MysqlDatabase *mysqldb = static_cast<MysqlDatabase*>(db);
+  MYSQL* conn = mysqldb->getReadHandle();
+  if (conn != handle() && mysql_real_query(conn, query, strlen(query)) != MYSQL_OK)
+  {
+    CLog::Log(LOGWARNING, "Mysql query failed on replica (%s), using the primary", mysql_error(conn));
+    mysqldb->dropReplica();
+    conn = handle();
+  }
 
-  MYSQL* conn = handle();
+  if (conn == handle())
+  {
+    if (mysqldb->setErr(mysqldb->query_with_reconnect(query), query) != MYSQL_OK)
+      throw DbErrors(db->getErrorMsg());
+    // query_with_reconnect may have replaced the connection
+    conn = handle();
+  }
   stmt = mysql_store_result(conn);
 
   // column headers
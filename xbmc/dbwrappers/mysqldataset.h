@@ -23,10 +23,60 @@
 #define _MYSQLDATASET_H
 
 #include <stdio.h>
+#include <map>
+#include <vector>
 #include "dataset.h"
+#include "threads/CriticalSection.h"
 #include "mysql/mysql.h"
 
 namespace dbiplus {
+/***************** Class MysqlConnectionPool definition ************
+
+       class 'MysqlConnectionPool' keeps idle, authenticated
+       connections to MySQL-servers so they can be reused by
+       later MysqlDatabase instances instead of reconnecting.
+       It also tracks when each database was last written to
+       by this process, so that no connection reads it from a
+       replica that may not have caught up yet
+
+******************************************************************/
+class MysqlConnectionPool {
+public:
+  static MysqlConnectionPool &Get();
+
+/* func. returns a healthy idle connection for the given server and credentials, or NULL,
+   along with the character set the server gave it before it was switched to utf8 */
+  MYSQL *Acquire(const std::string &host, const std::string &port,
+                 const std::string &login, const std::string &passwd, std::string &charset);
+/* func. hands a connection back to the pool, closing it if the pool is full */
+  void Release(MYSQL *conn, const std::string &host, const std::string &port,
+               const std::string &login, const std::string &passwd, const std::string &charset);
+/* func. closes connections that have been idle for too long (or all of them) */
+  void Evict(bool all = false);
+/* func. records that a database has been modified through any connection of this process */
+  void SetWritten(const std::string &host, const std::string &port, const std::string &db);
+/* func. returns whether a database was modified by this process within the last ms milliseconds */
+  bool WrittenWithin(const std::string &host, const std::string &port, const std::string &db, unsigned int ms);
+
+private:
+  MysqlConnectionPool() {}
+  ~MysqlConnectionPool();
+
+  struct IdleConnection
+  {
+    std::string key;
+    MYSQL *conn;
+    std::string charset;
+    unsigned int released;
+  };
+  static std::string MakeKey(const std::string &host, const std::string &port,
+                             const std::string &login, const std::string &passwd);
+
+  std::vector<IdleConnection> m_idle;
+  std::map<std::string, unsigned int> m_lastWrite;
+  CCriticalSection m_section;
+};
+
 /***************** Class MysqlDatabase definition ******************
 
        class 'MysqlDatabase' connects with MySQL-server
@@ -36,6 +86,9 @@ class MysqlDatabase: public Database {
 protected:
 /* connect descriptor */
   MYSQL* conn;
+/* optional read-only replica descriptor */
+  MYSQL* read_conn;
+  std::string replica_host, replica_port, replica_charset;
   bool _in_transaction;
   int last_err;
 
@@ -50,6 +103,14 @@ public:
 
 /* func. returns connection handle with MySQL-server */
   MYSQL *getHandle() {  return conn; }
+/* func. returns the connection handle read-only queries should use */
+  MYSQL *getReadHandle();
+/* func. drops the replica connection after a failure, reads go to the primary */
+  void dropReplica();
+/* func. records that data has been modified, keeping reads of this database by all connections on the primary for a while */
+  void setWritten();
+
+  virtual void setReplica(const char *newHost, const char *newPort);
 /* func. returns current status about MySQL-server connection */
   virtual int status();
   virtual int setErr(int err_code,const char * qry);
@@ -84,6 +145,10 @@ public:
   bool in_transaction() {return _in_transaction;};
   int query_with_reconnect(const char* query);
 
+protected:
+/* func. opens the read-only replica connection, if one is configured */
+  void connectReplica();
+
 private:
 
   typedef struct StrAccum StrAccum;
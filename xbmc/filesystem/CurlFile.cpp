@@ -328,6 +328,7 @@ CCurlFile::CCurlFile()
   m_httpauth = "";
   m_state = new CReadState();
   m_skipshout = false;
+  m_httpresponse = -1;
 }
 
 //Has to be called before Open()
@@ -839,6 +840,7 @@ bool CCurlFile::Open(const CURL& url)
   SetRequestHeaders(m_state);
 
   long response = m_state->Connect(m_bufferSize);
+  m_httpresponse = response;
   if( response < 0 || response >= 400)
     return false;
 
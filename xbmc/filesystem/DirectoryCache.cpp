@@ -33,6 +33,8 @@ using namespace XFILE;
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
+  m_pins = 0;
+  m_lookups = 0;
   m_lastAccess = 0;
   m_Items = new CFileItemList;
   m_Items->SetFastLookup(true);
@@ -107,11 +109,21 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
+  // a directory that is listed again stays pinned
+  unsigned int pins = 0, lookups = 0;
+  iCache i = m_cache.find(storedPath);
+  if (i != m_cache.end())
+  {
+    pins = i->second->m_pins;
+    lookups = i->second->m_lookups;
+    Delete(i);
+  }
 
   CheckIfFull();
 
   CDir* dir = new CDir(cacheType);
+  dir->m_pins = pins;
+  dir->m_lookups = lookups;
   dir->m_Items->Copy(items);
   dir->SetLastAccess(m_accessCounter);
   m_cache.insert(pair<CStdString, CDir*>(storedPath, dir));
@@ -187,6 +199,8 @@ bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache)
     bInCache = true;
     CDir *dir = i->second;
     dir->SetLastAccess(m_accessCounter);
+    if (dir->m_pins)
+      dir->m_lookups++;
 #ifdef _DEBUG
     m_cacheHits++;
 #endif
@@ -242,8 +256,8 @@ void CDirectoryCache::CheckIfFull()
   unsigned int numCached = 0;
   for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
+    // ensure dirs that are always cached or are pinned aren't cleared
+    if (i->second->m_cacheType != DIR_CACHE_ALWAYS && !i->second->m_pins)
     {
       if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
         lastAccessed = i;
@@ -254,6 +268,43 @@ void CDirectoryCache::CheckIfFull()
     Delete(lastAccessed);
 }
 
+bool CDirectoryCache::PinDirectory(const CStdString& strPath)
+{
+  CSingleLock lock (m_cs);
+
+  CStdString storedPath = URIUtils::SubstitutePath(strPath);
+  URIUtils::RemoveSlashAtEnd(storedPath);
+
+  iCache i = m_cache.find(storedPath);
+  if (i == m_cache.end())
+    return false;
+
+  i->second->m_pins++;
+  return true;
+}
+
+unsigned int CDirectoryCache::UnpinDirectory(const CStdString& strPath)
+{
+  CSingleLock lock (m_cs);
+
+  CStdString storedPath = URIUtils::SubstitutePath(strPath);
+  URIUtils::RemoveSlashAtEnd(storedPath);
+
+  iCache i = m_cache.find(storedPath);
+  if (i == m_cache.end() || !i->second->m_pins)
+    return 0; // cleared while pinned
+
+  CDir *dir = i->second;
+  unsigned int lookups = dir->m_lookups;
+  if (--dir->m_pins == 0)
+  {
+    dir->m_lookups = 0;
+    if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+      Delete(i); // done with, and would only be evicted anyway
+  }
+  return lookups;
+}
+
 void CDirectoryCache::Delete(iCache it)
 {
   CDir* dir = it->second;
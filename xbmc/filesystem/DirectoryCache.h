@@ -44,6 +44,8 @@ namespace XFILE
 
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
+      unsigned int m_pins;     ///< number of PinDirectory() calls yet to be matched by UnpinDirectory()
+      unsigned int m_lookups;  ///< FileExists() calls answered while pinned
     private:
       unsigned int m_lastAccess;
     };
@@ -58,6 +60,19 @@ namespace XFILE
     void Clear();
     void AddFile(const CStdString& strFile);
     bool FileExists(const CStdString& strPath, bool& bInCache);
+
+    /*! \brief Keep the cached listing of a directory from being evicted, so that files in it can be
+     checked for (by CFile::Exists() for instance) without going to the filesystem.
+     The listing is still dropped if the directory is cleared, eg because a file in it was written.
+     \param strPath the directory, which should just have been listed with CDirectory::GetDirectory().
+     \return true if the directory is cached and is now pinned, in which case UnpinDirectory() must be called.
+     */
+    bool PinDirectory(const CStdString& strPath);
+
+    /*! \brief Allow the listing of a directory pinned with PinDirectory() to be evicted again.
+     \return the number of lookups of files in the directory answered from the cache while it was pinned.
+     */
+    unsigned int UnpinDirectory(const CStdString& strPath);
 #ifdef _DEBUG
     void PrintStats() const;
 #endif
@@ -0,0 +1,413 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "HttpCache.h"
+#include "CurlFile.h"
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/HttpHeader.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+
+using namespace std;
+using namespace XFILE;
+
+#define HTTPCACHE_INDEX            "index.xml"
+#define HTTPCACHE_SAVE_INTERVAL    10000  // ms between writes of the index
+#define HTTPCACHE_MAX_HEURISTIC    86400  // s a response without explicit freshness may be served for
+#define HTTPCACHE_STATS_INTERVAL   100    // requests between logging statistics
+
+CHttpCache::CHttpCache()
+{
+  m_loaded = false;
+  m_dirty = false;
+  m_lastSave = 0;
+  m_accessCounter = 0;
+  m_size = 0;
+  m_requests = 0;
+  m_hits = 0;
+  m_revalidated = 0;
+  m_stale = 0;
+  m_stored = 0;
+  m_bytesServed = 0;
+}
+
+CHttpCache::~CHttpCache()
+{
+}
+
+CHttpCache &CHttpCache::Get()
+{
+  static CHttpCache s_cache;
+  return s_cache;
+}
+
+bool CHttpCache::Fetch(CCurlFile &http, const CStdString &url, CStdString &data, bool revalidate /* = false */)
+{
+  if (g_advancedSettings.m_httpCacheSize <= 0)
+    return http.Get(url, data);
+
+  CStdString key = XBMC::XBMC_MD5::GetMD5(url);
+  CacheEntry entry;
+  bool cached = false;
+  {
+    CSingleLock lock(m_section);
+    Load();
+
+    if (++m_requests % HTTPCACHE_STATS_INTERVAL == 0)
+      LogStats();
+
+    CacheMap::iterator i = m_entries.find(key);
+    if (i != m_entries.end() && i->second.url == url)
+    {
+      if (!revalidate && i->second.expires > time(NULL) && ReadBody(key, data))
+      {
+        i->second.lastAccess = ++m_accessCounter;
+        m_dirty = true;
+        m_hits++;
+        m_bytesServed += data.size();
+        return true;
+      }
+      entry = i->second;
+      cached = true;
+    }
+  }
+
+  // don't hold the lock while we're on the network
+  if (cached)
+  {
+    if (!entry.etag.IsEmpty())
+      http.SetRequestHeader("If-None-Match", entry.etag);
+    if (!entry.lastModified.IsEmpty())
+      http.SetRequestHeader("If-Modified-Since", entry.lastModified);
+  }
+  CStdString body;
+  bool fetched = http.Get(url, body);
+  http.RemoveRequestHeader("If-None-Match");
+  http.RemoveRequestHeader("If-Modified-Since");
+  int response = http.GetResponseCode();
+
+  CSingleLock lock(m_section);
+  if (cached && fetched && response == 304)
+  {
+    CacheMap::iterator i = m_entries.find(key);
+    if (i != m_entries.end() && ReadBody(key, data))
+    { // still valid - the 304 may carry new freshness and validators
+      const CHttpHeader &headers = http.GetHttpHeader();
+      SetFreshness(i->second, headers);
+      if (!headers.GetValue("ETag").IsEmpty())
+        i->second.etag = headers.GetValue("ETag");
+      if (!headers.GetValue("Last-Modified").IsEmpty())
+        i->second.lastModified = headers.GetValue("Last-Modified");
+      i->second.lastAccess = ++m_accessCounter;
+      m_dirty = true;
+      m_revalidated++;
+      m_bytesServed += data.size();
+      return true;
+    }
+
+    // the cached response has gone, so fetch it again in full
+    Remove(key);
+    lock.Leave();
+    return http.Get(url, data);
+  }
+
+  if (!fetched)
+  {
+    if (cached && response < 0 && !entry.mustRevalidate && ReadBody(key, data))
+    {
+      CLog::Log(LOGDEBUG, "%s - %s couldn't be fetched, using the stale cached response", __FUNCTION__, url.c_str());
+      m_stale++;
+      m_bytesServed += data.size();
+      return true;
+    }
+    return false;
+  }
+
+  data = body;
+  if (response == 200)
+    Store(key, url, http.GetHttpHeader(), data);
+  return true;
+}
+
+void CHttpCache::Store(const CStdString &key, const CStdString &url, const CHttpHeader &headers, const CStdString &data)
+{
+  Remove(key);
+
+  CStdString cacheControl(headers.GetValue("Cache-Control"));
+  cacheControl.ToLower();
+  if (cacheControl.Find("no-store") >= 0)
+    return;
+
+  // we don't keep track of the request headers a response varies on, other than the encoding
+  CStdString vary(headers.GetValue("Vary"));
+  if (!vary.IsEmpty() && !vary.Equals("Accept-Encoding"))
+    return;
+
+  uint64_t maxSize = (uint64_t)g_advancedSettings.m_httpCacheSize * 1024 * 1024;
+  if (data.size() > maxSize / 4)
+    return;
+
+  CacheEntry entry;
+  entry.url = url;
+  entry.etag = headers.GetValue("ETag");
+  entry.lastModified = headers.GetValue("Last-Modified");
+  SetFreshness(entry, headers);
+  if (entry.expires <= time(NULL) && entry.etag.IsEmpty() && entry.lastModified.IsEmpty())
+    return; // can neither be served as is nor revalidated
+
+  CFile file;
+  if (!file.OpenForWrite(GetCacheFile(key), true))
+    return;
+  bool written = file.Write(data.c_str(), data.size()) == (int)data.size();
+  file.Close();
+  if (!written)
+  {
+    CFile::Delete(GetCacheFile(key));
+    return;
+  }
+
+  entry.size = data.size();
+  entry.lastAccess = ++m_accessCounter;
+  m_entries[key] = entry;
+  m_size += entry.size;
+  m_stored++;
+  m_dirty = true;
+
+  Evict();
+  if (XbmcThreads::SystemClockMillis() - m_lastSave > HTTPCACHE_SAVE_INTERVAL)
+    Save();
+}
+
+void CHttpCache::Remove(const CStdString &key)
+{
+  CacheMap::iterator i = m_entries.find(key);
+  if (i == m_entries.end())
+    return;
+
+  CFile::Delete(GetCacheFile(key));
+  m_size -= i->second.size;
+  m_entries.erase(i);
+  m_dirty = true;
+}
+
+void CHttpCache::Evict()
+{
+  uint64_t maxSize = (uint64_t)g_advancedSettings.m_httpCacheSize * 1024 * 1024;
+  while (m_size > maxSize && !m_entries.empty())
+  {
+    CacheMap::iterator oldest = m_entries.begin();
+    for (CacheMap::iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+    {
+      if (i->second.lastAccess < oldest->second.lastAccess)
+        oldest = i;
+    }
+    Remove(oldest->first);
+  }
+}
+
+bool CHttpCache::ReadBody(const CStdString &key, CStdString &data)
+{
+  CFile file;
+  if (!file.Open(GetCacheFile(key)))
+    return false;
+
+  int64_t length = file.GetLength();
+  data.clear();
+  if (length > 0)
+  {
+    data.resize((size_t)length);
+    if (file.Read(&data[0], length) != length)
+    {
+      data.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void CHttpCache::SetFreshness(CacheEntry &entry, const CHttpHeader &headers)
+{
+  time_t now = time(NULL);
+  CStdString cacheControl(headers.GetValue("Cache-Control"));
+  cacheControl.ToLower();
+  entry.mustRevalidate = cacheControl.Find("must-revalidate") >= 0;
+
+  time_t lifetime = 0;
+  time_t date, expires, modified;
+  if (!ParseHTTPDate(headers.GetValue("Date"), date))
+    date = now;
+
+  int maxAge = cacheControl.Find("max-age=");
+  if (cacheControl.Find("no-cache") >= 0)
+    lifetime = 0;
+  else if (maxAge >= 0)
+    lifetime = atoi(cacheControl.c_str() + maxAge + 8);
+  else if (ParseHTTPDate(headers.GetValue("Expires"), expires))
+    lifetime = expires - date;
+  else if (ParseHTTPDate(headers.GetValue("Last-Modified"), modified))
+  { // a tenth of the age of the response, as suggested by RFC 2616
+    lifetime = std::min((time_t)HTTPCACHE_MAX_HEURISTIC, (date - modified) / 10);
+  }
+
+  entry.expires = now + std::max((time_t)0, lifetime);
+}
+
+bool CHttpCache::ParseHTTPDate(const CStdString &date, time_t &time)
+{
+  // RFC 1123 dates, eg "Sun, 06 Nov 1994 08:49:37 GMT"
+  static const char *months[] = { "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec" };
+
+  int day, year, hour, minute, second;
+  char name[4];
+  if (date.IsEmpty() || sscanf(date.c_str(), "%*[^,], %d %3s %d %d:%d:%d", &day, name, &year, &hour, &minute, &second) != 6)
+    return false;
+
+  int month = 0;
+  while (month < 12 && !CStdString(name).Equals(months[month]))
+    month++;
+  if (month == 12 || year < 1970)
+    return false;
+  month++;
+
+  // days since the epoch of the given (proleptic gregorian) date
+  int y = year - (month <= 2 ? 1 : 0);
+  int era = y / 400;
+  int yearOfEra = y - era * 400;
+  int dayOfYear = (153 * ((month + 9) % 12) + 2) / 5 + day - 1;
+  int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  int64_t days = (int64_t)era * 146097 + dayOfEra - 719468;
+
+  time = (time_t)(days * 86400 + hour * 3600 + minute * 60 + second);
+  return true;
+}
+
+CStdString CHttpCache::GetCacheFile(const CStdString &key) const
+{
+  return URIUtils::AddFileToFolder(m_cachePath, key);
+}
+
+void CHttpCache::Load()
+{
+  if (m_loaded)
+    return;
+  m_loaded = true;
+
+  m_cachePath = URIUtils::AddFileToFolder(g_advancedSettings.m_cachePath, "httpcache/");
+  if (!CDirectory::Exists(m_cachePath))
+    CDirectory::Create(m_cachePath);
+
+  CXBMCTinyXML doc;
+  if (doc.LoadFile(URIUtils::AddFileToFolder(m_cachePath, HTTPCACHE_INDEX)) && doc.RootElement())
+  {
+    for (TiXmlElement *element = doc.RootElement()->FirstChildElement("entry"); element; element = element->NextSiblingElement("entry"))
+    {
+      const char *key = element->Attribute("key");
+      const char *url = element->Attribute("url");
+      if (!key || !url)
+        continue;
+
+      CacheEntry entry;
+      entry.url = url;
+      if (element->Attribute("etag"))
+        entry.etag = element->Attribute("etag");
+      if (element->Attribute("lastmodified"))
+        entry.lastModified = element->Attribute("lastmodified");
+      int value = 0;
+      element->QueryIntAttribute("expires", &value);
+      entry.expires = value;
+      value = 0;
+      element->QueryIntAttribute("mustrevalidate", &value);
+      entry.mustRevalidate = value != 0;
+      value = 0;
+      element->QueryIntAttribute("size", &value);
+      entry.size = value;
+      value = 0;
+      element->QueryIntAttribute("lastaccess", &value);
+      entry.lastAccess = value;
+
+      m_entries[key] = entry;
+      m_size += entry.size;
+      m_accessCounter = std::max(m_accessCounter, entry.lastAccess);
+    }
+  }
+
+  // remove responses that were stored after the index was last written
+  CFileItemList items;
+  CDirectory::GetDirectory(m_cachePath, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO | DIR_FLAG_BYPASS_CACHE);
+  for (int i = 0; i < items.Size(); i++)
+  {
+    CStdString name = URIUtils::GetFileName(items[i]->GetPath());
+    if (!items[i]->m_bIsFolder && !name.Equals(HTTPCACHE_INDEX) && m_entries.find(name) == m_entries.end())
+      CFile::Delete(items[i]->GetPath());
+  }
+
+  Evict();
+  CLog::Log(LOGDEBUG, "%s - %u responses (%"PRIu64" bytes) in the cache", __FUNCTION__, (unsigned int)m_entries.size(), m_size);
+}
+
+void CHttpCache::Save()
+{
+  CXBMCTinyXML doc;
+  TiXmlElement root("httpcache");
+  for (CacheMap::const_iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+  {
+    TiXmlElement element("entry");
+    element.SetAttribute("key", i->first.c_str());
+    element.SetAttribute("url", i->second.url.c_str());
+    if (!i->second.etag.IsEmpty())
+      element.SetAttribute("etag", i->second.etag.c_str());
+    if (!i->second.lastModified.IsEmpty())
+      element.SetAttribute("lastmodified", i->second.lastModified.c_str());
+    element.SetAttribute("expires", (int)i->second.expires);
+    element.SetAttribute("mustrevalidate", i->second.mustRevalidate ? 1 : 0);
+    element.SetAttribute("size", (int)i->second.size);
+    element.SetAttribute("lastaccess", (int)i->second.lastAccess);
+    root.InsertEndChild(element);
+  }
+  doc.InsertEndChild(root);
+
+  if (doc.SaveFile(URIUtils::AddFileToFolder(m_cachePath, HTTPCACHE_INDEX)))
+    m_dirty = false;
+  m_lastSave = XbmcThreads::SystemClockMillis();
+}
+
+void CHttpCache::Flush()
+{
+  CSingleLock lock(m_section);
+  if (m_loaded && m_dirty)
+    Save();
+}
+
+void CHttpCache::LogStats()
+{
+  CSingleLock lock(m_section);
+  unsigned int served = m_hits + m_revalidated + m_stale;
+  CLog::Log(LOGDEBUG, "%s - %u requests, %u served from the cache (%u fresh, %u revalidated, %u stale, %.1f%%), %"PRIu64" bytes served, %u stored",
+            __FUNCTION__, m_requests, served, m_hits, m_revalidated, m_stale,
+            m_requests ? 100.0f * served / m_requests : 0.0f, m_bytesServed, m_stored);
+}
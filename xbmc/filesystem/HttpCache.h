@@ -0,0 +1,113 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "utils/StdString.h"
+
+#include <map>
+
+class CHttpHeader;
+
+namespace XFILE
+{
+  class CCurlFile;
+
+  /*!
+   \brief On-disk cache of http responses, shared by scrapers, RSS feeds and add-on repositories.
+
+   Responses to GET requests are kept under the cache path along with their validators (ETag
+   and Last-Modified) and how long they stay fresh, as given by Cache-Control or Expires, or
+   guessed from Last-Modified. A fresh response is served without a request. A stale one is
+   revalidated with a conditional request, and served from the cache if the server answers
+   304 Not Modified, or if the server can't be reached and the response doesn't have to be
+   revalidated.
+
+   The cache is limited to <network><httpcachesize> MB (advancedsettings.xml), evicting the
+   least recently used responses first. 0 disables it.
+   */
+  class CHttpCache
+  {
+  public:
+    static CHttpCache &Get();
+
+    /*! \brief Fetch a url through the cache.
+     \param http the curl file to fetch with, set up with any user agent, referer, encoding etc.
+     \param url the url to fetch.
+     \param data [out] the body of the response.
+     \param revalidate whether a cached response must be revalidated even while it is fresh, for small
+     responses that must be current such as a repository's checksum. Defaults to false.
+     \return true if the url was fetched, as for CCurlFile::Get().
+     */
+    bool Fetch(CCurlFile &http, const CStdString &url, CStdString &data, bool revalidate = false);
+
+    /*! \brief Write out the index of the cache, if it has changed since it was last written.
+     */
+    void Flush();
+
+    void LogStats();
+
+  private:
+    CHttpCache();
+    ~CHttpCache();
+
+    struct CacheEntry
+    {
+      CacheEntry() : expires(0), mustRevalidate(false), size(0), lastAccess(0) {};
+      CStdString url;
+      CStdString etag;
+      CStdString lastModified;
+      time_t expires;           ///< time until which the response is served without revalidating
+      bool mustRevalidate;      ///< whether a stale response may not be served when the server can't be reached
+      unsigned int size;
+      unsigned int lastAccess;
+    };
+    typedef std::map<CStdString, CacheEntry> CacheMap;
+
+    void Load();
+    void Save();
+    bool ReadBody(const CStdString &key, CStdString &data);
+    void Store(const CStdString &key, const CStdString &url, const CHttpHeader &headers, const CStdString &data);
+    void Remove(const CStdString &key);
+    void Evict();
+    CStdString GetCacheFile(const CStdString &key) const;
+
+    static void SetFreshness(CacheEntry &entry, const CHttpHeader &headers);
+    static bool ParseHTTPDate(const CStdString &date, time_t &time);
+
+    CCriticalSection m_section;
+    CacheMap m_entries;
+    CStdString m_cachePath;
+    bool m_loaded;
+    bool m_dirty;
+    unsigned int m_lastSave;
+    unsigned int m_accessCounter;
+    uint64_t m_size;
+
+    // statistics
+    unsigned int m_requests;
+    unsigned int m_hits;          ///< fresh responses served without a request
+    unsigned int m_revalidated;   ///< stale responses served after a 304
+    unsigned int m_stale;         ///< stale responses served as the server couldn't be reached
+    unsigned int m_stored;
+    uint64_t m_bytesServed;
+  };
+}
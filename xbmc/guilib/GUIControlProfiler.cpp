@@ -20,6 +20,7 @@
  */
 
 #include "GUIControlProfiler.h"
+#include "GUIInfoManager.h"
 #include "utils/XBMCTinyXML.h"
 #include "utils/TimeUtils.h"
 
@@ -239,7 +240,8 @@ CGUIControlProfilerItem *CGUIControlProfilerItem::FindOrAddControl(CGUIControl *
 }
 
 CGUIControlProfiler::CGUIControlProfiler(void)
-: m_ItemHead(NULL, NULL, NULL), m_pLastItem(NULL), m_iMaxFrameCount(200)
+: m_ItemHead(NULL, NULL, NULL), m_pLastItem(NULL), m_iMaxFrameCount(200),
+  m_boolEvaluationsStart(0), m_boolEvaluationsLast(0), m_boolEvaluationsMax(0)
 // m_bIsRunning(false), no isRunning because it is static
 {
   m_fPerfScale = 100000.0f / CurrentHostFrequency();
@@ -262,6 +264,8 @@ void CGUIControlProfiler::Start(void)
   m_bIsRunning = true;
   m_pLastItem = NULL;
   m_ItemHead.Reset(this);
+  m_boolEvaluationsStart = m_boolEvaluationsLast = g_infoManager.GetBoolEvaluations();
+  m_boolEvaluationsMax = 0;
 }
 
 void CGUIControlProfiler::BeginVisibility(CGUIControl *pControl)
@@ -319,6 +323,10 @@ CGUIControlProfilerItem *CGUIControlProfiler::FindOrAddControl(CGUIControl *pCon
 void CGUIControlProfiler::EndFrame(void)
 {
   m_iFrameCount++;
+  unsigned int evaluations = g_infoManager.GetBoolEvaluations();
+  if (evaluations - m_boolEvaluationsLast > m_boolEvaluationsMax)
+    m_boolEvaluationsMax = evaluations - m_boolEvaluationsLast;
+  m_boolEvaluationsLast = evaluations;
   if (m_iFrameCount >= m_iMaxFrameCount)
   {
     const unsigned int dwSize = m_ItemHead.m_vecChildren.size();
@@ -351,6 +359,14 @@ bool CGUIControlProfiler::SaveResults(void)
   root->SetAttribute("timeunit", "ms");
   doc.LinkEndChild(root);
 
+  // how many visibility conditions had to be re-evaluated, per frame
+  TiXmlElement *evaluations = new TiXmlElement("infoboolevaluations");
+  str.Format("%u", m_iFrameCount ? (m_boolEvaluationsLast - m_boolEvaluationsStart) / m_iFrameCount : 0);
+  evaluations->SetAttribute("average", str.c_str());
+  str.Format("%u", m_boolEvaluationsMax);
+  evaluations->SetAttribute("max", str.c_str());
+  root->LinkEndChild(evaluations);
+
   m_ItemHead.SaveToXML(root);
   return doc.SaveFile(m_strOutputFile);
 }
@@ -92,6 +92,11 @@ private:
   CStdString m_strOutputFile;
   int m_iMaxFrameCount;
   int m_iFrameCount;
+
+  // evaluations of boolean conditions by the info manager
+  unsigned int m_boolEvaluationsStart;
+  unsigned int m_boolEvaluationsLast;
+  unsigned int m_boolEvaluationsMax;
 };
 
 #define GUIPROFILER_VISIBILITY_BEGIN(x) { if (CGUIControlProfiler::IsRunning()) CGUIControlProfiler::Instance().BeginVisibility(x); }
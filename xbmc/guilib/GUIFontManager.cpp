@@ -25,6 +25,7 @@
 #include "addons/Skin.h"
 #include "GUIFontTTF.h"
 #include "GUIFont.h"
+#include "GUITextLayout.h"
 #include "utils/XMLUtils.h"
 #include "GUIControlFactory.h"
 #include "filesystem/File.h"
@@ -207,6 +208,9 @@ void GUIFontManager::ReloadTTFFonts(void)
   if (!m_vecFonts.size())
     return;   // we haven't even loaded fonts in yet
 
+  // text laid out with the old sizes is of no use
+  CGUITextLayout::ClearCache();
+
   for (unsigned int i = 0; i < m_vecFonts.size(); i++)
   {
     CGUIFont* font = m_vecFonts[i];
@@ -246,6 +250,7 @@ void GUIFontManager::Unload(const CStdString& strFontName)
   {
     if ((*iFont)->GetFontName() == strFontName)
     {
+      CGUITextLayout::ClearCache();
       delete (*iFont);
       m_vecFonts.erase(iFont);
       return;
@@ -327,6 +332,8 @@ CGUIFont* GUIFontManager::GetDefaultFont(bool border)
 
 void GUIFontManager::Clear()
 {
+  CGUITextLayout::ClearCache();
+
   for (int i = 0; i < (int)m_vecFonts.size(); ++i)
   {
     CGUIFont* pFont = m_vecFonts[i];
@@ -26,10 +26,12 @@
 #include "GraphicContext.h"
 #include "filesystem/SpecialProtocol.h"
 #include "utils/MathUtils.h"
+#include "utils/TimeUtils.h"
 #include "utils/log.h"
 #include "windowing/WindowingFactory.h"
 
 #include <math.h>
+#include <algorithm>
 
 // stuff for freetype
 #include <ft2build.h>
@@ -49,11 +51,30 @@ using namespace std;
 
 #define CHARS_PER_TEXTURE_LINE 20 // number of characters to cache per texture line
 #define CHAR_CHUNK    64      // 64 chars allocated at a time (1024 bytes)
+#define CHARACTER_ROW_EVICTED ((unsigned int)-1)  // row of characters whose row has been reused
+#define TEXT_CACHE_LIFETIME 2000  // ms the vertices of text are kept after it was last drawn
 
 int CGUIFontTTFBase::justification_word_weight = 6;   // weight of word spacing over letter spacing when justifying.
                                                   // A larger number means more of the "dead space" is placed between
                                                   // words rather than between letters.
 
+static uint32_t HashText(float x, float y, const vecColors &colors, const vecText &text, uint32_t alignment)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  uint32_t values[3];
+  memcpy(&values[0], &x, sizeof(float));
+  memcpy(&values[1], &y, sizeof(float));
+  values[2] = alignment;
+  for (int i = 0; i < 3; i++)
+    hash = (hash ^ values[i]) * 16777619u;
+  for (vecColors::const_iterator i = colors.begin(); i != colors.end(); ++i)
+    hash = (hash ^ *i) * 16777619u;
+  for (vecText::const_iterator i = text.begin(); i != text.end(); ++i)
+    hash = (hash ^ *i) * 16777619u;
+  return hash;
+}
+
 class CFreeTypeLibrary
 {
 public:
@@ -162,6 +183,9 @@ CGUIFontTTFBase::CGUIFontTTFBase(const CStdString& strFileName)
   m_color = 0;
   m_vertex_count = 0;
   m_nTexture = 0;
+  m_charsEvicted = false;
+  m_textCacheGeneration = 0;
+  m_textCachePruned = 0;
 }
 
 CGUIFontTTFBase::~CGUIFontTTFBase(void)
@@ -195,10 +219,13 @@ void CGUIFontTTFBase::ClearCharacterCache()
   memset(m_charquick, 0, sizeof(m_charquick));
   m_numChars = 0;
   m_maxChars = CHAR_CHUNK;
+  m_charsEvicted = false;
+  m_rowUsed.clear();
   // set the posX and posY so that our texture will be created on first character write.
   m_posX = m_textureWidth;
   m_posY = -(int)m_cellHeight;
   m_textureHeight = 0;
+  InvalidateTextCache();
 }
 
 void CGUIFontTTFBase::Clear()
@@ -210,9 +237,12 @@ void CGUIFontTTFBase::Clear()
   m_char = NULL;
   m_maxChars = 0;
   m_numChars = 0;
+  m_charsEvicted = false;
+  m_rowUsed.clear();
   m_posX = 0;
   m_posY = 0;
   m_nestedBeginCount = 0;
+  InvalidateTextCache();
 
   if (m_face)
     g_freeTypeLibrary.ReleaseFont(m_face);
@@ -283,6 +313,9 @@ bool CGUIFontTTFBase::Load(const CStdString& strFilename, float height, float as
 
   m_maxChars = 0;
   m_numChars = 0;
+  m_charsEvicted = false;
+  m_rowUsed.clear();
+  InvalidateTextCache();
 
   m_strFilename = strFilename;
 
@@ -309,11 +342,35 @@ void CGUIFontTTFBase::DrawTextInternal(float x, float y, const vecColors &colors
 {
   Begin();
 
+  // reuse the vertices from the last time this text was drawn, if it was drawn the same way.
+  // Scrolling text moves every frame, so isn't worth keeping.
+  uint32_t hash = 0;
+  if (!scrolling)
+  {
+    hash = HashText(x, y, colors, text, alignment);
+    CachedText *cached = GetCachedText(hash, x, y, colors, text, alignment, maxPixelWidth);
+    if (cached)
+    {
+      unsigned int now = CTimeUtils::GetFrameTime();
+      cached->lastUsed = now;
+      for (vector<unsigned int>::const_iterator i = cached->rows.begin(); i != cached->rows.end(); ++i)
+        m_rowUsed[*i] = now;
+      if (!cached->vertices.empty())
+        memcpy(AddVertices(cached->vertices.size()), &cached->vertices[0], cached->vertices.size() * sizeof(SVertex));
+      End();
+      return;
+    }
+  }
+  unsigned int generation = m_textCacheGeneration;
+  int startVertex = m_vertex_count;
+  vector<unsigned int> rows;
+
   // save the origin, which is scaled separately
   m_originX = x;
   m_originY = y;
 
   // Check if we will really need to truncate or justify the text
+  uint32_t originalAlignment = alignment;
   if ( alignment & XBFONT_TRUNCATED )
   {
     if ( maxPixelWidth <= 0.0f || GetTextWidthInternal(text.begin(), text.end()) <= maxPixelWidth)
@@ -392,6 +449,7 @@ void CGUIFontTTFBase::DrawTextInternal(float x, float y, const vecColors &colors
           RenderCharacter(startX + cursorX, startY, period, color, !scrolling);
           cursorX += period->advance;
         }
+        rows.push_back(period->row);
         break;
       }
     }
@@ -399,6 +457,8 @@ void CGUIFontTTFBase::DrawTextInternal(float x, float y, const vecColors &colors
       break;  // exceeded max allowed width - stop rendering
 
     RenderCharacter(startX + cursorX, startY, ch, color, !scrolling);
+    if (rows.empty() || rows.back() != ch->row)
+      rows.push_back(ch->row);
     if ( alignment & XBFONT_JUSTIFIED )
     {
       if ((*pos & 0xffff) == L' ')
@@ -410,6 +470,39 @@ void CGUIFontTTFBase::DrawTextInternal(float x, float y, const vecColors &colors
       cursorX += ch->advance;
   }
 
+  // keep the vertices for next time, unless caching characters along the way has invalidated them
+  if (!scrolling && generation == m_textCacheGeneration)
+  {
+    CachedText &cached = m_textCache[hash];
+    cached.text = text;
+    cached.colors = colors;
+    cached.alignment = originalAlignment;
+    cached.maxPixelWidth = maxPixelWidth;
+    cached.x = x;
+    cached.y = y;
+    cached.transform = g_graphicsContext.GetFinalTransform();
+    cached.clipped = g_graphicsContext.GetClipRegion(cached.clip);
+    cached.vertices.assign(m_vertex + startVertex, m_vertex + m_vertex_count);
+    sort(rows.begin(), rows.end());
+    rows.erase(unique(rows.begin(), rows.end()), rows.end());
+    cached.rows.swap(rows);
+
+    // drop the vertices of text that is no longer drawn
+    unsigned int now = CTimeUtils::GetFrameTime();
+    cached.lastUsed = now;
+    if (now - m_textCachePruned > TEXT_CACHE_LIFETIME)
+    {
+      for (map<uint32_t, CachedText>::iterator i = m_textCache.begin(); i != m_textCache.end();)
+      {
+        if (now - i->second.lastUsed > TEXT_CACHE_LIFETIME)
+          m_textCache.erase(i++);
+        else
+          ++i;
+      }
+      m_textCachePruned = now;
+    }
+  }
+
   End();
 }
 
@@ -499,6 +592,8 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
   }
   // render the character to our texture
   // must End() as we can't render text to our texture during a Begin(), End() block
+  // which leaves any vertices being generated for the text cache incomplete
+  InvalidateTextCache();
   unsigned int nestedBeginCount = m_nestedBeginCount;
   m_nestedBeginCount = 1;
   if (nestedBeginCount) End();
@@ -518,6 +613,26 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
   if (nestedBeginCount) Begin();
   m_nestedBeginCount = nestedBeginCount;
 
+  // remove any characters whose row of our texture was reused for this one
+  if (m_charsEvicted)
+  {
+    int count = 0;
+    int index = low;
+    for (int i = 0; i < m_numChars; i++)
+    {
+      if (m_char[i].row == CHARACTER_ROW_EVICTED)
+      {
+        if (i < low)
+          index--;
+      }
+      else
+        m_char[count++] = m_char[i];
+    }
+    m_numChars = count;
+    low = index;
+    m_charsEvicted = false;
+  }
+
   // fixup quick access
   memset(m_charquick, 0, sizeof(m_charquick));
   for(int i=0;i<m_numChars;i++)
@@ -569,9 +684,11 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
 
   // check we have enough room for the character
   if (m_posX + bitGlyph->left + bitmap.width > (int)m_textureWidth)
-  { // no space - gotta drop to the next line (which means creating a new texture and copying it across)
+  { // no space - gotta drop to the next unused line (which means creating a new texture and copying it across)
+    unsigned int currentRow = m_rowUsed.empty() ? 0 : m_posY / m_cellHeight;
+    unsigned int row = m_rowUsed.size();
     m_posX = 0;
-    m_posY += m_cellHeight;
+    m_posY = row * m_cellHeight;
     if (bitGlyph->left < 0)
       m_posX += -bitGlyph->left;
 
@@ -581,22 +698,31 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
       unsigned int newHeight = m_posY + m_cellHeight;
       // check for max height
       if (newHeight > g_Windowing.GetMaxTextureSize())
-      {
-        CLog::Log(LOGDEBUG, "GUIFontTTF::CacheCharacter: New cache texture is too large (%u > %u pixels long)", newHeight, g_Windowing.GetMaxTextureSize());
-        FT_Done_Glyph(glyph);
-        return false;
+      { // can't grow any further, so reuse the line we've drawn from least recently
+        if (!EvictCharacterRow(ch, currentRow, row))
+        {
+          CLog::Log(LOGDEBUG, "GUIFontTTF::CacheCharacter: New cache texture is too large (%u > %u pixels long)", newHeight, g_Windowing.GetMaxTextureSize());
+          FT_Done_Glyph(glyph);
+          return false;
+        }
+        m_posY = row * m_cellHeight;
       }
-
-      CBaseTexture* newTexture = NULL;
-      newTexture = ReallocTexture(newHeight);
-      if(newTexture == NULL)
+      else
       {
-        FT_Done_Glyph(glyph);
-        CLog::Log(LOGDEBUG, "GUIFontTTF::CacheCharacter: Failed to allocate new texture of height %u", newHeight);
-        return false;
+        CBaseTexture* newTexture = NULL;
+        newTexture = ReallocTexture(newHeight);
+        if(newTexture == NULL)
+        {
+          FT_Done_Glyph(glyph);
+          CLog::Log(LOGDEBUG, "GUIFontTTF::CacheCharacter: Failed to allocate new texture of height %u", newHeight);
+          return false;
+        }
+        m_texture = newTexture;
       }
-      m_texture = newTexture;
     }
+    if (row == m_rowUsed.size())
+      m_rowUsed.push_back(0);
+    m_rowUsed[row] = CTimeUtils::GetFrameTime();
   }
 
   if(m_texture == NULL)
@@ -614,6 +740,7 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
   ch->right = ch->left + bitmap.width;
   ch->bottom = ch->top + bitmap.rows;
   ch->advance = (float)MathUtils::round_int( (float)m_face->glyph->advance.x / 64 );
+  ch->row = m_posY / m_cellHeight;
 
   // we need only render if we actually have some pixels
   if (bitmap.width * bitmap.rows)
@@ -694,22 +821,9 @@ void CGUIFontTTFBase::RenderCharacter(float posX, float posY, const Character *c
   float tt = texture.y1 * m_textureScaleY;
   float tb = texture.y2 * m_textureScaleY;
 
-  // grow the vertex buffer if required
-  if(m_vertex_count >= m_vertex_size)
-  {
-    m_vertex_size *= 2;
-    void* old      = m_vertex;
-    m_vertex       = (SVertex*)realloc(m_vertex, m_vertex_size * sizeof(SVertex));
-    if (!m_vertex)
-    {
-      free(old);
-      printf("realloc failed in CGUIFontTTF::RenderCharacter. aborting\n");
-      abort();
-    }
-  }
-
+  m_rowUsed[ch->row] = CTimeUtils::GetFrameTime();
   m_color = color;
-  SVertex* v = m_vertex + m_vertex_count;
+  SVertex* v = AddVertices(4);
 
   for(int i = 0; i < 4; i++)
   {
@@ -764,8 +878,81 @@ void CGUIFontTTFBase::RenderCharacter(float posX, float posY, const Character *c
   v[3].y = y[2];
   v[3].z = z[2];
 #endif
+}
+
+SVertex *CGUIFontTTFBase::AddVertices(int count)
+{
+  // grow the vertex buffer if required
+  if(m_vertex_count + count > m_vertex_size)
+  {
+    while (m_vertex_count + count > m_vertex_size)
+      m_vertex_size *= 2;
+    void* old      = m_vertex;
+    m_vertex       = (SVertex*)realloc(m_vertex, m_vertex_size * sizeof(SVertex));
+    if (!m_vertex)
+    {
+      free(old);
+      printf("realloc failed in CGUIFontTTF::AddVertices. aborting\n");
+      abort();
+    }
+  }
+  SVertex *v = m_vertex + m_vertex_count;
+  m_vertex_count += count;
+  return v;
+}
 
-  m_vertex_count+=4;
+bool CGUIFontTTFBase::EvictCharacterRow(const Character *keep, unsigned int currentRow, unsigned int &row)
+{
+  // find the row drawn from least recently, other than the one we've just filled
+  bool found = false;
+  for (unsigned int i = 0; i < m_rowUsed.size(); i++)
+  {
+    if (i != currentRow && (!found || m_rowUsed[i] < m_rowUsed[row]))
+    {
+      row = i;
+      found = true;
+    }
+  }
+  if (!found)
+    return false;
+
+  // the character array has a gap for the new character at this point, hence the extra entry
+  for (int i = 0; i <= m_numChars; i++)
+  {
+    if (m_char + i != keep && m_char[i].row == row)
+    {
+      m_char[i].row = CHARACTER_ROW_EVICTED;
+      m_charsEvicted = true;
+    }
+  }
+  ClearTextureRows(row * m_cellHeight, m_cellHeight);
+  return true;
+}
+
+CGUIFontTTFBase::CachedText *CGUIFontTTFBase::GetCachedText(uint32_t hash, float x, float y, const vecColors &colors, const vecText &text,
+                                                            uint32_t alignment, float maxPixelWidth)
+{
+  map<uint32_t, CachedText>::iterator i = m_textCache.find(hash);
+  if (i == m_textCache.end())
+    return NULL;
+
+  CachedText &cached = i->second;
+  if (cached.x != x || cached.y != y || cached.alignment != alignment || cached.maxPixelWidth != maxPixelWidth ||
+      cached.text != text || cached.colors != colors || cached.transform != g_graphicsContext.GetFinalTransform())
+    return NULL;
+
+  CRect clip;
+  bool clipped = g_graphicsContext.GetClipRegion(clip);
+  if (clipped != cached.clipped || (clipped && clip != cached.clip))
+    return NULL;
+
+  return &cached;
+}
+
+void CGUIFontTTFBase::InvalidateTextCache()
+{
+  m_textCache.clear();
+  m_textCacheGeneration++;
 }
 
 // Oblique code - original taken from freetype2 (ftsynth.c)
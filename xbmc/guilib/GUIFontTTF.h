@@ -28,6 +28,11 @@
  *
  */
 
+#include "Geometry.h"
+#include "TransformMatrix.h"
+
+#include <map>
+
 // forward definition
 class CBaseTexture;
 
@@ -90,6 +95,25 @@ protected:
     float left, top, right, bottom;
     float advance;
     character_t letterAndStyle;
+    unsigned int row;              // the row of our texture the character is cached in
+  };
+
+  /*! \brief The vertices generated for a piece of text, kept so that text drawn the same
+   way frame after frame (the usual case for labels) needn't have its vertices regenerated.
+   */
+  struct CachedText
+  {
+    vecText text;
+    vecColors colors;
+    uint32_t alignment;
+    float maxPixelWidth;
+    float x, y;
+    TransformMatrix transform;
+    bool clipped;
+    CRect clip;
+    std::vector<SVertex> vertices;
+    std::vector<unsigned int> rows;  // the rows of our texture used by the text
+    unsigned int lastUsed;
   };
   void AddReference();
   void RemoveReference();
@@ -111,9 +135,16 @@ protected:
   bool CacheCharacter(wchar_t letter, uint32_t style, Character *ch);
   void RenderCharacter(float posX, float posY, const Character *ch, color_t color, bool roundX);
   void ClearCharacterCache();
+  bool EvictCharacterRow(const Character *keep, unsigned int currentRow, unsigned int &row);
+  SVertex *AddVertices(int count);
+
+  CachedText *GetCachedText(uint32_t hash, float x, float y, const vecColors &colors, const vecText &text,
+                            uint32_t alignment, float maxPixelWidth);
+  void InvalidateTextCache();
 
   virtual CBaseTexture* ReallocTexture(unsigned int& newHeight) = 0;
   virtual bool CopyCharToTexture(FT_BitmapGlyph bitGlyph, Character *ch) = 0;
+  virtual void ClearTextureRows(unsigned int top, unsigned int height) = 0;
   virtual void DeleteHardwareTexture() = 0;
 
   // modifying glyphs
@@ -133,6 +164,13 @@ protected:
   Character *m_charquick[256*4];     // ascii chars (4 styles) here
   int m_maxChars;                    // size of character array (can be incremented)
   int m_numChars;                    // the current number of cached characters
+  bool m_charsEvicted;               // whether characters have been marked for removal from the array
+
+  std::vector<unsigned int> m_rowUsed;   // frame time each row of our texture was last drawn from
+
+  std::map<uint32_t, CachedText> m_textCache;  // vertices of recently drawn text, by hash
+  unsigned int m_textCacheGeneration;          // incremented whenever the cached vertices become invalid
+  unsigned int m_textCachePruned;              // frame time the text cache was last pruned
 
   float m_ellipsesWidth;               // this is used every character (width of '.')
 
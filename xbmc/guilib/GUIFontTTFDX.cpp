@@ -303,6 +303,37 @@ bool CGUIFontTTFDX::CopyCharToTexture(FT_BitmapGlyph bitGlyph, Character* ch)
   return TRUE;
 }
 
+void CGUIFontTTFDX::ClearTextureRows(unsigned int top, unsigned int height)
+{
+  LPDIRECT3DTEXTURE9 texture = ((CDXTexture *)m_texture)->GetTextureObject();
+  LPDIRECT3DSURFACE9 target;
+  if (m_speedupTexture)
+    m_speedupTexture->GetSurfaceLevel(0, &target);
+  else
+    texture->GetSurfaceLevel(0, &target);
+
+  std::vector<unsigned char> blank(m_textureWidth * height, 0);
+  RECT sourcerect = { 0, 0, m_textureWidth, height };
+  RECT targetrect = { 0, top, m_textureWidth, top + height };
+
+  HRESULT hr = D3DXLoadSurfaceFromMemory( target, NULL, &targetrect,
+                                          &blank[0], D3DFMT_LIN_A8, m_textureWidth, NULL, &sourcerect,
+                                          D3DX_FILTER_NONE, 0x00000000);
+  SAFE_RELEASE(target);
+
+  if (FAILED(hr))
+  {
+    CLog::Log(LOGERROR, __FUNCTION__": Failed to clear the texture (0x%08X)", hr);
+    return;
+  }
+
+  if (m_speedupTexture)
+  {
+    hr = g_Windowing.Get3DDevice()->UpdateTexture(m_speedupTexture->Get(), texture);
+    if (FAILED(hr))
+      CLog::Log(LOGERROR, __FUNCTION__": Failed to upload from sysmem to vidmem (0x%08X)", hr);
+  }
+}
 
 void CGUIFontTTFDX::DeleteHardwareTexture()
 {
@@ -229,6 +229,19 @@ bool CGUIFontTTFGL::CopyCharToTexture(FT_BitmapGlyph bitGlyph, Character* ch)
   return TRUE;
 }
 
+void CGUIFontTTFGL::ClearTextureRows(unsigned int top, unsigned int height)
+{
+  memset((unsigned char*) m_texture->GetPixels() + top * m_texture->GetPitch(), 0, height * m_texture->GetPitch());
+
+  // as for a new character, the texture has to be uploaded again
+  if (m_bTextureLoaded)
+  {
+    g_graphicsContext.BeginPaint();  //FIXME
+    DeleteHardwareTexture();
+    g_graphicsContext.EndPaint();
+    m_bTextureLoaded = false;
+  }
+}
 
 void CGUIFontTTFGL::DeleteHardwareTexture()
 {
@@ -82,6 +82,7 @@ CGUIIncludes::~CGUIIncludes()
 
 void CGUIIncludes::ClearIncludes()
 {
+  CExclusiveLock lock(m_section);
   m_includes.clear();
   m_defaults.clear();
   m_constants.clear();
@@ -91,6 +92,7 @@ void CGUIIncludes::ClearIncludes()
 
 bool CGUIIncludes::LoadIncludes(const CStdString &includeFile)
 {
+  CExclusiveLock lock(m_section);
   // check to see if we already have this loaded
   if (HasIncludeFile(includeFile))
     return true;
@@ -175,25 +177,40 @@ bool CGUIIncludes::HasIncludeFile(const CStdString &file) const
   return false;
 }
 
-void CGUIIncludes::ResolveIncludes(TiXmlElement *node)
+bool CGUIIncludes::ResolveIncludes(TiXmlElement *node)
+{
+  return ResolveIncludes(node, false);
+}
+
+bool CGUIIncludes::ResolveIncludesInBackground(TiXmlElement *node)
+{
+  CSharedLock lock(m_section);
+  return ResolveIncludes(node, true);
+}
+
+bool CGUIIncludes::ResolveIncludes(TiXmlElement *node, bool background)
 {
   if (!node)
-    return;
-  ResolveIncludesForNode(node);
+    return true;
+  bool fixed = ResolveIncludesForNode(node, background);
 
   TiXmlElement *child = node->FirstChildElement();
-  while (child)
+  while (child && (fixed || !background))
   {
-    ResolveIncludes(child);
+    if (!ResolveIncludes(child, background))
+      fixed = false;
     child = child->NextSiblingElement();
   }
+  return fixed;
 }
 
-void CGUIIncludes::ResolveIncludesForNode(TiXmlElement *node)
+bool CGUIIncludes::ResolveIncludesForNode(TiXmlElement *node, bool background)
 {
   // we have a node, find any <include file="fileName">tagName</include> tags and replace
   // recursively with their real includes
-  if (!node) return;
+  if (!node) return true;
+
+  bool fixed = true;
 
   // First add the defaults if this is for a control
   CStdString type;
@@ -219,6 +236,10 @@ void CGUIIncludes::ResolveIncludesForNode(TiXmlElement *node)
   {
     // have an include tag - grab it's tag name and replace it with the real tag contents
     const char *file = include->Attribute("file");
+    if (background && (file || include->Attribute("condition")))
+    { // loading include files and evaluating conditions is left to the gui thread
+      return false;
+    }
     if (file)
     { // we need to load this include from the alternative file
       LoadIncludes(g_SkinInfo->GetSkinPath(file));
@@ -226,6 +247,7 @@ void CGUIIncludes::ResolveIncludesForNode(TiXmlElement *node)
     const char *condition = include->Attribute("condition");
     if (condition)
     { // check this condition
+      fixed = false;
       if (!g_infoManager.EvaluateBool(condition))
       {
         include = include->NextSiblingElement("include");
@@ -267,6 +289,7 @@ void CGUIIncludes::ResolveIncludesForNode(TiXmlElement *node)
   // also do the value
   if (node->FirstChild() && node->FirstChild()->Type() == TiXmlNode::TINYXML_TEXT && m_constantNodes.count(node->ValueStr()))
     node->FirstChild()->SetValue(ResolveConstant(node->FirstChild()->ValueStr()));
+  return fixed;
 }
 
 CStdString CGUIIncludes::ResolveConstant(const CStdString &constant) const
@@ -22,6 +22,7 @@
  */
 
 #include "utils/StdString.h"
+#include "threads/SharedSection.h"
 
 #include <map>
 #include <set>
@@ -47,12 +48,24 @@ public:
    Replaces any instances of <include file="foo">bar</include> with the value of the include
    "bar" from the include file "foo".
    \param node an XML Element - all child elements are traversed.
+   \return true if the result depends only on the skin files, false if a conditional include was evaluated.
    */
-  void ResolveIncludes(TiXmlElement *node);
+  bool ResolveIncludes(TiXmlElement *node);
+
+  /*! \brief Resolve includes for the given XML element from a thread other than the GUI thread
+   Conditional includes and includes from other files have to be resolved on the GUI thread,
+   so if there are any we give up, leaving the element partly resolved.
+   \param node an XML Element - all child elements are traversed.
+   \return true if all includes were resolved, false if the element has to be loaded again.
+   \sa ResolveIncludes
+   */
+  bool ResolveIncludesInBackground(TiXmlElement *node);
+
   const INFO::CSkinVariableString* CreateSkinVariable(const CStdString& name, int context);
 
 private:
-  void ResolveIncludesForNode(TiXmlElement *node);
+  bool ResolveIncludes(TiXmlElement *node, bool background);
+  bool ResolveIncludesForNode(TiXmlElement *node, bool background);
   CStdString ResolveConstant(const CStdString &constant) const;
   bool HasIncludeFile(const CStdString &includeFile) const;
   std::map<CStdString, TiXmlElement> m_includes;
@@ -64,5 +77,7 @@ private:
 
   std::set<std::string> m_constantAttributes;
   std::set<std::string> m_constantNodes;
+
+  CSharedSection m_section;  ///< held shared while resolving in the background, exclusive while loading
 };
 
@@ -124,11 +124,11 @@ void CGUIInfoColor::Parse(const CStdString &label, int context)
     m_color = g_colorManager.GetColor(label);
 }
 
-CGUIInfoLabel::CGUIInfoLabel()
+CGUIInfoLabel::CGUIInfoLabel() : m_dirty(true)
 {
 }
 
-CGUIInfoLabel::CGUIInfoLabel(const CStdString &label, const CStdString &fallback, int context)
+CGUIInfoLabel::CGUIInfoLabel(const CStdString &label, const CStdString &fallback, int context) : m_dirty(true)
 {
   SetLabel(label, fallback, context);
 }
@@ -141,7 +141,6 @@ void CGUIInfoLabel::SetLabel(const CStdString &label, const CStdString &fallback
 
 CStdString CGUIInfoLabel::GetLabel(int contextWindow, bool preferImage, CStdString *fallback) const
 {
-  CStdString label;
   for (unsigned int i = 0; i < m_info.size(); i++)
   {
     const CInfoPortion &portion = m_info[i];
@@ -152,23 +151,16 @@ CStdString CGUIInfoLabel::GetLabel(int contextWindow, bool preferImage, CStdStri
         infoLabel = g_infoManager.GetImage(portion.m_info, contextWindow, fallback);
       if (infoLabel.IsEmpty())
         infoLabel = g_infoManager.GetLabel(portion.m_info, contextWindow, fallback);
-      if (!infoLabel.IsEmpty())
-        label += portion.GetLabel(infoLabel);
-    }
-    else
-    { // no info, so just append the prefix
-      label += portion.m_prefix;
+      if (portion.NeedsUpdate(infoLabel))
+        m_dirty = true;
     }
   }
-  if (label.IsEmpty())  // empty label, use the fallback
-    return m_fallback;
-  return label;
+  return BuildLabel();
 }
 
 CStdString CGUIInfoLabel::GetItemLabel(const CGUIListItem *item, bool preferImages, CStdString *fallback) const
 {
   if (!item->IsFileItem()) return "";
-  CStdString label;
   for (unsigned int i = 0; i < m_info.size(); i++)
   {
     const CInfoPortion &portion = m_info[i];
@@ -179,17 +171,38 @@ CStdString CGUIInfoLabel::GetItemLabel(const CGUIListItem *item, bool preferImag
         infoLabel = g_infoManager.GetItemImage((const CFileItem *)item, portion.m_info, fallback);
       else
         infoLabel = g_infoManager.GetItemLabel((const CFileItem *)item, portion.m_info, fallback);
-      if (!infoLabel.IsEmpty())
-        label += portion.GetLabel(infoLabel);
+      if (portion.NeedsUpdate(infoLabel))
+        m_dirty = true;
     }
-    else
-    { // no info, so just append the prefix
-      label += portion.m_prefix;
+  }
+  return BuildLabel();
+}
+
+const CStdString &CGUIInfoLabel::BuildLabel() const
+{
+  // labels mostly stay the same from one frame to the next, so we only put
+  // them together again once the value of one of our infos has changed.
+  if (m_dirty)
+  {
+    m_label.clear();
+    for (unsigned int i = 0; i < m_info.size(); i++)
+    {
+      const CInfoPortion &portion = m_info[i];
+      if (portion.m_info)
+      {
+        if (!portion.m_label.IsEmpty())
+          m_label += portion.GetLabel(portion.m_label);
+      }
+      else
+      { // no info, so just append the prefix
+        m_label += portion.m_prefix;
+      }
     }
+    m_dirty = false;
   }
-  if (label.IsEmpty())
+  if (m_label.IsEmpty())  // empty label, use the fallback
     return m_fallback;
-  return label;
+  return m_label;
 }
 
 bool CGUIInfoLabel::IsEmpty() const
@@ -273,6 +286,7 @@ const static infoformat infoformatmap[] = {{ "$INFO[",    FORMATINFO },
 void CGUIInfoLabel::Parse(const CStdString &label, int context)
 {
   m_info.clear();
+  m_dirty = true;
   // Step 1: Replace all $LOCALIZE[number] with the real string
   CStdString work = ReplaceLocalize(label);
   // Step 2: Replace all $ADDON[id number] with the real string
@@ -354,6 +368,14 @@ CGUIInfoLabel::CInfoPortion::CInfoPortion(int info, const CStdString &prefix, co
   m_postfix.Replace("$LBRACKET", "["); m_postfix.Replace("$RBRACKET", "]");
 }
 
+bool CGUIInfoLabel::CInfoPortion::NeedsUpdate(const CStdString &label) const
+{
+  if (m_label == label)
+    return false;
+  m_label = label;
+  return true;
+}
+
 CStdString CGUIInfoLabel::CInfoPortion::GetLabel(const CStdString &info) const
 {
   CStdString label = m_prefix + info + m_postfix;
@@ -101,20 +101,30 @@ public:
 private:
   void Parse(const CStdString &label, int context);
 
+  /*! \brief Put the label together from the last values of its info portions
+   */
+  const CStdString &BuildLabel() const;
+
   class CInfoPortion
   {
   public:
     CInfoPortion(int info, const CStdString &prefix, const CStdString &postfix, bool escaped = false);
     CStdString GetLabel(const CStdString &info) const;
+    /*! \brief Keep the value of our info, returning whether it changed since last time
+     */
+    bool NeedsUpdate(const CStdString &label) const;
     int m_info;
     CStdString m_prefix;
     CStdString m_postfix;
+    mutable CStdString m_label;  ///< last value of our info
   private:
     bool m_escaped;
   };
 
   CStdString m_fallback;
   std::vector<CInfoPortion> m_info;
+  mutable CStdString m_label;    ///< label last put together from our portions
+  mutable bool m_dirty;          ///< whether m_label has to be put together again
 };
 
 #endif
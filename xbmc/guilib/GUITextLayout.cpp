@@ -23,6 +23,8 @@
 #include "GUIFont.h"
 #include "GUIControl.h"
 #include "GUIColorManager.h"
+#include "GraphicContext.h"
+#include "TextLayoutCache.h"
 #include "utils/CharsetConverter.h"
 #include "utils/StringUtils.h"
 
@@ -30,6 +32,8 @@ using namespace std;
 
 #define WORK_AROUND_NEEDED_FOR_LINE_BREAKS
 
+static CTextLayoutCache g_textLayoutCache;
+
 CGUIString::CGUIString(iString start, iString end, bool carriageReturn)
 {
   m_text.assign(start, end);
@@ -55,6 +59,11 @@ CGUITextLayout::CGUITextLayout(CGUIFont *font, bool wrap, float fHeight, CGUIFon
   m_textHeight = 0;
 }
 
+void CGUITextLayout::ClearCache()
+{
+  g_textLayoutCache.Clear();
+}
+
 void CGUITextLayout::SetWrap(bool bWrap)
 {
   m_wrap = bWrap;
@@ -195,12 +204,17 @@ void CGUITextLayout::RenderOutline(float x, float y, color_t color, color_t outl
 
 bool CGUITextLayout::Update(const CStdString &text, float maxWidth, bool forceUpdate /*= false*/, bool forceLTRReadingOrder /*= false*/)
 {
+  if (!forceUpdate && !m_lastUTF8Text.IsEmpty() && text == m_lastUTF8Text)
+    return false;
+
   // convert to utf16
   CStdStringW utf16;
   utf8ToW(text, utf16);
 
   // update
-  return UpdateW(utf16, maxWidth, forceUpdate, forceLTRReadingOrder);
+  bool changed = UpdateW(utf16, maxWidth, forceUpdate, forceLTRReadingOrder);
+  m_lastUTF8Text = text;
+  return changed;
 }
 
 bool CGUITextLayout::UpdateW(const CStdStringW &text, float maxWidth /*= 0*/, bool forceUpdate /*= false*/, bool forceLTRReadingOrder /*= false*/)
@@ -208,6 +222,13 @@ bool CGUITextLayout::UpdateW(const CStdStringW &text, float maxWidth /*= 0*/, bo
   if (text.Equals(m_lastText) && !forceUpdate)
     return false;
 
+  m_lastUTF8Text.Empty();
+  if (GetCachedLayout(text, maxWidth, forceLTRReadingOrder))
+  {
+    m_lastText = text;
+    return true;
+  }
+
   vecText parsedText;
 
   // empty out our previous string
@@ -236,10 +257,49 @@ bool CGUITextLayout::UpdateW(const CStdStringW &text, float maxWidth /*= 0*/, bo
   // and cache the width and height for later reading
   CalcTextExtent();
 
+  CacheLayout(text, maxWidth, forceLTRReadingOrder);
   m_lastText = text;
   return true;
 }
 
+bool CGUITextLayout::GetCachedLayout(const CStdStringW &text, float maxWidth, bool forceLTRReadingOrder)
+{
+  if (!m_font)
+    return false;
+
+  CTextLayoutCache::Key key;
+  key.text = text;
+  key.font = m_font;
+  key.maxWidth = (m_wrap && maxWidth > 0) ? maxWidth : 0;
+  key.maxHeight = m_maxHeight;
+  key.forceLTRReadingOrder = forceLTRReadingOrder;
+  key.scaleX = g_graphicsContext.GetGUIScaleX();
+  key.scaleY = g_graphicsContext.GetGUIScaleY();
+  if (!g_textLayoutCache.Get(key, m_lines, m_colors, m_textWidth, m_textHeight))
+    return false;
+
+  // the default color is set when the text is rendered, so may differ from the one laid out with
+  if (m_colors.size())
+    m_colors[0] = m_textColor;
+  return true;
+}
+
+void CGUITextLayout::CacheLayout(const CStdStringW &text, float maxWidth, bool forceLTRReadingOrder) const
+{
+  if (!m_font)
+    return;
+
+  CTextLayoutCache::Key key;
+  key.text = text;
+  key.font = m_font;
+  key.maxWidth = (m_wrap && maxWidth > 0) ? maxWidth : 0;
+  key.maxHeight = m_maxHeight;
+  key.forceLTRReadingOrder = forceLTRReadingOrder;
+  key.scaleX = g_graphicsContext.GetGUIScaleX();
+  key.scaleY = g_graphicsContext.GetGUIScaleY();
+  g_textLayoutCache.Add(key, m_lines, m_colors, m_textWidth, m_textHeight);
+}
+
 // BidiTransform is used to handle RTL text flipping in the string
 void CGUITextLayout::BidiTransform(vector<CGUIString> &lines, bool forceLTRReadingOrder)
 {
@@ -629,6 +689,7 @@ void CGUITextLayout::Reset()
 {
   m_lines.clear();
   m_lastText.Empty();
+  m_lastUTF8Text.Empty();
   m_textWidth = m_textHeight = 0;
 }
 
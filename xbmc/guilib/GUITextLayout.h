@@ -100,6 +100,11 @@ public:
   static void DrawText(CGUIFont *font, float x, float y, color_t color, color_t shadowColor, const CStdString &text, uint32_t align);
   static void Filter(CStdString &text);
 
+  /*! \brief Forget all laid out text kept for reuse.
+   Must be called whenever a font is unloaded or has its size changed, as layouts are kept per font.
+   */
+  static void ClearCache();
+
 protected:
   void ParseText(const CStdStringW &text, vecText &parsedText);
   void LineBreakText(const vecText &text, std::vector<CGUIString> &lines);
@@ -123,6 +128,7 @@ protected:
   color_t m_textColor;
 
   CStdStringW m_lastText;
+  CStdString m_lastUTF8Text;  // text last given to Update(), so unchanged text needn't be converted again
   float m_textWidth;
   float m_textHeight;
 private:
@@ -140,5 +146,8 @@ private:
   static void ParseText(const CStdStringW &text, uint32_t defaultStyle, vecColors &colors, vecText &parsedText);
 
   static void utf8ToW(const CStdString &utf8, CStdStringW &utf16);
+
+  bool GetCachedLayout(const CStdStringW &text, float maxWidth, bool forceLTRReadingOrder);
+  void CacheLayout(const CStdStringW &text, float maxWidth, bool forceLTRReadingOrder) const;
 };
 
@@ -25,6 +25,8 @@
 #include "GUILargeTextureManager.h"
 #include "utils/MathUtils.h"
 
+#include <algorithm>
+
 using namespace std;
 
 CTextureInfo::CTextureInfo()
@@ -83,6 +85,8 @@ CGUITextureBase::CGUITextureBase(float posX, float posY, float width, float heig
 
   m_allocateDynamically = false;
   m_isAllocated = NO;
+  m_largeWidth = 0;
+  m_largeHeight = 0;
   m_invalid = true;
 }
 
@@ -119,6 +123,8 @@ CGUITextureBase::CGUITextureBase(const CGUITextureBase &right)
   m_currentLoop = 0;
 
   m_isAllocated = NO;
+  m_largeWidth = 0;
+  m_largeHeight = 0;
   m_invalid = true;
 }
 
@@ -312,8 +318,10 @@ bool CGUITextureBase::AllocResources()
     }
     if (m_isAllocated != NORMAL)
     { // use our large image background loader
+      if (!IsAllocated())
+        GetLargeLoadSize(m_largeWidth, m_largeHeight);
       CTextureArray texture;
-      if (g_largeTextureManager.GetImage(m_info.filename, texture, !IsAllocated()))
+      if (g_largeTextureManager.GetImage(m_info.filename, texture, !IsAllocated(), m_largeWidth, m_largeHeight, GetScreenDistance()))
       {
         m_isAllocated = LARGE;
 
@@ -453,10 +461,37 @@ bool CGUITextureBase::CalculateSize()
   return true;
 }
 
+void CGUITextureBase::GetLargeLoadSize(unsigned int &width, unsigned int &height) const
+{
+  // images that are cropped to fill us, or not scaled at all, may need to be larger than we are
+  if (m_aspect.ratio == CAspectRatio::AR_SCALE || m_aspect.ratio == CAspectRatio::AR_CENTER ||
+      m_width <= 0 || m_height <= 0)
+  {
+    width = height = 0;
+    return;
+  }
+  width = (unsigned int)(m_width * g_graphicsContext.GetGUIScaleX() + 0.5f);
+  height = (unsigned int)(m_height * g_graphicsContext.GetGUIScaleY() + 0.5f);
+}
+
+float CGUITextureBase::GetScreenDistance() const
+{
+  // how far off screen we are, in screen pixels, with the transform of our control
+  float x1 = g_graphicsContext.ScaleFinalXCoord(m_posX, m_posY);
+  float y1 = g_graphicsContext.ScaleFinalYCoord(m_posX, m_posY);
+  float x2 = g_graphicsContext.ScaleFinalXCoord(m_posX + m_width, m_posY + m_height);
+  float y2 = g_graphicsContext.ScaleFinalYCoord(m_posX + m_width, m_posY + m_height);
+  CRect rect(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2));
+
+  float dx = std::max(0.0f, std::max(-rect.x2, rect.x1 - (float)g_graphicsContext.GetWidth()));
+  float dy = std::max(0.0f, std::max(-rect.y2, rect.y1 - (float)g_graphicsContext.GetHeight()));
+  return std::max(dx, dy);
+}
+
 void CGUITextureBase::FreeResources(bool immediately /* = false */)
 {
   if (m_isAllocated == LARGE || m_isAllocated == LARGE_FAILED)
-    g_largeTextureManager.ReleaseImage(m_info.filename, immediately || (m_isAllocated == LARGE_FAILED));
+    g_largeTextureManager.ReleaseImage(m_info.filename, immediately || (m_isAllocated == LARGE_FAILED), m_largeWidth, m_largeHeight);
   else if (m_isAllocated == NORMAL && m_texture.size())
     g_TextureManager.ReleaseTexture(m_info.filename);
 
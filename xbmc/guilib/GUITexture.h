@@ -127,6 +127,8 @@ protected:
   bool UpdateAnimFrame();
   void Render(float left, float top, float bottom, float right, float u1, float v1, float u2, float v2, float u3, float v3);
   void OrientateTexture(CRect &rect, float width, float height, int orientation);
+  void GetLargeLoadSize(unsigned int &width, unsigned int &height) const;
+  float GetScreenDistance() const;
 
   // functions that our implementation classes handle
   virtual void Allocate() {}; ///< called after our textures have been allocated
@@ -163,6 +165,8 @@ protected:
   bool m_allocateDynamically;
   enum ALLOCATE_TYPE { NO = 0, NORMAL, LARGE, NORMAL_FAILED, LARGE_FAILED };
   ALLOCATE_TYPE m_isAllocated;
+  unsigned int m_largeWidth;   // size requested from the large texture manager
+  unsigned int m_largeHeight;
 
   CTextureInfo m_info;
   CAspectRatio m_aspect;
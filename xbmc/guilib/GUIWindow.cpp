@@ -27,6 +27,9 @@
 #include "GUIControlFactory.h"
 #include "GUIControlGroup.h"
 #include "GUIControlProfiler.h"
+#include "GUIWindowCache.h"
+#include "GUIWindowLoader.h"
+#include "TextureManager.h"
 #include "settings/Settings.h"
 #ifdef PRE_SKIN_VERSION_9_10_COMPATIBILITY
 #include "GUIEditControl.h"
@@ -75,6 +78,24 @@ CGUIWindow::CGUIWindow(int id, const CStdString &xmlFile)
 CGUIWindow::~CGUIWindow(void)
 {}
 
+// the textures of a window's controls - any element named for a texture
+// (<texture>, <texturefocus>, <midtexture> and so on) that isn't an info label
+static void GetTextureNames(const TiXmlElement *element, vector<CStdString> &textures)
+{
+  for (const TiXmlElement *child = element->FirstChildElement(); child; child = child->NextSiblingElement())
+  {
+    CStdString name = child->ValueStr();
+    if (name.ToLower().Find("texture") >= 0)
+    {
+      const TiXmlNode *text = child->FirstChild();
+      if (text && text->Type() == TiXmlNode::TINYXML_TEXT && !strchr(text->Value(), '$'))
+        textures.push_back(text->ValueStr());
+    }
+    else
+      GetTextureNames(child, textures);
+  }
+}
+
 bool CGUIWindow::Load(const CStdString& strFileName, bool bContainsPath)
 {
 #ifdef HAS_PERFORMANCE_SAMPLE
@@ -115,6 +136,27 @@ bool CGUIWindow::Load(const CStdString& strFileName, bool bContainsPath)
 
 bool CGUIWindow::LoadXML(const CStdString &strPath, const CStdString &strLowerPath)
 {
+  // use the document preloaded in the background, if there is one
+  bool resolved = false;
+  CXBMCTinyXML *preloaded = CGUIWindowLoader::Get().Take(strPath, resolved);
+  if (preloaded)
+  {
+    CGUIWindowLoader::Get().AddLoadTimes(strPath, 0, 0, 0, true);
+    bool ret = Load(*preloaded, resolved);
+    delete preloaded;
+    return ret;
+  }
+
+  int64_t start = CurrentHostCounter();
+  CXBMCTinyXML *cached = CGUIWindowCache::Get().Load(strPath);
+  if (cached)
+  {
+    CGUIWindowLoader::Get().AddLoadTimes(strPath, CurrentHostCounter() - start, 0, 0, false, true);
+    bool ret = Load(*cached, true);
+    delete cached;
+    return ret;
+  }
+
   CXBMCTinyXML xmlDoc;
   if ( !xmlDoc.LoadFile(strPath) && !xmlDoc.LoadFile(CStdString(strPath).ToLower()) && !xmlDoc.LoadFile(strLowerPath))
   {
@@ -122,11 +164,18 @@ bool CGUIWindow::LoadXML(const CStdString &strPath, const CStdString &strLowerPa
     SetID(WINDOW_INVALID);
     return false;
   }
+  int64_t parsed = CurrentHostCounter();
 
-  return Load(xmlDoc);
+  // resolve the includes here rather than in Load() so that the expanded window can be cached
+  TiXmlElement *pRootElement = xmlDoc.RootElement();
+  if (g_SkinInfo->ResolveIncludes(pRootElement) && pRootElement && !strcmpi(pRootElement->Value(), "window"))
+    CGUIWindowCache::Get().Store(strPath, pRootElement);
+  CGUIWindowLoader::Get().AddLoadTimes(strPath, parsed - start, CurrentHostCounter() - parsed, 0);
+
+  return Load(xmlDoc, true);
 }
 
-bool CGUIWindow::Load(CXBMCTinyXML &xmlDoc)
+bool CGUIWindow::Load(CXBMCTinyXML &xmlDoc, bool includesResolved /* = false */)
 {
   TiXmlElement* pRootElement = xmlDoc.RootElement();
   if (strcmpi(pRootElement->Value(), "window"))
@@ -140,7 +189,20 @@ bool CGUIWindow::Load(CXBMCTinyXML &xmlDoc)
   g_graphicsContext.SetScalingResolution(m_coordsRes, m_needsScaling);
 
   // Resolve any includes that may be present
-  g_SkinInfo->ResolveIncludes(pRootElement);
+  int64_t start = CurrentHostCounter();
+  if (!includesResolved)
+    g_SkinInfo->ResolveIncludes(pRootElement);
+  int64_t resolved = CurrentHostCounter();
+
+  // get the textures unpacking while we create the controls that use them - windows
+  // that aren't loaded on demand are loaded well before they're shown, so aren't worth it
+  if (m_loadOnDemand)
+  {
+    vector<CStdString> textures;
+    GetTextureNames(pRootElement, textures);
+    g_TextureManager.Prefetch(textures);
+  }
+
   // now load in the skin file
   SetDefaults();
 
@@ -233,6 +295,7 @@ bool CGUIWindow::Load(CXBMCTinyXML &xmlDoc)
     pChild = pChild->NextSiblingElement();
   }
   LoadAdditionalTags(pRootElement);
+  CGUIWindowLoader::Get().AddLoadTimes(GetProperty("xmlfile").asString(), 0, resolved - start, CurrentHostCounter() - resolved);
 
   m_windowLoaded = true;
   OnWindowLoaded();
@@ -668,12 +731,14 @@ void CGUIWindow::AllocResources(bool forceLoad /*= FALSE */)
 {
   CSingleLock lock(g_graphicsContext);
 
+  CStdString xmlFile = GetProperty("xmlfile").asString();
+  g_TextureManager.StartTimeline(xmlFile);
+
 #ifdef _DEBUG
   int64_t start;
   start = CurrentHostCounter();
 #endif
   // load skin xml fil
-  CStdString xmlFile = GetProperty("xmlfile").asString();
   bool bHasPath=false;
   if (xmlFile.Find("\\") > -1 || xmlFile.Find("/") > -1 )
     bHasPath = true;
@@ -692,6 +757,7 @@ void CGUIWindow::AllocResources(bool forceLoad /*= FALSE */)
   freq = CurrentHostFrequency();
   CLog::Log(LOGDEBUG,"Alloc resources: %.2fms (%.2f ms skin load)", 1000.f * (end - start) / freq, 1000.f * (slend - start) / freq);
 #endif
+  g_TextureManager.EndTimeline();
   m_bAllocated = true;
 }
 
@@ -0,0 +1,378 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "GUIWindowCache.h"
+#include "FileItem.h"
+#include "addons/Skin.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+#include "utils/log.h"
+
+#include <map>
+#include <vector>
+
+using namespace std;
+using namespace XFILE;
+
+#define WINDOWCACHE_MAGIC   "XBWC"
+#define WINDOWCACHE_VERSION 1
+
+enum WindowCacheNode
+{
+  NODE_ELEMENT = 0,
+  NODE_TEXT,
+  NODE_CDATA
+};
+
+/*
+ The cache file is laid out as
+   magic, version, stamp
+   string count, then each string as length and characters
+   the string index of the window's path
+   the root element
+ with each element as its type, name index, attribute count, name and value indices of its
+ attributes, child count and then its children, and each text as its type and value index.
+ */
+class CWindowCacheWriter
+{
+public:
+  void Write(const CStdString &path, uint32_t stamp, const TiXmlElement *root)
+  {
+    m_nodes.clear();
+    WriteUInt(GetString(path));
+    WriteElement(root);
+
+    m_data.clear();
+    m_data.append(WINDOWCACHE_MAGIC, 4);
+    Append(WINDOWCACHE_VERSION);
+    Append(stamp);
+    Append(m_strings.size());
+    for (vector<const string *>::const_iterator i = m_strings.begin(); i != m_strings.end(); ++i)
+    {
+      Append((*i)->size());
+      m_data.append(**i);
+    }
+    m_data.append(m_nodes);
+  }
+
+  const string &GetData() const { return m_data; };
+
+private:
+  void Append(uint32_t value)
+  {
+    m_data.append((const char *)&value, sizeof(value));
+  }
+
+  void WriteUInt(uint32_t value)
+  {
+    m_nodes.append((const char *)&value, sizeof(value));
+  }
+
+  void WriteByte(unsigned char value)
+  {
+    m_nodes.append(1, (char)value);
+  }
+
+  uint32_t GetString(const string &value)
+  {
+    map<string, uint32_t>::iterator i = m_indices.find(value);
+    if (i != m_indices.end())
+      return i->second;
+    i = m_indices.insert(make_pair(value, (uint32_t)m_strings.size())).first;
+    m_strings.push_back(&i->first);
+    return i->second;
+  }
+
+  void WriteElement(const TiXmlElement *element)
+  {
+    WriteByte(NODE_ELEMENT);
+    WriteUInt(GetString(element->ValueStr()));
+
+    uint32_t count = 0;
+    for (const TiXmlAttribute *attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+      count++;
+    WriteUInt(count);
+    for (const TiXmlAttribute *attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+    {
+      WriteUInt(GetString(attribute->NameTStr()));
+      WriteUInt(GetString(attribute->ValueStr()));
+    }
+
+    // comments and declarations are of no interest to the window
+    count = 0;
+    for (const TiXmlNode *child = element->FirstChild(); child; child = child->NextSibling())
+    {
+      if (child->Type() == TiXmlNode::TINYXML_ELEMENT || child->Type() == TiXmlNode::TINYXML_TEXT)
+        count++;
+    }
+    WriteUInt(count);
+    for (const TiXmlNode *child = element->FirstChild(); child; child = child->NextSibling())
+    {
+      if (child->Type() == TiXmlNode::TINYXML_ELEMENT)
+        WriteElement(child->ToElement());
+      else if (child->Type() == TiXmlNode::TINYXML_TEXT)
+      {
+        WriteByte(child->ToText()->CDATA() ? NODE_CDATA : NODE_TEXT);
+        WriteUInt(GetString(child->ValueStr()));
+      }
+    }
+  }
+
+  map<string, uint32_t> m_indices;
+  vector<const string *> m_strings;
+  string m_nodes;
+  string m_data;
+};
+
+class CWindowCacheReader
+{
+public:
+  CWindowCacheReader(const char *data, size_t size) : m_data(data), m_end(data + size), m_valid(true)
+  {
+  }
+
+  /*! \brief Read the document if it's of the given window and stamp.
+   \return the document, or NULL if the file doesn't match or is invalid.
+   */
+  CXBMCTinyXML *Read(const CStdString &path, uint32_t stamp)
+  {
+    if (m_end - m_data < 4 || memcmp(m_data, WINDOWCACHE_MAGIC, 4))
+      return NULL;
+    m_data += 4;
+    if (ReadUInt() != WINDOWCACHE_VERSION || ReadUInt() != stamp)
+      return NULL;
+
+    uint32_t count = ReadUInt();
+    if (!m_valid || count > (uint32_t)(m_end - m_data) / sizeof(uint32_t))
+      return NULL;
+    m_strings.reserve(count);
+    for (uint32_t i = 0; i < count && m_valid; i++)
+    {
+      uint32_t length = ReadUInt();
+      if (length > (uint32_t)(m_end - m_data))
+        m_valid = false;
+      else
+      {
+        m_strings.push_back(string(m_data, length));
+        m_data += length;
+      }
+    }
+
+    if (!m_valid || GetString(ReadUInt()) != path || ReadByte() != NODE_ELEMENT)
+      return NULL;
+
+    TiXmlElement *root = ReadElement();
+    if (!m_valid || m_data != m_end)
+    {
+      delete root;
+      return NULL;
+    }
+    CXBMCTinyXML *doc = new CXBMCTinyXML;
+    doc->LinkEndChild(root);
+    return doc;
+  }
+
+private:
+  uint32_t ReadUInt()
+  {
+    uint32_t value = 0;
+    if (m_end - m_data < (ptrdiff_t)sizeof(value))
+      m_valid = false;
+    else
+    {
+      memcpy(&value, m_data, sizeof(value));
+      m_data += sizeof(value);
+    }
+    return value;
+  }
+
+  unsigned char ReadByte()
+  {
+    if (m_data >= m_end)
+    {
+      m_valid = false;
+      return 0;
+    }
+    return (unsigned char)*m_data++;
+  }
+
+  const string &GetString(uint32_t index)
+  {
+    static const string empty;
+    if (index >= m_strings.size())
+    {
+      m_valid = false;
+      return empty;
+    }
+    return m_strings[index];
+  }
+
+  TiXmlElement *ReadElement()
+  {
+    TiXmlElement *element = new TiXmlElement(GetString(ReadUInt()));
+    uint32_t count = ReadUInt();
+    for (uint32_t i = 0; i < count && m_valid; i++)
+    {
+      const string &name = GetString(ReadUInt());
+      element->SetAttribute(name, GetString(ReadUInt()));
+    }
+
+    count = ReadUInt();
+    for (uint32_t i = 0; i < count && m_valid; i++)
+    {
+      unsigned char type = ReadByte();
+      if (type == NODE_ELEMENT)
+        element->LinkEndChild(ReadElement());
+      else if (type == NODE_TEXT || type == NODE_CDATA)
+      {
+        TiXmlText *text = new TiXmlText(GetString(ReadUInt()));
+        text->SetCDATA(type == NODE_CDATA);
+        element->LinkEndChild(text);
+      }
+      else
+        m_valid = false;
+    }
+    return element;
+  }
+
+  const char *m_data;
+  const char *m_end;
+  bool m_valid;
+  vector<string> m_strings;
+};
+
+CGUIWindowCache::CGUIWindowCache() : m_stamp(0)
+{
+}
+
+CGUIWindowCache &CGUIWindowCache::Get()
+{
+  static CGUIWindowCache cache;
+  return cache;
+}
+
+void CGUIWindowCache::Initialize()
+{
+  CSingleLock lock(m_section);
+  m_cachePath.clear();
+  if (!g_advancedSettings.m_guiCacheWindows || !g_SkinInfo)
+    return;
+
+  // any change to the skin's files may change the expansion of any window
+  Crc32 crc;
+  crc.Compute(g_SkinInfo->ID() + "|" + g_SkinInfo->Version().c_str());
+  vector<CStdString> paths;
+  g_SkinInfo->GetSkinPaths(paths);
+  for (vector<CStdString>::const_iterator i = paths.begin(); i != paths.end(); ++i)
+  {
+    CFileItemList items;
+    CDirectory::GetDirectory(*i, items, ".xml", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_BYPASS_CACHE);
+    items.Sort(SORT_METHOD_FILE, SortOrderAscending);
+    for (int j = 0; j < items.Size(); j++)
+    {
+      CStdString file;
+      file.Format("|%s|%s|%"PRId64, items[j]->GetPath().c_str(), items[j]->m_dateTime.GetAsDBDateTime().c_str(), items[j]->m_dwSize);
+      crc.Compute(file);
+    }
+  }
+  m_stamp = crc;
+
+  m_cachePath = URIUtils::AddFileToFolder(g_advancedSettings.m_cachePath, "skincache/");
+  if (!CDirectory::Exists(m_cachePath))
+    CDirectory::Create(m_cachePath);
+  m_cachePath = URIUtils::AddFileToFolder(m_cachePath, g_SkinInfo->ID() + "/");
+  if (!CDirectory::Exists(m_cachePath))
+    CDirectory::Create(m_cachePath);
+}
+
+void CGUIWindowCache::Clear()
+{
+  CSingleLock lock(m_section);
+  m_cachePath.clear();
+}
+
+CXBMCTinyXML *CGUIWindowCache::Load(const CStdString &path)
+{
+  CSingleLock lock(m_section);
+  if (m_cachePath.IsEmpty())
+    return NULL;
+  CStdString cacheFile = GetCacheFile(path);
+  uint32_t stamp = m_stamp;
+  lock.Leave();
+
+  // don't read a window while it's being written
+  CSingleLock writeLock(m_writeSection);
+  CFile file;
+  if (!file.Open(cacheFile))
+    return NULL;
+
+  int64_t length = file.GetLength();
+  if (length <= 0)
+    return NULL;
+  vector<char> data((size_t)length);
+  if (file.Read(&data[0], length) != length)
+    return NULL;
+  file.Close();
+  writeLock.Leave();
+
+  CWindowCacheReader reader(&data[0], data.size());
+  return reader.Read(path, stamp);
+}
+
+void CGUIWindowCache::Store(const CStdString &path, const TiXmlElement *root)
+{
+  CSingleLock lock(m_section);
+  if (m_cachePath.IsEmpty() || !root)
+    return;
+  CStdString cacheFile = GetCacheFile(path);
+  uint32_t stamp = m_stamp;
+  lock.Leave();
+
+  CWindowCacheWriter writer;
+  writer.Write(path, stamp, root);
+  const string &data = writer.GetData();
+
+  CSingleLock writeLock(m_writeSection);
+  CFile file;
+  if (!file.OpenForWrite(cacheFile, true))
+    return;
+  bool written = file.Write(data.c_str(), data.size()) == (int)data.size();
+  file.Close();
+  if (!written)
+  {
+    CLog::Log(LOGWARNING, "%s unable to write %s", __FUNCTION__, cacheFile.c_str());
+    CFile::Delete(cacheFile);
+  }
+}
+
+CStdString CGUIWindowCache::GetCacheFile(const CStdString &path) const
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(path);
+  CStdString file;
+  file.Format("%08x.bin", (uint32_t)crc);
+  return URIUtils::AddFileToFolder(m_cachePath, file);
+}
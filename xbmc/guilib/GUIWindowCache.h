@@ -0,0 +1,80 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "utils/StdString.h"
+
+#include <stdint.h>
+
+class CXBMCTinyXML;
+class TiXmlElement;
+
+/*!
+ \ingroup windows
+ \brief On-disk cache of skin windows with their includes, defaults and constants resolved.
+
+ Expanding includes is the bulk of the work of loading a window. Once a window has been
+ expanded, the resulting tree is written to <cachepath>/skincache/<skin>/ in a compact binary
+ form with a shared string table, which is read back far quicker than the skin XML can be
+ parsed and expanded. Windows using conditional includes aren't cached, as their expansion
+ depends on the state at the time they're loaded.
+
+ The cache of a window is used only while no XML file in the skin's resolution folders has
+ changed size or modification time, and the skin's id and version are the same.
+ Disable with <gui><cachewindows>false</cachewindows></gui> in advancedsettings.xml.
+ */
+class CGUIWindowCache
+{
+public:
+  static CGUIWindowCache &Get();
+
+  /*! \brief Stamp the current skin's files so that out of date windows are ignored.
+   Should be called from the GUI thread after the skin has been loaded.
+   */
+  void Initialize();
+
+  /*! \brief Stop using the cache until Initialize() is called again.
+   */
+  void Clear();
+
+  /*! \brief Read the expanded XML of a window from the cache.
+   \param path the path of the window's XML file, as resolved for the current resolution.
+   \return the document, to be deleted by the caller, or NULL if the window isn't cached or is out of date.
+   */
+  CXBMCTinyXML *Load(const CStdString &path);
+
+  /*! \brief Write the expanded XML of a window to the cache.
+   \param path the path of the window's XML file, as resolved for the current resolution.
+   \param root the root element of the window, with its includes resolved.
+   */
+  void Store(const CStdString &path, const TiXmlElement *root);
+
+private:
+  CGUIWindowCache();
+
+  CStdString GetCacheFile(const CStdString &path) const;
+
+  CCriticalSection m_section;
+  CCriticalSection m_writeSection;  ///< held while reading or writing a window's file
+  CStdString m_cachePath;           ///< empty when the cache isn't in use
+  uint32_t m_stamp;                 ///< hash of the skin's id, version and files
+};
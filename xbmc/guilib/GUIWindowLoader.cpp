@@ -0,0 +1,259 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "GUIWindowLoader.h"
+#include "GUIWindowCache.h"
+#include "addons/Skin.h"
+#include "threads/SingleLock.h"
+#include "utils/JobManager.h"
+#include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+#include "utils/log.h"
+
+using namespace std;
+
+class CWindowXMLJob : public CJob
+{
+public:
+  CWindowXMLJob(const ADDON::SkinPtr &skin, const CStdString &path, const CStdString &lowerPath)
+    : m_skin(skin), m_path(path), m_lowerPath(lowerPath), m_doc(NULL), m_resolved(false)
+  {
+  }
+
+  virtual ~CWindowXMLJob()
+  {
+    delete m_doc;
+  }
+
+  virtual const char *GetType() const { return "windowxml"; };
+
+  virtual bool DoWork()
+  {
+    m_doc = CGUIWindowCache::Get().Load(m_path);
+    if (m_doc)
+    {
+      m_resolved = true;
+      return true;
+    }
+
+    if (!Load())
+      return false;
+
+    TiXmlElement *root = m_doc->RootElement();
+    if (!root || strcmpi(root->Value(), "window"))
+      return false;
+
+    m_resolved = m_skin->ResolveIncludesInBackground(root);
+    if (!m_resolved)
+    { // we've been left with a partly resolved document, so start again for the gui thread
+      return Load();
+    }
+    CGUIWindowCache::Get().Store(m_path, root);
+    return true;
+  }
+
+  const CStdString &GetPath() const { return m_path; };
+  bool IsResolved() const { return m_resolved; };
+
+  CXBMCTinyXML *ReleaseDocument()
+  {
+    CXBMCTinyXML *doc = m_doc;
+    m_doc = NULL;
+    return doc;
+  }
+
+private:
+  bool Load()
+  {
+    // the same paths as tried by CGUIWindow::LoadXML
+    delete m_doc;
+    m_doc = new CXBMCTinyXML;
+    return m_doc->LoadFile(m_path) || m_doc->LoadFile(CStdString(m_path).ToLower()) || m_doc->LoadFile(m_lowerPath);
+  }
+
+  ADDON::SkinPtr m_skin;  ///< keeps the skin and its includes around until we're done
+  CStdString m_path;
+  CStdString m_lowerPath;
+  CXBMCTinyXML *m_doc;
+  bool m_resolved;
+};
+
+static CStdString GetSkinKey()
+{
+  if (!g_SkinInfo)
+    return "";
+  CStdString key;
+  key.Format("%s-%s", g_SkinInfo->ID().c_str(), g_SkinInfo->Version().c_str());
+  return key;
+}
+
+CGUIWindowLoader::CGUIWindowLoader()
+{
+}
+
+CGUIWindowLoader::~CGUIWindowLoader()
+{
+  for (map<CStdString, Document>::iterator it = m_documents.begin(); it != m_documents.end(); ++it)
+    delete it->second.doc;
+}
+
+CGUIWindowLoader &CGUIWindowLoader::Get()
+{
+  static CGUIWindowLoader loader;
+  return loader;
+}
+
+void CGUIWindowLoader::Preload(const vector<CStdString> &files)
+{
+  if (!g_SkinInfo)
+    return;
+
+  CSingleLock lock(m_section);
+  CStdString skin = GetSkinKey();
+  if (m_skin != skin)
+  { // documents of another skin are no use to us
+    for (map<CStdString, unsigned int>::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+      CJobManager::GetInstance().CancelJob(it->second);
+    m_jobs.clear();
+    for (map<CStdString, Document>::iterator it = m_documents.begin(); it != m_documents.end(); ++it)
+      delete it->second.doc;
+    m_documents.clear();
+    m_skin = skin;
+  }
+
+  for (vector<CStdString>::const_iterator it = files.begin(); it != files.end(); ++it)
+  {
+    // the same paths as used by CGUIWindow::Load, for the current resolution
+    CStdString path = g_SkinInfo->GetSkinPath(*it);
+    CStdString lowerPath = g_SkinInfo->GetSkinPath(CStdString(*it).ToLower());
+    if (m_jobs.find(path) != m_jobs.end() || m_documents.find(path) != m_documents.end())
+      continue;
+    m_jobs[path] = CJobManager::GetInstance().AddJob(new CWindowXMLJob(g_SkinInfo, path, lowerPath), this);
+  }
+  CLog::Log(LOGDEBUG, "%s preloading %u windows of %s", __FUNCTION__, (unsigned int)m_jobs.size(), m_skin.c_str());
+}
+
+CXBMCTinyXML *CGUIWindowLoader::Take(const CStdString &path, bool &resolved)
+{
+  CSingleLock lock(m_section);
+  if (m_jobs.empty() && m_documents.empty())
+    return NULL;
+
+  if (m_skin != GetSkinKey())
+    return NULL;
+
+  map<CStdString, Document>::iterator it = m_documents.find(path);
+  if (it != m_documents.end())
+  {
+    CXBMCTinyXML *doc = it->second.doc;
+    resolved = it->second.resolved;
+    m_documents.erase(it);
+    return doc;
+  }
+
+  // still being parsed - it's quicker to load it ourselves than to wait
+  // for it behind the other windows, so forget about it
+  map<CStdString, unsigned int>::iterator job = m_jobs.find(path);
+  if (job != m_jobs.end())
+  {
+    CJobManager::GetInstance().CancelJob(job->second);
+    m_jobs.erase(job);
+  }
+  return NULL;
+}
+
+void CGUIWindowLoader::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CWindowXMLJob *xmlJob = (CWindowXMLJob *)job;
+
+  CSingleLock lock(m_section);
+  map<CStdString, unsigned int>::iterator it = m_jobs.find(xmlJob->GetPath());
+  if (it == m_jobs.end() || it->second != jobID)
+    return; // taken or cleared meanwhile
+  m_jobs.erase(it);
+
+  if (!success)
+  {
+    CLog::Log(LOGDEBUG, "%s unable to preload %s", __FUNCTION__, xmlJob->GetPath().c_str());
+    return;
+  }
+
+  Document document;
+  document.resolved = xmlJob->IsResolved();
+  document.doc = xmlJob->ReleaseDocument();
+  m_documents[xmlJob->GetPath()] = document;
+}
+
+void CGUIWindowLoader::Clear()
+{
+  CSingleLock lock(m_section);
+  for (map<CStdString, unsigned int>::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+    CJobManager::GetInstance().CancelJob(it->second);
+  m_jobs.clear();
+  for (map<CStdString, Document>::iterator it = m_documents.begin(); it != m_documents.end(); ++it)
+    delete it->second.doc;
+  m_documents.clear();
+  m_skin.clear();
+
+  LogLoadTimes();
+  m_loadTimes.clear();
+}
+
+void CGUIWindowLoader::AddLoadTimes(const CStdString &file, int64_t parse, int64_t includes, int64_t controls, bool preloaded, bool cached)
+{
+  CSingleLock lock(m_section);
+  LoadTimes &times = m_loadTimes[URIUtils::GetFileName(file)];
+  times.parse += parse;
+  times.includes += includes;
+  times.controls += controls;
+  if (preloaded)
+    times.preloaded = true;
+  if (cached)
+    times.cached = true;
+}
+
+void CGUIWindowLoader::LogLoadTimes()
+{
+  if (m_loadTimes.empty())
+    return;
+
+  float scale = 1000.0f / CurrentHostFrequency();
+  LoadTimes total;
+  unsigned int preloaded = 0;
+  unsigned int cached = 0;
+  for (map<CStdString, LoadTimes>::const_iterator it = m_loadTimes.begin(); it != m_loadTimes.end(); ++it)
+  {
+    const LoadTimes &times = it->second;
+    CLog::Log(LOGDEBUG, "Window load %s: parse %.2fms, includes %.2fms, controls %.2fms%s%s", it->first.c_str(),
+              scale * times.parse, scale * times.includes, scale * times.controls,
+              times.preloaded ? " (preloaded)" : "", times.cached ? " (cached)" : "");
+    total.parse += times.parse;
+    total.includes += times.includes;
+    total.controls += times.controls;
+    if (times.preloaded)
+      preloaded++;
+    if (times.cached)
+      cached++;
+  }
+  CLog::Log(LOGDEBUG, "Window load total for %u windows (%u preloaded, %u cached): parse %.2fms, includes %.2fms, controls %.2fms",
+            (unsigned int)m_loadTimes.size(), preloaded, cached, scale * total.parse, scale * total.includes, scale * total.controls);
+}
@@ -0,0 +1,103 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "utils/Job.h"
+#include "utils/StdString.h"
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+class CXBMCTinyXML;
+
+/*!
+ \ingroup windows
+ \brief Preloads the XML of skin windows in the background, and profiles window loading.
+
+ Windows that are loaded on demand are loaded on the GUI thread the first time they're opened.
+ With <gui><preloadwindows> set in advancedsettings.xml, the XML of those windows is parsed and
+ has its includes resolved by the job manager's workers as soon as the skin is loaded, so that
+ opening them only has to create their controls. Windows using conditional includes or includes
+ from other files are only parsed, as those includes have to be resolved on the GUI thread.
+
+ Windows are read from the CGUIWindowCache where possible, both here and on the GUI thread.
+
+ The time spent parsing, resolving includes and creating controls is kept for every window
+ loaded, and logged when the skin is unloaded.
+ */
+class CGUIWindowLoader : public IJobCallback
+{
+public:
+  static CGUIWindowLoader &Get();
+
+  /*! \brief Start preloading the XML of the given windows for the current skin.
+   \param files the XML files of the windows, relative to the skin.
+   */
+  void Preload(const std::vector<CStdString> &files);
+
+  /*! \brief Take the preloaded XML of a window, if we have it.
+   Windows still being parsed aren't waited for.
+   \param path the path of the XML file, as resolved for the current resolution.
+   \param resolved [out] whether the includes of the document have been resolved.
+   \return the document, to be deleted by the caller, or NULL if it hasn't been preloaded.
+   */
+  CXBMCTinyXML *Take(const CStdString &path, bool &resolved);
+
+  /*! \brief Forget all preloaded windows, and log the load times of the skin.
+   */
+  void Clear();
+
+  /*! \brief Add to the time spent loading a window, in host counter ticks.
+   */
+  void AddLoadTimes(const CStdString &file, int64_t parse, int64_t includes, int64_t controls, bool preloaded = false, bool cached = false);
+
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
+private:
+  CGUIWindowLoader();
+  virtual ~CGUIWindowLoader();
+
+  struct LoadTimes
+  {
+    LoadTimes() : parse(0), includes(0), controls(0), preloaded(false), cached(false) {};
+    int64_t parse;
+    int64_t includes;
+    int64_t controls;
+    bool preloaded;
+    bool cached;
+  };
+
+  struct Document
+  {
+    CXBMCTinyXML *doc;
+    bool resolved;
+  };
+
+  void LogLoadTimes();
+
+  CCriticalSection m_section;
+  CStdString m_skin;                                ///< id and version of the skin preloaded for
+  std::map<CStdString, unsigned int> m_jobs;        ///< jobs preloading, by path
+  std::map<CStdString, Document> m_documents;       ///< preloaded documents, by path
+  std::map<CStdString, LoadTimes> m_loadTimes;      ///< load times, by window file
+};
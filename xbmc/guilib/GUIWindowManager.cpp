@@ -22,6 +22,8 @@
 #include "GUIWindowManager.h"
 #include "GUIAudioManager.h"
 #include "GUIDialog.h"
+#include "GUIWindowCache.h"
+#include "GUIWindowLoader.h"
 #include "Application.h"
 #include "ApplicationMessenger.h"
 #include "GUIPassword.h"
@@ -55,6 +57,9 @@ void CGUIWindowManager::Initialize()
   m_tracker.SelectAlgorithm();
   m_initialized = true;
 
+  CGUIWindowCache::Get().Initialize();
+  if (g_advancedSettings.m_guiPreloadWindows)
+    PreloadWindows();
   LoadNotOnDemandWindows();
 }
 
@@ -653,6 +658,9 @@ void CGUIWindowManager::SetCallback(IWindowManagerCallback& callback)
 
 void CGUIWindowManager::DeInitialize()
 {
+  CGUIWindowLoader::Get().Clear();
+  CGUIWindowCache::Get().Clear();
+
   CSingleLock lock(g_graphicsContext);
   for (WindowMap::iterator it = m_mapWindows.begin(); it != m_mapWindows.end(); it++)
   {
@@ -864,6 +872,22 @@ void CGUIWindowManager::LoadNotOnDemandWindows()
   }
 }
 
+void CGUIWindowManager::PreloadWindows()
+{
+  vector<CStdString> files;
+  CSingleLock lock(g_graphicsContext);
+  for (WindowMap::iterator it = m_mapWindows.begin(); it != m_mapWindows.end(); it++)
+  {
+    CGUIWindow *pWindow = (*it).second;
+    CStdString xmlFile = pWindow->GetProperty("xmlfile").asString();
+    if (pWindow->GetLoadOnDemand() && !xmlFile.IsEmpty())
+      files.push_back(xmlFile);
+  }
+  lock.Leave();
+
+  CGUIWindowLoader::Get().Preload(files);
+}
+
 void CGUIWindowManager::UnloadNotOnDemandWindows()
 {
   CSingleLock lock(g_graphicsContext);
@@ -931,6 +955,14 @@ void CGUIWindowManager::GetActiveModelessWindows(vector<int> &ids)
   }
 }
 
+void CGUIWindowManager::GetActiveWindowState(vector<int> &ids) const
+{
+  CSingleLock lock(g_graphicsContext);
+  ids.push_back(GetActiveWindow());
+  for (ciDialog it = m_activeDialogs.begin(); it != m_activeDialogs.end(); ++it)
+    ids.push_back((*it)->IsAnimating(ANIM_TYPE_WINDOW_CLOSE) ? -(*it)->GetID() : (*it)->GetID());
+}
+
 CGUIWindow *CGUIWindowManager::GetTopMostDialog() const
 {
   CSingleLock lock(g_graphicsContext);
@@ -127,6 +127,11 @@ public:
   bool IsOverlayAllowed() const;
   void ShowOverlay(CGUIWindow::OVERLAY_STATE state);
   void GetActiveModelessWindows(std::vector<int> &ids);
+
+  /*! \brief Get the active window followed by the active dialogs, negated while they're closing.
+   Whether windows are active, visible or topmost only changes when this does.
+   */
+  void GetActiveWindowState(std::vector<int> &ids) const;
 #ifdef _DEBUG
   void DumpTextureUse();
 #endif
@@ -135,6 +140,7 @@ private:
 
   void LoadNotOnDemandWindows();
   void UnloadNotOnDemandWindows();
+  void PreloadWindows();
   void HideOverlay(CGUIWindow::OVERLAY_STATE state);
   void AddToWindowHistory(int newWindowID);
   void ClearWindowHistory();
@@ -118,6 +118,16 @@ void CGraphicContext::RestoreClipRegion()
   // here we could reset the hardware clipping, if applicable
 }
 
+bool CGraphicContext::GetClipRegion(CRect &region) const
+{
+  if (m_clipRegions.empty())
+    return false;
+  region = m_clipRegions.top();
+  if (m_origins.size())
+    region -= m_origins.top();
+  return true;
+}
+
 void CGraphicContext::ClipRect(CRect &vertex, CRect &texture, CRect *texture2)
 {
   // this is the software clipping routine.  If the graphics hardware is set to do the clipping
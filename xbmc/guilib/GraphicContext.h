@@ -170,6 +170,13 @@ public:
   void ApplyHardwareTransform();
   void RestoreHardwareTransform();
   void ClipRect(CRect &vertex, CRect &texture, CRect *diffuse = NULL);
+
+  /*! \brief Get the clip region used by ClipRect, relative to the current origin
+   \param region [out] the clip region.
+   \return true if there is a clip region, false otherwise.
+   */
+  bool GetClipRegion(CRect &region) const;
+  inline const TransformMatrix &GetFinalTransform() const XBMC_FORCE_INLINE { return m_finalTransform; }
   inline unsigned int AddGUITransform()
   {
     unsigned int size = m_groupTransform.size();
@@ -30,6 +30,7 @@
 #include "JpegIO.h"
 
 #include <setjmp.h>
+#include <algorithm>
 
 #define EXIF_TAG_ORIENTATION    0x0112
 
@@ -309,6 +310,7 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
     If the res is greater than the one desired, use that one since there's no need
     to decode a bigger one just to squish it back down. If the res is greater than
     the gpu can hold, use the previous one.*/
+    bool exactSize = minx && miny;
     if (minx == 0 || miny == 0)
     {
       miny = g_advancedSettings.m_imageRes;
@@ -341,6 +343,19 @@ bool CJpegIO::Read(unsigned char* buffer, unsigned int bufSize, unsigned int min
     m_width  = m_cinfo.output_width;
     m_height = m_cinfo.output_height;
 
+    /* libjpeg only gets us to the next eighth (or half, with older versions) above the size
+    asked for. If a size was asked for and we're still well above it, average the decoded
+    pixels down to the smallest size that still covers it as we decode. */
+    if (exactSize && m_width > minx && m_height > miny)
+    {
+      float scale = std::max((float)minx / m_width, (float)miny / m_height);
+      if (scale < 0.875f)
+      {
+        m_width  = std::max(minx, (unsigned int)(m_width * scale + 0.5f));
+        m_height = std::max(miny, (unsigned int)(m_height * scale + 0.5f));
+      }
+    }
+
     if (m_cinfo.marker_list)
       m_orientation = GetExifOrientation(m_cinfo.marker_list->data, m_cinfo.marker_list->data_length);
     return true;
@@ -362,9 +377,19 @@ bool CJpegIO::Decode(const unsigned char *pixels, unsigned int pitch, unsigned i
   }
   else
   {
+    bool scaled = m_width != m_cinfo.output_width || m_height != m_cinfo.output_height;
+#ifdef JCS_ALPHA_EXTENSIONS
+    // libjpeg-turbo can decode straight into our texture format
+    if (format == XB_FMT_A8R8G8B8 && !scaled)
+      m_cinfo.out_color_space = JCS_EXT_BGRA;
+#endif
     jpeg_start_decompress(&m_cinfo);
 
-    if (format == XB_FMT_RGB8)
+    if (scaled && (format == XB_FMT_RGB8 || format == XB_FMT_A8R8G8B8))
+    {
+      DecodeScaled(dst, pitch, format);
+    }
+    else if (format == XB_FMT_RGB8 || m_cinfo.out_color_space != JCS_RGB)
     {
       while (m_cinfo.output_scanline < m_height)
       {
@@ -403,6 +428,82 @@ bool CJpegIO::Decode(const unsigned char *pixels, unsigned int pitch, unsigned i
   return true;
 }
 
+void CJpegIO::DecodeScaled(unsigned char *dst, unsigned int pitch, unsigned int format)
+{
+  // each of our pixels is the average of the decoded pixels within it
+  unsigned int decodedWidth = m_cinfo.output_width;
+  unsigned int decodedHeight = m_cinfo.output_height;
+
+  unsigned int *columns = new unsigned int[m_width + 1]; // first decoded column of each of our columns
+  for (unsigned int x = 0; x <= m_width; x++)
+    columns[x] = (unsigned int)((uint64_t)x * decodedWidth / m_width);
+
+  unsigned int *sums = new unsigned int[m_width * 3];
+  memset(sums, 0, m_width * 3 * sizeof(unsigned int));
+  unsigned char *row = new unsigned char[decodedWidth * 3];
+
+  unsigned int y = 0;
+  unsigned int rows = 0;
+  unsigned int nextRow = (unsigned int)((uint64_t)decodedHeight / m_height); // first decoded row of our next row
+  while (m_cinfo.output_scanline < decodedHeight && y < m_height)
+  {
+    jpeg_read_scanlines(&m_cinfo, &row, 1);
+    rows++;
+
+    const unsigned char *src = row;
+    unsigned int *sum = sums;
+    for (unsigned int x = 0; x < m_width; x++, sum += 3)
+    {
+      for (unsigned int i = columns[x]; i < columns[x + 1]; i++, src += 3)
+      {
+        sum[0] += src[0];
+        sum[1] += src[1];
+        sum[2] += src[2];
+      }
+    }
+
+    if (m_cinfo.output_scanline < nextRow)
+      continue;
+
+    // we have all of this row, so write it out
+    unsigned char *dst2 = dst;
+    sum = sums;
+    for (unsigned int x = 0; x < m_width; x++, sum += 3)
+    {
+      unsigned int count = (columns[x + 1] - columns[x]) * rows;
+      unsigned char r = (unsigned char)((sum[0] + count / 2) / count);
+      unsigned char g = (unsigned char)((sum[1] + count / 2) / count);
+      unsigned char b = (unsigned char)((sum[2] + count / 2) / count);
+      if (format == XB_FMT_RGB8)
+      {
+        *dst2++ = r;
+        *dst2++ = g;
+        *dst2++ = b;
+      }
+      else
+      {
+        *dst2++ = b;
+        *dst2++ = g;
+        *dst2++ = r;
+        *dst2++ = 0xff;
+      }
+    }
+    memset(sums, 0, m_width * 3 * sizeof(unsigned int));
+    rows = 0;
+    dst += pitch;
+    y++;
+    nextRow = (unsigned int)((uint64_t)(y + 1) * decodedHeight / m_height);
+  }
+
+  // libjpeg complains if we finish without reading all the rows
+  while (m_cinfo.output_scanline < decodedHeight)
+    jpeg_read_scanlines(&m_cinfo, &row, 1);
+
+  delete[] row;
+  delete[] sums;
+  delete[] columns;
+}
+
 bool CJpegIO::CreateThumbnail(const CStdString& sourceFile, const CStdString& destFile, int minx, int miny, bool rotateExif)
 {
   //Copy sourceFile to buffer, pass to CreateThumbnailFromMemory for decode+re-encode
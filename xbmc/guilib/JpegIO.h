@@ -52,13 +52,14 @@ protected:
   static  void   jpeg_error_exit(j_common_ptr cinfo);
 
   unsigned int   GetExifOrientation(unsigned char* exif_data, unsigned int exif_data_size);
+  void           DecodeScaled(unsigned char *dst, unsigned int pitch, unsigned int format);
 
   unsigned char  *m_inputBuff;
   unsigned int   m_inputBuffSize;
   struct         jpeg_decompress_struct m_cinfo;
   CStdString     m_texturePath;
 
-  unsigned int   m_width;
+  unsigned int   m_width;       ///< width we decode to, which may be smaller than libjpeg's output
   unsigned int   m_height;
   unsigned int   m_orientation;
 };
@@ -0,0 +1,119 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "TextLayoutCache.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+
+using namespace std;
+
+bool CTextLayoutCache::Key::operator <(const Key &right) const
+{
+  if (font != right.font) return font < right.font;
+  if (maxWidth != right.maxWidth) return maxWidth < right.maxWidth;
+  if (maxHeight != right.maxHeight) return maxHeight < right.maxHeight;
+  if (forceLTRReadingOrder != right.forceLTRReadingOrder) return forceLTRReadingOrder < right.forceLTRReadingOrder;
+  if (scaleX != right.scaleX) return scaleX < right.scaleX;
+  if (scaleY != right.scaleY) return scaleY < right.scaleY;
+  return text < right.text;
+}
+
+CTextLayoutCache::CTextLayoutCache() : m_size(0), m_counter(0), m_hits(0), m_misses(0), m_evictions(0)
+{
+}
+
+bool CTextLayoutCache::Get(const Key &key, vector<CGUIString> &lines, vecColors &colors, float &width, float &height)
+{
+  CSingleLock lock(m_section);
+  LayoutMap::iterator i = m_layouts.find(key);
+  if (i == m_layouts.end())
+  {
+    m_misses++;
+    return false;
+  }
+  m_hits++;
+  Layout &layout = i->second;
+  layout.lastUsed = ++m_counter;
+  lines = layout.lines;
+  colors = layout.colors;
+  width = layout.width;
+  height = layout.height;
+  return true;
+}
+
+void CTextLayoutCache::Add(const Key &key, const vector<CGUIString> &lines, const vecColors &colors, float width, float height)
+{
+  unsigned int size = sizeof(Layout) + 2 * key.text.size() * sizeof(wchar_t) + colors.size() * sizeof(color_t);
+  for (vector<CGUIString>::const_iterator i = lines.begin(); i != lines.end(); ++i)
+    size += sizeof(CGUIString) + i->m_text.size() * sizeof(character_t);
+  if (size > TEXT_LAYOUT_CACHE_SIZE / 16)
+    return; // not worth pushing out everything else for
+
+  CSingleLock lock(m_section);
+  Layout &layout = m_layouts[key];
+  m_size += size - layout.size;
+  layout.lines = lines;
+  layout.colors = colors;
+  layout.width = width;
+  layout.height = height;
+  layout.size = size;
+  layout.lastUsed = ++m_counter;
+
+  if (m_size > TEXT_LAYOUT_CACHE_SIZE)
+    Evict();
+}
+
+void CTextLayoutCache::Clear()
+{
+  CSingleLock lock(m_section);
+  if (m_hits + m_misses)
+    CLog::Log(LOGDEBUG, "%s %u of %u text layouts reused (%u%%), %u dropped, %u kept in %u bytes", __FUNCTION__,
+              m_hits, m_hits + m_misses, 100 * m_hits / (m_hits + m_misses), m_evictions, (unsigned int)m_layouts.size(), m_size);
+  m_layouts.clear();
+  m_size = 0;
+  m_hits = m_misses = m_evictions = 0;
+}
+
+void CTextLayoutCache::Evict()
+{
+  // drop the least recently used layouts until we're down to 3/4 of the limit, so that
+  // we don't have to do this again for a while
+  vector< pair<unsigned int, LayoutMap::iterator> > layouts;
+  layouts.reserve(m_layouts.size());
+  for (LayoutMap::iterator i = m_layouts.begin(); i != m_layouts.end(); ++i)
+    layouts.push_back(make_pair(i->second.lastUsed, i));
+  sort(layouts.begin(), layouts.end(), CompareLastUsed);
+
+  for (unsigned int i = 0; i < layouts.size() && m_size > TEXT_LAYOUT_CACHE_SIZE * 3 / 4; i++)
+  {
+    m_size -= layouts[i].second->second.size;
+    m_layouts.erase(layouts[i].second);
+    m_evictions++;
+  }
+}
+
+bool CTextLayoutCache::CompareLastUsed(const pair<unsigned int, LayoutMap::iterator> &left,
+                                       const pair<unsigned int, LayoutMap::iterator> &right)
+{
+  return left.first < right.first;
+}
@@ -0,0 +1,85 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "GUITextLayout.h"
+#include "threads/CriticalSection.h"
+
+#include <map>
+
+#define TEXT_LAYOUT_CACHE_SIZE (4 * 1024 * 1024)  // approximate bytes of laid out text kept for reuse
+
+/*!
+ \brief Laid out text, kept for reuse by any layout given the same text with the same font and constraints.
+
+ Converting text from utf8 (with bidi flipping), parsing its formatting and wrapping it is done again
+ whenever the text of a label changes, which in lists happens to the same few strings over and over
+ as items scroll past.  The least recently used layouts are dropped once they take up more than
+ TEXT_LAYOUT_CACHE_SIZE bytes.
+ */
+class CTextLayoutCache
+{
+public:
+  struct Key
+  {
+    CStdStringW text;
+    const CGUIFont *font;
+    float maxWidth;    // 0 unless wrapping
+    float maxHeight;
+    bool forceLTRReadingOrder;
+    float scaleX;      // the gui scale the text was measured at, as widths and heights depend on it
+    float scaleY;
+
+    bool operator <(const Key &right) const;
+  };
+
+  CTextLayoutCache();
+
+  bool Get(const Key &key, std::vector<CGUIString> &lines, vecColors &colors, float &width, float &height);
+  void Add(const Key &key, const std::vector<CGUIString> &lines, const vecColors &colors, float width, float height);
+  void Clear();
+
+private:
+  struct Layout
+  {
+    std::vector<CGUIString> lines;
+    vecColors colors;
+    float width;
+    float height;
+    unsigned int size;
+    unsigned int lastUsed;
+  };
+  typedef std::map<Key, Layout> LayoutMap;
+
+  void Evict();
+  static bool CompareLastUsed(const std::pair<unsigned int, LayoutMap::iterator> &left,
+                              const std::pair<unsigned int, LayoutMap::iterator> &right);
+
+  CCriticalSection m_section;
+  LayoutMap m_layouts;
+  unsigned int m_size;
+  unsigned int m_counter;
+
+  // statistics
+  unsigned int m_hits;
+  unsigned int m_misses;
+  unsigned int m_evictions;
+};
@@ -27,12 +27,97 @@
 #include "DDSImage.h"
 #include "filesystem/SpecialProtocol.h"
 #include "JpegIO.h"
+#include "TextureBundleXBT.h"
+#include "XBTFReader.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "utils/EndianSwap.h"
+
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #if defined(TARGET_DARWIN_IOS)
 #include <ImageIO/ImageIO.h>
 #include "filesystem/File.h"
 #include "osx/DarwinUtils.h"
 #endif
 
+#define PIXEL_POOL_MIN_BUFFER  (64 * 1024)         // smaller buffers are cheap enough to allocate
+#define PIXEL_POOL_SIZE        (16 * 1024 * 1024)  // most memory kept in unused buffers
+
+/*!
+ \brief Pixel buffers freed by textures, kept for reuse by those allocated next.
+ A buffer is reused for any texture needing at least 3/4 of it, and the oldest
+ buffers are released once the pool exceeds PIXEL_POOL_SIZE.
+ */
+class CPixelBufferPool
+{
+public:
+  CPixelBufferPool() : m_size(0) {};
+
+  unsigned char *Get(unsigned int size, unsigned int &allocated)
+  {
+    if (size >= PIXEL_POOL_MIN_BUFFER)
+    {
+      CSingleLock lock(m_section);
+      std::vector<Buffer>::iterator best = m_buffers.end();
+      for (std::vector<Buffer>::iterator i = m_buffers.begin(); i != m_buffers.end(); ++i)
+      {
+        if (i->size >= size && i->size / 4 * 3 <= size && (best == m_buffers.end() || i->size < best->size))
+          best = i;
+      }
+      if (best != m_buffers.end())
+      {
+        unsigned char *pixels = best->pixels;
+        allocated = best->size;
+        m_size -= best->size;
+        m_buffers.erase(best);
+        return pixels;
+      }
+    }
+    allocated = size;
+    return new unsigned char[size];
+  }
+
+  void Release(unsigned char *pixels, unsigned int size)
+  {
+    if (size < PIXEL_POOL_MIN_BUFFER || size > PIXEL_POOL_SIZE / 2)
+    {
+      delete[] pixels;
+      return;
+    }
+    CSingleLock lock(m_section);
+    Buffer buffer = { pixels, size };
+    m_buffers.push_back(buffer);
+    m_size += size;
+    while (m_size > PIXEL_POOL_SIZE)
+    {
+      m_size -= m_buffers.front().size;
+      delete[] m_buffers.front().pixels;
+      m_buffers.erase(m_buffers.begin());
+    }
+  }
+
+private:
+  struct Buffer
+  {
+    unsigned char *pixels;
+    unsigned int size;
+  };
+
+  CCriticalSection m_section;
+  std::vector<Buffer> m_buffers;  // oldest first
+  unsigned int m_size;
+};
+
+static CPixelBufferPool &GetPixelBufferPool()
+{
+  // never destroyed, as textures held by other statics may be freed after it would be
+  static CPixelBufferPool *pool = new CPixelBufferPool;
+  return *pool;
+}
+
 /************************************************************************/
 /*                                                                      */
 /************************************************************************/
@@ -40,6 +125,7 @@ CBaseTexture::CBaseTexture(unsigned int width, unsigned int height, unsigned int
  : m_hasAlpha( true )
 {
   m_pixels = NULL;
+  m_pixelsSize = 0;
   m_loadedToGPU = false;
   Allocate(width, height, format);
 }
@@ -54,17 +140,26 @@ CBaseTexture::CBaseTexture(const CBaseTexture &copy)
   m_orientation = copy.m_orientation;
   m_hasAlpha = copy.m_hasAlpha;
   m_pixels = NULL;
+  m_pixelsSize = 0;
   m_loadedToGPU = false;
   if (copy.m_pixels)
   {
-    m_pixels = new unsigned char[GetPitch() * GetRows()];
+    m_pixels = GetPixelBufferPool().Get(GetPitch() * GetRows(), m_pixelsSize);
     memcpy(m_pixels, copy.m_pixels, GetPitch() * GetRows());
   }
 }
 
 CBaseTexture::~CBaseTexture()
 {
-  delete[] m_pixels;
+  FreePixels();
+}
+
+void CBaseTexture::FreePixels()
+{
+  if (m_pixels)
+    GetPixelBufferPool().Release(m_pixels, m_pixelsSize);
+  m_pixels = NULL;
+  m_pixelsSize = 0;
 }
 
 void CBaseTexture::Allocate(unsigned int width, unsigned int height, unsigned int format)
@@ -98,8 +193,12 @@ void CBaseTexture::Allocate(unsigned int width, unsigned int height, unsigned in
   CLAMP(m_textureHeight, g_Windowing.GetMaxTextureSize());
   CLAMP(m_imageWidth, m_textureWidth);
   CLAMP(m_imageHeight, m_textureHeight);
-  delete[] m_pixels;
-  m_pixels = new unsigned char[GetPitch() * GetRows()];
+  unsigned int size = GetPitch() * GetRows();
+  if (!m_pixels || m_pixelsSize < size || m_pixelsSize / 4 * 3 > size)
+  {
+    FreePixels();
+    m_pixels = GetPixelBufferPool().Get(size, m_pixelsSize);
+  }
 }
 
 void CBaseTexture::Update(unsigned int width, unsigned int height, unsigned int pitch, unsigned int format, const unsigned char *pixels, bool loadToGPU)
@@ -203,6 +302,25 @@ bool CBaseTexture::LoadFromFile(const CStdString& texturePath, unsigned int maxW
     return false;
   }
 
+  if (URIUtils::GetExtension(texturePath).Equals(".xbt"))
+  { // special case for textures packed by the texture cache, which are ready to upload as they are
+    CXBTFReader reader;
+    if (!reader.Open(CSpecialProtocol::TranslatePath(texturePath)) || reader.GetFiles().empty() ||
+        reader.GetFiles()[0].GetFrames().empty())
+    {
+      reader.Close(); // a failed Open() may leave the file open
+      return false;
+    }
+    CXBTFFrame frame = reader.GetFiles()[0].GetFrames()[0]; // Close() drops the reader's frames
+    unsigned char *pixels = CTextureBundleXBT::UnpackFrame(reader, frame, texturePath);
+    reader.Close();
+    if (!pixels)
+      return false;
+    LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), pixels);
+    delete[] pixels;
+    return true;
+  }
+
   //ImageLib is sooo sloow for jpegs. Try our own decoder first. If it fails, fall back to ImageLib.
   if (URIUtils::GetExtension(texturePath).Equals(".jpg") || URIUtils::GetExtension(texturePath).Equals(".tbn"))
   {
@@ -397,6 +515,35 @@ unsigned int CBaseTexture::PadPow2(unsigned int x)
 bool CBaseTexture::SwapBlueRed(unsigned char *pixels, unsigned int height, unsigned int pitch, unsigned int elements, unsigned int offset)
 {
   if (!pixels) return false;
+#ifndef WORDS_BIGENDIAN
+  if (elements == 4 && offset == 0 && (pitch & 3) == 0 && ((size_t)pixels & 3) == 0)
+  { // swap whole pixels at a time
+    for (unsigned int y = 0; y < height; y++)
+    {
+      uint32_t *row = (uint32_t *)(pixels + y * pitch);
+      unsigned int count = pitch / 4;
+      unsigned int x = 0;
+#ifdef __SSE2__
+      const __m128i greenAlpha = _mm_set1_epi32(0xff00ff00);
+      const __m128i lowByte = _mm_set1_epi32(0x000000ff);
+      for (; x + 4 <= count; x += 4)
+      {
+        __m128i p = _mm_loadu_si128((const __m128i *)(row + x));
+        __m128i swapped = _mm_or_si128(_mm_and_si128(p, greenAlpha),
+                          _mm_or_si128(_mm_slli_epi32(_mm_and_si128(p, lowByte), 16),
+                                       _mm_and_si128(_mm_srli_epi32(p, 16), lowByte)));
+        _mm_storeu_si128((__m128i *)(row + x), swapped);
+      }
+#endif
+      for (; x < count; x++)
+      {
+        uint32_t p = row[x];
+        row[x] = (p & 0xff00ff00) | ((p & 0xff) << 16) | ((p >> 16) & 0xff);
+      }
+    }
+    return true;
+  }
+#endif
   unsigned char *dst = pixels;
   for (unsigned int y = 0; y < height; y++)
   {
@@ -106,6 +106,12 @@ protected:
   bool LoadFromFileInMem(unsigned char* buffer, size_t size, const std::string& mimeType,
                          unsigned int maxWidth, unsigned int maxHeight);
   void LoadFromImage(ImageInfo &image, bool autoRotate = false);
+
+  /*! \brief Release our pixels to be reused by the next texture allocated at a similar size.
+   Textures are loaded one after another by the large texture loader, usually at the same few sizes,
+   so recently freed pixel buffers are kept in a small pool rather than going back to the heap.
+   */
+  void FreePixels();
   // helpers for computation of texture parameters for compressed textures
   unsigned int GetPitch(unsigned int width) const;
   unsigned int GetRows(unsigned int height) const;
@@ -117,6 +123,7 @@ protected:
   unsigned int m_textureHeight;
 
   unsigned char* m_pixels;
+  unsigned int m_pixelsSize;  ///< size of the buffer held in m_pixels, which may be larger than needed
   bool m_loadedToGPU;
   unsigned int m_format;
   int m_orientation;
@@ -104,6 +104,21 @@ int CTextureBundle::LoadAnim(const CStdString& Filename, CBaseTexture*** ppTextu
   }
 }
 
+unsigned int CTextureBundle::Prefetch(const std::vector<CStdString> &names)
+{
+  // only xbt bundles can be read in the background
+  if (m_useXPR)
+    return 0;
+  return m_tbXBT.Prefetch(names);
+}
+
+bool CTextureBundle::IsPrefetched(const CStdString& Filename)
+{
+  if (m_useXPR)
+    return false;
+  return m_tbXBT.IsPrefetched(Filename);
+}
+
 void CTextureBundle::Cleanup()
 {
   m_tbXBT.Cleanup();
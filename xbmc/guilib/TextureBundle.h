@@ -42,6 +42,9 @@ public:
 
   int LoadAnim(const CStdString& Filename, CBaseTexture*** ppTextures, int &width, int &height, int& nLoops, int** ppDelays);
 
+  unsigned int Prefetch(const std::vector<CStdString> &names);
+  bool IsPrefetched(const CStdString& Filename);
+
 private:
   CTextureBundleXPR m_tbXPR;
   CTextureBundleXBT m_tbXBT;
@@ -29,7 +29,10 @@
 #include "settings/GUISettings.h"
 #include "filesystem/SpecialProtocol.h"
 #include "utils/EndianSwap.h"
+#include "utils/JobManager.h"
 #include "utils/URIUtils.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "XBTF.h"
 #include <lzo/lzo1x.h>
 
@@ -37,9 +40,51 @@
 #pragma comment(lib,"liblzo2.lib")
 #endif
 
+using namespace std;
+
+#define PREFETCH_MAX_SIZE  64 * 1024 * 1024  // unpacked size of the textures prefetched at once
+#define PREFETCH_EXPIRY    10000             // ms after which prefetched textures that weren't used are freed
+
+class CTexturePrefetchJob : public CJob
+{
+public:
+  CTexturePrefetchJob(CTextureBundleXBT *bundle, const CStdString &name)
+    : m_bundle(bundle), m_name(name), m_texture(NULL)
+  {
+  }
+
+  virtual ~CTexturePrefetchJob()
+  {
+    delete m_texture;
+  }
+
+  virtual const char *GetType() const { return "textureprefetch"; };
+
+  virtual bool DoWork()
+  {
+    m_texture = m_bundle->UnpackPrefetched(m_name);
+    return m_texture != NULL;
+  }
+
+  const CStdString &GetName() const { return m_name; };
+
+  CBaseTexture *ReleaseTexture()
+  {
+    CBaseTexture *texture = m_texture;
+    m_texture = NULL;
+    return texture;
+  }
+
+private:
+  CTextureBundleXBT *m_bundle;
+  CStdString m_name;
+  CBaseTexture *m_texture;
+};
+
 CTextureBundleXBT::CTextureBundleXBT(void)
 {
   m_themeBundle = false;
+  m_prefetchedSize = 0;
 }
 
 CTextureBundleXBT::~CTextureBundleXBT(void)
@@ -78,6 +123,7 @@ bool CTextureBundleXBT::OpenBundle()
   strPath = CSpecialProtocol::TranslatePathConvertCase(strPath);
 
   // Load the texture file
+  CExclusiveLock lock(m_readerSection);
   if (!m_XBTFReader.Open(strPath))
   {
     return false;
@@ -145,7 +191,8 @@ bool CTextureBundleXBT::LoadTexture(const CStdString& Filename, CBaseTexture** p
     return false;
 
   CXBTFFrame& frame = file->GetFrames().at(0);
-  if (!ConvertFrameToTexture(Filename, frame, ppTexture))
+  *ppTexture = TakePrefetched(name);
+  if (!*ppTexture && !ConvertFrameToTexture(Filename, frame, ppTexture))
   {
     return false;
   }
@@ -193,20 +240,58 @@ int CTextureBundleXBT::LoadAnim(const CStdString& Filename, CBaseTexture*** ppTe
 
 bool CTextureBundleXBT::ConvertFrameToTexture(const CStdString& name, CXBTFFrame& frame, CBaseTexture** ppTexture)
 {
-  // found texture - allocate the necessary buffers
-  squish::u8 *buffer = new squish::u8[(size_t)frame.GetPackedSize()];
-  if (buffer == NULL)
+  *ppTexture = ConvertFrame(name, frame);
+  return *ppTexture != NULL;
+}
+
+CBaseTexture *CTextureBundleXBT::ConvertFrame(const CStdString& name, const CXBTFFrame& frame)
+{
+  // create an xbmc texture
+  CBaseTexture *texture = new CTexture();
+
+  // frames that aren't packed are copied straight from the mapped bundle
+  const unsigned char *data = frame.IsPacked() ? NULL : m_XBTFReader.GetData(frame);
+  if (data)
   {
-    CLog::Log(LOGERROR, "Out of memory loading texture: %s (need %"PRIu64" bytes)", name.c_str(), frame.GetPackedSize());
-    return false;
+    texture->LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), (unsigned char *)data);
+    return texture;
   }
 
-  // load the compressed texture
-  if (!m_XBTFReader.Load(frame, buffer))
+  unsigned char *buffer = UnpackFrame(m_XBTFReader, frame, name);
+  if (!buffer)
   {
-    CLog::Log(LOGERROR, "Error loading texture: %s", name.c_str());
-    delete[] buffer;
-    return false;
+    delete texture;
+    return NULL;
+  }
+  texture->LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), buffer);
+  delete[] buffer;
+
+  return texture;
+}
+
+unsigned char *CTextureBundleXBT::UnpackFrame(CXBTFReader &reader, const CXBTFFrame &frame, const CStdString &name)
+{
+  // packed frames are unpacked straight from the mapped file, if it is
+  squish::u8 *buffer = NULL;
+  const unsigned char *data = frame.IsPacked() ? reader.GetData(frame) : NULL;
+  if (!data)
+  {
+    // found texture - allocate the necessary buffers
+    buffer = new squish::u8[(size_t)frame.GetPackedSize()];
+    if (buffer == NULL)
+    {
+      CLog::Log(LOGERROR, "Out of memory loading texture: %s (need %"PRIu64" bytes)", name.c_str(), frame.GetPackedSize());
+      return NULL;
+    }
+
+    // load the compressed texture
+    if (!reader.Load(frame, buffer))
+    {
+      CLog::Log(LOGERROR, "Error loading texture: %s", name.c_str());
+      delete[] buffer;
+      return NULL;
+    }
+    data = buffer;
   }
 
   // check if it's packed with lzo
@@ -217,32 +302,173 @@ bool CTextureBundleXBT::ConvertFrameToTexture(const CStdString& name, CXBTFFrame
     {
       CLog::Log(LOGERROR, "Out of memory unpacking texture: %s (need %"PRIu64" bytes)", name.c_str(), frame.GetUnpackedSize());
       delete[] buffer;
-      return false;
+      return NULL;
     }
+    // textures may be unpacked without a bundle having been opened, so make sure lzo is ready
     lzo_uint s = (lzo_uint)frame.GetUnpackedSize();
-    if (lzo1x_decompress(buffer, (lzo_uint)frame.GetPackedSize(), unpacked, &s, NULL) != LZO_E_OK ||
+    if (lzo_init() != LZO_E_OK ||
+        lzo1x_decompress(data, (lzo_uint)frame.GetPackedSize(), unpacked, &s, NULL) != LZO_E_OK ||
         s != frame.GetUnpackedSize())
     {
       CLog::Log(LOGERROR, "Error loading texture: %s: Decompression error", name.c_str());
       delete[] buffer;
       delete[] unpacked;
-      return false;
+      return NULL;
     }
     delete[] buffer;
     buffer = unpacked;
   }
+  return buffer;
+}
 
-  // create an xbmc texture
-  *ppTexture = new CTexture();
-  (*ppTexture)->LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), buffer);
+unsigned int CTextureBundleXBT::Prefetch(const vector<CStdString> &names)
+{
+  if (!m_XBTFReader.IsOpen() && !OpenBundle())
+    return 0;
 
-  delete[] buffer;
+  CSingleLock lock(m_prefetchSection);
+  ExpirePrefetched();
 
-  return true;
+  unsigned int queued = 0;
+  for (vector<CStdString>::const_iterator it = names.begin(); it != names.end(); ++it)
+  {
+    CStdString name = Normalize(*it);
+    if (m_prefetched.find(name) != m_prefetched.end())
+      continue;
+    CXBTFFile *file = m_XBTFReader.Find(name);
+    if (!file || file->GetFrames().size() != 1)
+      continue;
+    unsigned int size = (unsigned int)file->GetFrames()[0].GetUnpackedSize();
+    if (m_prefetchedSize + size > PREFETCH_MAX_SIZE)
+      continue;
+
+    // the job can't start unpacking until we've let go of the lock, so its id is set first
+    PrefetchedTexture &texture = m_prefetched[name];
+    texture.loading = false;
+    texture.texture = NULL;
+    texture.size = size;
+    texture.time = XbmcThreads::SystemClockMillis();
+    texture.jobID = CJobManager::GetInstance().AddJob(new CTexturePrefetchJob(this, name), this, CJob::PRIORITY_NORMAL);
+    m_prefetchedSize += size;
+    queued++;
+  }
+  return queued;
+}
+
+bool CTextureBundleXBT::IsPrefetched(const CStdString &name)
+{
+  CSingleLock lock(m_prefetchSection);
+  return m_prefetched.find(Normalize(name)) != m_prefetched.end();
+}
+
+CBaseTexture *CTextureBundleXBT::UnpackPrefetched(const CStdString &name)
+{
+  // keep the bundle open while we read from it
+  CSharedLock readerLock(m_readerSection);
+  {
+    CSingleLock lock(m_prefetchSection);
+    map<CStdString, PrefetchedTexture>::iterator it = m_prefetched.find(name);
+    if (it == m_prefetched.end())
+      return NULL; // taken or cleared before we got to it
+    it->second.loading = true;
+  }
+
+  CXBTFFile *file = m_XBTFReader.Find(name);
+  if (!file || file->GetFrames().empty())
+    return NULL;
+  return ConvertFrame(name, file->GetFrames()[0]);
+}
+
+void CTextureBundleXBT::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CTexturePrefetchJob *prefetchJob = (CTexturePrefetchJob *)job;
+
+  CSingleLock lock(m_prefetchSection);
+  map<CStdString, PrefetchedTexture>::iterator it = m_prefetched.find(prefetchJob->GetName());
+  if (it != m_prefetched.end() && it->second.jobID == jobID)
+  {
+    if (success)
+    {
+      it->second.texture = prefetchJob->ReleaseTexture();
+      it->second.loading = false;
+    }
+    else
+    {
+      m_prefetchedSize -= it->second.size;
+      m_prefetched.erase(it);
+    }
+  }
+  lock.Leave();
+  m_prefetchEvent.Set();
+}
+
+CBaseTexture *CTextureBundleXBT::TakePrefetched(const CStdString &name)
+{
+  CSingleLock lock(m_prefetchSection);
+  while (true)
+  {
+    map<CStdString, PrefetchedTexture>::iterator it = m_prefetched.find(name);
+    if (it == m_prefetched.end())
+      return NULL;
+
+    PrefetchedTexture &texture = it->second;
+    if (texture.texture)
+    {
+      CBaseTexture *unpacked = texture.texture;
+      m_prefetchedSize -= texture.size;
+      m_prefetched.erase(it);
+      return unpacked;
+    }
+    if (!texture.loading)
+    { // still queued behind the others - it's quicker to unpack it ourselves than to wait
+      CJobManager::GetInstance().CancelJob(texture.jobID);
+      m_prefetchedSize -= texture.size;
+      m_prefetched.erase(it);
+      return NULL;
+    }
+
+    // being unpacked, so it'll be done sooner than if we started again
+    lock.Leave();
+    m_prefetchEvent.WaitMSec(100);
+    lock.Enter();
+  }
+}
+
+void CTextureBundleXBT::ExpirePrefetched()
+{
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  map<CStdString, PrefetchedTexture>::iterator it = m_prefetched.begin();
+  while (it != m_prefetched.end())
+  {
+    if (it->second.texture && now - it->second.time > PREFETCH_EXPIRY)
+    {
+      delete it->second.texture;
+      m_prefetchedSize -= it->second.size;
+      m_prefetched.erase(it++);
+    }
+    else
+      ++it;
+  }
+}
+
+void CTextureBundleXBT::ClearPrefetched()
+{
+  CSingleLock lock(m_prefetchSection);
+  for (map<CStdString, PrefetchedTexture>::iterator it = m_prefetched.begin(); it != m_prefetched.end(); ++it)
+  {
+    CJobManager::GetInstance().CancelJob(it->second.jobID);
+    delete it->second.texture;
+  }
+  m_prefetched.clear();
+  m_prefetchedSize = 0;
 }
 
 void CTextureBundleXBT::Cleanup()
 {
+  // wait for any workers reading from the bundle before closing it
+  CExclusiveLock lock(m_readerSection);
+  ClearPrefetched();
+
   if (m_XBTFReader.IsOpen())
   {
     m_XBTFReader.Close();
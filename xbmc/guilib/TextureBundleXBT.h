@@ -24,10 +24,22 @@
 #include "utils/StdString.h"
 #include <map>
 #include "XBTFReader.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/SharedSection.h"
+#include "utils/Job.h"
 
 class CBaseTexture;
 
-class CTextureBundleXBT
+/*!
+ \ingroup textures
+ \brief Reads textures from a skin's Textures.xbt, or a theme's xbt.
+
+ The bundle is memory mapped where possible. Textures may be prefetched before they're
+ needed, such as while a window is being loaded, in which case they're read and unpacked
+ by the job manager's workers, leaving only the upload to the GUI thread.
+ */
+class CTextureBundleXBT : public IJobCallback
 {
 public:
   CTextureBundleXBT(void);
@@ -45,14 +57,58 @@ public:
   int LoadAnim(const CStdString& Filename, CBaseTexture*** ppTextures,
                 int &width, int &height, int& nLoops, int** ppDelays);
 
+  /*! \brief Read a frame of an XBT file and unpack it if it's packed with lzo.
+   \param reader the opened XBT file.
+   \param frame the frame to read.
+   \param name the name of the texture, for logging.
+   \return the pixels of the frame, to be delete[]'d by the caller, or NULL on error.
+   */
+  static unsigned char *UnpackFrame(CXBTFReader &reader, const CXBTFFrame &frame, const CStdString &name);
+
+  /*! \brief Start unpacking textures in the background, ready for LoadTexture().
+   Animated textures, and textures already prefetched, are skipped.
+   \param names the names of the textures, as passed to LoadTexture().
+   \return the number of textures queued.
+   */
+  unsigned int Prefetch(const std::vector<CStdString> &names);
+
+  /*! \brief Whether a texture has been or is being prefetched.
+   */
+  bool IsPrefetched(const CStdString &name);
+
+  /*! \brief Unpack a texture that has been prefetched, called from the prefetch job.
+   */
+  CBaseTexture *UnpackPrefetched(const CStdString &name);
+
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
 private:
   bool OpenBundle();
   bool ConvertFrameToTexture(const CStdString& name, CXBTFFrame& frame, CBaseTexture** ppTexture);
+  CBaseTexture *ConvertFrame(const CStdString& name, const CXBTFFrame& frame);
+  CBaseTexture *TakePrefetched(const CStdString& name);
+  void ClearPrefetched();
+  void ExpirePrefetched();
+
+  struct PrefetchedTexture
+  {
+    unsigned int jobID;
+    bool loading;             ///< a worker is unpacking it
+    CBaseTexture *texture;    ///< the unpacked texture, once done
+    unsigned int size;        ///< unpacked size, towards the prefetch limit
+    unsigned int time;        ///< when it was queued, in ms
+  };
 
   time_t m_TimeStamp;
 
   bool m_themeBundle;
   CXBTFReader m_XBTFReader;
+  CSharedSection m_readerSection;   ///< held shared by workers reading the bundle, exclusive while opening or closing it
+
+  CCriticalSection m_prefetchSection;
+  CEvent m_prefetchEvent;           ///< set as prefetched textures are done
+  std::map<CStdString, PrefetchedTexture> m_prefetched;
+  unsigned int m_prefetchedSize;
 };
 
 
@@ -138,8 +138,7 @@ void CDXTexture::LoadToGPU()
   }
   m_texture.UnlockRect(0);
 
-  delete [] m_pixels;
-  m_pixels = NULL;
+  FreePixels();
 
   m_loadedToGPU = true;
 }
@@ -178,8 +178,7 @@ void CGLTexture::LoadToGPU()
 #endif
   VerifyGLState();
 
-  delete [] m_pixels;
-  m_pixels = NULL;
+  FreePixels();
 
   m_loadedToGPU = true;
 }
@@ -28,9 +28,8 @@
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "addons/Skin.h"
-#ifdef _DEBUG
+#include "settings/AdvancedSettings.h"
 #include "utils/TimeUtils.h"
-#endif
 #include "filesystem/File.h"
 #include "filesystem/Directory.h"
 #include "URL.h"
@@ -214,6 +213,9 @@ void CTextureMap::Add(CBaseTexture* texture, int delay)
 /************************************************************************/
 CGUITextureManager::CGUITextureManager(void)
 {
+  m_timelineStart = 0;
+  m_timelineDepth = 0;
+  m_timelinePrefetches = 0;
   // we set the theme bundle to be the first bundle (thus prioritizing it)
   m_TexBundle[0].SetThemeBundle(true);
 }
@@ -309,6 +311,14 @@ int CGUITextureManager::Load(const CStdString& strTextureName, bool checkBundleO
   //Lock here, we will do stuff that could break rendering
   CSingleLock lock(g_graphicsContext);
 
+  int64_t loadStart = 0;
+  bool prefetched = false;
+  if (m_timelineDepth)
+  {
+    loadStart = CurrentHostCounter();
+    prefetched = bundle >= 0 && m_TexBundle[bundle].IsPrefetched(strTextureName);
+  }
+
 #ifdef _DEBUG
   int64_t start;
   start = CurrentHostCounter();
@@ -386,6 +396,7 @@ int CGUITextureManager::Load(const CStdString& strTextureName, bool checkBundleO
 #endif
 
     m_vecTextures.push_back(pMap);
+    AddToTimeline(strTextureName, loadStart, bundle >= 0, false);
     return 1;
   } // of if (strPath.Right(4).ToLower()==".gif")
 
@@ -413,6 +424,7 @@ int CGUITextureManager::Load(const CStdString& strTextureName, bool checkBundleO
   CTextureMap* pMap = new CTextureMap(strTextureName, width, height, 0);
   pMap->Add(pTexture, 100);
   m_vecTextures.push_back(pMap);
+  AddToTimeline(strTextureName, loadStart, bundle >= 0, prefetched);
 
 #ifdef _DEBUG_TEXTURES
   int64_t end, freq;
@@ -473,6 +485,102 @@ void CGUITextureManager::ReleaseHwTexture(unsigned int texture)
   m_unusedHwTextures.push_back(texture);
 }
 
+void CGUITextureManager::Prefetch(const vector<CStdString> &textures)
+{
+  CSingleLock lock(g_graphicsContext);
+
+  // the textures of each bundle, with the theme's taking priority as in HasTexture()
+  vector<CStdString> bundled[2];
+  for (vector<CStdString>::const_iterator it = textures.begin(); it != textures.end(); ++it)
+  {
+    const CStdString &textureName = *it;
+    if (!CanLoad(textureName) || CURL::IsFullPath(textureName) || CStdString(textureName).Right(4).ToLower() == ".gif")
+      continue;
+
+    bool loaded = false;
+    for (int i = 0; i < (int)m_vecTextures.size() && !loaded; ++i)
+      loaded = m_vecTextures[i]->GetName() == textureName;
+    if (loaded)
+      continue;
+
+    CStdString bundledName = CTextureBundle::Normalize(textureName);
+    for (int i = 0; i < 2; i++)
+    {
+      if (m_TexBundle[i].HasFile(bundledName))
+      {
+        bundled[i].push_back(textureName);
+        break;
+      }
+    }
+  }
+
+  unsigned int queued = 0;
+  for (int i = 0; i < 2; i++)
+  {
+    if (!bundled[i].empty())
+      queued += m_TexBundle[i].Prefetch(bundled[i]);
+  }
+  if (m_timelineDepth)
+    m_timelinePrefetches += queued;
+}
+
+void CGUITextureManager::StartTimeline(const CStdString &name)
+{
+  if (m_timelineDepth)
+  {
+    m_timelineDepth++;
+    return;
+  }
+  if (g_advancedSettings.m_logLevel < LOG_LEVEL_DEBUG)
+    return;
+
+  m_timelineName = name;
+  m_timelineStart = CurrentHostCounter();
+  m_timelineDepth = 1;
+  m_timelinePrefetches = 0;
+  m_timeline.clear();
+}
+
+void CGUITextureManager::EndTimeline()
+{
+  if (!m_timelineDepth || --m_timelineDepth)
+    return;
+
+  if (!m_timeline.empty())
+  {
+    float scale = 1000.0f / CurrentHostFrequency();
+    unsigned int prefetched = 0;
+    for (vector<TimelineTexture>::const_iterator it = m_timeline.begin(); it != m_timeline.end(); ++it)
+    {
+      if (it->prefetched)
+        prefetched++;
+    }
+    CLog::Log(LOGDEBUG, "Texture load timeline for %s: %u textures in %.2fms, %u queued for prefetch, %u prefetched",
+              m_timelineName.c_str(), (unsigned int)m_timeline.size(), scale * (CurrentHostCounter() - m_timelineStart),
+              m_timelinePrefetches, prefetched);
+    for (vector<TimelineTexture>::const_iterator it = m_timeline.begin(); it != m_timeline.end(); ++it)
+    {
+      CLog::Log(LOGDEBUG, "  +%.2fms %s: %.2fms%s", scale * (it->start - m_timelineStart), it->name.c_str(),
+                scale * it->duration, it->prefetched ? " (prefetched)" : it->bundled ? " (bundled)" : "");
+    }
+  }
+  m_timeline.clear();
+}
+
+void CGUITextureManager::AddToTimeline(const CStdString &textureName, int64_t start, bool bundled, bool prefetched)
+{
+  if (!m_timelineDepth)
+    return;
+
+  TimelineTexture texture;
+  texture.name = textureName;
+  texture.start = start;
+  texture.duration = CurrentHostCounter() - start;
+  texture.bundled = bundled;
+  texture.prefetched = prefetched;
+  m_timeline.push_back(texture);
+}
+
 void CGUITextureManager::Cleanup()
 {
   CSingleLock lock(g_graphicsContext);
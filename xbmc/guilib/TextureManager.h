@@ -28,6 +28,7 @@
 #define GUILIB_TEXTUREMANAGER_H
 
 #include <vector>
+#include <stdint.h>
 #include "TextureBundle.h"
 #include "threads/CriticalSection.h"
 
@@ -125,7 +126,35 @@ public:
 
   void FreeUnusedTextures(); ///< Free textures (called from app thread only)
   void ReleaseHwTexture(unsigned int texture);
+
+  /*! \brief Start unpacking bundled textures in the background, ahead of their being loaded.
+   Textures that are already loaded, animated or not bundled are skipped.
+   \param textures the names of the textures, as passed to Load().
+   */
+  void Prefetch(const std::vector<CStdString> &textures);
+
+  /*! \brief Record the textures loaded from now on, such as while a window allocates its resources.
+   Only done when logging at debug level. Timelines started before the last has ended are part of it.
+   \param name what the textures are loaded for, for the log.
+   \sa EndTimeline()
+   */
+  void StartTimeline(const CStdString &name);
+
+  /*! \brief Log the textures loaded since StartTimeline(), with when each was loaded and how long it took.
+   */
+  void EndTimeline();
 protected:
+  void AddToTimeline(const CStdString &textureName, int64_t start, bool bundled, bool prefetched);
+
+  struct TimelineTexture
+  {
+    CStdString name;
+    int64_t start;
+    int64_t duration;
+    bool bundled;
+    bool prefetched;
+  };
+
   std::vector<CTextureMap*> m_vecTextures;
   std::vector<CTextureMap*> m_unusedTextures;
   std::vector<unsigned int> m_unusedHwTextures;
@@ -135,6 +164,12 @@ protected:
 
   std::vector<CStdString> m_texturePaths;
   CCriticalSection m_section;
+
+  CStdString m_timelineName;
+  int64_t m_timelineStart;
+  unsigned int m_timelineDepth;
+  unsigned int m_timelinePrefetches;        ///< textures queued for prefetch during the timeline
+  std::vector<TimelineTexture> m_timeline;
 };
 
 /*!
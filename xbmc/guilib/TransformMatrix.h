@@ -135,6 +135,16 @@ public:
     identity = (a == 1.0f);
   }
 
+  bool operator ==(const TransformMatrix &right) const
+  {
+    return alpha == right.alpha && memcmp(m, right.m, sizeof(m)) == 0;
+  }
+
+  bool operator !=(const TransformMatrix &right) const
+  {
+    return !(*this == right);
+  }
+
   // multiplication operators
   const TransformMatrix &operator *=(const TransformMatrix &right)
   {
@@ -23,8 +23,12 @@
 #include "XBTFReader.h"
 #include "utils/EndianSwap.h"
 #include "utils/CharsetConverter.h"
+#include "threads/SingleLock.h"
 #ifdef _WIN32
 #include "FileSystem/SpecialProtocol.h"
+#include <io.h>
+#else
+#include <sys/mman.h>
 #endif
 
 #include <string.h>
@@ -47,6 +51,14 @@
 CXBTFReader::CXBTFReader()
 {
   m_file = NULL;
+  m_mapped = NULL;
+  m_mappedSize = 0;
+  m_mapping = NULL;
+}
+
+CXBTFReader::~CXBTFReader()
+{
+  Close();
 }
 
 bool CXBTFReader::IsOpen() const
@@ -136,11 +148,62 @@ bool CXBTFReader::Open(const CStdString& fileName)
     return false;
   }
 
+  Map();
+
   return true;
 }
 
+void CXBTFReader::Map()
+{
+  // frames are read straight from the mapping, so that they can be unpacked
+  // by several threads at once without copying - fall back to reading them
+  // if the file can't be mapped, such as when short of address space
+  struct stat fileStat;
+  if (fstat(fileno(m_file), &fileStat) == -1 || fileStat.st_size <= 0)
+    return;
+  if ((uint64_t)fileStat.st_size != (uint64_t)(size_t)fileStat.st_size)
+    return;
+
+#ifdef _WIN32
+  HANDLE file = (HANDLE)_get_osfhandle(_fileno(m_file));
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping)
+    return;
+  void *mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!mapped)
+  {
+    CloseHandle(mapping);
+    return;
+  }
+  m_mapping = mapping;
+#else
+  void *mapped = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fileno(m_file), 0);
+  if (mapped == MAP_FAILED)
+    return;
+#endif
+  m_mapped = (unsigned char *)mapped;
+  m_mappedSize = fileStat.st_size;
+}
+
+void CXBTFReader::Unmap()
+{
+  if (!m_mapped)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(m_mapped);
+  CloseHandle((HANDLE)m_mapping);
+  m_mapping = NULL;
+#else
+  munmap(m_mapped, (size_t)m_mappedSize);
+#endif
+  m_mapped = NULL;
+  m_mappedSize = 0;
+}
+
 void CXBTFReader::Close()
 {
+  Unmap();
+
   if (m_file)
   {
     fclose(m_file);
@@ -183,12 +246,28 @@ CXBTFFile* CXBTFReader::Find(const CStdString& name)
   return &(iter->second);
 }
 
+const unsigned char* CXBTFReader::GetData(const CXBTFFrame& frame) const
+{
+  if (!m_mapped || frame.GetOffset() > m_mappedSize || frame.GetPackedSize() > m_mappedSize - frame.GetOffset())
+    return NULL;
+  return m_mapped + frame.GetOffset();
+}
+
 bool CXBTFReader::Load(const CXBTFFrame& frame, unsigned char* buffer)
 {
   if (!m_file)
   {
     return false;
   }
+
+  const unsigned char *data = GetData(frame);
+  if (data)
+  {
+    memcpy(buffer, data, (size_t)frame.GetPackedSize());
+    return true;
+  }
+
+  CSingleLock lock(m_section);
 #if defined(TARGET_DARWIN) || defined(__FreeBSD__)
     if (fseeko(m_file, (off_t)frame.GetOffset(), SEEK_SET) == -1)
 #else
@@ -25,12 +25,14 @@
 #include <vector>
 #include <map>
 #include "utils/StdString.h"
+#include "threads/CriticalSection.h"
 #include "XBTF.h"
 
 class CXBTFReader
 {
 public:
   CXBTFReader();
+  ~CXBTFReader();
   bool IsOpen() const;
   bool Open(const CStdString& fileName);
   void Close();
@@ -40,10 +42,23 @@ public:
   bool Load(const CXBTFFrame& frame, unsigned char* buffer);
   std::vector<CXBTFFile>&  GetFiles();
 
+  /*! \brief Get the (packed) data of a frame from the memory mapped file.
+   Unlike Load(), this may be used from any number of threads at once.
+   \return the data of the frame, valid until Close(), or NULL if the file isn't mapped.
+   */
+  const unsigned char* GetData(const CXBTFFrame& frame) const;
+
 private:
+  void Map();
+  void Unmap();
+
   CXBTF      m_xbtf;
   CStdString m_fileName;
   FILE*      m_file;
+  unsigned char* m_mapped;    ///< the whole file, if it could be memory mapped
+  uint64_t   m_mappedSize;
+  void*      m_mapping;       ///< file mapping handle on windows
+  CCriticalSection m_section; ///< serialises seeking and reading when the file isn't mapped
   std::map<CStdString, CXBTFFile> m_filesMap;
 };
 
@@ -0,0 +1,179 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "guilib/Texture.h"
+#include "guilib/JpegIO.h"
+#include "guilib/XBTF.h"
+#include "threads/SystemClock.h"
+#include "utils/test/TestHelpers.h"
+
+#include <boost/test/unit_test.hpp>
+#include <stdlib.h>
+#include <vector>
+
+using namespace std;
+using namespace xbmcutil::test;
+
+// a jpeg of the given size in a single color, or a diagonal gradient if gradient is set
+static void WriteJpeg(const TempFile &file, unsigned int width, unsigned int height,
+                      unsigned char r, unsigned char g, unsigned char b, bool gradient = false)
+{
+  vector<unsigned char> pixels(width * height * 3);
+  for (unsigned int y = 0; y < height; y++)
+  {
+    for (unsigned int x = 0; x < width; x++)
+    {
+      unsigned char *p = &pixels[(y * width + x) * 3];
+      p[0] = gradient ? (unsigned char)(x * 255 / width) : r;
+      p[1] = gradient ? (unsigned char)(y * 255 / height) : g;
+      p[2] = gradient ? (unsigned char)((x + y) * 255 / (width + height)) : b;
+    }
+  }
+  CJpegIO jpeg;
+  BOOST_REQUIRE(jpeg.CreateThumbnailFromSurface(&pixels[0], width, height, XB_FMT_RGB8, width * 3, file.Path()));
+}
+
+// the color of every pixel is within the tolerance of lossy compression
+static void CheckColor(const vector<unsigned char> &pixels, unsigned int width, unsigned int height, unsigned int pitch,
+                       unsigned int bytes, const unsigned char *expected)
+{
+  unsigned int wrong = 0;
+  for (unsigned int y = 0; y < height; y++)
+  {
+    for (unsigned int x = 0; x < width; x++)
+    {
+      const unsigned char *p = &pixels[y * pitch + x * bytes];
+      for (unsigned int c = 0; c < bytes; c++)
+      {
+        if (abs((int)p[c] - (int)expected[c]) > 4)
+          wrong++;
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(wrong, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(TestJpegIODecode)
+{
+  TempFile file(".jpg", "");
+  WriteJpeg(file, 64, 48, 200, 100, 50);
+
+  CJpegIO jpeg;
+  BOOST_REQUIRE(jpeg.Open(file.Path(), 64, 48));
+  BOOST_CHECK_EQUAL(jpeg.Width(), 64U);
+  BOOST_CHECK_EQUAL(jpeg.Height(), 48U);
+  vector<unsigned char> pixels(64 * 48 * 4);
+  BOOST_REQUIRE(jpeg.Decode(&pixels[0], 64 * 4, XB_FMT_A8R8G8B8));
+  const unsigned char bgra[] = { 50, 100, 200, 0xff };
+  CheckColor(pixels, 64, 48, 64 * 4, 4, bgra);
+}
+
+BOOST_AUTO_TEST_CASE(TestJpegIODecodeRGB)
+{
+  TempFile file(".jpg", "");
+  WriteJpeg(file, 64, 48, 200, 100, 50);
+
+  CJpegIO jpeg;
+  BOOST_REQUIRE(jpeg.Open(file.Path(), 64, 48));
+  vector<unsigned char> pixels(64 * 48 * 3);
+  BOOST_REQUIRE(jpeg.Decode(&pixels[0], 64 * 3, XB_FMT_RGB8));
+  const unsigned char rgb[] = { 200, 100, 50 };
+  CheckColor(pixels, 64, 48, 64 * 3, 3, rgb);
+}
+
+BOOST_AUTO_TEST_CASE(TestJpegIODecodeScaled)
+{
+  // libjpeg can only get to 1/4 of 800x600, so the rest is averaged down to the smallest size covering 150x100
+  TempFile file(".jpg", "");
+  WriteJpeg(file, 800, 600, 30, 160, 90);
+
+  CJpegIO jpeg;
+  BOOST_REQUIRE(jpeg.Open(file.Path(), 150, 100));
+  BOOST_CHECK_EQUAL(jpeg.Width(), 150U);
+  BOOST_CHECK_EQUAL(jpeg.Height(), 113U);
+  vector<unsigned char> pixels(150 * 113 * 4);
+  BOOST_REQUIRE(jpeg.Decode(&pixels[0], 150 * 4, XB_FMT_A8R8G8B8));
+  const unsigned char bgra[] = { 90, 160, 30, 0xff };
+  CheckColor(pixels, 150, 113, 150 * 4, 4, bgra);
+}
+
+BOOST_AUTO_TEST_CASE(TestJpegIOInvalid)
+{
+  TempFile file(".jpg", "not a jpeg");
+  CJpegIO jpeg;
+  BOOST_CHECK(!jpeg.Open(file.Path(), 64, 48));
+}
+
+// only the pixel helpers of the base texture are used, so it needs no render system
+class CTestTexture : public CBaseTexture
+{
+public:
+  virtual void CreateTextureObject() {}
+  virtual void DestroyTextureObject() {}
+  virtual void LoadToGPU() {}
+  virtual void BindToUnit(unsigned int unit) {}
+};
+
+BOOST_AUTO_TEST_CASE(TestSwapBlueRed)
+{
+  // 7 pixels a row, so both the 4 pixel and the single pixel paths are taken
+  const unsigned int width = 7, height = 3, pitch = width * 4;
+  vector<uint32_t> pixels(width * height);
+  for (unsigned int i = 0; i < pixels.size(); i++)
+    pixels[i] = 0x80000000 | (i << 16) | ((i + 1) << 8) | (i + 2);
+
+  CTestTexture texture;
+  BOOST_REQUIRE(texture.SwapBlueRed((unsigned char *)&pixels[0], height, pitch));
+  for (unsigned int i = 0; i < pixels.size(); i++)
+  {
+    const unsigned char *p = (const unsigned char *)&pixels[i];
+    BOOST_CHECK_EQUAL(p[0], i);
+    BOOST_CHECK_EQUAL(p[1], i + 1);
+    BOOST_CHECK_EQUAL(p[2], i + 2);
+    BOOST_CHECK_EQUAL(p[3], 0x80);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestJpegIODecodeThroughput)
+{
+  // a 1080p image decoded at full size, and at the size of a thumbnail which takes the averaging path
+  TempFile file(".jpg", "");
+  WriteJpeg(file, 1920, 1080, 0, 0, 0, true);
+
+  const unsigned int sizes[][2] = { { 1920, 1080 }, { 320, 180 }, { 200, 150 } };
+  const unsigned int decodes = 20;
+  vector<unsigned char> pixels(1920 * 1080 * 4);
+  for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    unsigned int width = 0, height = 0;
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int j = 0; j < decodes; j++)
+    {
+      CJpegIO jpeg;
+      BOOST_REQUIRE(jpeg.Open(file.Path(), sizes[i][0], sizes[i][1]));
+      width = jpeg.Width();
+      height = jpeg.Height();
+      BOOST_REQUIRE(jpeg.Decode(&pixels[0], width * 4, XB_FMT_A8R8G8B8));
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+    BOOST_TEST_MESSAGE("jpeg decode to " << width << "x" << height << ": " << decodes << " in " << elapsed << " ms");
+  }
+}
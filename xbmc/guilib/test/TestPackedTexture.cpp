@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "TextureCacheJob.h"
+#include "filesystem/File.h"
+#include "guilib/Texture.h"
+#include "guilib/JpegIO.h"
+#include "guilib/XBTF.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "utils/URIUtils.h"
+#include "utils/test/TestHelpers.h"
+
+#include <boost/test/unit_test.hpp>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+using namespace xbmcutil::test;
+
+// a cached image as the texture cache keeps it: a jpeg, with its packed copy beside it once made
+class CCachedImage : public TempFile
+{
+public:
+  CCachedImage(unsigned int width, unsigned int height) : TempFile(".jpg", "")
+  {
+    // the default sizes images are loaded at, as advancedsettings.xml isn't read here
+    g_advancedSettings.m_imageRes = 720;
+    g_advancedSettings.m_fanartRes = 1080;
+
+    vector<unsigned char> pixels(width * height * 3);
+    for (unsigned int i = 0; i < pixels.size(); i++)
+      pixels[i] = (unsigned char)(i * 7 / 3);
+    CJpegIO jpeg;
+    jpeg.CreateThumbnailFromSurface(&pixels[0], width, height, XB_FMT_RGB8, width * 3, Path());
+  }
+  ~CCachedImage() { XFILE::CFile::Delete(PackedPath()); }
+
+  CStdString PackedPath() const { return URIUtils::ReplaceExtension(Path(), ".xbt"); }
+};
+
+BOOST_AUTO_TEST_CASE(TestPackedTextureMatchesDecoded)
+{
+  CCachedImage image(1280, 720);
+  CTextureXBTJob job(image.Path());
+  BOOST_REQUIRE(job.DoWork());
+  BOOST_REQUIRE(XFILE::CFile::Exists(image.PackedPath()));
+
+  CBaseTexture *decoded = CBaseTexture::LoadFromFile(image.Path());
+  CBaseTexture *packed = CBaseTexture::LoadFromFile(image.PackedPath());
+  BOOST_REQUIRE(decoded && packed);
+  BOOST_CHECK_EQUAL(packed->GetWidth(), decoded->GetWidth());
+  BOOST_REQUIRE_EQUAL(packed->GetHeight(), decoded->GetHeight());
+  unsigned int different = 0;
+  for (unsigned int y = 0; y < decoded->GetHeight(); y++)
+  {
+    if (memcmp(packed->GetPixels() + y * packed->GetPitch(), decoded->GetPixels() + y * decoded->GetPitch(), decoded->GetWidth() * 4))
+      different++;
+  }
+  BOOST_CHECK_EQUAL(different, 0U);
+  delete decoded;
+  delete packed;
+}
+
+BOOST_AUTO_TEST_CASE(TestPackedTextureRefusesLarge)
+{
+  // taller than <imageres> once decoded, so not worth keeping unpacked
+  CCachedImage image(1920, 1080);
+  CTextureXBTJob job(image.Path());
+  BOOST_CHECK(!job.DoWork());
+  BOOST_CHECK(!XFILE::CFile::Exists(image.PackedPath()));
+}
+
+BOOST_AUTO_TEST_CASE(TestPackedTextureLoadLatency)
+{
+  // the time taken to load a cached image at <imageres>, as decoded from its jpeg and as unpacked from its .xbt
+  CCachedImage image(1280, 720);
+  CTextureXBTJob job(image.Path());
+  BOOST_REQUIRE(job.DoWork());
+
+  const CStdString paths[] = { image.Path(), image.PackedPath() };
+  const unsigned int loads = 20;
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int j = 0; j < loads; j++)
+    {
+      CBaseTexture *texture = CBaseTexture::LoadFromFile(paths[i]);
+      BOOST_REQUIRE(texture);
+      delete texture;
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+    BOOST_TEST_MESSAGE(URIUtils::GetExtension(paths[i]) << ": " << loads << " loads in " << elapsed << " ms");
+  }
+}
@@ -0,0 +1,98 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "guilib/TextLayoutCache.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static CTextLayoutCache::Key MakeKey(float scaleX, float scaleY)
+{
+  CTextLayoutCache::Key key;
+  key.text = L"Some text";
+  key.font = NULL;
+  key.maxWidth = 0;
+  key.maxHeight = 0;
+  key.forceLTRReadingOrder = false;
+  key.scaleX = scaleX;
+  key.scaleY = scaleY;
+  return key;
+}
+
+static vector<CGUIString> MakeLines()
+{
+  vecText text;
+  text.push_back('A');
+  text.push_back('B');
+  vector<CGUIString> lines;
+  lines.push_back(CGUIString(text.begin(), text.end(), false));
+  return lines;
+}
+
+BOOST_AUTO_TEST_CASE(TestTextLayoutCacheHit)
+{
+  CTextLayoutCache cache;
+  cache.Add(MakeKey(1.0f, 1.0f), MakeLines(), vecColors(1, 0xffffffff), 30.0f, 12.0f);
+
+  vector<CGUIString> lines;
+  vecColors colors;
+  float width = 0, height = 0;
+  BOOST_REQUIRE(cache.Get(MakeKey(1.0f, 1.0f), lines, colors, width, height));
+  BOOST_REQUIRE_EQUAL(lines.size(), 1U);
+  BOOST_CHECK_EQUAL(lines[0].GetAsString(), "AB");
+  BOOST_CHECK_EQUAL(colors.size(), 1U);
+  BOOST_CHECK_EQUAL(width, 30.0f);
+  BOOST_CHECK_EQUAL(height, 12.0f);
+}
+
+BOOST_AUTO_TEST_CASE(TestTextLayoutCacheScaleChange)
+{
+  // text is measured at the gui scale, so a layout from another resolution or zoom can't be reused
+  CTextLayoutCache cache;
+  cache.Add(MakeKey(1.0f, 1.0f), MakeLines(), vecColors(1, 0xffffffff), 30.0f, 12.0f);
+
+  vector<CGUIString> lines;
+  vecColors colors;
+  float width = 0, height = 0;
+  BOOST_CHECK(!cache.Get(MakeKey(1.5f, 1.0f), lines, colors, width, height));
+  BOOST_CHECK(!cache.Get(MakeKey(1.0f, 1.5f), lines, colors, width, height));
+  BOOST_CHECK(!cache.Get(MakeKey(1.5f, 1.5f), lines, colors, width, height));
+
+  // once laid out at the new scale, both are kept
+  cache.Add(MakeKey(1.5f, 1.5f), MakeLines(), vecColors(1, 0xffffffff), 45.0f, 18.0f);
+  BOOST_REQUIRE(cache.Get(MakeKey(1.5f, 1.5f), lines, colors, width, height));
+  BOOST_CHECK_EQUAL(width, 45.0f);
+  BOOST_REQUIRE(cache.Get(MakeKey(1.0f, 1.0f), lines, colors, width, height));
+  BOOST_CHECK_EQUAL(width, 30.0f);
+}
+
+BOOST_AUTO_TEST_CASE(TestTextLayoutCacheClear)
+{
+  CTextLayoutCache cache;
+  cache.Add(MakeKey(1.0f, 1.0f), MakeLines(), vecColors(1, 0xffffffff), 30.0f, 12.0f);
+  cache.Clear();
+
+  vector<CGUIString> lines;
+  vecColors colors;
+  float width = 0, height = 0;
+  BOOST_CHECK(!cache.Get(MakeKey(1.0f, 1.0f), lines, colors, width, height));
+}
@@ -22,6 +22,7 @@
 #include "InfoBool.h"
 #include <stack>
 #include "utils/log.h"
+#include "utils/StringUtils.h"
 #include "GUIInfoManager.h"
 
 using namespace std;
@@ -31,6 +32,7 @@ InfoSingle::InfoSingle(const CStdString &expression, int context)
 : InfoBool(expression, context)
 {
   m_condition = g_infoManager.TranslateSingleString(expression);
+  m_dependencies = g_infoManager.GetConditionDependencies(m_condition);
 }
 
 void InfoSingle::Update(const CGUIListItem *item)
@@ -46,22 +48,16 @@ InfoExpression::InfoExpression(const CStdString &expression, int context)
 
 void InfoExpression::Update(const CGUIListItem *item)
 {
-  Evaluate(item, m_value);
+  m_value = Evaluate(item);
 }
 
-#define OPERATOR_LB   5
-#define OPERATOR_RB   4
 #define OPERATOR_NOT  3
 #define OPERATOR_AND  2
 #define OPERATOR_OR   1
 
 short InfoExpression::GetOperator(const char ch) const
 {
-  if (ch == '[')
-    return OPERATOR_LB;
-  else if (ch == ']')
-    return OPERATOR_RB;
-  else if (ch == '!')
+  if (ch == '!')
     return OPERATOR_NOT;
   else if (ch == '+')
     return OPERATOR_AND;
@@ -71,54 +67,77 @@ short InfoExpression::GetOperator(const char ch) const
     return 0;
 }
 
+bool InfoExpression::AddOperand(const CStdString &operand, vector<Code> &output)
+{
+  unsigned int info = g_infoManager.Register(operand, m_context);
+  if (!info) // nothing but whitespace
+    return true;
+  m_dependencies |= g_infoManager.GetBoolDependencies(info);
+  output.push_back(Code(1, Instruction(OP_EVALUATE, info)));
+  return true;
+}
+
+bool InfoExpression::ApplyOperator(char op, vector<Code> &output) const
+{
+  if (op == '!')
+  {
+    if (output.empty())
+      return false;
+    output.back().push_back(Instruction(OP_NOT));
+    return true;
+  }
+  if (output.size() < 2)
+    return false;
+  // left [jump over right] right
+  Code right;
+  right.swap(output.back());
+  output.pop_back();
+  Code &left = output.back();
+  left.push_back(Instruction(op == '+' ? OP_JUMP_IF_FALSE : OP_JUMP_IF_TRUE, right.size()));
+  left.insert(left.end(), right.begin(), right.end());
+  return true;
+}
+
 void InfoExpression::Parse(const CStdString &expression)
 {
   stack<char> operators;
+  vector<Code> output;
   CStdString operand;
-  for (unsigned int i = 0; i < expression.size(); i++)
+  bool valid = true;
+  m_dependencies = 0;
+  for (unsigned int i = 0; i < expression.size() && valid; i++)
   {
-    if (GetOperator(expression[i]))
+    if (expression[i] == '[')
+    { // the bracketed sub-expression is an operand of its own
+      int end = StringUtils::FindEndBracket(expression, '[', ']', i + 1);
+      if (end < 0)
+      {
+        valid = false;
+        break;
+      }
+      if (!operand.IsEmpty())
+        valid = AddOperand(operand, output);
+      operand.clear();
+      if (valid)
+        valid = AddOperand(expression.Mid(i + 1, end - i - 1), output);
+      i = end;
+    }
+    else if (expression[i] == ']')
+      valid = false;
+    else if (GetOperator(expression[i]))
     {
       // cleanup any operand, translate and put into our expression list
       if (!operand.IsEmpty())
-      {
-        unsigned int info = g_infoManager.Register(operand, m_context);
-        if (info)
-        {
-          m_postfix.push_back(m_operands.size());
-          m_operands.push_back(info);
-        }
-        operand.clear();
-      }
-      // handle closing parenthesis
-      if (expression[i] == ']')
-      {
-        while (operators.size())
-        {
-          char oper = operators.top();
-          operators.pop();
-
-          if (oper == '[')
-            break;
+        valid = AddOperand(operand, output);
+      operand.clear();
 
-          m_postfix.push_back(-GetOperator(oper)); // negative denotes operator
-        }
-      }
-      else
+      // pop off the stack any operator that has a higher priority than the one we have.
+      while (valid && !operators.empty() && GetOperator(operators.top()) > GetOperator(expression[i]))
       {
-        // all other operators we pop off the stack any operator
-        // that has a higher priority than the one we have.
-        while (!operators.empty() && GetOperator(operators.top()) > GetOperator(expression[i]))
-        {
-          // only handle parenthesis once they're closed.
-          if (operators.top() == '[' && expression[i] != ']')
-            break;
-
-          m_postfix.push_back(-GetOperator(operators.top()));  // negative denotes operator
-          operators.pop();
-        }
-        operators.push(expression[i]);
+        valid = ApplyOperator(operators.top(), output);
+        operators.pop();
       }
+      operators.push(expression[i]);
     }
     else
     {
@@ -126,62 +145,48 @@ void InfoExpression::Parse(const CStdString &expression)
     }
   }
 
-  if (!operand.empty())
-  {
-    unsigned int info = g_infoManager.Register(operand, m_context);
-    if (info)
-    {
-      m_postfix.push_back(m_operands.size());
-      m_operands.push_back(info);
-    }
-  }
+  if (valid && !operand.empty())
+    valid = AddOperand(operand, output);
 
-  // finish up by adding any operators
-  while (!operators.empty())
+  // finish up by applying any operators
+  while (valid && !operators.empty())
   {
-    m_postfix.push_back(-GetOperator(operators.top()));  // negative denotes operator
+    valid = ApplyOperator(operators.top(), output);
     operators.pop();
   }
 
-  // test evaluate
-  bool test;
-  if (!Evaluate(NULL, test))
+  if (valid && output.size() == 1)
+    m_code.swap(output.back());
+  else
+  {
     CLog::Log(LOGERROR, "Error evaluating boolean expression %s", expression.c_str());
+    m_code.clear();
+  }
 }
 
-bool InfoExpression::Evaluate(const CGUIListItem *item, bool &result)
+bool InfoExpression::Evaluate(const CGUIListItem *item) const
 {
-  stack<bool> save;
-  for (vector<short>::const_iterator it = m_postfix.begin(); it != m_postfix.end(); ++it)
+  bool value = false;
+  for (unsigned int i = 0; i < m_code.size(); i++)
   {
-    short expr = *it;
-    if (expr == -OPERATOR_NOT)
-    { // NOT the top item on the stack
-      if (save.size() < 1) return false;
-      bool expr = save.top();
-      save.pop();
-      save.push(!expr);
-    }
-    else if (expr == -OPERATOR_AND)
-    { // AND the top two items on the stack
-      if (save.size() < 2) return false;
-      bool right = save.top(); save.pop();
-      bool left = save.top(); save.pop();
-      save.push(left && right);
-    }
-    else if (expr == -OPERATOR_OR)
-    { // OR the top two items on the stack
-      if (save.size() < 2) return false;
-      bool right = save.top(); save.pop();
-      bool left = save.top(); save.pop();
-      save.push(left || right);
+    const Instruction &instruction = m_code[i];
+    switch (instruction.opcode)
+    {
+    case OP_EVALUATE:
+      value = g_infoManager.GetBoolValue(instruction.arg, item);
+      break;
+    case OP_NOT:
+      value = !value;
+      break;
+    case OP_JUMP_IF_FALSE:
+      if (!value)
+        i += instruction.arg;
+      break;
+    case OP_JUMP_IF_TRUE:
+      if (value)
+        i += instruction.arg;
+      break;
     }
-    else  // operand
-      save.push(g_infoManager.GetBoolValue(m_operands[expr], item));
   }
-  if (save.size() != 1)
-    return false;
-  result = save.top();
-  return true;
+  return value;
 }
-
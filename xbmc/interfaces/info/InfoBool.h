@@ -29,6 +29,25 @@ class CGUIListItem;
 
 namespace INFO
 {
+/*!
+ \ingroup info
+ \brief The state that conditions depend on.
+
+ A condition is only re-evaluated once one of the signals it depends on has been raised since
+ it was last evaluated. Conditions whose state can't be tracked depend on SIGNAL_FRAME, which
+ is raised every frame, and conditions that depend on no signal are evaluated just once.
+ */
+enum InfoSignal
+{
+  SIGNAL_FRAME = 0,         ///< raised every frame
+  SIGNAL_PLAYER,            ///< the player state and the playing item, raised every frame while playing
+  SIGNAL_WINDOW,            ///< the active window and dialogs
+  SIGNAL_SKIN,              ///< skin settings
+  SIGNAL_TIME,              ///< the time of day, raised once a minute
+  SIGNAL_CONTAINER_MOVES,   ///< containers moving their focus
+  SIGNAL_MAX
+};
+
 /*!
  \ingroup info
  \brief Base class, wrapping boolean conditions and expressions
@@ -39,6 +58,7 @@ public:
   InfoBool(const CStdString &expression, int context)
     : m_value(false),
       m_context(context),
+      m_dependencies(1 << SIGNAL_FRAME),
       m_expression(expression),
       m_lastUpdate(0)
   {
@@ -48,21 +68,39 @@ public:
 
   /*! \brief Get the value of this info bool
    This is called to update (if necessary) and fetch the value of the info bool
-   \param time current time (used to test if we need to update yet)
+   \param time current time, stamped on the value if we update it
    \param item the item used to evaluate the bool
    */
   inline bool Get(unsigned int time, const CGUIListItem *item = NULL)
   {
-    if (item)
-      Update(item);
-    else if (time - m_lastUpdate > 0)
+    Update(item);
+    // a value for an item doesn't hold for anything else
+    m_lastUpdate = item ? 0 : time;
+    return m_value;
+  }
+
+  /*! \brief Whether the value of this info bool has to be updated
+   \param signals the times at which each of the signals was last raised
+   \return true if we haven't been updated since one of the signals we depend on was raised
+   */
+  inline bool IsDirty(const unsigned int *signals) const
+  {
+    if (!m_lastUpdate)
+      return true;
+    for (unsigned int i = 0; i < SIGNAL_MAX; i++)
     {
-      Update(NULL);
-      m_lastUpdate = time;
+      if ((m_dependencies & (1 << i)) && signals[i] > m_lastUpdate)
+        return true;
     }
-    return m_value;
+    return false;
   }
 
+  inline bool GetValue() const { return m_value; };
+
+  /*! \brief Get the signals this info bool depends on, as a mask of (1 << InfoSignal)
+   */
+  unsigned int GetDependencies() const { return m_dependencies; };
+
   bool operator==(const InfoBool &right) const
   {
     return (m_context == right.m_context && 
@@ -78,6 +116,7 @@ protected:
 
   bool m_value;                ///< current value
   int m_context;               ///< contextual information to go with the condition
+  unsigned int m_dependencies; ///< signals the value depends on, as a mask of (1 << InfoSignal)
 
 private:
   CStdString m_expression;     ///< original expression
@@ -98,6 +137,11 @@ private:
 };
 
 /*! \brief Class to wrap active boolean expressions
+
+ Expressions are compiled into a list of instructions operating on a single boolean value, with
+ jumps over the right hand side of an AND or OR once the left hand side decides it. Bracketed
+ sub-expressions are registered as info bools of their own so that their values are cached and
+ shared between the expressions using them.
  */
 class InfoExpression : public InfoBool
 {
@@ -107,12 +151,29 @@ public:
 
   virtual void Update(const CGUIListItem *item);
 private:
+  enum Opcode
+  {
+    OP_EVALUATE = 0,      ///< set the value to that of the info bool in arg
+    OP_NOT,               ///< negate the value
+    OP_JUMP_IF_FALSE,     ///< skip the next arg instructions if the value is false
+    OP_JUMP_IF_TRUE       ///< skip the next arg instructions if the value is true
+  };
+
+  struct Instruction
+  {
+    Instruction(Opcode op, unsigned int argument = 0) : opcode(op), arg(argument) {};
+    Opcode opcode;
+    unsigned int arg;
+  };
+  typedef std::vector<Instruction> Code;
+
   void Parse(const CStdString &expression);
-  bool Evaluate(const CGUIListItem *item, bool &result);
+  bool AddOperand(const CStdString &operand, std::vector<Code> &output);
+  bool ApplyOperator(char op, std::vector<Code> &output) const;
+  bool Evaluate(const CGUIListItem *item) const;
   short GetOperator(const char ch) const;
 
-  std::vector<short> m_postfix;         ///< the postfix form of the expression (operators and operand indicies)
-  std::vector<unsigned int> m_operands; ///< the operands in the expression
+  Code m_code;             ///< the compiled expression
 };
 
 };
@@ -274,6 +274,31 @@ JSONRPC_STATUS CAudioLibrary::GetGenres(const CStdString &method, ITransportLaye
   return OK;
 }
 
+JSONRPC_STATUS CAudioLibrary::Search(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  // in the order of CMusicDatabase::SearchIndexType
+  static const char * const types[] = { "artist", "album", "song" };
+
+  int type = -1;
+  CStdString strType = parameterObject["type"].asString();
+  for (unsigned int i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+  {
+    if (strType.Equals(types[i]))
+      type = i;
+  }
+
+  CMusicDatabase musicdatabase;
+  if (!musicdatabase.Open())
+    return InternalError;
+
+  std::vector<CSearchIndex::Result> results;
+  if (!musicdatabase.SearchIndex(parameterObject["query"].asString(), type, results))
+    return FailedToExecute;
+
+  HandleSearchResults(types, results, parameterObject, result);
+  return OK;
+}
+
 JSONRPC_STATUS CAudioLibrary::SetArtistDetails(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   int id = (int)parameterObject["artistid"].asInteger();
@@ -212,6 +212,29 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
   }
 }
 
+void CFileItemHandler::HandleSearchResults(const char * const *types, const std::vector<CSearchIndex::Result> &results, const CVariant &parameterObject, CVariant &result)
+{
+  int size  = (int)results.size();
+  int start = (int)parameterObject["limits"]["start"].asInteger();
+  int end   = (int)parameterObject["limits"]["end"].asInteger();
+  end = (end <= 0 || end > size) ? size : end;
+  start = start > end ? end : start;
+
+  result["limits"]["start"] = start;
+  result["limits"]["end"]   = end;
+  result["limits"]["total"] = size;
+
+  result["results"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = start; i < end; i++)
+  {
+    CVariant object;
+    object["type"]  = types[results[i].type];
+    object["id"]    = results[i].id;
+    object["score"] = results[i].score;
+    result["results"].push_back(object);
+  }
+}
+
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */)
 {
   CVariant object;
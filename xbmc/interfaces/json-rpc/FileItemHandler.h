@@ -24,6 +24,7 @@
 #include "JSONUtils.h"
 #include "FileItem.h"
 #include "utils/StdString.h"
+#include "utils/SearchIndex.h"
 
 namespace JSONRPC
 {
@@ -34,6 +35,7 @@ namespace JSONRPC
     static void HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit = true);
     static void HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit = true);
     static void HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append = true);
+    static void HandleSearchResults(const char * const *types, const std::vector<CSearchIndex::Result> &results, const CVariant &parameterObject, CVariant &result);
 
     static bool FillFileItemList(const CVariant &parameterObject, CFileItemList &list);
 
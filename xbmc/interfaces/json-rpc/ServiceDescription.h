@@ -23,7 +23,7 @@
 namespace JSONRPC
 {
   const char* const JSONRPC_SERVICE_ID          = "http://www.xbmc.org/jsonrpc/ServiceDescription.json";
-  const int         JSONRPC_SERVICE_VERSION     = 5;
+  const int         JSONRPC_SERVICE_VERSION     = 6;
   const char* const JSONRPC_SERVICE_DESCRIPTION = "JSON-RPC API of XBMC";
 
   const char* const JSONRPC_SERVICE_TYPES[] = {  
@@ -1660,6 +1660,32 @@ namespace JSONRPC
         "}"
       "}"
     "}",
+    "\"AudioLibrary.Search\": {"
+      "\"type\": \"method\","
+      "\"description\": \"Search the names of artists and the titles of albums and songs, best match first\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": ["
+        "{ \"name\": \"query\", \"type\": \"string\", \"required\": true, \"description\": \"Words to search for, each matching the start of a word in the item\" },"
+        "{ \"name\": \"type\", \"type\": \"string\", \"enum\": [ \"all\", \"artist\", \"album\", \"song\" ], \"default\": \"all\" },"
+        "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" }"
+      "],"
+      "\"returns\": {"
+        "\"type\": \"object\","
+        "\"properties\": {"
+          "\"limits\": { \"$ref\": \"List.LimitsReturned\", \"required\": true },"
+          "\"results\": { \"type\": \"array\", \"required\": true,"
+            "\"items\": { \"type\": \"object\","
+              "\"properties\": {"
+                "\"type\": { \"type\": \"string\", \"required\": true, \"enum\": [ \"artist\", \"album\", \"song\" ] },"
+                "\"id\": { \"$ref\": \"Library.Id\", \"required\": true },"
+                "\"score\": { \"type\": \"number\", \"required\": true }"
+              "}"
+            "}"
+          "}"
+        "}"
+      "}"
+    "}",
     "\"AudioLibrary.SetArtistDetails\": {"
       "\"type\": \"method\","
       "\"description\": \"Update the given artist with the given details\","
@@ -2048,6 +2074,32 @@ namespace JSONRPC
         "}"
       "}"
     "}",
+    "\"VideoLibrary.Search\": {"
+      "\"type\": \"method\","
+      "\"description\": \"Search the titles, cast, tags and plots of movies, tv shows, episodes and music videos, best match first\","
+      "\"transport\": \"Response\","
+      "\"permission\": \"ReadData\","
+      "\"params\": ["
+        "{ \"name\": \"query\", \"type\": \"string\", \"required\": true, \"description\": \"Words to search for, each matching the start of a word in the item\" },"
+        "{ \"name\": \"type\", \"type\": \"string\", \"enum\": [ \"all\", \"movie\", \"tvshow\", \"episode\", \"musicvideo\" ], \"default\": \"all\" },"
+        "{ \"name\": \"limits\", \"$ref\": \"List.Limits\" }"
+      "],"
+      "\"returns\": {"
+        "\"type\": \"object\","
+        "\"properties\": {"
+          "\"limits\": { \"$ref\": \"List.LimitsReturned\", \"required\": true },"
+          "\"results\": { \"type\": \"array\", \"required\": true,"
+            "\"items\": { \"type\": \"object\","
+              "\"properties\": {"
+                "\"type\": { \"type\": \"string\", \"required\": true, \"enum\": [ \"movie\", \"tvshow\", \"episode\", \"musicvideo\" ] },"
+                "\"id\": { \"$ref\": \"Library.Id\", \"required\": true },"
+                "\"score\": { \"type\": \"number\", \"required\": true }"
+              "}"
+            "}"
+          "}"
+        "}"
+      "}"
+    "}",
     "\"VideoLibrary.SetMovieDetails\": {"
       "\"type\": \"method\","
       "\"description\": \"Update the given movie with the given details\","
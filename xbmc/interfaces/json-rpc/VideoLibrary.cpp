@@ -326,6 +326,31 @@ JSONRPC_STATUS CVideoLibrary::GetGenres(const CStdString &method, ITransportLaye
   return OK;
 }
 
+JSONRPC_STATUS CVideoLibrary::Search(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  // in the order of CVideoDatabase::SearchIndexType
+  static const char * const types[] = { "movie", "tvshow", "episode", "musicvideo" };
+
+  int type = -1;
+  CStdString strType = parameterObject["type"].asString();
+  for (unsigned int i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+  {
+    if (strType.Equals(types[i]))
+      type = i;
+  }
+
+  CVideoDatabase videodatabase;
+  if (!videodatabase.Open())
+    return InternalError;
+
+  std::vector<CSearchIndex::Result> results;
+  if (!videodatabase.SearchIndex(parameterObject["query"].asString(), type, results))
+    return FailedToExecute;
+
+  HandleSearchResults(types, results, parameterObject, result);
+  return OK;
+}
+
 JSONRPC_STATUS CVideoLibrary::SetMovieDetails(const CStdString &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   int id = (int)parameterObject["movieid"].asInteger();
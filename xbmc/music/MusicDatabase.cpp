@@ -20,6 +20,7 @@
  */
 
 #include "threads/SystemClock.h"
+#include "threads/SingleLock.h"
 #include "system.h"
 #include "MusicDatabase.h"
 #include "network/cddb.h"
@@ -62,6 +63,8 @@
 #include "interfaces/AnnouncementManager.h"
 #include "dbwrappers/dataset.h"
 #include "utils/XMLUtils.h"
+#include "utils/SearchIndex.h"
+#include "utils/FileExistenceChecker.h"
 #include "URL.h"
 
 using namespace std;
@@ -72,6 +75,15 @@ using ADDON::AddonPtr;
 
 #define RECENTLY_PLAYED_LIMIT 25
 #define MIN_FULL_SEARCH_LENGTH 3
+// the most results a search fetches of each type, which bounds the id lists queried for them
+#define SEARCH_INDEX_LIMIT 1000
+
+// shared by all CMusicDatabase instances, so the scanner keeps it current for the GUI
+static CSearchIndex &GetMusicSearchIndex()
+{
+  static CSearchIndex index;
+  return index;
+}
 
 #ifdef HAS_DVD_DRIVE
 using namespace CDDB;
@@ -79,6 +91,9 @@ using namespace CDDB;
 
 CMusicDatabase::CMusicDatabase(void)
 {
+  m_cacheHits = 0;
+  m_cacheMisses = 0;
+  m_searchIndexChanged = false;
 }
 
 CMusicDatabase::~CMusicDatabase(void)
@@ -110,7 +125,7 @@ bool CMusicDatabase::CreateTables()
     CLog::Log(LOGINFO, "create genre table");
     m_pDS->exec("CREATE TABLE genre ( idGenre integer primary key, strGenre varchar(256))\n");
     CLog::Log(LOGINFO, "create path table");
-    m_pDS->exec("CREATE TABLE path ( idPath integer primary key, strPath varchar(512), strHash text)\n");
+    m_pDS->exec("CREATE TABLE path ( idPath integer primary key, strPath varchar(512), strHash text, strMTime text)\n");
     CLog::Log(LOGINFO, "create song table");
     m_pDS->exec("CREATE TABLE song ( idSong integer primary key, idAlbum integer, idPath integer, strArtists text, strGenres text, strTitle varchar(512), iTrack integer, iDuration integer, iYear integer, dwFileNameCRC text, strFileName text, strMusicBrainzTrackID text, strMusicBrainzArtistID text, strMusicBrainzAlbumID text, strMusicBrainzAlbumArtistID text, strMusicBrainzTRMID text, iTimesPlayed integer, iStartOffset integer, iEndOffset integer, idThumb integer, lastplayed varchar(20) default NULL, rating char default '0', comment text)\n");
     CLog::Log(LOGINFO, "create song_artist table");
@@ -195,6 +210,10 @@ bool CMusicDatabase::CreateTables()
     m_pDS->exec("CREATE TRIGGER delete_album AFTER DELETE ON album FOR EACH ROW BEGIN DELETE FROM art WHERE media_id=old.idAlbum AND media_type='album'; END");
     m_pDS->exec("CREATE TRIGGER delete_artist AFTER DELETE ON artist FOR EACH ROW BEGIN DELETE FROM art WHERE media_id=old.idArtist AND media_type='artist'; END");
 
+    CLog::Log(LOGINFO, "create searchgeneration table");
+    m_pDS->exec("CREATE TABLE searchgeneration (idGeneration integer)");
+    m_pDS->exec("INSERT INTO searchgeneration (idGeneration) VALUES (0)");
+
     // we create views last to ensure all indexes are rolled in
     CreateViews();
 
@@ -363,6 +382,12 @@ int CMusicDatabase::AddSong(const CSong& song, bool bCheck, int idAlbum)
         idSong = (int)m_pDS->lastinsertid();
       else
         idSong = song.idSong;
+
+      CSearchIndex::Fields fields;
+      fields.push_back(CSearchIndex::Field(song.strTitle, 1.0f));
+      fields.push_back(CSearchIndex::Field(StringUtils::Join(song.artist, " "), 0.5f));
+      fields.push_back(CSearchIndex::Field(song.strAlbum, 0.3f));
+      UpdateSearchIndex(SEARCH_INDEX_SONG, idSong, fields, BumpSearchIndexGeneration());
     }
 
     if (!song.strThumb.empty())
@@ -473,6 +498,11 @@ int CMusicDatabase::AddAlbum(const CStdString& strAlbum1, const CStdString &strA
       album.strAlbum = strAlbum;
       album.artist = StringUtils::Split(strArtist, g_advancedSettings.m_musicItemSeparator);
       m_albumCache.insert(pair<CStdString, CAlbumCache>(album.strAlbum + strArtist, album));
+
+      CSearchIndex::Fields fields;
+      fields.push_back(CSearchIndex::Field(strAlbum, 1.0f));
+      fields.push_back(CSearchIndex::Field(strArtist, 0.5f));
+      UpdateSearchIndex(SEARCH_INDEX_ALBUM, album.idAlbum, fields, BumpSearchIndexGeneration());
       return album.idAlbum;
     }
     else
@@ -519,10 +549,16 @@ int CMusicDatabase::AddGenre(const CStdString& strGenre1)
     if (NULL == m_pDS.get()) return -1;
     map <CStdString, int>::const_iterator it;
 
-    it = m_genreCache.find(strGenre);
+    // genres are matched case insensitively (LIKE), so key the cache the same way
+    CStdString strKey(strGenre);
+    strKey.ToLower();
+    it = m_genreCache.find(strKey);
     if (it != m_genreCache.end())
+    {
+      m_cacheHits++;
       return it->second;
-
+    }
+    m_cacheMisses++;
 
     strSQL=PrepareSQL("select * from genre where strGenre like '%s'", strGenre.c_str());
     m_pDS->query(strSQL.c_str());
@@ -534,13 +570,13 @@ int CMusicDatabase::AddGenre(const CStdString& strGenre1)
       m_pDS->exec(strSQL.c_str());
 
       int idGenre = (int)m_pDS->lastinsertid();
-      m_genreCache.insert(pair<CStdString, int>(strGenre1, idGenre));
+      m_genreCache.insert(pair<CStdString, int>(strKey, idGenre));
       return idGenre;
     }
     else
     {
       int idGenre = m_pDS->fv("idGenre").get_asInt();
-      m_genreCache.insert(pair<CStdString, int>(strGenre1, idGenre));
+      m_genreCache.insert(pair<CStdString, int>(strKey, idGenre));
       m_pDS->close();
       return idGenre;
     }
@@ -570,9 +606,16 @@ int CMusicDatabase::AddArtist(const CStdString& strArtist1)
 
     map <CStdString, int>::const_iterator it;
 
-    it = m_artistCache.find(strArtist);
+    // artists are matched case insensitively (LIKE), so key the cache the same way
+    CStdString strKey(strArtist);
+    strKey.ToLower();
+    it = m_artistCache.find(strKey);
     if (it != m_artistCache.end())
+    {
+      m_cacheHits++;
       return it->second;//.idArtist;
+    }
+    m_cacheMisses++;
 
     strSQL=PrepareSQL("select * from artist where strArtist like '%s'", strArtist.c_str());
     m_pDS->query(strSQL.c_str());
@@ -584,13 +627,17 @@ int CMusicDatabase::AddArtist(const CStdString& strArtist1)
       strSQL=PrepareSQL("insert into artist (idArtist, strArtist) values( NULL, '%s' )", strArtist.c_str());
       m_pDS->exec(strSQL.c_str());
       int idArtist = (int)m_pDS->lastinsertid();
-      m_artistCache.insert(pair<CStdString, int>(strArtist1, idArtist));
+      m_artistCache.insert(pair<CStdString, int>(strKey, idArtist));
+
+      CSearchIndex::Fields fields;
+      fields.push_back(CSearchIndex::Field(strArtist, 1.0f));
+      UpdateSearchIndex(SEARCH_INDEX_ARTIST, idArtist, fields, BumpSearchIndexGeneration());
       return idArtist;
     }
     else
     {
       int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
-      m_artistCache.insert(pair<CStdString, int>(strArtist1, idArtist));
+      m_artistCache.insert(pair<CStdString, int>(strKey, idArtist));
       m_pDS->close();
       return idArtist;
     }
@@ -792,7 +839,11 @@ int CMusicDatabase::AddPath(const CStdString& strPath1)
 
     it = m_pathCache.find(strPath);
     if (it != m_pathCache.end())
+    {
+      m_cacheHits++;
       return it->second;
+    }
+    m_cacheMisses++;
 
     strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
     m_pDS->query(strSQL.c_str());
@@ -1114,7 +1165,16 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
     int idVariousArtist = AddArtist(g_localizeStrings.Get(340));
 
     CStdString strSQL;
-    if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
+    CStdString ids;
+    std::vector<int> order;
+    bool indexed = GetSearchIndexIds(search, SEARCH_INDEX_ARTIST, SEARCH_INDEX_LIMIT, ids, order);
+    if (indexed)
+    {
+      if (ids.IsEmpty())
+        return false;
+      strSQL=PrepareSQL("select * from artist where idArtist in (%s) and idArtist <> %i", ids.c_str(), idVariousArtist);
+    }
+    else if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from artist "
                                 "where (strArtist like '%s%%' or strArtist like '%% %s%%') and idArtist <> %i "
                                 , search.c_str(), search.c_str(), idVariousArtist );
@@ -1131,6 +1191,7 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
     }
 
     CStdString artistLabel(g_localizeStrings.Get(557)); // Artist
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       CStdString path;
@@ -1142,11 +1203,15 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
       label.Format("A %s", m_pDS->fv(1).get_asString()); // sort label is stored in the title tag
       pItem->GetMusicInfoTag()->SetTitle(label);
       pItem->GetMusicInfoTag()->SetDatabaseId(m_pDS->fv(0).get_asInt(), "artist");
-      artists.Add(pItem);
+      fetched.push_back(std::make_pair(m_pDS->fv(0).get_asInt(), pItem));
       m_pDS->next();
     }
-
     m_pDS->close(); // cleanup recordset data
+
+    if (indexed)
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      artists.Add(fetched[i].second);
     return true;
   }
   catch (...)
@@ -1741,6 +1806,11 @@ bool CMusicDatabase::GetSongsByPath(const CStdString& strPath1, CSongMap& songs,
 
 void CMusicDatabase::EmptyCache()
 {
+  if (m_cacheHits || m_cacheMisses)
+    CLog::Log(LOGDEBUG, "%s - lookup cache: %u hits, %u misses (%u artists, %u genres, %u paths)", __FUNCTION__,
+              m_cacheHits, m_cacheMisses, (unsigned int)m_artistCache.size(), (unsigned int)m_genreCache.size(), (unsigned int)m_pathCache.size());
+  m_cacheHits = m_cacheMisses = 0;
+
   m_artistCache.erase(m_artistCache.begin(), m_artistCache.end());
   m_genreCache.erase(m_genreCache.begin(), m_genreCache.end());
   m_pathCache.erase(m_pathCache.begin(), m_pathCache.end());
@@ -1748,6 +1818,54 @@ void CMusicDatabase::EmptyCache()
   m_thumbCache.erase(m_thumbCache.begin(), m_thumbCache.end());
 }
 
+void CMusicDatabase::PreloadCaches()
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return;
+    if (NULL == m_pDS.get()) return;
+
+    unsigned int time = XbmcThreads::SystemClockMillis();
+
+    if (!m_pDS->query("select idArtist, strArtist from artist")) return;
+    while (!m_pDS->eof())
+    {
+      CStdString strKey = m_pDS->fv(1).get_asString();
+      strKey.ToLower();
+      m_artistCache.insert(make_pair(strKey, m_pDS->fv(0).get_asInt()));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query("select idGenre, strGenre from genre")) return;
+    while (!m_pDS->eof())
+    {
+      CStdString strKey = m_pDS->fv(1).get_asString();
+      strKey.ToLower();
+      m_genreCache.insert(make_pair(strKey, m_pDS->fv(0).get_asInt()));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query("select idPath, strPath from path")) return;
+    while (!m_pDS->eof())
+    {
+      m_pathCache.insert(make_pair(CStdString(m_pDS->fv(1).get_asString()), m_pDS->fv(0).get_asInt()));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    CLog::Log(LOGDEBUG, "%s - preloaded %u artists, %u genres, %u paths in %u ms", __FUNCTION__,
+              (unsigned int)m_artistCache.size(), (unsigned int)m_genreCache.size(), (unsigned int)m_pathCache.size(),
+              XbmcThreads::SystemClockMillis() - time);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    EmptyCache();
+  }
+}
+
 bool CMusicDatabase::Search(const CStdString& search, CFileItemList &items)
 {
   unsigned int time = XbmcThreads::SystemClockMillis();
@@ -1768,6 +1886,160 @@ bool CMusicDatabase::Search(const CStdString& search, CFileItemList &items)
   return true;
 }
 
+CStdString CMusicDatabase::GetSearchIndexSource()
+{
+  if (!m_pDS->query("select idGeneration from searchgeneration"))
+    return "";
+  if (m_pDS->eof())
+  {
+    m_pDS->close();
+    return "";
+  }
+  int generation = m_pDS->fv(0).get_asInt();
+  m_pDS->close();
+  return GetSearchIndexSource(generation);
+}
+
+CStdString CMusicDatabase::GetSearchIndexSource(int generation)
+{
+  // the profile and database, and the number of changes made to the indexed items, so that the
+  // index is rebuilt after a profile switch, or after items are changed by anyone else, such as
+  // another client of a shared mysql database
+  CStdString source;
+  source.Format("%s|%s|%s|%i", g_settings.GetCurrentProfile().getDirectory().c_str(),
+                m_pDB->getHostName(), m_pDB->getDatabase(), generation);
+  return source;
+}
+
+int CMusicDatabase::BumpSearchIndexGeneration()
+{
+  // called within the write, so the change and its generation are committed together
+  m_pDS->exec("update searchgeneration set idGeneration=idGeneration+1");
+  if (!m_pDS->query("select idGeneration from searchgeneration"))
+    return -1;
+  int generation = m_pDS->eof() ? -1 : m_pDS->fv(0).get_asInt();
+  m_pDS->close();
+  return generation;
+}
+
+void CMusicDatabase::UpdateSearchIndex(int type, int id, const CSearchIndex::Fields &fields, int generation)
+{
+  // only an index holding every change before this one can take it; any other is rebuilt
+  // on the next search. An index being built is left alone, as the build reads the generation
+  // committed before this change.
+  CSearchIndex &index = GetMusicSearchIndex();
+  CSingleTryLock lock(index.GetBuildSection());
+  if (!lock.IsOwner() || generation < 1 || !index.IsBuiltFrom(GetSearchIndexSource(generation - 1)))
+    return;
+
+  index.AddDocument(type, id, fields);
+  index.SetBuilt(GetSearchIndexSource(generation));
+  m_searchIndexChanged = true;
+}
+
+void CMusicDatabase::RemoveFromSearchIndex(int type, const std::vector<int> &ids, int generation)
+{
+  CSearchIndex &index = GetMusicSearchIndex();
+  CSingleTryLock lock(index.GetBuildSection());
+  if (!lock.IsOwner() || generation < 1 || !index.IsBuiltFrom(GetSearchIndexSource(generation - 1)))
+    return;
+
+  for (std::vector<int>::const_iterator i = ids.begin(); i != ids.end(); ++i)
+    index.RemoveDocument(type, *i);
+  index.SetBuilt(GetSearchIndexSource(generation));
+  m_searchIndexChanged = true;
+}
+
+bool CMusicDatabase::BuildSearchIndex()
+{
+  CSearchIndex &index = GetMusicSearchIndex();
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    // the state of the tables is taken before they're read, so that
+    // anything changed while we build has the index rebuilt next time
+    CSingleLock lock(index.GetBuildSection());
+    CStdString source = GetSearchIndexSource();
+    if (source.IsEmpty())
+      return false;
+    if (index.IsBuiltFrom(source))
+      return true;
+
+    index.Clear();
+    unsigned int time = XbmcThreads::SystemClockMillis();
+
+    if (!m_pDS->query("select idArtist, strArtist from artist")) return false;
+    while (!m_pDS->eof())
+    {
+      CSearchIndex::Fields fields;
+      fields.push_back(CSearchIndex::Field(m_pDS->fv(1).get_asString(), 1.0f));
+      index.AddDocument(SEARCH_INDEX_ARTIST, m_pDS->fv(0).get_asInt(), fields);
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query("select idAlbum, strAlbum, strArtists from album")) return false;
+    while (!m_pDS->eof())
+    {
+      CSearchIndex::Fields fields;
+      fields.push_back(CSearchIndex::Field(m_pDS->fv(1).get_asString(), 1.0f));
+      fields.push_back(CSearchIndex::Field(m_pDS->fv(2).get_asString(), 0.5f));
+      index.AddDocument(SEARCH_INDEX_ALBUM, m_pDS->fv(0).get_asInt(), fields);
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!m_pDS->query("select song.idSong, song.strTitle, song.strArtists, album.strAlbum from song join album on song.idAlbum=album.idAlbum")) return false;
+    while (!m_pDS->eof())
+    {
+      CSearchIndex::Fields fields;
+      fields.push_back(CSearchIndex::Field(m_pDS->fv(1).get_asString(), 1.0f));
+      fields.push_back(CSearchIndex::Field(m_pDS->fv(2).get_asString(), 0.5f));
+      fields.push_back(CSearchIndex::Field(m_pDS->fv(3).get_asString(), 0.3f));
+      index.AddDocument(SEARCH_INDEX_SONG, m_pDS->fv(0).get_asInt(), fields);
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    index.SetBuilt(source);
+    CLog::Log(LOGDEBUG, "%s - indexed %u items in %u ms", __FUNCTION__, index.Size(), XbmcThreads::SystemClockMillis() - time);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  index.Clear();
+  return false;
+}
+
+bool CMusicDatabase::SearchIndex(const CStdString& search, int type, std::vector<CSearchIndex::Result> &results, unsigned int limit)
+{
+  if (!g_advancedSettings.m_bMusicLibrarySearchIndex || !BuildSearchIndex())
+    return false;
+
+  unsigned int time = XbmcThreads::SystemClockMillis();
+  GetMusicSearchIndex().Search(search, type, results, limit);
+  CLog::Log(LOGDEBUG, "%s - '%s' matched %u items in %u ms", __FUNCTION__, search.c_str(), (unsigned int)results.size(), XbmcThreads::SystemClockMillis() - time);
+  return true;
+}
+
+bool CMusicDatabase::GetSearchIndexIds(const CStdString& search, int type, unsigned int limit, CStdString &ids, std::vector<int> &order)
+{
+  std::vector<CSearchIndex::Result> results;
+  if (!SearchIndex(search, type, results, limit))
+    return false;
+
+  for (std::vector<CSearchIndex::Result>::const_iterator i = results.begin(); i != results.end(); ++i)
+  {
+    ids.AppendFormat("%s%i", ids.IsEmpty() ? "" : ",", i->id);
+    order.push_back(i->id);
+  }
+  return true;
+}
+
 bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
 {
   try
@@ -1776,7 +2048,16 @@ bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
     if (NULL == m_pDS.get()) return false;
 
     CStdString strSQL;
-    if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
+    CStdString ids;
+    std::vector<int> order;
+    bool indexed = GetSearchIndexIds(search, SEARCH_INDEX_SONG, SEARCH_INDEX_LIMIT, ids, order);
+    if (indexed)
+    {
+      if (ids.IsEmpty())
+        return false;
+      strSQL=PrepareSQL("select * from songview where idSong in (%s)", ids.c_str());
+    }
+    else if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' or strTitle like '%% %s%%' limit 1000", search.c_str(), search.c_str());
     else
       strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' limit 1000", search.c_str());
@@ -1785,15 +2066,20 @@ bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
     if (m_pDS->num_rows() == 0) return false;
 
     CStdString songLabel = g_localizeStrings.Get(179); // Song
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       CFileItemPtr item(new CFileItem);
       GetFileItemFromDataset(item.get(), "musicdb://4/");
-      items.Add(item);
+      fetched.push_back(std::make_pair(item->GetMusicInfoTag()->GetDatabaseId(), item));
       m_pDS->next();
     }
-
     m_pDS->close();
+
+    if (indexed)
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      items.Add(fetched[i].second);
     return true;
   }
   catch (...)
@@ -1812,7 +2098,16 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
     if (NULL == m_pDS.get()) return false;
 
     CStdString strSQL;
-    if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
+    CStdString ids;
+    std::vector<int> order;
+    bool indexed = GetSearchIndexIds(search, SEARCH_INDEX_ALBUM, SEARCH_INDEX_LIMIT, ids, order);
+    if (indexed)
+    {
+      if (ids.IsEmpty())
+        return false;
+      strSQL=PrepareSQL("select * from albumview where idAlbum in (%s)", ids.c_str());
+    }
+    else if (search.GetLength() >= MIN_FULL_SEARCH_LENGTH)
       strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%' or strAlbum like '%% %s%%'", search.c_str(), search.c_str());
     else
       strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%'", search.c_str());
@@ -1820,6 +2115,7 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
     if (!m_pDS->query(strSQL.c_str())) return false;
 
     CStdString albumLabel(g_localizeStrings.Get(558)); // Album
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       CAlbum album = GetAlbumFromDataset(m_pDS.get());
@@ -1831,10 +2127,15 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
       pItem->SetLabel(label);
       label.Format("B %s", album.strAlbum); // sort label is stored in the title tag
       pItem->GetMusicInfoTag()->SetTitle(label);
-      albums.Add(pItem);
+      fetched.push_back(std::make_pair(album.idAlbum, pItem));
       m_pDS->next();
     }
     m_pDS->close(); // cleanup recordset data
+
+    if (indexed)
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      albums.Add(fetched[i].second);
     return true;
   }
   catch (...)
@@ -1977,26 +2278,25 @@ bool CMusicDatabase::SetAlbumInfoSongs(int idAlbumInfo, const VECSONGS& songs)
   return false;
 }
 
-bool CMusicDatabase::CleanupSongsByIds(const CStdString &strSongIds)
+bool CMusicDatabase::CleanupSongs(CGUIDialogProgress *pDlgProgress)
 {
   try
   {
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
-    // ok, now find all idSong's
-    CStdString strSQL=PrepareSQL("select * from song join path on song.idPath = path.idPath where song.idSong in %s", strSongIds.c_str());
+
+    // a clean that is cancelled picks up where it left off next time
+    CStdString cursorFile;
+    URIUtils::AddFileToFolder(g_settings.GetDatabaseFolder(), CStdString(GetBaseDBName()) + "CleanCursor.xml", cursorFile);
+    CFileExistenceChecker checker(cursorFile);
+
+    CStdString strSQL = "select song.idSong, song.strFileName, path.idPath, path.strPath from song join path on song.idPath = path.idPath order by path.idPath";
     if (!m_pDS->query(strSQL.c_str())) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
-    {
-      m_pDS->close();
-      return true;
-    }
-    CStdString strSongsToDelete = "";
     while (!m_pDS->eof())
     { // get the full song path
+      CStdString strPath = m_pDS->fv("path.strPath").get_asString();
       CStdString strFileName;
-      URIUtils::AddFileToFolder(m_pDS->fv("path.strPath").get_asString(), m_pDS->fv("song.strFileName").get_asString(), strFileName);
+      URIUtils::AddFileToFolder(strPath, m_pDS->fv("song.strFileName").get_asString(), strFileName);
 
       //  Special case for streams inside an ogg file. (oggstream)
       //  The last dir in the path is the ogg file that
@@ -2010,18 +2310,42 @@ bool CMusicDatabase::CleanupSongsByIds(const CStdString &strSongIds)
         URIUtils::RemoveSlashAtEnd(strFileName);
       }
 
-      if (!CFile::Exists(strFileName))
-      { // file no longer exists, so add to deletion list
-        strSongsToDelete += m_pDS->fv("song.idSong").get_asString() + ",";
-      }
+      checker.AddFile(m_pDS->fv("path.idPath").get_asInt(), strPath, m_pDS->fv("song.idSong").get_asInt(), strFileName);
       m_pDS->next();
     }
     m_pDS->close();
 
-    if ( ! strSongsToDelete.IsEmpty() )
+    // check the songs a directory at a time, and each source in parallel.
+    // songs found missing before a cancel are still removed, so that the check can resume.
+    checker.Start(*g_settings.GetSourcesFromType("music"));
+    while (!checker.Wait(100))
+    {
+      if (pDlgProgress)
+      {
+        unsigned int current, total;
+        checker.GetProgress(current, total);
+        pDlgProgress->SetPercentage(total ? current * 20 / total : 0);
+        pDlgProgress->Progress();
+        if (pDlgProgress->IsCanceled())
+          checker.Stop();
+      }
+    }
+
+    std::vector<int> missing;
+    checker.GetMissing(missing);
+    CLog::Log(LOGDEBUG, "%s - %u songs no longer exist", __FUNCTION__, (unsigned int)missing.size());
+
+    // delete these songs + all references to them from the linked tables, in batches
+    for (unsigned int i = 0; i < missing.size(); i += 1000)
     {
-      strSongsToDelete = "(" + strSongsToDelete.TrimRight(",") + ")";
-      // ok, now delete these songs + all references to them from the linked tables
+      CStdString strSongsToDelete;
+      std::vector<int> batch;
+      for (unsigned int j = i; j < missing.size() && j < i + 1000; j++)
+      {
+        strSongsToDelete.AppendFormat("%s%i", j == i ? "" : ",", missing[j]);
+        batch.push_back(missing[j]);
+      }
+      strSongsToDelete = "(" + strSongsToDelete + ")";
       strSQL = "delete from song where idSong in " + strSongsToDelete;
       m_pDS->exec(strSQL.c_str());
       strSQL = "delete from song_artist where idSong in " + strSongsToDelete;
@@ -2030,46 +2354,7 @@ bool CMusicDatabase::CleanupSongsByIds(const CStdString &strSongIds)
       m_pDS->exec(strSQL.c_str());
       strSQL = "delete from karaokedata where idSong in " + strSongsToDelete;
       m_pDS->exec(strSQL.c_str());
-      m_pDS->close();
-    }
-    return true;
-  }
-  catch (...)
-  {
-    CLog::Log(LOGERROR, "Exception in CMusicDatabase::CleanupSongsFromPaths()");
-  }
-  return false;
-}
-
-
-bool CMusicDatabase::CleanupSongs()
-{
-  try
-  {
-    // run through all songs and get all unique path ids
-    int iLIMIT = 1000;
-    for (int i=0;;i+=iLIMIT)
-    {
-      CStdString strSQL=PrepareSQL("select song.idSong from song order by song.idSong limit %i offset %i",iLIMIT,i);
-      if (!m_pDS->query(strSQL.c_str())) return false;
-      int iRowsFound = m_pDS->num_rows();
-      // keep going until no rows are left!
-      if (iRowsFound == 0)
-      {
-        m_pDS->close();
-        return true;
-      }
-      CStdString strSongIds = "(";
-      while (!m_pDS->eof())
-      {
-        strSongIds += m_pDS->fv("song.idSong").get_asString() + ",";
-        m_pDS->next();
-      }
-      m_pDS->close();
-      strSongIds.TrimRight(",");
-      strSongIds += ")";
-      CLog::Log(LOGDEBUG,"Checking songs from song ID list: %s",strSongIds.c_str());
-      if (!CleanupSongsByIds(strSongIds)) return false;
+      RemoveFromSearchIndex(SEARCH_INDEX_SONG, batch, BumpSearchIndexGeneration());
     }
     return true;
   }
@@ -2095,9 +2380,11 @@ bool CMusicDatabase::CleanupAlbums()
       return true;
     }
     CStdString strAlbumIds = "(";
+    std::vector<int> ids;
     while (!m_pDS->eof())
     {
       strAlbumIds += m_pDS->fv("album.idAlbum").get_asString() + ",";
+      ids.push_back(m_pDS->fv("album.idAlbum").get_asInt());
       m_pDS->next();
     }
     m_pDS->close();
@@ -2113,6 +2400,7 @@ bool CMusicDatabase::CleanupAlbums()
     m_pDS->exec(strSQL.c_str());
     strSQL = "delete from albuminfo where idAlbum in " + strAlbumIds;
     m_pDS->exec(strSQL.c_str());
+    RemoveFromSearchIndex(SEARCH_INDEX_ALBUM, ids, BumpSearchIndexGeneration());
     return true;
   }
   catch (...)
@@ -2162,6 +2450,7 @@ bool CMusicDatabase::CleanupPaths()
       deleteSQL = "DELETE FROM path WHERE idPath IN (" + deleteSQL.TrimRight(',') + ")";
       // do the deletion, and drop our temp table
       m_pDS->exec(deleteSQL.c_str());
+      m_pathCache.clear();
     }
     m_pDS->exec("drop table songpaths");
     return true;
@@ -2182,12 +2471,25 @@ bool CMusicDatabase::CleanupArtists()
     // don't delete the "Various Artists" string
     CStdString strVariousArtists = g_localizeStrings.Get(340);
     int idVariousArtists = AddArtist(strVariousArtists);
-    CStdString strSQL = "delete from artist where idArtist not in (select idArtist from song_artist)";
-    strSQL += " and idArtist not in (select idArtist from album_artist)";
+    CStdString strWhere = " where idArtist not in (select idArtist from song_artist)";
+    strWhere += " and idArtist not in (select idArtist from album_artist)";
     CStdString strSQL2;
     strSQL2.Format(" and idArtist<>%i", idVariousArtists);
-    strSQL += strSQL2;
+    strWhere += strSQL2;
+    CStdString strSQL = "select idArtist from artist" + strWhere;
+    if (!m_pDS->query(strSQL.c_str())) return false;
+    std::vector<int> ids;
+    while (!m_pDS->eof())
+    {
+      ids.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    strSQL = "delete from artist" + strWhere;
     m_pDS->exec(strSQL.c_str());
+    if (!ids.empty())
+      RemoveFromSearchIndex(SEARCH_INDEX_ARTIST, ids, BumpSearchIndexGeneration());
+    m_artistCache.clear();
     m_pDS->exec("delete from artistinfo where idArtist not in (select idArtist from artist)");
     m_pDS->exec("delete from album_artist where idArtist not in (select idArtist from artist)");
     m_pDS->exec("delete from song_artist where idArtist not in (select idArtist from artist)");
@@ -2211,6 +2513,7 @@ bool CMusicDatabase::CleanupGenres()
     CStdString strSQL = "delete from genre where idGenre not in (select idGenre from song_genre) and";
     strSQL += " idGenre not in (select idGenre from album_genre)";
     m_pDS->exec(strSQL.c_str());
+    m_genreCache.clear();
     return true;
   }
   catch (...)
@@ -2250,7 +2553,7 @@ int CMusicDatabase::Cleanup(CGUIDialogProgress *pDlgProgress)
     pDlgProgress->StartModal();
     pDlgProgress->ShowProgressBar(true);
   }
-  if (!CleanupSongs())
+  if (!CleanupSongs(pDlgProgress))
   {
     RollbackTransaction();
     return ERROR_REORG_SONGS;
@@ -3516,6 +3819,17 @@ bool CMusicDatabase::UpdateOldVersion(int version)
     g_settings.Save();
   }
 
+  if (version < 28)
+  { // add modification times of paths, for fast library updates
+    m_pDS->exec("ALTER TABLE path ADD strMTime text");
+  }
+
+  if (version < 29)
+  { // counts the changes to indexed items, so the search index knows when it's out of date
+    m_pDS->exec("CREATE TABLE searchgeneration (idGeneration integer)");
+    m_pDS->exec("INSERT INTO searchgeneration (idGeneration) VALUES (0)");
+  }
+
   // always recreate the views after any table change
   CreateViews();
 
@@ -3903,6 +4217,78 @@ bool CMusicDatabase::GetPathHash(const CStdString &path, CStdString &hash)
   return false;
 }
 
+bool CMusicDatabase::GetPathHashes(map<CStdString, CStdString> &hashes)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    hashes.clear();
+    if (!m_pDS->query("select strPath, strHash from path")) return false;
+    while (!m_pDS->eof())
+    {
+      hashes.insert(make_pair(CStdString(m_pDS->fv(0).get_asString()), CStdString(m_pDS->fv(1).get_asString())));
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+bool CMusicDatabase::GetPathMTimes(map<CStdString, CStdString> &mtimes)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    mtimes.clear();
+    if (!m_pDS->query("select strPath, strMTime from path where strMTime is not NULL")) return false;
+    while (!m_pDS->eof())
+    {
+      mtimes.insert(make_pair(CStdString(m_pDS->fv(0).get_asString()), CStdString(m_pDS->fv(1).get_asString())));
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+bool CMusicDatabase::SetPathMTimes(const map<CStdString, CStdString> &mtimes)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    BeginTransaction();
+    for (map<CStdString, CStdString>::const_iterator i = mtimes.begin(); i != mtimes.end(); ++i)
+    {
+      CStdString strSQL = PrepareSQL("update path set strMTime='%s' where strPath='%s'", i->second.c_str(), i->first.c_str());
+      m_pDS->exec(strSQL.c_str());
+    }
+    CommitTransaction();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    RollbackTransaction();
+  }
+  return false;
+}
+
 bool CMusicDatabase::RemoveSongsFromPath(const CStdString &path1, CSongMap &songs, bool exact)
 {
   // We need to remove all songs from this path, as their tags are going
@@ -3975,6 +4361,7 @@ bool CMusicDatabase::RemoveSongsFromPath(const CStdString &path1, CSongMap &song
       m_pDS->exec(sql.c_str());
       sql = "delete from karaokedata where idSong in " + songIds;
       m_pDS->exec(sql.c_str());
+      RemoveFromSearchIndex(SEARCH_INDEX_SONG, ids, BumpSearchIndexGeneration());
 
       for (unsigned int i = 0; i < ids.size(); i++)
         AnnounceRemove("song", ids[i]);
@@ -3982,6 +4369,14 @@ bool CMusicDatabase::RemoveSongsFromPath(const CStdString &path1, CSongMap &song
     // and remove the path as well (it'll be re-added later on with the new hash if it's non-empty)
     sql = "delete from path" + where;
     m_pDS->exec(sql.c_str());
+    if (exact)
+      m_pathCache.erase(path);
+    else
+    {
+      map<CStdString, int>::iterator it = m_pathCache.lower_bound(path);
+      while (it != m_pathCache.end() && it->first.Left(path.size()) == path)
+        m_pathCache.erase(it++);
+    }
     return iRowsFound > 0;
   }
   catch (...)
@@ -4090,12 +4485,25 @@ bool CMusicDatabase::CommitTransaction()
 {
   if (CDatabase::CommitTransaction())
   { // number of items in the db has likely changed, so reset the infomanager cache
+    m_searchIndexChanged = false;
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSIC, GetSongsCount("") > 0);
     return true;
   }
   return false;
 }
 
+void CMusicDatabase::RollbackTransaction()
+{
+  CDatabase::RollbackTransaction();
+  if (m_searchIndexChanged)
+  { // the index holds changes that were just undone, under generations that will be reused
+    CSearchIndex &index = GetMusicSearchIndex();
+    CSingleLock lock(index.GetBuildSection());
+    index.Clear();
+    m_searchIndexChanged = false;
+  }
+}
+
 bool CMusicDatabase::SetScraperForPath(const CStdString& strPath, const ADDON::ScraperPtr& scraper)
 {
   try
@@ -27,6 +27,7 @@
 #include "Album.h"
 #include "addons/Scraper.h"
 #include "utils/SortUtils.h"
+#include "utils/SearchIndex.h"
 
 class CArtist;
 class CFileItem;
@@ -121,7 +122,15 @@ public:
 
   virtual bool Open();
   virtual bool CommitTransaction();
+  virtual void RollbackTransaction();
   void EmptyCache();
+
+  /*! \brief Bulk load the artist, genre and path lookup caches.
+   Used at the start of a scan so that AddArtist, AddGenre and AddPath can
+   resolve existing entries without a query per item. The caches are kept
+   until EmptyCache() is called, and are invalidated by the cleanup routines.
+   */
+  void PreloadCaches();
   void Clean();
   int  Cleanup(CGUIDialogProgress *pDlgProgress=NULL);
   void DeleteAlbumInfo();
@@ -151,6 +160,25 @@ public:
   bool GetSongsByPath(const CStdString& strPath, CSongMap& songs, bool bAppendToMap = false);
   bool Search(const CStdString& search, CFileItemList &items);
 
+  enum SearchIndexType
+  {
+    SEARCH_INDEX_ARTIST = 0,
+    SEARCH_INDEX_ALBUM,
+    SEARCH_INDEX_SONG
+  };
+
+  /*! \brief Search the library's full text index of artist names, album titles and song titles.
+   Every word of the search must match the start of a word in the item. The index is
+   built on first use, kept current by the Add* and cleanup methods, and rebuilt when
+   the library has been changed by anything else.
+   \param search the words to search for.
+   \param type a SearchIndexType to restrict the search to, or -1 for all types.
+   \param results [out] the matching items, best match first.
+   \param limit maximum number of results (0 for no limit).
+   \return false if the index is disabled or couldn't be built.
+   */
+  bool SearchIndex(const CStdString& search, int type, std::vector<CSearchIndex::Result> &results, unsigned int limit = 0);
+
   bool GetAlbumFromSong(int idSong, CAlbum &album);
   bool GetAlbumFromSong(const CSong &song, CAlbum &album);
   
@@ -176,6 +204,12 @@ public:
   bool GetPaths(std::set<CStdString> &paths);
   bool SetPathHash(const CStdString &path, const CStdString &hash);
   bool GetPathHash(const CStdString &path, CStdString &hash);
+  bool GetPathHashes(std::map<CStdString, CStdString> &hashes);
+
+  /*! \brief Get the modification times recorded for paths by fast library updates, keyed by path
+   */
+  bool GetPathMTimes(std::map<CStdString, CStdString> &mtimes);
+  bool SetPathMTimes(const std::map<CStdString, CStdString> &mtimes);
   bool GetGenresNav(const CStdString& strBaseDir, CFileItemList& items);
   bool GetYearsNav(const CStdString& strBaseDir, CFileItemList& items);
   bool GetArtistsNav(const CStdString& strBaseDir, CFileItemList& items, int idGenre, bool albumArtistsOnly);
@@ -297,9 +331,12 @@ protected:
   std::map<CStdString, int /*CPathCache*/> m_pathCache;
   std::map<CStdString, int /*CPathCache*/> m_thumbCache;
   std::map<CStdString, CAlbumCache> m_albumCache;
+  unsigned int m_cacheHits;   ///< number of artist/genre/path lookups served from the caches
+  unsigned int m_cacheMisses; ///< number of artist/genre/path lookups that needed a query
+  bool m_searchIndexChanged;  ///< the search index was updated since the last commit
 
   virtual bool CreateTables();
-  virtual int GetMinVersion() const { return 27; };
+  virtual int GetMinVersion() const { return 29; };
   const char *GetBaseDBName() const { return "MyMusic"; };
 
   int AddSong(const CSong& song, bool bCheck = true, int idAlbum = -1);
@@ -328,13 +365,19 @@ private:
   CAlbum GetAlbumFromDataset(const dbiplus::sql_record* const record, bool imageURL=false);
   void GetFileItemFromDataset(CFileItem* item, const CStdString& strMusicDBbasePath);
   void GetFileItemFromDataset(const dbiplus::sql_record* const record, CFileItem* item, const CStdString& strMusicDBbasePath);
-  bool CleanupSongs();
-  bool CleanupSongsByIds(const CStdString &strSongIds);
+  bool CleanupSongs(CGUIDialogProgress *pDlgProgress = NULL);
   bool CleanupPaths();
   bool CleanupAlbums();
   bool CleanupArtists();
   bool CleanupGenres();
   virtual bool UpdateOldVersion(int version);
+  bool BuildSearchIndex();
+  CStdString GetSearchIndexSource();
+  CStdString GetSearchIndexSource(int generation);
+  int BumpSearchIndexGeneration();
+  void UpdateSearchIndex(int type, int id, const CSearchIndex::Fields &fields, int generation);
+  void RemoveFromSearchIndex(int type, const std::vector<int> &ids, int generation);
+  bool GetSearchIndexIds(const CStdString& search, int type, unsigned int limit, CStdString &ids, std::vector<int> &order);
   bool SearchArtists(const CStdString& search, CFileItemList &artists);
   bool SearchAlbums(const CStdString& search, CFileItemList &albums);
   bool SearchSongs(const CStdString& strSearch, CFileItemList &songs);
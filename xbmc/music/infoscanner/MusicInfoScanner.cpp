@@ -22,12 +22,14 @@
 #include "threads/SystemClock.h"
 #include "MusicInfoScanner.h"
 #include "music/tags/MusicInfoTagLoaderFactory.h"
+#include "music/tags/FastTag.h"
 #include "MusicAlbumInfo.h"
 #include "MusicInfoScraper.h"
 #include "filesystem/MusicDatabaseDirectory.h"
 #include "filesystem/MusicDatabaseDirectory/DirectoryNode.h"
 #include "Util.h"
 #include "utils/md5.h"
+#include "utils/RegExp.h"
 #include "GUIInfoManager.h"
 #include "utils/Variant.h"
 #include "NfoFile.h"
@@ -38,6 +40,7 @@
 #include "dialogs/GUIDialogKeyboard.h"
 #include "filesystem/File.h"
 #include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/GUISettings.h"
 #include "settings/Settings.h"
@@ -50,6 +53,8 @@
 #include "TextureCache.h"
 #include "ThumbLoader.h"
 #include "interfaces/AnnouncementManager.h"
+#include "threads/SingleLock.h"
+#include "utils/DirectoryWatcher.h"
 
 #include <algorithm>
 
@@ -58,6 +63,11 @@ using namespace MUSIC_INFO;
 using namespace XFILE;
 using namespace MUSIC_GRABBER;
 
+// number of items enumerated directories may hold in memory while waiting to be scanned
+#define MAX_RETAINED_ITEMS 5000
+// number of items the tag readers may get ahead of the directory being written
+#define MAX_READ_AHEAD 1000
+
 CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
 {
   m_bRunning = false;
@@ -66,6 +76,13 @@ CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
   m_currentItem=0;
   m_itemCount=0;
   m_flags = 0;
+  m_enumeratedItems = 0;
+  m_retainedItems = 0;
+  m_enumerated = false;
+  m_stopPipeline = false;
+  m_fastTags = 0;
+  m_fullTags = 0;
+  m_existsSaved = 0;
 }
 
 CMusicInfoScanner::~CMusicInfoScanner()
@@ -77,6 +94,7 @@ void CMusicInfoScanner::Process()
   try
   {
     unsigned int tick = XbmcThreads::SystemClockMillis();
+    CRegExp::CacheStats regExpStats = CRegExp::GetCacheStats();
 
     m_musicDatabase.Open();
 
@@ -92,15 +110,11 @@ void CMusicInfoScanner::Process()
       if (m_pObserver)
         m_pObserver->OnStateChanged(READING_MUSIC_INFO);
 
-      // Reset progress vars
+      // Reset progress vars.  The item count is known once all directories are enumerated
       m_currentItem=0;
       m_itemCount=-1;
 
-      // Create the thread to count all files to be scanned
       SetPriority( GetMinPriority() );
-      CThread fileCountReader(this, "CMusicInfoScanner");
-      if (m_pObserver)
-        fileCountReader.Create();
 
       // Database operations should not be canceled
       // using Interupt() while scanning as it could
@@ -108,21 +122,12 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
-      bool commit = false;
-      bool cancelled = false;
-      while (!cancelled && m_pathsToScan.size())
-      {
-        /*
-         * A copy of the directory path is used because the path supplied is
-         * immediately removed from the m_pathsToScan set in DoScan(). If the
-         * reference points to the entry in the set a null reference error
-         * occurs.
-         */
-        CStdString directory = *m_pathsToScan.begin();
-        if (!DoScan(directory))
-          cancelled = true;
-        commit = !cancelled;
-      }
+      // resolve existing artists, genres and paths from memory while scanning
+      m_musicDatabase.PreloadCaches();
+
+      bool commit = !m_pathsToScan.empty();
+      if (commit && !ScanPaths())
+        commit = false;
 
       if (commit)
       {
@@ -142,12 +147,11 @@ void CMusicInfoScanner::Process()
         }
       }
 
-      fileCountReader.StopThread();
-
       m_musicDatabase.EmptyCache();
 
       m_musicDatabase.Close();
       CLog::Log(LOGDEBUG, "%s - Finished scan", __FUNCTION__);
+      CRegExp::LogCacheStats(regExpStats, __FUNCTION__);
 
       tick = XbmcThreads::SystemClockMillis() - tick;
       CLog::Log(LOGNOTICE, "My Music: Scanning for music info using worker thread, operation took %s", StringUtils::SecondsToTimeString(tick / 1000).c_str());
@@ -222,7 +226,6 @@ void CMusicInfoScanner::Start(const CStdString& strDirectory, int flags)
   }
   else
     m_pathsToScan.insert(strDirectory);
-  m_pathsToCount = m_pathsToScan;
   m_scanType = 0;
   StopThread();
   Create();
@@ -346,15 +349,133 @@ void CMusicInfoScanner::SetObserver(IMusicInfoScannerObserver* pObserver)
   m_pObserver = pObserver;
 }
 
-bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
+bool CMusicInfoScanner::ScanPaths()
 {
-  if (m_pObserver)
-    m_pObserver->OnDirectoryChanged(strDirectory);
+  m_musicDatabase.GetPathHashes(m_pathHashes);
+  set<CStdString> pathsToScan(m_pathsToScan);
+  unsigned int watcherSequence = CDirectoryWatcher::Get().GetSequence();
+  if (g_advancedSettings.m_bMusicLibraryFastUpdate)
+  { // unchanged folders aren't listed, so their subfolders are found from the database
+    m_musicDatabase.GetPathMTimes(m_pathMTimes);
+    for (map<CStdString, CStdString>::const_iterator i = m_pathHashes.begin(); i != m_pathHashes.end(); ++i)
+      m_subPaths[URIUtils::GetParentPath(i->first)].push_back(i->first);
+  }
+  m_enumeratedItems = 0;
+  m_retainedItems = 0;
+  m_enumerated = false;
+  m_stopPipeline = false;
+  m_fastTags = 0;
+  m_fullTags = 0;
+  m_existsSaved = 0;
+
+  CThread enumerator(this, "CMusicInfoScanner");
+  enumerator.Create();
+  enumerator.SetPriority(enumerator.GetMinPriority());
+
+  CTagReader reader(this);
+  vector<CThread*> readers;
+  for (int i = 0; i < g_advancedSettings.m_iMusicLibraryTagReaders; i++)
+  {
+    CThread *thread = new CThread(&reader, "CMusicInfoScanner");
+    thread->Create();
+    thread->SetPriority(thread->GetMinPriority());
+    readers.push_back(thread);
+  }
 
+  // write each directory in the order it was enumerated, as soon as its tags have been read
+  while (!m_bStop)
+  {
+    DirectoryToScan *directory = NULL;
+    {
+      CSingleLock lock(m_pipelineSection);
+      if (m_directories.empty())
+      {
+        if (m_enumerated)
+          break;
+      }
+      else if (IsDirectoryRead(*m_directories.front()))
+      {
+        directory = m_directories.front();
+        m_directories.pop_front();
+      }
+    }
+    if (!directory)
+    {
+      m_readEvent.WaitMSec(100);
+      continue;
+    }
+
+    WriteDirectory(*directory);
+    FreeDirectory(directory);
+    m_workEvent.Set();
+  }
+
+  m_stopPipeline = true;
+  enumerator.StopThread();
+  for (vector<CThread*>::iterator i = readers.begin(); i != readers.end(); ++i)
+  {
+    (*i)->StopThread();
+    delete *i;
+  }
+
+  for (deque<DirectoryToScan*>::iterator i = m_directories.begin(); i != m_directories.end(); ++i)
+    FreeDirectory(*i);
+  m_directories.clear();
+  CLog::Log(LOGDEBUG, "%s - read %i tags from their tag blocks, %i with the full tag loaders", __FUNCTION__, m_fastTags, m_fullTags);
+  CLog::Log(LOGDEBUG, "%s - %u checks for local files answered from folder listings", __FUNCTION__, m_existsSaved);
+
+  if (g_advancedSettings.m_bMusicLibraryFastUpdate && !m_bStop)
+  { // remember what we've seen for next time, and watch the local sources for changes
+    m_musicDatabase.SetPathMTimes(m_newMTimes);
+    for (set<CStdString>::const_iterator i = pathsToScan.begin(); i != pathsToScan.end(); ++i)
+      CDirectoryWatcher::Get().ClearChanges(*i, watcherSequence);
+
+    VECSOURCES *sources = g_settings.GetSourcesFromType("music");
+    for (unsigned int i = 0; sources && i < sources->size(); i++)
+    {
+      const vector<CStdString> &paths = (*sources)[i].vecPaths;
+      for (vector<CStdString>::const_iterator path = paths.begin(); path != paths.end(); ++path)
+      {
+        if (URIUtils::IsHD(*path) && !URIUtils::IsInArchive(*path) && !URIUtils::IsStack(*path))
+          CDirectoryWatcher::Get().Watch(*path);
+      }
+    }
+  }
+  m_pathHashes.clear();
+  m_pathMTimes.clear();
+  m_newMTimes.clear();
+  m_subPaths.clear();
+
+  return !m_bStop;
+}
+
+// This function is run by another thread
+void CMusicInfoScanner::Run()
+{
+  while (!m_bStop && !m_stopPipeline && m_pathsToScan.size())
+  {
+    /*
+     * A copy of the directory path is used because the path supplied is
+     * immediately removed from the m_pathsToScan set in EnumerateDirectory().
+     * If the reference points to the entry in the set a null reference error
+     * occurs.
+     */
+    CStdString directory = *m_pathsToScan.begin();
+    EnumerateDirectory(directory);
+  }
+
+  CSingleLock lock(m_pipelineSection);
+  m_enumerated = true;
+  m_itemCount = m_enumeratedItems;
+  m_readEvent.Set();
+}
+
+void CMusicInfoScanner::EnumerateDirectory(const CStdString& strDirectory)
+{
   /*
    * remove this path from the list we're processing. This must be done prior to
    * the check for file or folder exclusion to prevent an infinite while loop
-   * in Process().
+   * in Run().
    */
   set<CStdString>::iterator it = m_pathsToScan.find(strDirectory);
   if (it != m_pathsToScan.end())
@@ -365,75 +486,282 @@ bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
   CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
   if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
-    return true;
+    return;
+
+  CStdString mtime;
+  if (g_advancedSettings.m_bMusicLibraryFastUpdate && !(m_flags & SCAN_RESCAN) && IsDirectoryUnchanged(strDirectory, mtime))
+  { // no need to list it, but its subfolders may have changed
+    CLog::Log(LOGDEBUG, "%s Skipping dir '%s' as unmodified", __FUNCTION__, strDirectory.c_str());
+    DirectoryToScan *directory = new DirectoryToScan;
+    directory->path = strDirectory;
+    QueueDirectory(directory);
+
+    map<CStdString, vector<CStdString> >::const_iterator subPaths = m_subPaths.find(strDirectory);
+    if (subPaths != m_subPaths.end())
+      EnumerateSubFolders(subPaths->second);
+    return;
+  }
 
   // load subfolder
-  CFileItemList items;
-  CDirectory::GetDirectory(strDirectory, items, g_settings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg");
+  auto_ptr<CFileItemList> items(new CFileItemList);
+  if (CDirectory::GetDirectory(strDirectory, *items, g_settings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg") && !mtime.IsEmpty())
+    m_newMTimes[strDirectory] = mtime;
 
   // sort and get the path hash.  Note that we don't filter .cue sheet items here as we want
   // to detect changes in the .cue sheet as well.  The .cue sheet items only need filtering
   // if we have a changed hash.
-  items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
-  CStdString hash;
-  GetPathHash(items, hash);
+  items->Sort(SORT_METHOD_LABEL, SortOrderAscending);
+
+  DirectoryToScan *directory = new DirectoryToScan;
+  directory->path = strDirectory;
+  GetPathHash(*items, directory->hash);
+  directory->files = CountFiles(*items);
 
   // check whether we need to rescan or not
-  CStdString dbHash;
-  if ((m_flags & SCAN_RESCAN) || !m_musicDatabase.GetPathHash(strDirectory, dbHash) || dbHash != hash)
+  map<CStdString, CStdString>::const_iterator dbHash = m_pathHashes.find(strDirectory);
+  if ((m_flags & SCAN_RESCAN) || dbHash == m_pathHashes.end() || dbHash->second != directory->hash)
   { // path has changed - rescan
-    if (dbHash.IsEmpty())
+    if (dbHash == m_pathHashes.end() || dbHash->second.IsEmpty())
       CLog::Log(LOGDEBUG, "%s Scanning dir '%s' as not in the database", __FUNCTION__, strDirectory.c_str());
     else
       CLog::Log(LOGDEBUG, "%s Rescanning dir '%s' due to change", __FUNCTION__, strDirectory.c_str());
+    directory->changed = true;
+  }
+  else
+    CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, strDirectory.c_str());
+
+  // the directory may be written (and freed) as soon as it's queued, so grab its subfolders first
+  vector<CStdString> subFolders;
+  for (int i = 0; i < items->Size(); ++i)
+  {
+    CFileItemPtr pItem = (*items)[i];
+    // if we have a directory item (non-playlist) we then recurse into that folder
+    if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+      subFolders.push_back(pItem->GetPath());
+  }
+
+  bool retain;
+  {
+    CSingleLock lock(m_pipelineSection);
+    retain = m_retainedItems < MAX_RETAINED_ITEMS;
+  }
+  if (directory->changed && retain)
+  { // filter items in the sub dir (for .cue sheet support).  Otherwise a tag reader lists
+    // the directory again when it gets near the front of the queue
+    items->FilterCueItems();
+    items->Sort(SORT_METHOD_LABEL, SortOrderAscending);
+    directory->items = items.release();
+    // keep the full listing around, so looking for local art needs no further trips to the filesystem
+    directory->pinned = g_directoryCache.PinDirectory(strDirectory);
+  }
+
+  QueueDirectory(directory);
+
+  // now enumerate the subfolders
+  EnumerateSubFolders(subFolders);
+}
+
+void CMusicInfoScanner::EnumerateSubFolders(const vector<CStdString> &subFolders)
+{
+  for (vector<CStdString>::const_iterator i = subFolders.begin(); i != subFolders.end(); ++i)
+  {
+    if (m_bStop || m_stopPipeline)
+      break;
+    EnumerateDirectory(*i);
+  }
+}
+
+bool CMusicInfoScanner::IsDirectoryUnchanged(const CStdString& strDirectory, CStdString &mtime)
+{
+  bool known = m_pathHashes.find(strDirectory) != m_pathHashes.end();
+  CDirectoryWatcher &watcher = CDirectoryWatcher::Get();
+  bool changed = watcher.HasChanged(strDirectory);
+  if (known && !changed && watcher.IsWatched(strDirectory))
+    return true;
+
+  if (!GetDirectoryMTime(strDirectory, mtime))
+    return false;
+  map<CStdString, CStdString>::const_iterator lastMTime = m_pathMTimes.find(strDirectory);
+  return known && !changed && lastMTime != m_pathMTimes.end() && lastMTime->second == mtime;
+}
+
+bool CMusicInfoScanner::GetDirectoryMTime(const CStdString& strDirectory, CStdString &mtime)
+{
+  // only filesystems where a folder's modification time changes when its entries do
+  if (URIUtils::IsInArchive(strDirectory) || URIUtils::IsStack(strDirectory) ||
+     !(URIUtils::IsHD(strDirectory) || URIUtils::IsSmb(strDirectory) || URIUtils::IsNfs(strDirectory)))
+    return false;
 
-    // filter items in the sub dir (for .cue sheet support)
-    items.FilterCueItems();
-    items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
+  CStdString path(strDirectory);
+  URIUtils::RemoveSlashAtEnd(path);
+  struct __stat64 info;
+  if (CFile::Stat(path, &info) != 0)
+    return false;
+
+  // a folder modified within the second it is listed may keep the same time after further changes
+  if (info.st_mtime >= time(NULL) - 1)
+    return false;
+
+  mtime.Format("%"PRId64, (int64_t)info.st_mtime);
+  return true;
+}
 
+void CMusicInfoScanner::QueueDirectory(DirectoryToScan *directory)
+{
+  {
+    CSingleLock lock(m_pipelineSection);
+    if (directory->items)
+    {
+      directory->retained = directory->items->Size();
+      m_retainedItems += directory->retained;
+    }
+    m_enumeratedItems += directory->files;
+    m_directories.push_back(directory);
+  }
+  m_workEvent.Set();
+  m_readEvent.Set();
+}
+
+// This function is run by the tag reader threads
+void CMusicInfoScanner::ReadTags()
+{
+  CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
+
+  while (!m_bStop && !m_stopPipeline)
+  {
+    DirectoryToScan *directory = NULL;
+    CFileItemPtr pItem;
+    {
+      CSingleLock lock(m_pipelineSection);
+      int ahead = 0;
+      for (deque<DirectoryToScan*>::iterator i = m_directories.begin(); i != m_directories.end() && ahead < MAX_READ_AHEAD; ++i)
+      {
+        DirectoryToScan *candidate = *i;
+        if (!candidate->changed || candidate->listing)
+          continue;
+        if (!candidate->items)
+        { // list it ourselves
+          candidate->listing = true;
+          directory = candidate;
+          break;
+        }
+        if (candidate->nextItem < candidate->items->Size())
+        {
+          pItem = (*candidate->items)[candidate->nextItem++];
+          candidate->reading++;
+          directory = candidate;
+          break;
+        }
+        ahead += candidate->items->Size();
+      }
+    }
+    if (!directory)
+    {
+      m_workEvent.WaitMSec(100);
+      continue;
+    }
+
+    if (pItem)
+    {
+      // read the tags RetrieveMusicInfo() would read, so it finds them loaded
+      if (!pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsPicture() && !pItem->IsLyrics() &&
+          !pItem->GetMusicInfoTag()->Loaded() && !CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
+      {
+        LoadTag(pItem->GetPath(), *pItem->GetMusicInfoTag());
+      }
+
+      CSingleLock lock(m_pipelineSection);
+      directory->reading--;
+    }
+    else
+    {
+      CFileItemList *items = new CFileItemList;
+      CDirectory::GetDirectory(directory->path, *items, g_settings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg");
+      items->FilterCueItems();
+      items->Sort(SORT_METHOD_LABEL, SortOrderAscending);
+      bool pinned = g_directoryCache.PinDirectory(directory->path);
+
+      CSingleLock lock(m_pipelineSection);
+      directory->items = items;
+      directory->pinned = pinned;
+      directory->listing = false;
+      directory->retained = items->Size();
+      m_retainedItems += directory->retained;
+    }
+    m_readEvent.Set();
+  }
+}
+
+void CMusicInfoScanner::LoadTag(const CStdString &strFile, CMusicInfoTag &tag)
+{
+  // most files can be read from their tag blocks alone, far quicker than the full loaders
+  CFastTag fastTag;
+  if (fastTag.Read(strFile))
+  {
+    fastTag.GetMusicInfoTag(tag);
+    CSingleLock lock(m_pipelineSection);
+    m_fastTags++;
+    return;
+  }
+
+  auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(strFile));
+  if (NULL != pLoader.get())
+    pLoader->Load(strFile, tag);
+  CSingleLock lock(m_pipelineSection);
+  m_fullTags++;
+}
+
+void CMusicInfoScanner::FreeDirectory(DirectoryToScan *directory)
+{
+  if (directory->pinned)
+    m_existsSaved += g_directoryCache.UnpinDirectory(directory->path);
+
+  {
+    // release what was counted, as the list may have been changed while it was scanned
+    CSingleLock lock(m_pipelineSection);
+    m_retainedItems -= directory->retained;
+  }
+  delete directory->items;
+  delete directory;
+}
+
+bool CMusicInfoScanner::IsDirectoryRead(const DirectoryToScan &directory) const
+{
+  if (!directory.changed)
+    return true;
+  return directory.items && directory.nextItem >= directory.items->Size() && directory.reading == 0;
+}
+
+void CMusicInfoScanner::WriteDirectory(DirectoryToScan &directory)
+{
+  if (m_pObserver)
+    m_pObserver->OnDirectoryChanged(directory.path);
+
+  if (directory.changed)
+  {
     // and then scan in the new information
-    if (RetrieveMusicInfo(items, strDirectory) > 0)
+    if (RetrieveMusicInfo(*directory.items, directory.path) > 0)
     {
       if (m_pObserver)
-        m_pObserver->OnDirectoryScanned(strDirectory);
+        m_pObserver->OnDirectoryScanned(directory.path);
     }
 
-    // save information about this folder
-    m_musicDatabase.SetPathHash(strDirectory, hash);
+    // save information about this folder, unless we were stopped part way through it
+    if (!m_bStop)
+      m_musicDatabase.SetPathHash(directory.path, directory.hash);
   }
   else
   { // path is the same - no need to rescan
-    CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, strDirectory.c_str());
-    m_currentItem += CountFiles(items, false);  // false for non-recursive
+    m_currentItem += directory.files;
 
     // notify our observer of our progress
     if (m_pObserver)
     {
       if (m_itemCount>0)
         m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
-      m_pObserver->OnDirectoryScanned(strDirectory);
-    }
-  }
-
-  // now scan the subfolders
-  for (int i = 0; i < items.Size(); ++i)
-  {
-    CFileItemPtr pItem = items[i];
-
-    if (m_bStop)
-      break;
-    // if we have a directory item (non-playlist) we then recurse into that folder
-    if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
-    {
-      CStdString strPath=pItem->GetPath();
-      if (!DoScan(strPath))
-      {
-        m_bStop = true;
-      }
+      m_pObserver->OnDirectoryScanned(directory.path);
     }
   }
-
-  return !m_bStop;
 }
 
 int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory)
@@ -474,9 +802,7 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
       CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
       if (!tag.Loaded() )
       { // read the tag from a file
-        auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
-        if (NULL != pLoader.get())
-          pLoader->Load(pItem->GetPath(), tag);
+        LoadTag(pItem->GetPath(), tag);
       }
 
       // if we have the itemcount, notify our
@@ -794,48 +1120,14 @@ void CMusicInfoScanner::FindArtForAlbums(VECALBUMS &albums, const CStdString &pa
   }
 }
 
-// This function is run by another thread
-void CMusicInfoScanner::Run()
-{
-  int count = 0;
-  while (!m_bStop && m_pathsToCount.size())
-    count+=CountFilesRecursively(*m_pathsToCount.begin());
-  m_itemCount = count;
-}
-
-// Recurse through all folders we scan and count files
-int CMusicInfoScanner::CountFilesRecursively(const CStdString& strPath)
-{
-  // load subfolder
-  CFileItemList items;
-//  CLog::Log(LOGDEBUG, __FUNCTION__" - processing dir: %s", strPath.c_str());
-  CDirectory::GetDirectory(strPath, items, g_settings.m_musicExtensions, DIR_FLAG_NO_FILE_DIRS);
-
-  if (m_bStop)
-    return 0;
-
-  // true for recursive counting
-  int count = CountFiles(items, true);
-
-  // remove this path from the list we're processing
-  set<CStdString>::iterator it = m_pathsToCount.find(strPath);
-  if (it != m_pathsToCount.end())
-    m_pathsToCount.erase(it);
-
-//  CLog::Log(LOGDEBUG, __FUNCTION__" - finished processing dir: %s", strPath.c_str());
-  return count;
-}
-
-int CMusicInfoScanner::CountFiles(const CFileItemList &items, bool recursive)
+int CMusicInfoScanner::CountFiles(const CFileItemList &items)
 {
   int count = 0;
   for (int i=0; i<items.Size(); ++i)
   {
     const CFileItemPtr pItem=items[i];
 
-    if (recursive && pItem->m_bIsFolder)
-      count+=CountFilesRecursively(pItem->GetPath());
-    else if (pItem->IsAudio() && !pItem->IsPlayList() && !pItem->IsNFO())
+    if (!pItem->m_bIsFolder && pItem->IsAudio() && !pItem->IsPlayList() && !pItem->IsNFO())
       count++;
   }
   return count;
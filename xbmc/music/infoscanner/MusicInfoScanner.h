@@ -19,7 +19,10 @@
  *  http://www.gnu.org/copyleft/gpl.html
  *
  */
+#include <deque>
 #include "threads/Thread.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "music/MusicDatabase.h"
 #include "MusicAlbumInfo.h"
 
@@ -111,11 +114,65 @@ protected:
   int GetPathHash(const CFileItemList &items, CStdString &hash);
   void GetAlbumArtwork(long id, const CAlbum &artist);
 
-  bool DoScan(const CStdString& strDirectory);
+  /*! \brief Scan the paths in m_pathsToScan and their subfolders.
+   Scanning is pipelined: Run() enumerates the directories on one thread, a pool of
+   CTagReader threads reads the tags of the files in changed directories ahead of
+   time, and the calling thread writes each directory to the database in the order
+   it was enumerated, once all its tags have been read.
+   \return false if the scan was cancelled.
+   */
+  bool ScanPaths();
 
+  /*! \brief Enumerate the directories to scan, run by another thread
+   */
   virtual void Run();
-  int CountFiles(const CFileItemList& items, bool recursive);
-  int CountFilesRecursively(const CStdString& strPath);
+  void EnumerateDirectory(const CStdString& strDirectory);
+  void EnumerateSubFolders(const std::vector<CStdString> &subFolders);
+  int CountFiles(const CFileItemList& items);
+
+  /*! \brief Whether a folder is known to be unchanged since it was last scanned, for fast updates.
+   Folders are trusted to be unchanged if they are watched and nothing has changed in them, or
+   if their modification time is the same as when they were last scanned.
+   \param strDirectory the folder to check.
+   \param mtime [out] the modification time of the folder, if it was needed and can be relied upon.
+   */
+  bool IsDirectoryUnchanged(const CStdString& strDirectory, CStdString &mtime);
+  static bool GetDirectoryMTime(const CStdString& strDirectory, CStdString &mtime);
+
+  struct DirectoryToScan
+  {
+    DirectoryToScan() : changed(false), files(0), items(NULL), retained(0), nextItem(0), reading(0), listing(false), pinned(false) {};
+    CStdString path;
+    CStdString hash;
+    bool changed;         ///< whether the directory differs from the database and must be rescanned
+    int files;            ///< number of audio files in the directory, for progress
+    CFileItemList *items; ///< items to scan, or NULL if not yet listed
+    int retained;         ///< number of items counted in m_retainedItems for this directory
+    int nextItem;         ///< next item to hand to a tag reader
+    int reading;          ///< number of tags currently being read
+    bool listing;         ///< whether a tag reader is listing the directory
+    bool pinned;          ///< whether the listing is pinned in the directory cache, for finding local art
+  };
+
+  class CTagReader : public IRunnable
+  {
+  public:
+    CTagReader(CMusicInfoScanner *scanner) : m_scanner(scanner) {};
+    virtual void Run() { m_scanner->ReadTags(); };
+  private:
+    CMusicInfoScanner *m_scanner;
+  };
+  friend class CTagReader;
+
+  void QueueDirectory(DirectoryToScan *directory);
+  void ReadTags();
+
+  /*! \brief Read the tag of a file, quickly with CFastTag if possible, or with the full tag loader.
+   */
+  void LoadTag(const CStdString &strFile, CMusicInfoTag &tag);
+  bool IsDirectoryRead(const DirectoryToScan &directory) const;
+  void WriteDirectory(DirectoryToScan &directory);
+  void FreeDirectory(DirectoryToScan *directory);
 
 protected:
   IMusicInfoScannerObserver* m_pObserver;
@@ -130,9 +187,24 @@ protected:
   std::set<CStdString> m_pathsToScan;
   std::set<CAlbum> m_albumsToScan;
   std::set<CArtist> m_artistsToScan;
-  std::set<CStdString> m_pathsToCount;
   std::vector<long> m_artistsScanned;
   std::vector<long> m_albumsScanned;
   int m_flags;
+
+  std::map<CStdString, CStdString> m_pathHashes; ///< hashes of the paths in the database, keyed by path
+  std::map<CStdString, CStdString> m_pathMTimes; ///< modification times of the paths in the database, for fast updates
+  std::map<CStdString, CStdString> m_newMTimes;  ///< modification times of the paths listed during the scan
+  std::map<CStdString, std::vector<CStdString> > m_subPaths; ///< paths in the database, keyed by their parent
+  std::deque<DirectoryToScan*> m_directories;    ///< directories enumerated but not yet written
+  int m_enumeratedItems;
+  int m_retainedItems;
+  int m_fastTags; ///< tags read by CFastTag during the scan
+  int m_fullTags; ///< tags read by the full tag loaders during the scan
+  unsigned int m_existsSaved; ///< file existence checks answered from pinned directory listings
+  volatile bool m_enumerated;
+  volatile bool m_stopPipeline;
+  CCriticalSection m_pipelineSection;
+  CEvent m_readEvent; ///< set when the first directory may be ready to write
+  CEvent m_workEvent; ///< set when the tag readers may have more work
 };
 }
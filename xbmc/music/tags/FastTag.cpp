@@ -0,0 +1,889 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "system.h"
+#include "FastTag.h"
+#include "Id3Tag.h"
+#include "filesystem/File.h"
+#include "guilib/LocalizeStrings.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/CharsetConverter.h"
+#include "utils/URIUtils.h"
+
+#include <map>
+#include <string.h>
+
+using namespace std;
+using namespace XFILE;
+using namespace MUSIC_INFO;
+
+#define HEAD_SIZE          65536 // read from the start of a file in one go - enough for most tags
+#define MP3_SCAN_SIZE      8192  // searched for the first mp3 frame after the ID3v2 tag
+#define MP3_MAX_FRAME_SIZE 2881
+#define MP3_CHECK_FRAMES   3     // consecutive frames needed to be sure we've found the audio
+#define FLAC_PICTURE_SIZE  4096  // read from a flac PICTURE block, enough for its header
+#define OGG_TAIL_SIZE      65536 // searched for the last page of an ogg file
+
+/* Xing header flags */
+#define VBR_FRAMES_FLAG 0x01
+#define VBR_BYTES_FLAG  0x02
+#define VBR_TOC_FLAG    0x04
+#define VBR_SCALE_FLAG  0x08
+
+/* ID3v2 picture types */
+#define PICTURE_OTHER          0
+#define PICTURE_COVERFRONT     3
+#define PICTURE_PUBLISHERLOGO 20
+
+struct ID3Picture
+{
+  ID3Picture() : size(0) {};
+  unsigned int size;
+  std::string mimeType;
+};
+
+struct CFastTag::ID3Frames
+{
+  ID3Frames() : hasComment(false), otherComment(false), popularity(-1) {};
+  map<string, vector<CStdString> > text; ///< strings of the first of each text frame, by frame id
+  map<CStdString, CStdString> userText;  ///< the first TXXX frame of each description
+  CStdString comment;
+  bool hasComment;   ///< whether there's a COMM frame without a description
+  bool otherComment; ///< whether there's a COMM frame with a description
+  CStdString lyrics;
+  int popularity;    ///< rating from the first POPM frame
+  CStdString musicBrainzTrackID;
+  ID3Picture front;
+  ID3Picture other;
+  ID3Picture nonStandard;
+};
+
+struct MP3Frame
+{
+  int version;      ///< 0 = MPEG 2.5, 2 = MPEG 2, 3 = MPEG 1
+  int layer;
+  int bitrate;
+  int sampleRate;
+  int samples;      ///< samples per frame
+  unsigned int size;
+  unsigned int sideInfo;
+};
+
+static inline unsigned int BE32(const unsigned char *p)
+{
+  return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+static inline unsigned int LE32(const unsigned char *p)
+{
+  return ((unsigned int)p[3] << 24) | ((unsigned int)p[2] << 16) | ((unsigned int)p[1] << 8) | p[0];
+}
+
+static inline unsigned int SyncSafe32(const unsigned char *p)
+{
+  return ((p[0] & 0x7f) << 21) | ((p[1] & 0x7f) << 14) | ((p[2] & 0x7f) << 7) | (p[3] & 0x7f);
+}
+
+static bool ReadAt(CFile &file, int64_t offset, unsigned char *buffer, unsigned int size)
+{
+  if (file.Seek(offset, SEEK_SET) != offset)
+    return false;
+  while (size)
+  {
+    unsigned int read = file.Read(buffer, size);
+    if (read == 0 || read > size)
+      return false;
+    buffer += read;
+    size -= read;
+  }
+  return true;
+}
+
+static bool ParseMP3Header(const unsigned char *p, MP3Frame &frame)
+{
+  static const int bitrates[2][3][15] = {
+    { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+      { 0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384 },
+      { 0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320 } },
+    { { 0, 32, 48, 56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256 },
+      { 0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160 },
+      { 0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160 } } };
+  static const int sampleRates[3] = { 44100, 48000, 32000 };
+
+  if (p[0] != 0xff || (p[1] & 0xe0) != 0xe0)
+    return false;
+  frame.version = (p[1] >> 3) & 3;
+  frame.layer = 4 - ((p[1] >> 1) & 3);
+  int bitrateIndex = p[2] >> 4;
+  int sampleRateIndex = (p[2] >> 2) & 3;
+  if (frame.version == 1 || frame.layer == 4 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3)
+    return false;
+
+  bool mpeg1 = frame.version == 3;
+  bool mono = (p[3] >> 6) == 3;
+  int padding = (p[2] >> 1) & 1;
+  frame.bitrate = bitrates[mpeg1 ? 0 : 1][frame.layer - 1][bitrateIndex] * 1000;
+  frame.sampleRate = sampleRates[sampleRateIndex] >> (mpeg1 ? 0 : (frame.version == 2 ? 1 : 2));
+  if (frame.layer == 1)
+  {
+    frame.samples = 384;
+    frame.size = (12 * frame.bitrate / frame.sampleRate + padding) * 4;
+  }
+  else
+  {
+    frame.samples = (frame.layer == 3 && !mpeg1) ? 576 : 1152;
+    frame.size = frame.samples / 8 * frame.bitrate / frame.sampleRate + padding;
+  }
+  if (frame.layer == 3)
+    frame.sideInfo = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+  else
+    frame.sideInfo = 0;
+  return true;
+}
+
+// find the first of several consecutive mp3 frames of the same format
+static const unsigned char *FindMP3Frame(const unsigned char *data, unsigned int scanSize, unsigned int available)
+{
+  const unsigned char *end = data + available;
+  const unsigned char *scanEnd = data + min(scanSize, available);
+  for (const unsigned char *p = data; p + 4 <= scanEnd; p++)
+  {
+    p = (const unsigned char *)memchr(p, 0xff, scanEnd - p);
+    if (!p)
+      break;
+
+    MP3Frame first;
+    if (p + 4 > end || !ParseMP3Header(p, first))
+      continue;
+    const unsigned char *next = p + first.size;
+    int found = 1;
+    for (; found < MP3_CHECK_FRAMES && next + 4 <= end; found++)
+    {
+      MP3Frame frame;
+      if (!ParseMP3Header(next, frame) || frame.version != first.version ||
+          frame.layer != first.layer || frame.sampleRate != first.sampleRate)
+        break;
+      next += frame.size;
+    }
+    if (found == MP3_CHECK_FRAMES)
+      return p;
+  }
+  return NULL;
+}
+
+// decode an ID3v2 string to UTF-8, returning the bytes used including its terminator
+static unsigned int DecodeID3String(unsigned char encoding, const unsigned char *data, unsigned int size, CStdString &value)
+{
+  unsigned int width = (encoding == 1 || encoding == 2) ? 2 : 1;
+  unsigned int length = 0;
+  while (length + width <= size && !(data[length] == 0 && (width == 1 || data[length + 1] == 0)))
+    length += width;
+  unsigned int used = min(length + width, size);
+  if (width == 2)
+    length &= ~1;
+
+  value.clear();
+  if (encoding == 0)
+    g_charsetConverter.unknownToUTF8(CStdString((const char *)data, length), value);
+  else if (encoding == 3)
+    value.assign((const char *)data, length);
+  else
+  {
+    bool bigEndian = true;
+    if (encoding == 1 && length >= 2)
+    { // byte order mark
+      if (data[0] == 0xff && data[1] == 0xfe)
+        bigEndian = false;
+      if ((data[0] == 0xff && data[1] == 0xfe) || (data[0] == 0xfe && data[1] == 0xff))
+      {
+        data += 2;
+        length -= 2;
+      }
+    }
+    if (length)
+    {
+      CStdString16 utf16;
+      utf16.resize(length / 2);
+      memcpy(&utf16[0], data, length);
+      if (bigEndian)
+        g_charsetConverter.utf16BEtoUTF8(utf16, value);
+      else
+        g_charsetConverter.utf16LEtoUTF8(utf16, value);
+    }
+  }
+  return used;
+}
+
+static CStdString DecodeLatin1(const unsigned char *data, unsigned int size, unsigned int &used)
+{
+  unsigned int length = 0;
+  while (length < size && data[length])
+    length++;
+  used = min(length + 1, size);
+  return CStdString((const char *)data, length);
+}
+
+// translate ID3v2.3 genres such as "(17)(6)Rock" into separate strings, as libid3tag does
+static void TranslateGenres(const CStdString &value, vector<CStdString> &genres)
+{
+  size_t pos = 0;
+  while (pos < value.size() && value[pos] == '(')
+  {
+    if (++pos < value.size() && value[pos] == '(')
+      break;
+    size_t end = value.find(')', pos);
+    if (end == string::npos)
+      end = value.size();
+    genres.push_back(value.substr(pos, end - pos));
+    pos = min(end + 1, value.size());
+  }
+  if (pos < value.size())
+    genres.push_back(value.substr(pos));
+}
+
+static CStdString GetFirstString(const map<string, vector<CStdString> > &text, const char *id)
+{
+  map<string, vector<CStdString> >::const_iterator frame = text.find(id);
+  if (frame == text.end())
+    return "";
+  for (vector<CStdString>::const_iterator i = frame->second.begin(); i != frame->second.end(); ++i)
+  {
+    if (!i->IsEmpty())
+      return *i;
+  }
+  return "";
+}
+
+static CStdString GetUserText(const map<CStdString, CStdString> &userText, const char *description)
+{
+  map<CStdString, CStdString>::const_iterator i = userText.find(description);
+  return i == userText.end() ? "" : i->second;
+}
+
+CFastTag::CFastTag()
+{
+}
+
+CFastTag::~CFastTag()
+{
+}
+
+bool CFastTag::Read(const CStdString& strFile)
+{
+  CTag::Read(strFile);
+
+  CStdString extension;
+  URIUtils::GetExtension(strFile, extension);
+  extension.ToLower();
+  if (extension != ".mp3" && extension != ".flac" && extension != ".ogg")
+    return false;
+
+  CFile file;
+  if (!file.Open(strFile))
+    return false;
+  int64_t length = file.GetLength();
+  if (length <= 0)
+    return false;
+
+  m_buffer.clear();
+  if (!ReadHead(file, length, HEAD_SIZE))
+    return false;
+
+  if (extension == ".mp3")
+    return ReadMP3(file, length);
+  if (extension == ".flac")
+    return ReadFlac(file, length);
+  return ReadOgg(file, length);
+}
+
+bool CFastTag::ReadHead(CFile &file, int64_t length, int64_t size)
+{
+  size = min(size, length);
+  unsigned int have = m_buffer.size();
+  if (size <= have)
+    return true;
+  m_buffer.resize((size_t)size);
+  return ReadAt(file, have, &m_buffer[have], (unsigned int)(size - have));
+}
+
+const unsigned char *CFastTag::GetBytes(CFile &file, int64_t offset, unsigned int size, vector<unsigned char> &scratch)
+{
+  if (offset + size <= (int64_t)m_buffer.size())
+    return &m_buffer[(size_t)offset];
+  scratch.resize(max(size, 1U));
+  if (!ReadAt(file, offset, &scratch[0], size))
+    return NULL;
+  return &scratch[0];
+}
+
+bool CFastTag::ReadMP3(CFile &file, int64_t length)
+{
+  ID3Frames frames;
+  bool hasID3v2 = false;
+  unsigned int audioStart = 0;
+  if (m_buffer.size() >= 10 && memcmp(&m_buffer[0], "ID3", 3) == 0)
+  {
+    int version = m_buffer[3];
+    unsigned char flags = m_buffer[5];
+    // unsynchronised tags and extended headers are rare enough to leave to libid3tag
+    if (version < 3 || version > 4 || (flags & 0xc0))
+      return false;
+    unsigned int size = SyncSafe32(&m_buffer[6]);
+    audioStart = 10 + size + ((flags & 0x10) ? 10 : 0);
+    if (audioStart >= length)
+      return false;
+    if (!ReadHead(file, length, audioStart + MP3_SCAN_SIZE + MP3_CHECK_FRAMES * MP3_MAX_FRAME_SIZE))
+      return false;
+    if (!ParseID3v2(&m_buffer[10], size, version, frames))
+      return false;
+    hasID3v2 = true;
+  }
+
+  // skip any padding after the tag, and leave files with several tags to libid3tag
+  while (audioStart < m_buffer.size() && m_buffer[audioStart] == 0)
+    audioStart++;
+  if (audioStart + 3 <= m_buffer.size() && memcmp(&m_buffer[audioStart], "ID3", 3) == 0)
+    return false;
+
+  // the end of the file may hold an APEv2 tag, an ID3v1 tag or both
+  int64_t audioEnd = length;
+  unsigned char tail[160];
+  if (length >= audioStart + (int64_t)sizeof(tail))
+  {
+    if (!ReadAt(file, length - sizeof(tail), tail, sizeof(tail)))
+      return false;
+    bool hasID3v1 = memcmp(tail + 32, "TAG", 3) == 0;
+    if (hasID3v1)
+    {
+      audioEnd -= 128;
+      if (!hasID3v2)
+        ParseID3v1(tail + 32, frames);
+    }
+    if (memcmp(tail + (hasID3v1 ? 22 : 150), "3DI", 3) == 0)
+      return false; // an appended ID3v2 tag
+    const unsigned char *ape = tail + (hasID3v1 ? 0 : 128);
+    if (memcmp(ape, "APETAGEX", 8) == 0)
+    {
+      if (g_advancedSettings.m_prioritiseAPEv2tags)
+        return false; // the loader merges it with the ID3 tags
+      audioEnd -= LE32(ape + 12) + ((LE32(ape + 20) & 0x80000000) ? 32 : 0);
+    }
+  }
+
+  const unsigned char *frame = FindMP3Frame(&m_buffer[0] + audioStart, MP3_SCAN_SIZE, m_buffer.size() - audioStart);
+  if (!frame)
+    return false;
+  int64_t audioLength = audioEnd - (frame - &m_buffer[0]);
+  if (audioLength <= 0)
+    return false;
+
+  SetID3Tag(frames);
+  m_musicInfoTag.SetDuration(GetMP3Duration(frame, &m_buffer[0] + m_buffer.size() - frame, audioLength));
+  return true;
+}
+
+bool CFastTag::ParseID3v2(const unsigned char *data, unsigned int size, int version, ID3Frames &frames)
+{
+  unsigned int pos = 0;
+  while (pos + 10 <= size && data[pos])
+  {
+    const unsigned char *header = data + pos;
+    for (int i = 0; i < 4; i++)
+    {
+      if (!((header[i] >= 'A' && header[i] <= 'Z') || (header[i] >= '0' && header[i] <= '9')))
+        return false;
+    }
+    string id((const char *)header, 4);
+
+    unsigned int frameSize;
+    if (version == 4)
+    {
+      // some taggers wrote plain sizes in v2.4 tags, which libid3tag copes with
+      if ((header[4] | header[5] | header[6] | header[7]) & 0x80)
+        return false;
+      frameSize = SyncSafe32(header + 4);
+      // grouped, compressed, encrypted or unsynchronised frames, or a data length indicator
+      if (header[9] & 0x4f)
+        return false;
+    }
+    else
+    {
+      frameSize = BE32(header + 4);
+      // compressed, encrypted or grouped frames
+      if (header[9] & 0xe0)
+        return false;
+    }
+    pos += 10;
+    if (frameSize > size - pos)
+      return false;
+    const unsigned char *frame = data + pos;
+    pos += frameSize;
+    if (frameSize == 0)
+      continue;
+
+    unsigned char encoding = frame[0];
+    if (id == "SEEK")
+      return false;
+    else if (id[0] == 'T' && id != "TXXX")
+    {
+      if (encoding > 3)
+        return false;
+      if (frames.text.find(id) != frames.text.end())
+        continue;
+      vector<CStdString> &strings = frames.text[id];
+      for (unsigned int used = 1; used < frameSize; )
+      {
+        CStdString value;
+        used += DecodeID3String(encoding, frame + used, frameSize - used, value);
+        if (version == 3 && id == "TCON")
+          TranslateGenres(value, strings);
+        else
+          strings.push_back(value);
+      }
+    }
+    else if (id == "TXXX")
+    {
+      if (encoding > 3)
+        return false;
+      CStdString description, value;
+      unsigned int used = 1 + DecodeID3String(encoding, frame + 1, frameSize - 1, description);
+      DecodeID3String(encoding, frame + used, frameSize - used, value);
+      if (frames.userText.find(description) == frames.userText.end())
+        frames.userText[description] = value;
+    }
+    else if (id == "COMM" || id == "USLT")
+    {
+      if (encoding > 3 || frameSize < 4)
+        return false;
+      CStdString description, value;
+      unsigned int used = 4 + DecodeID3String(encoding, frame + 4, frameSize - 4, description);
+      DecodeID3String(encoding, frame + used, frameSize - used, value);
+      if (id == "USLT")
+      {
+        if (frames.lyrics.IsEmpty())
+          frames.lyrics = value;
+      }
+      else if (!description.IsEmpty())
+        frames.otherComment = true;
+      else if (!frames.hasComment)
+      {
+        frames.comment = value;
+        frames.hasComment = true;
+      }
+    }
+    else if (id == "POPM")
+    {
+      unsigned int used;
+      DecodeLatin1(frame, frameSize, used);
+      if (frames.popularity < 0 && used < frameSize)
+        frames.popularity = frame[used];
+    }
+    else if (id == "UFID")
+    {
+      unsigned int used;
+      if (DecodeLatin1(frame, frameSize, used) == "http://musicbrainz.org" && frames.musicBrainzTrackID.IsEmpty())
+        frames.musicBrainzTrackID = CStdString((const char *)frame + used, frameSize - used);
+    }
+    else if (id == "APIC")
+    {
+      if (encoding > 3)
+        return false;
+      unsigned int used;
+      CStdString mimeType = DecodeLatin1(frame + 1, frameSize - 1, used);
+      used += 1;
+      if (used >= frameSize)
+        continue;
+      int type = frame[used++];
+      CStdString description;
+      used += DecodeID3String(encoding, frame + used, frameSize - used, description);
+      ID3Picture *picture = NULL;
+      if (type == PICTURE_COVERFRONT)
+        picture = &frames.front;
+      else if (type == PICTURE_OTHER)
+        picture = &frames.other;
+      else if (type > PICTURE_PUBLISHERLOGO)
+        picture = &frames.nonStandard;
+      if (picture && !picture->size && used < frameSize)
+      {
+        picture->size = frameSize - used;
+        picture->mimeType = mimeType;
+      }
+    }
+  }
+
+  // libid3tag takes the description of a comment as the comment if none lacks a description
+  if (frames.otherComment && !frames.hasComment)
+    return false;
+
+  // ID3v2.3 years are in TYER rather than TDRC
+  if (frames.text.find("TDRC") == frames.text.end() && frames.text.find("TYER") != frames.text.end())
+    frames.text["TDRC"] = frames.text["TYER"];
+  return true;
+}
+
+void CFastTag::ParseID3v1(const unsigned char *data, ID3Frames &frames)
+{
+  const struct { const char *id; unsigned int offset; unsigned int size; } fields[] = {
+    { "TIT2", 3, 30 }, { "TPE1", 33, 30 }, { "TALB", 63, 30 }, { "TDRC", 93, 4 } };
+
+  for (unsigned int i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+  {
+    unsigned int used;
+    CStdString value = DecodeLatin1(data + fields[i].offset, fields[i].size, used);
+    value.TrimRight();
+    if (!value.IsEmpty())
+    {
+      CStdString utf8;
+      g_charsetConverter.unknownToUTF8(value, utf8);
+      frames.text[fields[i].id].push_back(utf8);
+    }
+  }
+
+  // ID3v1.1 holds the track number in the last byte of the comment
+  unsigned int commentSize = 30;
+  if (data[125] == 0 && data[126] != 0)
+  {
+    CStdString track;
+    track.Format("%u", data[126]);
+    frames.text["TRCK"].push_back(track);
+    commentSize = 28;
+  }
+  unsigned int used;
+  CStdString comment = DecodeLatin1(data + 97, commentSize, used);
+  comment.TrimRight();
+  if (!comment.IsEmpty())
+  {
+    g_charsetConverter.unknownToUTF8(comment, frames.comment);
+    frames.hasComment = true;
+  }
+
+  if (data[127] != 0xff)
+  {
+    CStdString genre;
+    genre.Format("%u", data[127]);
+    frames.text["TCON"].push_back(genre);
+  }
+}
+
+// map the frames to the tag as CID3Tag::Parse() does with libid3tag
+void CFastTag::SetID3Tag(const ID3Frames &frames)
+{
+  CMusicInfoTag &tag = m_musicInfoTag;
+
+  tag.SetTrackNumber(atoi(GetFirstString(frames.text, "TRCK")));
+  tag.SetPartOfSet(atoi(GetFirstString(frames.text, "TPOS")));
+
+  CStdString genre;
+  map<string, vector<CStdString> >::const_iterator genres = frames.text.find("TCON");
+  if (genres != frames.text.end())
+  {
+    CID3Tag id3;
+    for (vector<CStdString>::const_iterator i = genres->second.begin(); i != genres->second.end(); ++i)
+    {
+      if (i->IsEmpty())
+        continue;
+      if (!genre.IsEmpty())
+        genre += g_advancedSettings.m_musicItemSeparator;
+      genre += id3.ParseMP3Genre(*i);
+    }
+  }
+  tag.SetGenre(genre);
+
+  tag.SetTitle(GetFirstString(frames.text, "TIT2"));
+  // like libid3tag, fall back through the other performer frames when TPE1 is missing
+  static const char *artistFrames[] = { "TPE1", "TPE2", "TPE3", "TPE4", "TCOM" };
+  CStdString artist;
+  for (unsigned int i = 0; i < sizeof(artistFrames) / sizeof(artistFrames[0]) && artist.IsEmpty(); i++)
+    artist = GetFirstString(frames.text, artistFrames[i]);
+  tag.SetArtist(artist);
+  tag.SetAlbum(GetFirstString(frames.text, "TALB"));
+
+  CStdString albumArtist = GetFirstString(frames.text, "TPE2");
+  if (albumArtist.IsEmpty())
+    albumArtist = GetUserText(frames.userText, "ALBUM ARTIST");
+  if (albumArtist.IsEmpty())
+    albumArtist = GetUserText(frames.userText, "ALBUMARTIST");
+  tag.SetAlbumArtist(albumArtist);
+
+  tag.SetComment(frames.comment);
+  tag.SetLyrics(frames.lyrics);
+
+  // based on mediamonkey's values, as libid3tag does
+  char rating = '0';
+  if (frames.popularity >= 0)
+  {
+    int value = frames.popularity;
+    if (value == 1)        rating = '1';
+    else if (value < 9)    rating = '0';
+    else if (value < 50)   rating = '1';
+    else if (value < 114)  rating = '2';
+    else if (value < 168)  rating = '3';
+    else if (value < 219)  rating = '4';
+    else                   rating = '5';
+  }
+  else
+  {
+    CStdString value = GetUserText(frames.userText, "RATING");
+    if (!value.IsEmpty() && value[0] > '0' && value[0] < '6')
+      rating = value[0];
+  }
+  tag.SetRating(rating);
+
+  bool compilation = GetFirstString(frames.text, "TCMP") == "1";
+  if (compilation && tag.GetAlbumArtist().empty())
+    tag.SetAlbumArtist(g_localizeStrings.Get(340)); // Various Artists
+  tag.SetCompilation(compilation);
+
+  if (!tag.GetTitle().IsEmpty() || !tag.GetArtist().empty() || !tag.GetAlbum().IsEmpty())
+    tag.SetLoaded();
+
+  SYSTEMTIME dateTime;
+  ZeroMemory(&dateTime, sizeof(SYSTEMTIME));
+  dateTime.wYear = atoi(GetFirstString(frames.text, "TDRC"));
+  tag.SetReleaseDate(dateTime);
+
+  if (!frames.musicBrainzTrackID.IsEmpty())
+    tag.SetMusicBrainzTrackID(frames.musicBrainzTrackID);
+  tag.SetMusicBrainzArtistID(GetUserText(frames.userText, "MusicBrainz Artist Id"));
+  tag.SetMusicBrainzAlbumID(GetUserText(frames.userText, "MusicBrainz Album Id"));
+  tag.SetMusicBrainzAlbumArtistID(GetUserText(frames.userText, "MusicBrainz Album Artist Id"));
+  tag.SetMusicBrainzTRMID(GetUserText(frames.userText, "MusicBrainz TRM Id"));
+
+  const ID3Picture &picture = frames.front.size ? frames.front : (frames.other.size ? frames.other : frames.nonStandard);
+  if (picture.size)
+    tag.SetCoverArtInfo(picture.size, picture.mimeType);
+}
+
+int CFastTag::GetMP3Duration(const unsigned char *data, unsigned int available, int64_t audioLength)
+{
+  MP3Frame frame;
+  ParseMP3Header(data, frame);
+  const unsigned char *end = data + available;
+
+  // a Xing (or Info, for constant bitrates) header in the first frame holds the number of frames
+  const unsigned char *xing = data + 4 + frame.sideInfo;
+  if (frame.layer == 3 && xing + 12 <= end && (memcmp(xing, "Xing", 4) == 0 || memcmp(xing, "Info", 4) == 0))
+  {
+    unsigned int flags = BE32(xing + 4);
+    if (flags & VBR_FRAMES_FLAG)
+    {
+      int64_t samples = (int64_t)BE32(xing + 8) * frame.samples;
+
+      // the LAME tag that follows gives the samples added by the encoder
+      const unsigned char *lame = xing + 12 + ((flags & VBR_BYTES_FLAG) ? 4 : 0) +
+                                  ((flags & VBR_TOC_FLAG) ? 100 : 0) + ((flags & VBR_SCALE_FLAG) ? 4 : 0);
+      if (lame + 24 <= end && memcmp(lame, "LAME", 4) == 0)
+      {
+        int delay = (lame[21] << 4) | (lame[22] >> 4);
+        int padding = ((lame[22] & 0x0f) << 8) | lame[23];
+        if (samples > delay + padding)
+          samples -= delay + padding;
+      }
+      return (int)(samples / frame.sampleRate);
+    }
+  }
+
+  // as does a VBRI header, written by the Fraunhofer encoder
+  const unsigned char *vbri = data + 4 + 32;
+  if (vbri + 18 <= end && memcmp(vbri, "VBRI", 4) == 0)
+    return (int)((int64_t)BE32(vbri + 14) * frame.samples / frame.sampleRate);
+
+  // otherwise assume a constant bitrate
+  return (int)(audioLength * 8 / frame.bitrate);
+}
+
+bool CFastTag::ReadFlac(CFile &file, int64_t length)
+{
+  // format is "fLaC" followed by METADATA_BLOCKs, each with a header of
+  // <1> last block flag <7> block type <24> length of the block to follow
+  // files with ID3 tags in front are left to CFlacTag
+  if (m_buffer.size() < 8 || memcmp(&m_buffer[0], "fLaC", 4) != 0)
+    return false;
+
+  // the picture chosen as the cover is the same as CFlacTag chooses
+  ID3Picture front, other, third;
+  vector<unsigned char> scratch;
+  int64_t pos = 4;
+  while (true)
+  {
+    const unsigned char *header = GetBytes(file, pos, 4, scratch);
+    if (!header)
+      return false;
+    bool last = (header[0] & 0x80) != 0;
+    int type = header[0] & 0x7f;
+    unsigned int size = (header[1] << 16) | (header[2] << 8) | header[3];
+    pos += 4;
+    if (pos + size > length)
+      return false;
+
+    if (type == 0 && size >= 18) // STREAMINFO
+    {
+      const unsigned char *info = GetBytes(file, pos, 18, scratch);
+      if (!info)
+        return false;
+      int frequency = (info[10] << 12) | (info[11] << 4) | (info[12] >> 4);
+      int64_t samples = ((int64_t)(info[13] & 0x0f) << 32) | ((int64_t)info[14] << 24) | (info[15] << 16) | (info[16] << 8) | info[17];
+      if (frequency != 0)
+        m_musicInfoTag.SetDuration((int)(samples / frequency));
+    }
+    else if (type == 4) // VORBIS_COMMENT
+    {
+      const unsigned char *comment = GetBytes(file, pos, size, scratch);
+      if (!comment)
+        return false;
+      ParseVorbisComment(comment, size);
+    }
+    else if (type == 6) // PICTURE
+    {
+      unsigned int headerSize = min(size, (unsigned int)FLAC_PICTURE_SIZE);
+      const unsigned char *picture = GetBytes(file, pos, headerSize, scratch);
+      // <32> type <32> mime length <n> mime <32> description length <n> description
+      // <32> width <32> height <32> depth <32> colors <32> data length
+      if (!picture || headerSize < 32)
+        return false;
+      unsigned int pictureType = BE32(picture);
+      unsigned int mimeSize = BE32(picture + 4);
+      unsigned int remaining = headerSize - 8;
+      if (mimeSize > remaining - 24)
+        return false;
+      CStdString mimeType((const char *)picture + 8, mimeSize);
+      remaining -= mimeSize + 4;
+      unsigned int descriptionSize = BE32(picture + 8 + mimeSize);
+      if (descriptionSize > remaining - 20)
+        return false;
+      unsigned int dataSize = BE32(picture + 12 + mimeSize + descriptionSize + 16);
+      ID3Picture *cover = &third;
+      if (pictureType == PICTURE_COVERFRONT)
+        cover = front.size ? NULL : &front;
+      else if (pictureType == PICTURE_OTHER)
+        cover = other.size ? NULL : &other;
+      if (cover)
+      {
+        cover->size = dataSize;
+        cover->mimeType = mimeType;
+      }
+    }
+    pos += size;
+    if (last)
+      break;
+  }
+
+  const ID3Picture &cover = front.size ? front : (other.size ? other : third);
+  if (cover.size)
+    m_musicInfoTag.SetCoverArtInfo(cover.size, cover.mimeType);
+  return true;
+}
+
+bool CFastTag::ReadOgg(CFile &file, int64_t length)
+{
+  // the identification and comment headers are the first two packets of the stream
+  const unsigned char *data = &m_buffer[0];
+  unsigned int size = m_buffer.size();
+  unsigned int pos = 0;
+  unsigned int serial = 0;
+  int packets = 0;
+  int sampleRate = 0;
+  string packet;
+  while (packets < 2)
+  {
+    if (pos + 27 > size || memcmp(data + pos, "OggS", 4) != 0 || data[pos + 4] != 0)
+      return false;
+    unsigned int pageSerial = LE32(data + pos + 14);
+    if (pos == 0)
+      serial = pageSerial;
+    else if (pageSerial != serial)
+      return false; // multiplexed streams
+    unsigned int segments = data[pos + 26];
+    const unsigned char *table = data + pos + 27;
+    pos += 27 + segments;
+    if (pos > size)
+      return false;
+
+    for (unsigned int i = 0; i < segments && packets < 2; i++)
+    {
+      if (pos + table[i] > size)
+        return false; // a large comment header, most likely with embedded art
+      packet.append((const char *)data + pos, table[i]);
+      pos += table[i];
+      if (table[i] == 255)
+        continue;
+
+      // end of the packet
+      if (++packets == 1)
+      {
+        if (packet.size() < 16 || packet.compare(0, 7, "\x01vorbis") != 0)
+          return false;
+        sampleRate = LE32((const unsigned char *)packet.c_str() + 12);
+      }
+      else
+      {
+        if (packet.size() < 7 || packet.compare(0, 7, "\x03vorbis") != 0)
+          return false;
+        ParseVorbisComment((const unsigned char *)packet.c_str() + 7, packet.size() - 7);
+      }
+      packet.clear();
+    }
+  }
+  if (sampleRate <= 0)
+    return false;
+
+  // the duration is given by the granule position of the last page
+  unsigned int tailSize = (unsigned int)min(length, (int64_t)OGG_TAIL_SIZE);
+  vector<unsigned char> tail(tailSize);
+  if (!ReadAt(file, length - tailSize, &tail[0], tailSize))
+    return false;
+  for (int i = (int)tailSize - 27; i >= 0; i--)
+  {
+    const unsigned char *page = &tail[i];
+    if (page[0] != 'O' || memcmp(page, "OggS", 4) != 0 || page[4] != 0)
+      continue;
+    if (LE32(page + 14) != serial)
+      return false; // a chained stream
+    int64_t granule = ((int64_t)LE32(page + 10) << 32) | LE32(page + 6);
+    if (granule < 0)
+      continue;
+    m_musicInfoTag.SetDuration((int)(granule / sampleRate));
+    return true;
+  }
+  return false;
+}
+
+void CFastTag::ParseVorbisComment(const unsigned char *data, unsigned int size)
+{
+  if (size < 8)
+    return;
+  unsigned int vendorSize = LE32(data);
+  if (vendorSize > size - 8)
+    return;
+  unsigned int pos = 4 + vendorSize;
+  unsigned int count = LE32(data + pos);
+  pos += 4;
+  for (unsigned int i = 0; i < count && pos + 4 <= size; i++)
+  {
+    unsigned int entrySize = LE32(data + pos);
+    pos += 4;
+    if (entrySize > size - pos)
+      break;
+    CStdString entry((const char *)data + pos, entrySize);
+    ParseTagEntry(entry);
+    pos += entrySize;
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <vector>
+#include "VorbisTag.h"
+
+namespace XFILE
+{
+  class CFile;
+}
+
+namespace MUSIC_INFO
+{
+
+/*!
+ \brief Reads the tags of common files from their tag blocks alone, for library scans.
+
+ Handles mp3 (ID3v2.3/2.4 or ID3v1), flac and ogg vorbis files. The start of the file
+ is read in one go, and the tag and audio headers are parsed from that buffer, with
+ further reads only for tags that don't fit in it and for the end of the file. The
+ duration of an mp3 is taken from its Xing, Info or VBRI header, or estimated from
+ the bitrate of its first frame, rather than by scanning the file.
+
+ The tags read match those of the full tag loaders. Anything out of the ordinary (an
+ unsynchronised or compressed ID3v2 tag, an APEv2 tag that is to take priority, a
+ chained ogg stream and so on) makes Read() fail, in which case the loader from
+ CMusicInfoTagLoaderFactory should be used instead. Embedded art isn't extracted,
+ though its presence is noted in the tag as the full loaders do.
+ */
+class CFastTag : public CVorbisTag
+{
+public:
+  CFastTag(void);
+  virtual ~CFastTag(void);
+
+  /*! \brief Read the tags of a file.
+   \return false if the file can't be read quickly, in which case the full tag loader should be used.
+   */
+  virtual bool Read(const CStdString& strFile);
+
+private:
+  struct ID3Frames;
+
+  bool ReadMP3(XFILE::CFile &file, int64_t length);
+  bool ReadFlac(XFILE::CFile &file, int64_t length);
+  bool ReadOgg(XFILE::CFile &file, int64_t length);
+
+  /*! \brief Extend the buffer holding the start of the file to the given size, or the whole file if smaller.
+   */
+  bool ReadHead(XFILE::CFile &file, int64_t length, int64_t size);
+
+  /*! \brief Get some bytes of the file, from the buffer holding its start if they're in it.
+   */
+  const unsigned char *GetBytes(XFILE::CFile &file, int64_t offset, unsigned int size, std::vector<unsigned char> &scratch);
+
+  static bool ParseID3v2(const unsigned char *data, unsigned int size, int version, ID3Frames &frames);
+  static void ParseID3v1(const unsigned char *data, ID3Frames &frames);
+  void SetID3Tag(const ID3Frames &frames);
+  static int GetMP3Duration(const unsigned char *frame, unsigned int available, int64_t audioLength);
+  void ParseVorbisComment(const unsigned char *data, unsigned int size);
+
+  std::vector<unsigned char> m_buffer; ///< the start of the file
+};
+}
@@ -189,6 +189,7 @@ void CAdvancedSettings::Initialize()
   m_fanartRes = 1080;
   m_imageRes = 720;
   m_useDDSFanart = false;
+  m_usePackedTextures = false;
 
   m_sambaclienttimeout = 10;
   m_sambadoscodepage = "";
@@ -205,6 +206,9 @@ void CAdvancedSettings::Initialize()
   m_bMusicLibraryHideAllItems = false;
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryAlbumsSortByArtistThenYear = false;
+  m_bMusicLibrarySearchIndex = true;
+  m_iMusicLibraryTagReaders = 4;
+  m_bMusicLibraryFastUpdate = false;
   m_iMusicLibraryRecentlyAddedItems = 25;
   m_strMusicLibraryAlbumFormat = "";
   m_strMusicLibraryAlbumFormatRight = "";
@@ -221,7 +225,9 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
+  m_bVideoLibrarySearchIndex = true;
   m_bVideoScannerIgnoreErrors = false;
+  m_iVideoScannerLookups = 3;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
   m_iTuxBoxStreamtsPort = 31339;
@@ -257,6 +263,7 @@ void CAdvancedSettings::Initialize()
   m_curlconnecttimeout = 10;
   m_curllowspeedtime = 20;
   m_curlretries = 2;
+  m_httpCacheSize = 20;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
 
@@ -305,6 +312,10 @@ void CAdvancedSettings::Initialize()
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
 
+  m_sqliteWAL = false;
+  m_sqliteCacheSize = 4096;
+  m_sqliteMmapSize = 0;
+
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
 
@@ -314,6 +325,8 @@ void CAdvancedSettings::Initialize()
   m_guiVisualizeDirtyRegions = false;
   m_guiAlgorithmDirtyRegions = 0;
   m_guiDirtyRegionNoFlipTimeout = -1;
+  m_guiPreloadWindows = false;
+  m_guiCacheWindows = true;
   m_logEnableAirtunes = false;
   m_airTunesPort = 36666;
   m_airPlayPort = 36667;
@@ -631,6 +644,9 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "prioritiseapetags", m_prioritiseAPEv2tags);
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "albumssortbyartistthenyear", m_bMusicLibraryAlbumsSortByArtistThenYear);
+    XMLUtils::GetBoolean(pElement, "searchindex", m_bMusicLibrarySearchIndex);
+    XMLUtils::GetInt(pElement, "tagreaders", m_iMusicLibraryTagReaders, 1, 16);
+    XMLUtils::GetBoolean(pElement, "fastupdate", m_bMusicLibraryFastUpdate);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
@@ -649,6 +665,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "exportautothumbs", m_bVideoLibraryExportAutoThumbs);
     XMLUtils::GetBoolean(pElement, "importwatchedstate", m_bVideoLibraryImportWatchedState);
     XMLUtils::GetBoolean(pElement, "importresumepoint", m_bVideoLibraryImportResumePoint);
+    XMLUtils::GetBoolean(pElement, "searchindex", m_bVideoLibrarySearchIndex);
     XMLUtils::GetInt(pElement, "dateadded", m_iVideoLibraryDateAdded);
   }
 
@@ -656,6 +673,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "ignoreerrors", m_bVideoScannerIgnoreErrors);
+    XMLUtils::GetInt(pElement, "lookups", m_iVideoScannerLookups, 1, 16);
   }
 
   // Backward-compatibility of ExternalPlayer config
@@ -687,6 +705,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetInt(pElement, "curlclienttimeout", m_curlconnecttimeout, 1, 1000);
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
+    XMLUtils::GetInt(pElement, "httpcachesize", m_httpCacheSize, 0, 1024);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
   }
@@ -921,6 +940,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   XMLUtils::GetInt(pRootElement, "fanartres", m_fanartRes, 0, 1080);
   XMLUtils::GetInt(pRootElement, "imageres", m_imageRes, 0, 1080);
   XMLUtils::GetBoolean(pRootElement, "useddsfanart", m_useDDSFanart);
+  XMLUtils::GetBoolean(pRootElement, "usepackedtextures", m_usePackedTextures);
 
   XMLUtils::GetBoolean(pRootElement, "playlistasfolders", m_playlistAsFolders);
   XMLUtils::GetBoolean(pRootElement, "detectasudf", m_detectAsUdf);
@@ -1001,6 +1021,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pDatabase, "user", m_databaseVideo.user);
     XMLUtils::GetString(pDatabase, "pass", m_databaseVideo.pass);
     XMLUtils::GetString(pDatabase, "name", m_databaseVideo.name);
+    XMLUtils::GetString(pDatabase, "replicahost", m_databaseVideo.replicahost);
+    XMLUtils::GetString(pDatabase, "replicaport", m_databaseVideo.replicaport);
   }
 
   pDatabase = pRootElement->FirstChildElement("musicdatabase");
@@ -1012,6 +1034,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pDatabase, "user", m_databaseMusic.user);
     XMLUtils::GetString(pDatabase, "pass", m_databaseMusic.pass);
     XMLUtils::GetString(pDatabase, "name", m_databaseMusic.name);
+    XMLUtils::GetString(pDatabase, "replicahost", m_databaseMusic.replicahost);
+    XMLUtils::GetString(pDatabase, "replicaport", m_databaseMusic.replicaport);
   }
 
   pDatabase = pRootElement->FirstChildElement("tvdatabase");
@@ -1023,6 +1047,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pDatabase, "user", m_databaseTV.user);
     XMLUtils::GetString(pDatabase, "pass", m_databaseTV.pass);
     XMLUtils::GetString(pDatabase, "name", m_databaseTV.name);
+    XMLUtils::GetString(pDatabase, "replicahost", m_databaseTV.replicahost);
+    XMLUtils::GetString(pDatabase, "replicaport", m_databaseTV.replicaport);
   }
 
   pDatabase = pRootElement->FirstChildElement("epgdatabase");
@@ -1034,6 +1060,18 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pDatabase, "user", m_databaseEpg.user);
     XMLUtils::GetString(pDatabase, "pass", m_databaseEpg.pass);
     XMLUtils::GetString(pDatabase, "name", m_databaseEpg.name);
+    XMLUtils::GetString(pDatabase, "replicahost", m_databaseEpg.replicahost);
+    XMLUtils::GetString(pDatabase, "replicaport", m_databaseEpg.replicaport);
+  }
+
+  pElement = pRootElement->FirstChildElement("sqlite");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "wal", m_sqliteWAL);
+    XMLUtils::GetInt(pElement, "cachesize", m_sqliteCacheSize, 16, 1024 * 1024);
+    uint32_t mmapSize; // in MB
+    if (XMLUtils::GetUInt(pElement, "mmapsize", mmapSize))
+      m_sqliteMmapSize = std::min(mmapSize, (uint32_t)2048) * 1024 * 1024;
   }
 
   pElement = pRootElement->FirstChildElement("enablemultimediakeys");
@@ -1048,6 +1086,8 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "visualizedirtyregions", m_guiVisualizeDirtyRegions);
     XMLUtils::GetInt(pElement, "algorithmdirtyregions",     m_guiAlgorithmDirtyRegions);
     XMLUtils::GetInt(pElement, "nofliptimeout",             m_guiDirtyRegionNoFlipTimeout);
+    XMLUtils::GetBoolean(pElement, "preloadwindows",        m_guiPreloadWindows);
+    XMLUtils::GetBoolean(pElement, "cachewindows",          m_guiCacheWindows);
   }
 
   // load in the GUISettings overrides:
@@ -37,6 +37,8 @@ public:
     user.clear();
     pass.clear();
     name.clear();
+    replicahost.clear();
+    replicaport.clear();
   };
   CStdString type;
   CStdString host;
@@ -44,6 +46,8 @@ public:
   CStdString user;
   CStdString pass;
   CStdString name;
+  CStdString replicahost; ///< optional read-only replica that selects may be routed to
+  CStdString replicaport;
 };
 
 struct TVShowRegexp
@@ -224,6 +228,7 @@ class CAdvancedSettings
      */
     unsigned int GetThumbSize() const { return m_imageRes / 2; };
     bool m_useDDSFanart;
+    bool m_usePackedTextures; ///< \brief keep lzo packed, ready to upload copies of cached images alongside them
 
     int m_sambaclienttimeout;
     CStdString m_sambadoscodepage;
@@ -241,6 +246,9 @@ class CAdvancedSettings
     int m_iMusicLibraryRecentlyAddedItems;
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryAlbumsSortByArtistThenYear;
+    bool m_bMusicLibrarySearchIndex;
+    int m_iMusicLibraryTagReaders;
+    bool m_bMusicLibraryFastUpdate; ///< skip folders whose modification time is unchanged when updating
     CStdString m_strMusicLibraryAlbumFormat;
     CStdString m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
@@ -257,8 +265,10 @@ class CAdvancedSettings
     bool m_bVideoLibraryExportAutoThumbs;
     bool m_bVideoLibraryImportWatchedState;
     bool m_bVideoLibraryImportResumePoint;
+    bool m_bVideoLibrarySearchIndex;
 
     bool m_bVideoScannerIgnoreErrors;
+    int m_iVideoScannerLookups;
     int m_iVideoLibraryDateAdded;
 
     std::vector<CStdString> m_vecTokens; // cleaning strings tied to language
@@ -298,6 +308,7 @@ class CAdvancedSettings
     int m_curlconnecttimeout;
     int m_curllowspeedtime;
     int m_curlretries;
+    int m_httpCacheSize;  ///< MB of http responses kept for scrapers, RSS feeds and repositories
     bool m_curlDisableIPV6;
 
     bool m_fullScreen;
@@ -349,9 +360,15 @@ class CAdvancedSettings
     DatabaseSettings m_databaseTV;    // advanced tv database setup
     DatabaseSettings m_databaseEpg;   /*!< advanced EPG database setup */
 
+    bool m_sqliteWAL;              ///< run local sqlite databases with a write-ahead log, so reads don't block behind writes
+    int m_sqliteCacheSize;         ///< sqlite page cache size per connection, in pages
+    unsigned int m_sqliteMmapSize; ///< amount of each sqlite database file to memory map, in bytes (0 disables)
+
     bool m_guiVisualizeDirtyRegions;
     int  m_guiAlgorithmDirtyRegions;
     int  m_guiDirtyRegionNoFlipTimeout;
+    bool m_guiPreloadWindows;
+    bool m_guiCacheWindows;
 
     unsigned int m_cacheMemBufferSize;
 
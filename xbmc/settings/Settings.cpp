@@ -1443,6 +1443,7 @@ void CSettings::LoadSkinSettings(const TiXmlElement* pRootElement)
       }
       pChild = pChild->NextSiblingElement("setting");
     }
+    g_infoManager.Signal(INFO::SIGNAL_SKIN);
   }
 }
 
@@ -1521,6 +1522,7 @@ void CSettings::SetSkinString(int setting, const CStdString &label)
   if (it != m_skinStrings.end())
   {
     (*it).second.value = label;
+    g_infoManager.Signal(INFO::SIGNAL_SKIN);
     return;
   }
   assert(false);
@@ -1537,6 +1539,7 @@ void CSettings::ResetSkinSetting(const CStdString &setting)
     if (settingName.Equals((*it).second.name))
     {
       (*it).second.value = "";
+      g_infoManager.Signal(INFO::SIGNAL_SKIN);
       return;
     }
   }
@@ -1546,6 +1549,7 @@ void CSettings::ResetSkinSetting(const CStdString &setting)
     if (settingName.Equals((*it).second.name))
     {
       (*it).second.value = false;
+      g_infoManager.Signal(INFO::SIGNAL_SKIN);
       return;
     }
   }
@@ -1586,6 +1590,7 @@ void CSettings::SetSkinBool(int setting, bool set)
   if (it != m_skinBools.end())
   {
     (*it).second.value = set;
+    g_infoManager.Signal(INFO::SIGNAL_SKIN);
     return;
   }
   assert(false);
@@ -1614,6 +1619,7 @@ void CSettings::ResetSkinSettings()
 
     it2++;
   }
+  g_infoManager.Signal(INFO::SIGNAL_SKIN);
   g_infoManager.ResetCache();
 }
 
@@ -0,0 +1,266 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "system.h"
+#include "DirectoryWatcher.h"
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+#include "threads/SingleLock.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+using namespace std;
+
+#ifdef HAVE_INOTIFY
+#define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR)
+#endif
+
+CDirectoryWatcher &CDirectoryWatcher::Get()
+{
+  static CDirectoryWatcher s_watcher;
+  return s_watcher;
+}
+
+CDirectoryWatcher::CDirectoryWatcher() : CThread("CDirectoryWatcher")
+{
+  m_fd = -1;
+  m_sequence = 0;
+}
+
+CDirectoryWatcher::~CDirectoryWatcher()
+{
+  StopThread();
+#ifdef HAVE_INOTIFY
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+}
+
+void CDirectoryWatcher::Watch(const CStdString &path)
+{
+#ifdef HAVE_INOTIFY
+  // only local paths can be watched
+  if (path.IsEmpty() || path[0] != '/')
+    return;
+
+  CStdString root(path);
+  URIUtils::AddSlashAtEnd(root);
+  {
+    CSingleLock lock(m_section);
+    if (m_roots.find(root) != m_roots.end())
+      return;
+    if (m_fd < 0 && (m_fd = inotify_init()) < 0)
+    {
+      CLog::Log(LOGERROR, "%s - unable to initialise inotify (%s)", __FUNCTION__, strerror(errno));
+      return;
+    }
+    m_roots[root].sequence = ++m_sequence;
+  }
+
+  if (AddWatches(root))
+    CLog::Log(LOGDEBUG, "%s - watching %s for changes", __FUNCTION__, root.c_str());
+  else
+  {
+    CLog::Log(LOGWARNING, "%s - unable to watch all of %s, changes to it will be found by scanning", __FUNCTION__, root.c_str());
+    CSingleLock lock(m_section);
+    m_roots[root].failed = true;
+  }
+
+  if (!IsRunning())
+    Create();
+#endif
+}
+
+bool CDirectoryWatcher::IsWatched(const CStdString &directory) const
+{
+  CSingleLock lock(m_section);
+  const Root *root = FindRoot(directory);
+  return root && root->trusted && !root->failed;
+}
+
+bool CDirectoryWatcher::HasChanged(const CStdString &directory) const
+{
+  CStdString path(directory);
+  URIUtils::AddSlashAtEnd(path);
+  CSingleLock lock(m_section);
+  return m_changes.find(path) != m_changes.end();
+}
+
+unsigned int CDirectoryWatcher::GetSequence() const
+{
+  CSingleLock lock(m_section);
+  return m_sequence;
+}
+
+void CDirectoryWatcher::ClearChanges(const CStdString &path, unsigned int sequence)
+{
+  CStdString scanned(path);
+  URIUtils::AddSlashAtEnd(scanned);
+  CSingleLock lock(m_section);
+  for (map<CStdString, unsigned int>::iterator i = m_changes.lower_bound(scanned); i != m_changes.end(); )
+  {
+    if (i->first.compare(0, scanned.size(), scanned) != 0)
+      break;
+    if (i->second <= sequence)
+      m_changes.erase(i++);
+    else
+      ++i;
+  }
+  // only trees scanned in full since they were watched can be trusted
+  for (map<CStdString, Root>::iterator i = m_roots.begin(); i != m_roots.end(); ++i)
+  {
+    if (i->second.sequence <= sequence && i->first.compare(0, scanned.size(), scanned) == 0)
+      i->second.trusted = true;
+  }
+}
+
+const CDirectoryWatcher::Root *CDirectoryWatcher::FindRoot(const CStdString &directory) const
+{
+  for (map<CStdString, Root>::const_iterator i = m_roots.begin(); i != m_roots.end(); ++i)
+  {
+    if (directory.compare(0, i->first.size(), i->first) == 0)
+      return &i->second;
+  }
+  return NULL;
+}
+
+bool CDirectoryWatcher::AddWatches(const CStdString &directory)
+{
+#ifdef HAVE_INOTIFY
+  int wd = inotify_add_watch(m_fd, directory.c_str(), WATCH_EVENTS);
+  if (wd < 0)
+  {
+    CLog::Log(LOGDEBUG, "%s - unable to watch %s (%s)", __FUNCTION__, directory.c_str(), strerror(errno));
+    return false;
+  }
+  {
+    CSingleLock lock(m_section);
+    m_watches[wd] = directory;
+  }
+
+  DIR *dir = opendir(directory.c_str());
+  if (!dir)
+    return false;
+
+  bool watched = true;
+  struct dirent *entry;
+  while ((entry = readdir(dir)))
+  {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+
+    CStdString path = directory + entry->d_name;
+    struct stat info;
+    if (entry->d_type == DT_DIR)
+      watched &= AddWatches(path + "/");
+    else if ((entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) && stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+    {
+      if (entry->d_type == DT_LNK)
+        watched = false; // changes behind a link aren't reported for the link's path
+      else
+        watched &= AddWatches(path + "/");
+    }
+  }
+  closedir(dir);
+  return watched;
+#else
+  return false;
+#endif
+}
+
+void CDirectoryWatcher::Changed(const CStdString &directory)
+{
+  CSingleLock lock(m_section);
+  m_changes[directory] = ++m_sequence;
+}
+
+void CDirectoryWatcher::Process()
+{
+#ifdef HAVE_INOTIFY
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  while (!m_bStop)
+  {
+    struct pollfd fd;
+    fd.fd = m_fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    if (poll(&fd, 1, 500) <= 0)
+      continue;
+
+    ssize_t length = read(m_fd, buffer, sizeof(buffer));
+    if (length <= 0)
+      continue;
+
+    for (char *next = buffer; next < buffer + length; )
+    {
+      const struct inotify_event *event = (const struct inotify_event *)next;
+      next += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW)
+      { // changes were lost, so we can't be trusted until another scan completes
+        CLog::Log(LOGWARNING, "%s - event queue overflowed", __FUNCTION__);
+        CSingleLock lock(m_section);
+        for (map<CStdString, Root>::iterator i = m_roots.begin(); i != m_roots.end(); ++i)
+        {
+          i->second.sequence = ++m_sequence;
+          i->second.trusted = false;
+        }
+        continue;
+      }
+
+      CStdString directory;
+      {
+        CSingleLock lock(m_section);
+        map<int, CStdString>::iterator watch = m_watches.find(event->wd);
+        if (watch == m_watches.end())
+          continue;
+        directory = watch->second;
+        if (event->mask & IN_IGNORED)
+        { // the directory was removed
+          m_watches.erase(watch);
+          continue;
+        }
+      }
+
+      Changed(directory);
+      if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)) && event->len)
+      { // watch new subdirectories too
+        CStdString path = directory + event->name + "/";
+        Changed(path);
+        if (!AddWatches(path))
+        {
+          CSingleLock lock(m_section);
+          Root *root = const_cast<Root *>(FindRoot(path));
+          if (root)
+            root->failed = true;
+        }
+      }
+    }
+  }
+#endif
+}
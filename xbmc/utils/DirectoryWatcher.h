@@ -0,0 +1,91 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <map>
+#include <vector>
+#include "utils/StdString.h"
+#include "threads/Thread.h"
+#include "threads/CriticalSection.h"
+
+/*!
+ \brief Collects changes to local directory trees between library scans.
+
+ Where the platform supports it (inotify on Linux) the watcher records every directory in
+ which files are created, deleted, moved or written, so a scan can tell which directories
+ have changed without listing or even stat()ing them. Elsewhere nothing is watched and
+ IsWatched() is always false.
+
+ A watched tree is only trusted once a scan that started after the tree was watched has
+ completed, as changes made before the watch began are unknown. Scans call GetSequence()
+ when they start, and ClearChanges() with that value for each path scanned when they complete.
+ */
+class CDirectoryWatcher : public CThread
+{
+public:
+  static CDirectoryWatcher &Get();
+
+  /*! \brief Start watching a local directory tree, if not already watched.
+   */
+  void Watch(const CStdString &path);
+
+  /*! \brief Whether changes to a directory are known since the last completed scan.
+   */
+  bool IsWatched(const CStdString &directory) const;
+
+  /*! \brief Whether anything in a directory has changed since the last completed scan.
+   */
+  bool HasChanged(const CStdString &directory) const;
+
+  unsigned int GetSequence() const;
+
+  /*! \brief Forget the changes recorded within a path before a scan of it, now that it has completed.
+   \param path the path that was scanned.
+   \param sequence the value of GetSequence() when the scan started.
+   */
+  void ClearChanges(const CStdString &path, unsigned int sequence);
+
+protected:
+  virtual void Process();
+
+private:
+  CDirectoryWatcher();
+  virtual ~CDirectoryWatcher();
+
+  struct Root
+  {
+    Root() : sequence(0), trusted(false), failed(false) {};
+    unsigned int sequence; ///< sequence when the watch began
+    bool trusted;          ///< whether a scan has completed since the watch began
+    bool failed;           ///< whether part of the tree couldn't be watched
+  };
+
+  const Root *FindRoot(const CStdString &directory) const;
+  bool AddWatches(const CStdString &directory);
+  void Changed(const CStdString &directory);
+
+  int m_fd;
+  std::map<CStdString, Root> m_roots;
+  std::map<int, CStdString> m_watches;          ///< watched directory by watch descriptor
+  std::map<CStdString, unsigned int> m_changes; ///< sequence of the last change to each directory
+  unsigned int m_sequence;
+  mutable CCriticalSection m_section;
+};
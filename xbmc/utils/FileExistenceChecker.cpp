@@ -0,0 +1,266 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "FileExistenceChecker.h"
+#include <set>
+#include "FileItem.h"
+#include "URL.h"
+#include "Util.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+#include "utils/log.h"
+
+using namespace std;
+using namespace XFILE;
+
+// number of sources checked at once
+#define MAX_THREADS 4
+
+CFileExistenceChecker::CFileExistenceChecker(const CStdString &cursorFile)
+{
+  m_cursorFile = cursorFile;
+  m_done = 0;
+  m_total = 0;
+  m_finished = false;
+  m_stop = false;
+}
+
+CFileExistenceChecker::~CFileExistenceChecker()
+{
+  m_stop = true;
+  for (vector<CThread*>::iterator i = m_threads.begin(); i != m_threads.end(); ++i)
+  {
+    (*i)->StopThread();
+    delete *i;
+  }
+}
+
+void CFileExistenceChecker::AddFile(int idPath, const CStdString &path, int id, const CStdString &file)
+{
+  if (m_directories.empty() || m_directories.back().idPath != idPath)
+  {
+    Directory directory;
+    directory.idPath = idPath;
+    directory.path = path;
+    m_directories.push_back(directory);
+  }
+  m_directories.back().files.push_back(make_pair(id, file));
+}
+
+void CFileExistenceChecker::Start(VECSOURCES &sources)
+{
+  bool resumed = LoadCursors();
+
+  // group the directories by source, skipping those we checked last time
+  unsigned int skipped = 0;
+  for (vector<Directory>::const_iterator i = m_directories.begin(); i != m_directories.end(); ++i)
+  {
+    bool isSource;
+    int index = CUtil::GetMatchingSource(i->path, sources, isSource);
+    Source &source = m_sources[index < 0 ? CStdString() : sources[index].strPath];
+    if (i->idPath <= source.cursor)
+    {
+      skipped++;
+      continue;
+    }
+    source.directories.push_back(&*i);
+    m_total += i->files.size();
+  }
+  if (resumed)
+    CLog::Log(LOGDEBUG, "%s - resuming, skipping %u directories checked previously", __FUNCTION__, skipped);
+
+  for (map<CStdString, Source>::iterator i = m_sources.begin(); i != m_sources.end(); ++i)
+  {
+    if (!i->second.directories.empty())
+      m_queue.push_back(&i->second);
+  }
+
+  unsigned int threads = min((unsigned int)m_queue.size(), (unsigned int)MAX_THREADS);
+  for (unsigned int i = 0; i < threads; i++)
+  {
+    CThread *thread = new CThread(this, "FileExistenceChecker");
+    m_threads.push_back(thread);
+    thread->Create();
+  }
+}
+
+bool CFileExistenceChecker::Wait(unsigned int milliseconds)
+{
+  for (vector<CThread*>::iterator i = m_threads.begin(); i != m_threads.end(); ++i)
+  {
+    if (!(*i)->WaitForThreadExit(i == m_threads.begin() ? milliseconds : 0))
+      return false;
+  }
+
+  if (!m_finished && !m_stop)
+  { // everything has been checked, so next time we start from scratch
+    if (!m_cursorFile.IsEmpty() && CFile::Exists(m_cursorFile))
+      CFile::Delete(m_cursorFile);
+  }
+  m_finished = true;
+  return true;
+}
+
+void CFileExistenceChecker::Stop()
+{
+  m_stop = true;
+  for (vector<CThread*>::iterator i = m_threads.begin(); i != m_threads.end(); ++i)
+    (*i)->StopThread();
+
+  if (m_done < m_total)
+    SaveCursors();
+  else if (!m_cursorFile.IsEmpty() && CFile::Exists(m_cursorFile))
+    CFile::Delete(m_cursorFile);
+  m_finished = true;
+}
+
+void CFileExistenceChecker::GetProgress(unsigned int &done, unsigned int &total) const
+{
+  CSingleLock lock(m_section);
+  done = m_done;
+  total = m_total;
+}
+
+void CFileExistenceChecker::GetMissing(vector<int> &ids) const
+{
+  CSingleLock lock(m_section);
+  ids.insert(ids.end(), m_missing.begin(), m_missing.end());
+}
+
+void CFileExistenceChecker::Run()
+{
+  while (!m_stop)
+  {
+    Source *source;
+    {
+      CSingleLock lock(m_section);
+      if (m_queue.empty())
+        return;
+      source = m_queue.back();
+      m_queue.pop_back();
+    }
+
+    for (vector<const Directory*>::const_iterator i = source->directories.begin(); i != source->directories.end() && !m_stop; ++i)
+    {
+      if (!CheckDirectory(**i))
+        break;
+
+      CSingleLock lock(m_section);
+      source->cursor = (*i)->idPath;
+    }
+  }
+}
+
+bool CFileExistenceChecker::CheckDirectory(const Directory &directory)
+{
+  // a single listing answers for all the files in the directory that are still there.
+  // anything not in it is checked on its own, as its path may just be spelt differently.
+  set<CStdString> listing;
+  bool listed = false;
+  bool missing = false;
+  if (!URIUtils::IsInternetStream(directory.path, true))
+  {
+    CFileItemList items;
+    listed = CDirectory::GetDirectory(directory.path, items, "", DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO | DIR_FLAG_GET_HIDDEN | DIR_FLAG_BYPASS_CACHE);
+    if (listed)
+    {
+      for (int i = 0; i < items.Size(); i++)
+        listing.insert(items[i]->GetPath());
+    }
+    else
+      missing = !CDirectory::Exists(directory.path);
+  }
+
+  for (vector<pair<int, CStdString> >::const_iterator i = directory.files.begin(); i != directory.files.end(); ++i)
+  {
+    if (m_stop)
+      return false;
+
+    bool exists;
+    if (missing)
+      exists = false;
+    else if (listed && listing.find(i->second) != listing.end())
+      exists = true;
+    else
+      exists = CFile::Exists(i->second, false);
+
+    CSingleLock lock(m_section);
+    if (!exists)
+      m_missing.push_back(i->first);
+    m_done++;
+  }
+  return true;
+}
+
+bool CFileExistenceChecker::LoadCursors()
+{
+  if (m_cursorFile.IsEmpty() || !CFile::Exists(m_cursorFile))
+    return false;
+
+  CXBMCTinyXML doc;
+  if (!doc.LoadFile(m_cursorFile) || !doc.RootElement())
+  {
+    CLog::Log(LOGERROR, "%s - unable to load %s", __FUNCTION__, m_cursorFile.c_str());
+    return false;
+  }
+
+  const TiXmlElement *source = doc.RootElement()->FirstChildElement("source");
+  while (source)
+  {
+    const char *path = source->Attribute("path");
+    if (path && source->FirstChild())
+      m_sources[path].cursor = atoi(source->FirstChild()->Value());
+    source = source->NextSiblingElement("source");
+  }
+  return true;
+}
+
+void CFileExistenceChecker::SaveCursors()
+{
+  if (m_cursorFile.IsEmpty())
+    return;
+
+  CXBMCTinyXML doc;
+  TiXmlElement root("cleancursors");
+  TiXmlNode *rootNode = doc.InsertEndChild(root);
+  if (!rootNode)
+    return;
+
+  CSingleLock lock(m_section);
+  for (map<CStdString, Source>::const_iterator i = m_sources.begin(); i != m_sources.end(); ++i)
+  {
+    if (i->second.cursor < 0)
+      continue;
+    TiXmlElement source("source");
+    source.SetAttribute("path", i->first.c_str());
+    CStdString cursor;
+    cursor.Format("%i", i->second.cursor);
+    TiXmlText value(cursor);
+    source.InsertEndChild(value);
+    rootNode->InsertEndChild(source);
+  }
+
+  if (!doc.SaveFile(m_cursorFile))
+    CLog::Log(LOGERROR, "%s - unable to save %s", __FUNCTION__, m_cursorFile.c_str());
+}
@@ -0,0 +1,111 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <map>
+#include <vector>
+#include "utils/StdString.h"
+#include "threads/Thread.h"
+#include "threads/CriticalSection.h"
+#include "MediaSource.h"
+
+/*!
+ \brief Finds which of the files in a library have gone missing, for cleaning the library.
+
+ Files are checked a directory at a time: each directory is listed once, and only files
+ not found in the listing are checked individually. The directories of each media source
+ are checked in parallel with those of other sources, so one slow share doesn't hold up
+ the rest.
+
+ Directories are checked in the order they were added, which should be by their database
+ id. When a cursor file is given, the last directory checked in each source is saved to it
+ if the check is stopped early, and the next check skips the directories already done.
+ The caller must therefore remove the missing files found before an early stop.
+ */
+class CFileExistenceChecker : public IRunnable
+{
+public:
+  /*! \param cursorFile file to save our progress to when stopped early, or empty to always check everything.
+   */
+  CFileExistenceChecker(const CStdString &cursorFile = "");
+  virtual ~CFileExistenceChecker();
+
+  /*! \brief Add a file to be checked.
+   \param idPath the database id of the directory holding the file.
+   \param path the directory holding the file.
+   \param id the database id of the file, as returned by GetMissing().
+   \param file the full path of the file.
+   */
+  void AddFile(int idPath, const CStdString &path, int id, const CStdString &file);
+
+  /*! \brief Start checking the files in the background.
+   \param sources the media sources the files belong to.
+   */
+  void Start(VECSOURCES &sources);
+
+  /*! \brief Wait for the check to complete.
+   \return true once all files have been checked (or the check has been stopped).
+   */
+  bool Wait(unsigned int milliseconds);
+
+  /*! \brief Stop checking, saving our progress to the cursor file.
+   */
+  void Stop();
+
+  void GetProgress(unsigned int &done, unsigned int &total) const;
+
+  /*! \brief Get the ids of the files that no longer exist.
+   */
+  void GetMissing(std::vector<int> &ids) const;
+
+  virtual void Run();
+
+private:
+  struct Directory
+  {
+    int idPath;
+    CStdString path;
+    std::vector<std::pair<int, CStdString> > files;
+  };
+
+  struct Source
+  {
+    Source() : cursor(-1) {};
+    std::vector<const Directory*> directories;
+    int cursor; ///< id of the last directory checked
+  };
+
+  bool CheckDirectory(const Directory &directory);
+  bool LoadCursors();
+  void SaveCursors();
+
+  CStdString m_cursorFile;
+  std::vector<Directory> m_directories;
+  std::map<CStdString, Source> m_sources;
+  std::vector<Source*> m_queue;
+  std::vector<CThread*> m_threads;
+  std::vector<int> m_missing;
+  unsigned int m_done;
+  unsigned int m_total;
+  bool m_finished;
+  volatile bool m_stop;
+  CCriticalSection m_section;
+};
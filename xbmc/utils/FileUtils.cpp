@@ -8,6 +8,7 @@
 #include "FileOperationJob.h"
 #include "URIUtils.h"
 #include "filesystem/MultiPathDirectory.h"
+#include "filesystem/File.h"
 #include <vector>
 
 using namespace XFILE;
@@ -81,3 +82,60 @@ bool CFileUtils::RenameFile(const CStdString &strFile)
   }
   return false;
 }
+
+// amount of the start and end of a file checksummed for its fingerprint
+#define FINGERPRINT_CHUNK_SIZE 65536
+
+bool CFileUtils::GetFingerprint(const CStdString &strPath, CStdString &fingerprint, bool *unsupported /* = NULL */)
+{
+  bool dummy;
+  if (!unsupported)
+    unsupported = &dummy;
+
+  *unsupported = true;
+  if (URIUtils::IsStack(strPath) || URIUtils::IsInArchive(strPath) ||
+     !(URIUtils::IsHD(strPath) || URIUtils::IsSmb(strPath) || URIUtils::IsNfs(strPath)))
+    return false;
+
+  // failing to open or read the file may pass, e.g. once an offline share is back
+  *unsupported = false;
+  CFile file;
+  if (!file.Open(strPath, READ_NO_CACHE))
+    return false;
+
+  int64_t size = file.GetLength();
+  if (size < FINGERPRINT_CHUNK_SIZE)
+  {
+    *unsupported = true;
+    return false; // too small to tell apart reliably
+  }
+
+  // the sum of the first and last 64 KB taken as little endian 64 bit words, plus the size
+  uint64_t hash = size;
+  vector<uint8_t> buffer(FINGERPRINT_CHUNK_SIZE);
+  int64_t offsets[] = { 0, size - FINGERPRINT_CHUNK_SIZE };
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    if (file.Seek(offsets[i], SEEK_SET) != offsets[i])
+      return false;
+    unsigned int read = 0;
+    while (read < FINGERPRINT_CHUNK_SIZE)
+    {
+      unsigned int bytes = file.Read(&buffer[read], FINGERPRINT_CHUNK_SIZE - read);
+      if (bytes == 0)
+        return false;
+      read += bytes;
+    }
+    for (unsigned int j = 0; j < FINGERPRINT_CHUNK_SIZE; j += 8)
+    {
+      uint64_t word = 0;
+      for (int k = 7; k >= 0; k--)
+        word = (word << 8) | buffer[j + k];
+      hash += word;
+    }
+  }
+  file.Close();
+
+  fingerprint.Format("%"PRId64"-%016"PRIx64, size, hash);
+  return true;
+}
@@ -7,4 +7,15 @@ public:
   static bool DeleteItem(const CFileItemPtr &item, bool force=false);
   static bool DeleteItem(const CStdString &strPath, bool force=false);
   static bool RenameFile(const CStdString &strFile);
+
+  /*! \brief Get a fingerprint of the contents of a file, to recognise it after it has been moved or renamed.
+   The fingerprint is the size of the file and a 64 bit checksum of its first and last 64 KB, as used
+   by OpenSubtitles, so only 128 KB at most is read. Only plain local, smb and nfs files have one.
+   \param strPath the file.
+   \param fingerprint [out] the fingerprint of the file.
+   \param unsupported [out] if given, set to true when the file can never be fingerprinted (a stack, a file
+   in an archive, one on another protocol or one too small to tell apart), and to false when it can't be now.
+   \return true if the file could be fingerprinted.
+   */
+  static bool GetFingerprint(const CStdString &strPath, CStdString &fingerprint, bool *unsupported = NULL);
 };
@@ -21,15 +21,119 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <map>
 #include "RegExp.h"
 #include "StdString.h"
+#include "TimeUtils.h"
 #include "log.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 
 using namespace PCRE;
 
+// number of compiled patterns kept around.  Scrapers substitute their buffers into
+// their expressions, so the number of distinct patterns isn't bounded.
+#define MAX_CACHED_PATTERNS 1000
+
+struct CRegExpPattern
+{
+  CRegExpPattern(pcre *compiled, pcre_extra *studied, int64_t time) : re(compiled), extra(studied), compileTime(time) {};
+  ~CRegExpPattern()
+  {
+    if (extra)
+#ifdef PCRE_STUDY_JIT_COMPILE
+      pcre_free_study(extra);
+#else
+      pcre_free(extra);
+#endif
+    pcre_free(re);
+  }
+  pcre *re;
+  pcre_extra *extra;
+  int64_t compileTime; ///< in microseconds
+};
+
+typedef boost::shared_ptr<CRegExpPattern> CRegExpPatternPtr;
+
+class CRegExpCache
+{
+public:
+  CRegExpCache() : m_lastUsed(0) {};
+
+  CRegExpPatternPtr Get(const char *re, int options)
+  {
+    CSingleLock lock(m_section);
+    std::map<Key, Entry>::iterator i = m_patterns.find(Key(re, options));
+    if (i == m_patterns.end())
+      return CRegExpPatternPtr();
+    i->second.lastUsed = ++m_lastUsed;
+    m_stats.hits++;
+    m_stats.savedTime += i->second.pattern->compileTime;
+    return i->second.pattern;
+  }
+
+  void Add(const char *re, int options, const CRegExpPatternPtr &pattern)
+  {
+    CSingleLock lock(m_section);
+    m_stats.compiles++;
+    m_stats.compileTime += pattern->compileTime;
+    if (m_patterns.size() >= MAX_CACHED_PATTERNS)
+    { // drop the least recently used pattern. CRegExp objects still using it keep it alive
+      std::map<Key, Entry>::iterator oldest = m_patterns.begin();
+      for (std::map<Key, Entry>::iterator i = m_patterns.begin(); i != m_patterns.end(); ++i)
+      {
+        if (i->second.lastUsed < oldest->second.lastUsed)
+          oldest = i;
+      }
+      m_patterns.erase(oldest);
+    }
+    Entry &entry = m_patterns[Key(re, options)];
+    entry.pattern = pattern;
+    entry.lastUsed = ++m_lastUsed;
+  }
+
+  CRegExp::CacheStats GetStats()
+  {
+    CSingleLock lock(m_section);
+    return m_stats;
+  }
+
+private:
+  typedef std::pair<std::string, int> Key;
+  struct Entry
+  {
+    CRegExpPatternPtr pattern;
+    unsigned int lastUsed;
+  };
+
+  std::map<Key, Entry> m_patterns;
+  unsigned int m_lastUsed;
+  CRegExp::CacheStats m_stats;
+  CCriticalSection m_section;
+};
+
+static CRegExpCache &GetRegExpCache()
+{
+  static CRegExpCache cache;
+  return cache;
+}
+
+CRegExp::CacheStats CRegExp::GetCacheStats()
+{
+  return GetRegExpCache().GetStats();
+}
+
+void CRegExp::LogCacheStats(const CacheStats &since, const char *caller)
+{
+  CacheStats stats = GetCacheStats();
+  CLog::Log(LOGDEBUG, "%s - regexp cache: %u hits, %u compiles taking %u ms, saved %u ms of compiling", caller,
+            stats.hits - since.hits, stats.compiles - since.compiles,
+            (unsigned int)((stats.compileTime - since.compileTime) / 1000),
+            (unsigned int)((stats.savedTime - since.savedTime) / 1000));
+}
+
 CRegExp::CRegExp(bool caseless)
 {
-  m_re          = NULL;
   m_iOptions    = PCRE_DOTALL;
   if(caseless)
     m_iOptions |= PCRE_CASELESS;
@@ -40,30 +144,22 @@ CRegExp::CRegExp(bool caseless)
 
 CRegExp::CRegExp(const CRegExp& re)
 {
-  m_re = NULL;
   m_iOptions = re.m_iOptions;
   *this = re;
 }
 
 const CRegExp& CRegExp::operator=(const CRegExp& re)
 {
-  size_t size;
-  Cleanup();
+  // compiled patterns are never modified, so they can be shared
+  m_re = re.m_re;
   m_pattern = re.m_pattern;
   if (re.m_re)
   {
-    if (pcre_fullinfo(re.m_re, NULL, PCRE_INFO_SIZE, &size) >= 0)
-    {
-      if ((m_re = (pcre*)malloc(size)))
-      {
-        memcpy(m_re, re.m_re, size);
-        memcpy(m_iOvector, re.m_iOvector, OVECCOUNT*sizeof(int));
-        m_iMatchCount = re.m_iMatchCount;
-        m_bMatched = re.m_bMatched;
-        m_subject = re.m_subject;
-        m_iOptions = re.m_iOptions;
-      }
-    }
+    memcpy(m_iOvector, re.m_iOvector, OVECCOUNT*sizeof(int));
+    m_iMatchCount = re.m_iMatchCount;
+    m_bMatched = re.m_bMatched;
+    m_subject = re.m_subject;
+    m_iOptions = re.m_iOptions;
   }
   return *this;
 }
@@ -85,13 +181,31 @@ CRegExp* CRegExp::RegComp(const char *re)
 
   Cleanup();
 
-  m_re = pcre_compile(re, m_iOptions, &errMsg, &errOffset, NULL);
+  m_re = GetRegExpCache().Get(re, m_iOptions);
   if (!m_re)
   {
-    m_pattern.clear();
-    CLog::Log(LOGERROR, "PCRE: %s. Compilation failed at offset %d in expression '%s'",
-              errMsg, errOffset, re);
-    return NULL;
+    int64_t start = CurrentHostCounter();
+    pcre *compiled = pcre_compile(re, m_iOptions, &errMsg, &errOffset, NULL);
+    if (!compiled)
+    {
+      m_pattern.clear();
+      CLog::Log(LOGERROR, "PCRE: %s. Compilation failed at offset %d in expression '%s'",
+                errMsg, errOffset, re);
+      return NULL;
+    }
+
+    // patterns are typically matched many times, so it's worth studying them
+#ifdef PCRE_STUDY_JIT_COMPILE
+    pcre_extra *studied = pcre_study(compiled, PCRE_STUDY_JIT_COMPILE, &errMsg);
+#else
+    pcre_extra *studied = pcre_study(compiled, 0, &errMsg);
+#endif
+    if (errMsg)
+      CLog::Log(LOGWARNING, "PCRE: %s. Study failed for expression '%s'", errMsg, re);
+
+    int64_t time = (CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency();
+    m_re.reset(new CRegExpPattern(compiled, studied, time));
+    GetRegExpCache().Add(re, m_iOptions, m_re);
   }
 
   m_pattern = re;
@@ -117,7 +231,15 @@ int CRegExp::RegFind(const char* str, int startoffset)
   }
 
   m_subject = str;
-  int rc = pcre_exec(m_re, NULL, str, strlen(str), startoffset, 0, m_iOvector, OVECCOUNT);
+  int rc = pcre_exec(m_re->re, m_re->extra, str, strlen(str), startoffset, 0, m_iOvector, OVECCOUNT);
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+  if (rc == PCRE_ERROR_JIT_STACKLIMIT)
+  { // the JIT stack is small, so fall back to the interpreter for very long subjects
+    pcre_extra extra = *m_re->extra;
+    extra.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+    rc = pcre_exec(m_re->re, &extra, str, strlen(str), startoffset, 0, m_iOvector, OVECCOUNT);
+  }
+#endif
 
   if (rc<1)
   {
@@ -144,7 +266,7 @@ int CRegExp::GetCaptureTotal()
 {
   int c = -1;
   if (m_re)
-    pcre_fullinfo(m_re, NULL, PCRE_INFO_CAPTURECOUNT, &c);
+    pcre_fullinfo(m_re->re, m_re->extra, PCRE_INFO_CAPTURECOUNT, &c);
   return c;
 }
 
@@ -239,7 +361,9 @@ std::string CRegExp::GetMatch(int iSub /* = 0 */)
 bool CRegExp::GetNamedSubPattern(const char* strName, std::string& strMatch)
 {
   strMatch.clear();
-  int iSub = pcre_get_stringnumber(m_re, strName);
+  if (!m_re)
+    return false;
+  int iSub = pcre_get_stringnumber(m_re->re, strName);
   if (iSub < 0)
     return false;
   strMatch = GetMatch(iSub);
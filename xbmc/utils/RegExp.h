@@ -23,8 +23,10 @@
 #ifndef REGEXP_H
 #define REGEXP_H
 
+#include <stdint.h>
 #include <string>
 #include <vector>
+#include "boost/shared_ptr.hpp"
 
 namespace PCRE {
 #ifdef _WIN32
@@ -39,9 +41,35 @@ namespace PCRE {
 // OVEVCOUNT must be a multiple of 3
 const int OVECCOUNT=(20+1)*3;
 
+struct CRegExpPattern;
+
+/*!
+ \brief Perl compatible regular expression matching.
+
+ Compiled (and studied) patterns are kept in a process wide cache keyed by the pattern
+ and its options, and are shared by all CRegExp objects using them, so callers may
+ construct and compile expressions as often as they like.
+ */
 class CRegExp
 {
 public:
+  /*! \brief Counters for the compiled pattern cache. Times are in microseconds.
+   */
+  struct CacheStats
+  {
+    CacheStats() : hits(0), compiles(0), compileTime(0), savedTime(0) {};
+    unsigned int hits;     ///< compilations answered from the cache
+    unsigned int compiles; ///< patterns compiled
+    int64_t compileTime;   ///< time spent compiling patterns
+    int64_t savedTime;     ///< time the cache hits would have spent compiling
+  };
+
+  static CacheStats GetCacheStats();
+
+  /*! \brief Log the cache counters accumulated since the given snapshot.
+   */
+  static void LogCacheStats(const CacheStats &since, const char *caller);
+
   CRegExp(bool caseless = false);
   CRegExp(const CRegExp& re);
   ~CRegExp();
@@ -69,10 +97,10 @@ public:
   const CRegExp& operator= (const CRegExp& re);
 
 private:
-  void Cleanup() { if (m_re) { PCRE::pcre_free(m_re); m_re = NULL; } }
+  void Cleanup() { m_re.reset(); }
 
 private:
-  PCRE::pcre* m_re;
+  boost::shared_ptr<CRegExpPattern> m_re;
   int         m_iOvector[OVECCOUNT];
   int         m_iMatchCount;
   int         m_iOptions;
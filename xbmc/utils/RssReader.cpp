@@ -27,6 +27,7 @@
 #include "URL.h"
 #include "filesystem/File.h"
 #include "filesystem/CurlFile.h"
+#include "filesystem/HttpCache.h"
 #if defined(TARGET_DARWIN)
 #include "CocoaInterface.h"
 #endif
@@ -167,7 +168,7 @@ void CRssReader::Process()
           }
         }
         else
-          if (http.Get(strUrl, strXML))
+          if (CHttpCache::Get().Fetch(http, strUrl, strXML))
           {
             CLog::Log(LOGDEBUG, "Got rss feed: %s", strUrl.c_str());
             break;
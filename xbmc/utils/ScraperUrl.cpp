@@ -26,6 +26,7 @@
 #include "CharsetConverter.h"
 #include "URL.h"
 #include "filesystem/CurlFile.h"
+#include "filesystem/HttpCache.h"
 #include "filesystem/ZipFile.h"
 #include "URIUtils.h"
 
@@ -223,7 +224,7 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, std::string& strHTML, XFILE::CCur
       return false;
   }
   else
-    if (!http.Get(url.Get(), strHTML1))
+    if (!XFILE::CHttpCache::Get().Fetch(http, url.Get(), strHTML1))
       return false;
 
   strHTML = strHTML1;
@@ -0,0 +1,250 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "SearchIndex.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+// a prefix match is worth this much of a whole word match
+#define PREFIX_MATCH_WEIGHT 0.6f
+
+static bool ResultGreater(const CSearchIndex::Result &lhs, const CSearchIndex::Result &rhs)
+{
+  if (lhs.score != rhs.score)
+    return lhs.score > rhs.score;
+  if (lhs.type != rhs.type)
+    return lhs.type < rhs.type;
+  return lhs.id < rhs.id;
+}
+
+static bool LongerWord(const string &lhs, const string &rhs)
+{
+  return lhs.size() > rhs.size();
+}
+
+CSearchIndex::CSearchIndex()
+{
+  m_built = false;
+}
+
+void CSearchIndex::Tokenize(const string &text, vector<string> &words)
+{
+  string word;
+  for (string::const_iterator i = text.begin(); i != text.end(); ++i)
+  {
+    unsigned char c = (unsigned char)*i;
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80)
+      word += (char)c;
+    else if (c >= 'A' && c <= 'Z')
+      word += (char)(c - 'A' + 'a');
+    else if (!word.empty())
+    {
+      words.push_back(word);
+      word.clear();
+    }
+  }
+  if (!word.empty())
+    words.push_back(word);
+}
+
+void CSearchIndex::AddDocument(int type, int id, const Fields &fields)
+{
+  // gather the weight of each term first, so that a term occuring in several
+  // fields gets a single posting
+  map<string, float> weights;
+  for (Fields::const_iterator field = fields.begin(); field != fields.end(); ++field)
+  {
+    vector<string> words;
+    Tokenize(field->text, words);
+    for (vector<string>::const_iterator word = words.begin(); word != words.end(); ++word)
+    {
+      float &weight = weights[*word];
+      weight = max(weight, field->weight);
+    }
+  }
+
+  CExclusiveLock lock(m_section);
+  map<pair<int, int>, unsigned int>::iterator existing = m_lookup.find(make_pair(type, id));
+  if (existing != m_lookup.end())
+    RemoveDocumentInternal(existing->second);
+
+  unsigned int doc;
+  if (!m_freeDocuments.empty())
+  {
+    doc = m_freeDocuments.back();
+    m_freeDocuments.pop_back();
+  }
+  else
+  {
+    doc = m_documents.size();
+    m_documents.push_back(Document());
+  }
+
+  Document &document = m_documents[doc];
+  document.type = type;
+  document.id = id;
+  document.terms.clear();
+  document.terms.reserve(weights.size());
+  for (map<string, float>::const_iterator i = weights.begin(); i != weights.end(); ++i)
+  {
+    Posting posting;
+    posting.doc = doc;
+    posting.weight = i->second;
+    m_terms[i->first].push_back(posting);
+    document.terms.push_back(i->first);
+  }
+  m_lookup[make_pair(type, id)] = doc;
+}
+
+void CSearchIndex::RemoveDocument(int type, int id)
+{
+  CExclusiveLock lock(m_section);
+  map<pair<int, int>, unsigned int>::iterator existing = m_lookup.find(make_pair(type, id));
+  if (existing != m_lookup.end())
+    RemoveDocumentInternal(existing->second);
+}
+
+void CSearchIndex::RemoveDocumentInternal(unsigned int doc)
+{
+  Document &document = m_documents[doc];
+  for (vector<string>::const_iterator term = document.terms.begin(); term != document.terms.end(); ++term)
+  {
+    TermMap::iterator postings = m_terms.find(*term);
+    if (postings == m_terms.end())
+      continue;
+    for (Postings::iterator i = postings->second.begin(); i != postings->second.end(); ++i)
+    {
+      if (i->doc == doc)
+      {
+        postings->second.erase(i);
+        break;
+      }
+    }
+    if (postings->second.empty())
+      m_terms.erase(postings);
+  }
+  m_lookup.erase(make_pair(document.type, document.id));
+  document.terms.clear();
+  document.type = -1;
+  m_freeDocuments.push_back(doc);
+}
+
+void CSearchIndex::Search(const string &query, int type, vector<Result> &results, unsigned int limit) const
+{
+  vector<string> words;
+  Tokenize(query, words);
+  if (words.empty())
+    return;
+  // longer words match fewer terms, so start with those to keep the candidate set small
+  sort(words.begin(), words.end(), LongerWord);
+
+  CSharedLock lock(m_section);
+  const float documents = (float)max((size_t)1, m_lookup.size());
+
+  // score of each candidate document, narrowed down by every word of the query
+  map<unsigned int, float> scores;
+  for (unsigned int w = 0; w < words.size(); w++)
+  {
+    const string &word = words[w];
+    map<unsigned int, float> wordScores;
+    for (TermMap::const_iterator term = m_terms.lower_bound(word);
+         term != m_terms.end() && term->first.compare(0, word.size(), word) == 0; ++term)
+    {
+      // rarer terms say more about a document
+      float idf = log(1.0f + documents / term->second.size());
+      float match = term->first.size() == word.size() ? 1.0f : PREFIX_MATCH_WEIGHT;
+      for (Postings::const_iterator posting = term->second.begin(); posting != term->second.end(); ++posting)
+      {
+        if (type >= 0 && m_documents[posting->doc].type != type)
+          continue;
+        if (w > 0 && scores.find(posting->doc) == scores.end())
+          continue;
+        float &score = wordScores[posting->doc];
+        score = max(score, posting->weight * match * idf);
+      }
+    }
+    if (w > 0)
+    {
+      for (map<unsigned int, float>::iterator i = wordScores.begin(); i != wordScores.end(); ++i)
+        i->second += scores[i->first];
+    }
+    scores.swap(wordScores);
+    if (scores.empty())
+      return;
+  }
+
+  size_t start = results.size();
+  results.reserve(start + scores.size());
+  for (map<unsigned int, float>::const_iterator i = scores.begin(); i != scores.end(); ++i)
+  {
+    Result result;
+    result.type = m_documents[i->first].type;
+    result.id = m_documents[i->first].id;
+    result.score = i->second;
+    results.push_back(result);
+  }
+  vector<Result>::iterator first = results.begin() + start;
+  if (limit && results.size() - start > limit)
+  {
+    partial_sort(first, first + limit, results.end(), ResultGreater);
+    results.resize(start + limit);
+  }
+  else
+    sort(first, results.end(), ResultGreater);
+}
+
+void CSearchIndex::Clear()
+{
+  CExclusiveLock lock(m_section);
+  m_terms.clear();
+  m_documents.clear();
+  m_freeDocuments.clear();
+  m_lookup.clear();
+  m_built = false;
+  m_source.clear();
+}
+
+bool CSearchIndex::IsBuilt() const
+{
+  CSharedLock lock(m_section);
+  return m_built;
+}
+
+bool CSearchIndex::IsBuiltFrom(const string &source) const
+{
+  CSharedLock lock(m_section);
+  return m_built && m_source == source;
+}
+
+void CSearchIndex::SetBuilt(const string &source)
+{
+  CExclusiveLock lock(m_section);
+  m_built = true;
+  m_source = source;
+}
+
+unsigned int CSearchIndex::Size() const
+{
+  CSharedLock lock(m_section);
+  return m_lookup.size();
+}
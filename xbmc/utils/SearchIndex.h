@@ -0,0 +1,154 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include "threads/CriticalSection.h"
+#include "threads/SharedSection.h"
+
+/*!
+ \brief In-memory inverted index over the text fields of library items.
+
+ Documents are identified by a caller defined type (eg. song, album) and their
+ database id, and consist of weighted text fields. Searches match every word of
+ the query against the start of words in the documents (so "beat ab" finds
+ "The Beatles - Abbey Road") and return the documents ranked by relevance.
+
+ The index is thread safe, so a single instance may be shared by all database
+ objects of a library, and updated incrementally as items are added. It records
+ what it was built from (see SetBuilt()), so that callers can rebuild it once
+ that's no longer the case, such as after a profile switch.
+ */
+class CSearchIndex
+{
+public:
+  struct Field
+  {
+    Field(const std::string &t, float w) : text(t), weight(w) {};
+    std::string text;
+    float weight;
+  };
+  typedef std::vector<Field> Fields;
+
+  struct Result
+  {
+    int type;
+    int id;
+    float score;
+  };
+
+  CSearchIndex();
+
+  /*! \brief Add (or replace) a document in the index.
+   \param type the caller defined type of the document.
+   \param id the database id of the document.
+   \param fields the text fields to index, with the weight a match in each should carry.
+   */
+  void AddDocument(int type, int id, const Fields &fields);
+
+  /*! \brief Remove a document from the index, if present.
+   */
+  void RemoveDocument(int type, int id);
+
+  /*! \brief Search the index.
+   \param query words to search for. Each word must match the start of a word in a document.
+   \param type only return documents of this type, or -1 for all types.
+   \param results [out] the matching documents, best match first.
+   \param limit maximum number of results to return (0 for no limit).
+   */
+  void Search(const std::string &query, int type, std::vector<Result> &results, unsigned int limit = 0) const;
+
+  /*! \brief Remove all documents and mark the index as not built.
+   */
+  void Clear();
+
+  /*! \brief Whether the index has been populated, see SetBuilt().
+   Callers populate the index in bulk on first use, and only update it incrementally afterwards.
+   */
+  bool IsBuilt() const;
+
+  /*! \brief Whether the index has been populated from the given source.
+   */
+  bool IsBuiltFrom(const std::string &source) const;
+
+  /*! \brief Mark the index as populated.
+   \param source identifies what the index was populated from, eg. the database and the state of its tables.
+   */
+  void SetBuilt(const std::string &source);
+
+  /*! \brief Held while the index is (re)built, so that callers build it only once.
+   */
+  CCriticalSection &GetBuildSection() { return m_buildSection; };
+
+  unsigned int Size() const;
+
+  /*! \brief Put the rows fetched for search results back into the order the results were ranked in.
+   \param order the ids of the results, best match first.
+   \param items [in/out] the id and item of each row fetched. Items whose id isn't in order are dropped.
+   */
+  template<class T>
+  static void SortByOrder(const std::vector<int> &order, std::vector<std::pair<int, T> > &items)
+  {
+    std::map<int, T> byId(items.begin(), items.end());
+    items.clear();
+    for (std::vector<int>::const_iterator i = order.begin(); i != order.end(); ++i)
+    {
+      typename std::map<int, T>::const_iterator item = byId.find(*i);
+      if (item != byId.end())
+        items.push_back(*item);
+    }
+  }
+
+  /*! \brief Split text into lowercased words for indexing or searching.
+   Any byte that isn't an ASCII letter or digit separates words, except for UTF-8
+   sequences which are kept as part of the word.
+   */
+  static void Tokenize(const std::string &text, std::vector<std::string> &words);
+
+private:
+  struct Posting
+  {
+    unsigned int doc;
+    float weight;
+  };
+  typedef std::vector<Posting> Postings;
+  typedef std::map<std::string, Postings> TermMap;
+
+  struct Document
+  {
+    int type;
+    int id;
+    std::vector<std::string> terms;
+  };
+
+  void RemoveDocumentInternal(unsigned int doc);
+
+  TermMap m_terms;
+  std::vector<Document> m_documents;
+  std::vector<unsigned int> m_freeDocuments;
+  std::map<std::pair<int, int>, unsigned int> m_lookup;
+  bool m_built;
+  std::string m_source;
+  CSharedSection m_section;
+  CCriticalSection m_buildSection;
+};
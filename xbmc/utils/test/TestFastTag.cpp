@@ -0,0 +1,197 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "music/tags/FastTag.h"
+#include "music/tags/MusicInfoTag.h"
+#include "threads/SystemClock.h"
+#include "utils/test/TestHelpers.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace MUSIC_INFO;
+using namespace xbmcutil::test;
+
+static std::string SyncSafe32(unsigned int value)
+{
+  char bytes[4] = { (char)((value >> 21) & 0x7f), (char)((value >> 14) & 0x7f), (char)((value >> 7) & 0x7f), (char)(value & 0x7f) };
+  return std::string(bytes, 4);
+}
+
+// an ID3v2.4 text frame, in UTF-8
+static std::string ID3TextFrame(const char *id, const std::string &text)
+{
+  std::string body = "\x03" + text;
+  return std::string(id, 4) + SyncSafe32(body.size()) + std::string(2, '\0') + body;
+}
+
+// an ID3v2 tag of the given version holding the frames, followed by three MPEG-1 layer III
+// frames at 128kbps and 44.1kHz. The first holds a Xing header for 11025 frames, or 288 seconds.
+static std::string MP3File(int version, const std::string &frames, unsigned char flags = 0)
+{
+  std::string file = "ID3";
+  file += (char)version;
+  file += '\0';
+  file += (char)flags;
+  file += SyncSafe32(frames.size()) + frames;
+  for (int i = 0; i < 3; i++)
+  {
+    std::string frame("\xff\xfb\x90\x00", 4);
+    frame.resize(417, '\0');
+    if (i == 0)
+      frame.replace(36, 12, "Xing" + BE32(1) + BE32(11025));
+    file += frame;
+  }
+  return file;
+}
+
+static std::string VorbisComment(const char **comments, unsigned int count)
+{
+  std::string body = LE32(4) + "test" + LE32(count);
+  for (unsigned int i = 0; i < count; i++)
+    body += LE32(strlen(comments[i])) + comments[i];
+  return body;
+}
+
+static const char *vorbisComments[] = { "TITLE=Title", "ARTIST=Artist", "ALBUM=Album", "TRACKNUMBER=3" };
+
+// a flac file of 200 seconds at 44.1kHz with a VORBIS_COMMENT block
+static std::string FlacFile()
+{
+  std::string info(34, '\0');
+  info[10] = (char)0x0a; info[11] = (char)0xc4; info[12] = (char)0x40; // 44100Hz
+  info[15] = (char)0x86; info[16] = (char)0x95; info[17] = (char)0x20; // 8820000 samples
+  std::string comment = VorbisComment(vorbisComments, 4);
+
+  std::string file = "fLaC";
+  file += std::string("\x00\x00\x00", 3) + (char)info.size() + info;
+  file += std::string("\x84\x00", 2) + (char)(comment.size() >> 8) + (char)comment.size() + comment;
+  file += std::string(1000, '\0'); // the audio
+  return file;
+}
+
+static std::string OggPage(unsigned int sequence, unsigned int granule, const std::string &packet)
+{
+  std::string page = "OggS";
+  page += '\0';
+  page += (char)(sequence == 0 ? 2 : 0);
+  page += LE32(granule) + LE32(0) + LE32(0x1234) + LE32(sequence) + LE32(0);
+  page += (char)1;
+  page += (char)packet.size();
+  return page + packet;
+}
+
+// an ogg vorbis file of 100 seconds at 44.1kHz
+static std::string OggFile()
+{
+  std::string identification = std::string("\x01vorbis", 7) + LE32(0) + (char)2 + LE32(44100) + std::string(14, '\0');
+  std::string comment = std::string("\x03vorbis", 7) + VorbisComment(vorbisComments, 4) + (char)1;
+  return OggPage(0, 0, identification) + OggPage(1, 0, comment) + OggPage(2, 4410000, std::string(200, '\0'));
+}
+
+static bool ReadTag(const TempFile &file, CMusicInfoTag &tag)
+{
+  CFastTag reader;
+  if (!reader.Read(file.Path()))
+    return false;
+  reader.GetMusicInfoTag(tag);
+  return true;
+}
+
+static void CheckTag(const CMusicInfoTag &tag, int duration)
+{
+  BOOST_CHECK_EQUAL(tag.GetTitle(), "Title");
+  BOOST_REQUIRE_EQUAL(tag.GetArtist().size(), 1U);
+  BOOST_CHECK_EQUAL(tag.GetArtist()[0], "Artist");
+  BOOST_CHECK_EQUAL(tag.GetAlbum(), "Album");
+  BOOST_CHECK_EQUAL(tag.GetTrackNumber(), 3);
+  BOOST_CHECK_EQUAL(tag.GetDuration(), duration);
+  BOOST_CHECK(tag.Loaded());
+}
+
+BOOST_AUTO_TEST_CASE(TestFastTagMP3)
+{
+  TempFile file(".mp3", MP3File(4, ID3TextFrame("TIT2", "Title") + ID3TextFrame("TPE1", "Artist") +
+                                   ID3TextFrame("TALB", "Album") + ID3TextFrame("TRCK", "3/12") +
+                                   ID3TextFrame("TDRC", "2004")));
+  CMusicInfoTag tag;
+  BOOST_REQUIRE(ReadTag(file, tag));
+  CheckTag(tag, 288);
+  BOOST_CHECK_EQUAL(tag.GetYear(), 2004);
+}
+
+BOOST_AUTO_TEST_CASE(TestFastTagMP3ArtistFallback)
+{
+  // without a TPE1 frame the artist comes from the next performer frame, as with libid3tag
+  TempFile file(".mp3", MP3File(4, ID3TextFrame("TIT2", "Title") + ID3TextFrame("TPE2", "Band")));
+  CMusicInfoTag tag;
+  BOOST_REQUIRE(ReadTag(file, tag));
+  BOOST_REQUIRE_EQUAL(tag.GetArtist().size(), 1U);
+  BOOST_CHECK_EQUAL(tag.GetArtist()[0], "Band");
+}
+
+BOOST_AUTO_TEST_CASE(TestFastTagMP3Unsupported)
+{
+  // ID3v2.2 tags and unsynchronised tags are left to the full loader
+  TempFile v22(".mp3", MP3File(2, ""));
+  TempFile unsynchronised(".mp3", MP3File(4, ID3TextFrame("TIT2", "Title"), 0x80));
+  CMusicInfoTag tag;
+  BOOST_CHECK(!ReadTag(v22, tag));
+  BOOST_CHECK(!ReadTag(unsynchronised, tag));
+}
+
+BOOST_AUTO_TEST_CASE(TestFastTagFlac)
+{
+  TempFile file(".flac", FlacFile());
+  CMusicInfoTag tag;
+  BOOST_REQUIRE(ReadTag(file, tag));
+  CheckTag(tag, 200);
+}
+
+BOOST_AUTO_TEST_CASE(TestFastTagOgg)
+{
+  TempFile file(".ogg", OggFile());
+  CMusicInfoTag tag;
+  BOOST_REQUIRE(ReadTag(file, tag));
+  CheckTag(tag, 100);
+}
+
+BOOST_AUTO_TEST_CASE(TestFastTagThroughput)
+{
+  TempFile mp3(".mp3", MP3File(4, ID3TextFrame("TIT2", "Title") + ID3TextFrame("TPE1", "Artist") +
+                                  ID3TextFrame("TALB", "Album") + ID3TextFrame("TRCK", "3")));
+  TempFile flac(".flac", FlacFile());
+  TempFile ogg(".ogg", OggFile());
+  const TempFile *files[] = { &mp3, &flac, &ogg };
+  const char *names[] = { "mp3", "flac", "ogg" };
+
+  const unsigned int reads = 2000;
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int j = 0; j < reads; j++)
+    {
+      CFastTag reader;
+      BOOST_REQUIRE(reader.Read(files[i]->Path()));
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+    BOOST_TEST_MESSAGE(names[i] << ": " << reads << " tags read in " << elapsed << " ms");
+  }
+}
@@ -0,0 +1,75 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+namespace xbmcutil
+{
+  namespace test
+  {
+    /*!
+     \brief A file written with the given contents under the temp folder, and removed again
+     when it goes out of scope. The extension is kept, as the readers under test choose by it.
+     */
+    class TempFile
+    {
+    public:
+      TempFile(const std::string &extension, const std::string &contents)
+      {
+        static unsigned int count = 0;
+        const char *dir = getenv("TMPDIR");
+        char name[64];
+        snprintf(name, sizeof(name), "/xbmctest-%d-%u", (int)getpid(), count++);
+        path = std::string(dir ? dir : "/tmp") + name + extension;
+
+        FILE *file = fopen(path.c_str(), "wb");
+        if (file)
+        {
+          fwrite(contents.data(), 1, contents.size(), file);
+          fclose(file);
+        }
+      }
+      ~TempFile() { remove(path.c_str()); }
+
+      const std::string &Path() const { return path; }
+
+    private:
+      std::string path;
+    };
+
+    inline std::string BE32(unsigned int value)
+    {
+      char bytes[4] = { (char)(value >> 24), (char)(value >> 16), (char)(value >> 8), (char)value };
+      return std::string(bytes, 4);
+    }
+
+    inline std::string LE32(unsigned int value)
+    {
+      char bytes[4] = { (char)value, (char)(value >> 8), (char)(value >> 16), (char)(value >> 24) };
+      return std::string(bytes, 4);
+    }
+  }
+}
@@ -0,0 +1,284 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StreamDetailsDatabase.h"
+#include "TextureCacheJob.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "utils/StreamDetails.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+using namespace XFILE;
+
+CStreamDetailsDatabase::CStreamDetailsDatabase()
+{
+}
+
+CStreamDetailsDatabase::~CStreamDetailsDatabase()
+{
+}
+
+bool CStreamDetailsDatabase::Open()
+{
+  return CDatabase::Open();
+}
+
+bool CStreamDetailsDatabase::CreateTables()
+{
+  try
+  {
+    CDatabase::CreateTables();
+
+    CLog::Log(LOGINFO, "create file table");
+    m_pDS->exec("CREATE TABLE file (idFile integer primary key, strPath text, strStamp text, iDuration integer, "
+                "strThumb text, iThumbWidth integer, iThumbHeight integer)");
+    m_pDS->exec("CREATE UNIQUE INDEX ix_file ON file (strPath)");
+
+    // the same layout as the streamdetails table of the video database
+    CLog::Log(LOGINFO, "create streamdetails table");
+    m_pDS->exec("CREATE TABLE streamdetails (idFile integer, iStreamType integer, "
+                "strVideoCodec text, fVideoAspect float, iVideoWidth integer, iVideoHeight integer, "
+                "strAudioCodec text, iAudioChannels integer, strAudioLanguage text, strSubtitleLanguage text, iVideoDuration integer)");
+    m_pDS->exec("CREATE INDEX ix_streamdetails ON streamdetails (idFile)");
+    m_pDS->exec("CREATE TRIGGER delete_file AFTER DELETE ON file FOR EACH ROW BEGIN DELETE FROM streamdetails WHERE idFile=old.idFile; END");
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s unable to create tables", __FUNCTION__);
+    return false;
+  }
+
+  return true;
+}
+
+bool CStreamDetailsDatabase::UpdateOldVersion(int version)
+{
+  return true;
+}
+
+bool CStreamDetailsDatabase::GetFileStamp(const CStdString &path, CStdString &stamp)
+{
+  // only plain files on filesystems that keep modification times
+  if (URIUtils::IsStack(path) || URIUtils::IsInArchive(path) ||
+     !(URIUtils::IsHD(path) || URIUtils::IsSmb(path) || URIUtils::IsNfs(path)))
+    return false;
+
+  struct __stat64 info;
+  if (CFile::Stat(path, &info) != 0 || info.st_size <= 0)
+    return false;
+
+  // a file written within the second it is probed may keep the same stamp after further changes
+  if (info.st_mtime >= time(NULL) - 1)
+    return false;
+
+  stamp.Format("%"PRId64"/%"PRId64, (int64_t)info.st_size, (int64_t)info.st_mtime);
+  return true;
+}
+
+int CStreamDetailsDatabase::AddFile(const CStdString &path, const CStdString &stamp)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return -1;
+    if (NULL == m_pDS.get()) return -1;
+
+    m_pDS->query(PrepareSQL("SELECT idFile, strStamp FROM file WHERE strPath='%s'", path.c_str()).c_str());
+    if (!m_pDS->eof())
+    {
+      int idFile = m_pDS->fv(0).get_asInt();
+      bool changed = m_pDS->fv(1).get_asString() != stamp;
+      m_pDS->close();
+      if (changed)
+      { // the file has changed, so nothing we know about it holds
+        m_pDS->exec(PrepareSQL("DELETE FROM streamdetails WHERE idFile=%i", idFile));
+        m_pDS->exec(PrepareSQL("UPDATE file SET strStamp='%s', iDuration=NULL, strThumb=NULL, iThumbWidth=NULL, iThumbHeight=NULL WHERE idFile=%i", stamp.c_str(), idFile));
+      }
+      return idFile;
+    }
+    m_pDS->close();
+
+    m_pDS->exec(PrepareSQL("INSERT INTO file (idFile, strPath, strStamp) VALUES (NULL, '%s', '%s')", path.c_str(), stamp.c_str()));
+    return (int)m_pDS->lastinsertid();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed on path '%s'", __FUNCTION__, path.c_str());
+  }
+  return -1;
+}
+
+bool CStreamDetailsDatabase::GetStreamDetails(const CStdString &path, const CStdString &stamp, CStreamDetails &details, int &duration)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    m_pDS->query(PrepareSQL("SELECT idFile, iDuration FROM file WHERE strPath='%s' AND strStamp='%s'", path.c_str(), stamp.c_str()).c_str());
+    if (m_pDS->eof() || m_pDS->fv(1).get_isNull())
+    {
+      m_pDS->close();
+      return false;
+    }
+    int idFile = m_pDS->fv(0).get_asInt();
+    duration = m_pDS->fv(1).get_asInt();
+    m_pDS->close();
+
+    details.Reset();
+    m_pDS->query(PrepareSQL("SELECT * FROM streamdetails WHERE idFile=%i", idFile).c_str());
+    while (!m_pDS->eof())
+    {
+      CStreamDetail::StreamType e = (CStreamDetail::StreamType)m_pDS->fv(1).get_asInt();
+      switch (e)
+      {
+      case CStreamDetail::VIDEO:
+        {
+          CStreamDetailVideo *p = new CStreamDetailVideo();
+          p->m_strCodec = m_pDS->fv(2).get_asString();
+          p->m_fAspect = m_pDS->fv(3).get_asFloat();
+          p->m_iWidth = m_pDS->fv(4).get_asInt();
+          p->m_iHeight = m_pDS->fv(5).get_asInt();
+          p->m_iDuration = m_pDS->fv(10).get_asInt();
+          details.AddStream(p);
+          break;
+        }
+      case CStreamDetail::AUDIO:
+        {
+          CStreamDetailAudio *p = new CStreamDetailAudio();
+          p->m_strCodec = m_pDS->fv(6).get_asString();
+          p->m_iChannels = m_pDS->fv(7).get_asInt();
+          p->m_strLanguage = m_pDS->fv(8).get_asString();
+          details.AddStream(p);
+          break;
+        }
+      case CStreamDetail::SUBTITLE:
+        {
+          CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
+          p->m_strLanguage = m_pDS->fv(9).get_asString();
+          details.AddStream(p);
+          break;
+        }
+      }
+      m_pDS->next();
+    }
+    m_pDS->close();
+    details.DetermineBestStreams();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed on path '%s'", __FUNCTION__, path.c_str());
+  }
+  return false;
+}
+
+void CStreamDetailsDatabase::SetStreamDetails(const CStdString &path, const CStdString &stamp, const CStreamDetails &details, int duration)
+{
+  try
+  {
+    BeginTransaction();
+    int idFile = AddFile(path, stamp);
+    if (idFile < 0)
+    {
+      RollbackTransaction();
+      return;
+    }
+
+    m_pDS->exec(PrepareSQL("DELETE FROM streamdetails WHERE idFile=%i", idFile));
+    for (int i=1; i<=details.GetVideoStreamCount(); i++)
+    {
+      m_pDS->exec(PrepareSQL("INSERT INTO streamdetails "
+        "(idFile, iStreamType, strVideoCodec, fVideoAspect, iVideoWidth, iVideoHeight, iVideoDuration) "
+        "VALUES (%i,%i,'%s',%f,%i,%i,%i)",
+        idFile, (int)CStreamDetail::VIDEO,
+        details.GetVideoCodec(i).c_str(), details.GetVideoAspect(i),
+        details.GetVideoWidth(i), details.GetVideoHeight(i), details.GetVideoDuration(i)));
+    }
+    for (int i=1; i<=details.GetAudioStreamCount(); i++)
+    {
+      m_pDS->exec(PrepareSQL("INSERT INTO streamdetails "
+        "(idFile, iStreamType, strAudioCodec, iAudioChannels, strAudioLanguage) "
+        "VALUES (%i,%i,'%s',%i,'%s')",
+        idFile, (int)CStreamDetail::AUDIO,
+        details.GetAudioCodec(i).c_str(), details.GetAudioChannels(i),
+        details.GetAudioLanguage(i).c_str()));
+    }
+    for (int i=1; i<=details.GetSubtitleStreamCount(); i++)
+    {
+      m_pDS->exec(PrepareSQL("INSERT INTO streamdetails "
+        "(idFile, iStreamType, strSubtitleLanguage) "
+        "VALUES (%i,%i,'%s')",
+        idFile, (int)CStreamDetail::SUBTITLE,
+        details.GetSubtitleLanguage(i).c_str()));
+    }
+    m_pDS->exec(PrepareSQL("UPDATE file SET iDuration=%i WHERE idFile=%i", duration, idFile));
+
+    CommitTransaction();
+  }
+  catch (...)
+  {
+    RollbackTransaction();
+    CLog::Log(LOGERROR, "%s failed on path '%s'", __FUNCTION__, path.c_str());
+  }
+}
+
+bool CStreamDetailsDatabase::GetThumb(const CStdString &path, const CStdString &stamp, CTextureDetails &thumb)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    m_pDS->query(PrepareSQL("SELECT strThumb, iThumbWidth, iThumbHeight FROM file WHERE strPath='%s' AND strStamp='%s'", path.c_str(), stamp.c_str()).c_str());
+    bool found = !m_pDS->eof() && !m_pDS->fv(0).get_asString().empty();
+    if (found)
+    {
+      thumb.file = m_pDS->fv(0).get_asString();
+      thumb.width = m_pDS->fv(1).get_asInt();
+      thumb.height = m_pDS->fv(2).get_asInt();
+    }
+    m_pDS->close();
+    return found;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed on path '%s'", __FUNCTION__, path.c_str());
+  }
+  return false;
+}
+
+void CStreamDetailsDatabase::SetThumb(const CStdString &path, const CStdString &stamp, const CTextureDetails &thumb)
+{
+  try
+  {
+    BeginTransaction();
+    int idFile = AddFile(path, stamp);
+    if (idFile >= 0)
+      m_pDS->exec(PrepareSQL("UPDATE file SET strThumb='%s', iThumbWidth=%u, iThumbHeight=%u WHERE idFile=%i", thumb.file.c_str(), thumb.width, thumb.height, idFile));
+    CommitTransaction();
+  }
+  catch (...)
+  {
+    RollbackTransaction();
+    CLog::Log(LOGERROR, "%s failed on path '%s'", __FUNCTION__, path.c_str());
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "dbwrappers/Database.h"
+
+class CStreamDetails;
+class CTextureDetails;
+
+/*!
+ \brief Cache of what was found by probing video files, kept apart from the video library.
+
+ Probing a file for its stream details or a thumb means opening a demuxer (and a decoder
+ for thumbs), which is slow. The results are kept here against the path of the file along
+ with its size and modification time, so they survive the file being removed from and
+ re-added to the library, or the library being rebuilt, and are only thrown away when the
+ file itself changes.
+ */
+class CStreamDetailsDatabase : public CDatabase
+{
+public:
+  CStreamDetailsDatabase();
+  virtual ~CStreamDetailsDatabase();
+  virtual bool Open();
+
+  /*! \brief Get the stamp identifying the current contents of a file.
+   Only plain files on filesystems with reliable modification times have one.
+   \param path the file.
+   \param stamp [out] the size and modification time of the file.
+   \return true if the file can be cached.
+   */
+  static bool GetFileStamp(const CStdString &path, CStdString &stamp);
+
+  /*! \brief Get the stream details and duration of a file, if they were found while it had the given stamp.
+   \param duration [out] the duration of the file in ms, as given by the demuxer.
+   */
+  bool GetStreamDetails(const CStdString &path, const CStdString &stamp, CStreamDetails &details, int &duration);
+  void SetStreamDetails(const CStdString &path, const CStdString &stamp, const CStreamDetails &details, int duration);
+
+  /*! \brief Get the thumb extracted from a file, if it was extracted while it had the given stamp.
+   \param thumb [out] the file and size of the thumb in the texture cache.
+   */
+  bool GetThumb(const CStdString &path, const CStdString &stamp, CTextureDetails &thumb);
+  void SetThumb(const CStdString &path, const CStdString &stamp, const CTextureDetails &thumb);
+
+protected:
+  /*! \brief Get the id of a file, adding it or forgetting what was known about it if its stamp has changed.
+   */
+  int AddFile(const CStdString &path, const CStdString &stamp);
+
+  virtual bool CreateTables();
+  virtual bool UpdateOldVersion(int version);
+  virtual int GetMinVersion() const { return 1; };
+  const char *GetBaseDBName() const { return "StreamDetails"; };
+};
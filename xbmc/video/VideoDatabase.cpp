@@ -20,6 +20,7 @@
  */
 
 #include "threads/SystemClock.h"
+#include "threads/SingleLock.h"
 #include "VideoDatabase.h"
 #include "video/windows/GUIWindowVideoBase.h"
 #include "utils/RegExp.h"
@@ -28,6 +29,8 @@
 #include "Util.h"
 #include "utils/URIUtils.h"
 #include "utils/XMLUtils.h"
+#include "utils/SearchIndex.h"
+#include "utils/FileExistenceChecker.h"
 #include "GUIPassword.h"
 #include "filesystem/StackDirectory.h"
 #include "filesystem/MultiPathDirectory.h"
@@ -63,9 +66,22 @@ using namespace VIDEO;
 using namespace ADDON;
 using namespace PVR;
 
+// the most results a search fetches of each type, which bounds the id lists queried for them
+#define SEARCH_INDEX_LIMIT 1000
+
+// shared by all CVideoDatabase instances, so the scanner keeps it current for the GUI
+static CSearchIndex &GetVideoSearchIndex()
+{
+  static CSearchIndex index;
+  return index;
+}
+
 //********************************************************************************************************************************
 CVideoDatabase::CVideoDatabase(void)
 {
+  m_cacheHits = 0;
+  m_cacheMisses = 0;
+  m_lookupCacheActive = false;
 }
 
 //********************************************************************************************************************************
@@ -165,8 +181,9 @@ bool CVideoDatabase::CreateTables()
     m_pDS->exec("CREATE UNIQUE INDEX ix_path ON path ( strPath(255) )");
 
     CLog::Log(LOGINFO, "create files table");
-    m_pDS->exec("CREATE TABLE files ( idFile integer primary key, idPath integer, strFilename text, playCount integer, lastPlayed text, dateAdded text)");
+    m_pDS->exec("CREATE TABLE files ( idFile integer primary key, idPath integer, strFilename text, playCount integer, lastPlayed text, dateAdded text, strFingerprint text)");
     m_pDS->exec("CREATE UNIQUE INDEX ix_files ON files ( idPath, strFilename(255) )");
+    m_pDS->exec("CREATE INDEX ix_files_fingerprint ON files ( strFingerprint(255) )");
 
     CLog::Log(LOGINFO, "create tvshow table");
     columns = "CREATE TABLE tvshow ( idShow integer primary key";
@@ -335,6 +352,10 @@ bool CVideoDatabase::CreateTables()
     m_pDS->exec("CREATE UNIQUE INDEX ix_taglinks_2 ON taglinks (idMedia, media_type(20), idTag)");
     m_pDS->exec("CREATE INDEX ix_taglinks_3 ON taglinks (media_type(20))");
 
+    CLog::Log(LOGINFO, "create searchgeneration table");
+    m_pDS->exec("CREATE TABLE searchgeneration (idGeneration integer)");
+    m_pDS->exec("INSERT INTO searchgeneration (idGeneration) VALUES (0)");
+
     // we create views last to ensure all indexes are rolled in
     CreateViews();
   }
@@ -541,6 +562,205 @@ bool CVideoDatabase::GetPaths(set<CStdString> &paths)
   return false;
 }
 
+void CVideoDatabase::SetFileFingerprint(const CStdString &strFileNameAndPath, const CStdString &fingerprint)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return;
+    if (NULL == m_pDS.get()) return;
+
+    int idFile = GetFileId(strFileNameAndPath);
+    if (idFile < 0)
+      return;
+
+    CStdString strSQL = PrepareSQL("update files set strFingerprint='%s' where idFile=%i", fingerprint.c_str(), idFile);
+    m_pDS->exec(strSQL.c_str());
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, strFileNameAndPath.c_str());
+  }
+}
+
+bool CVideoDatabase::GetFilesWithoutFingerprint(vector<CStdString> &files, unsigned int limit)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    files.clear();
+
+    // only files that are in the library as a movie, episode or music video, skipping those
+    // that have been tried already (an empty fingerprint) and those that can't be fingerprinted
+    CStdString strSQL = PrepareSQL("select path.strPath,files.strFileName from files join path on files.idPath=path.idPath"
+                                   " where files.strFingerprint is NULL"
+                                   " and files.strFileName not like 'stack://%%'"
+                                   " and path.strPath not like 'zip://%%' and path.strPath not like 'rar://%%'"
+                                   " and (files.idFile in (select idFile from movie)"
+                                   "   or files.idFile in (select idFile from episode)"
+                                   "   or files.idFile in (select idFile from musicvideo))"
+                                   " order by files.idFile limit %u", limit);
+    if (!m_pDS->query(strSQL.c_str()))
+      return false;
+
+    while (!m_pDS->eof())
+    {
+      CStdString file;
+      ConstructPath(file, m_pDS->fv(0).get_asString(), m_pDS->fv(1).get_asString());
+      files.push_back(file);
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+bool CVideoDatabase::RelinkMovedFile(const CStdString &strFileNameAndPath, const CStdString &fingerprint, const CStdString &type, int idShow /* = -1 */)
+{
+  CStdString strSQL;
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    int basePathColumn, parentPathColumn;
+    if (type == "movie")
+    {
+      basePathColumn = VIDEODB_ID_BASEPATH;
+      parentPathColumn = VIDEODB_ID_PARENTPATHID;
+    }
+    else if (type == "episode")
+    {
+      basePathColumn = VIDEODB_ID_EPISODE_BASEPATH;
+      parentPathColumn = VIDEODB_ID_EPISODE_PARENTPATHID;
+    }
+    else if (type == "musicvideo")
+    {
+      basePathColumn = VIDEODB_ID_MUSICVIDEO_BASEPATH;
+      parentPathColumn = VIDEODB_ID_MUSICVIDEO_PARENTPATHID;
+    }
+    else
+      return false;
+
+    if (fingerprint.IsEmpty())
+      return false;
+
+    // a file entry may already exist at the new path, e.g. from a bookmark kept when the file was
+    // played before it was scanned. it is only replaced if it isn't in the library itself.
+    int idExisting = GetFileId(strFileNameAndPath);
+    if (idExisting >= 0)
+    {
+      strSQL = PrepareSQL("select (select count(*) from movie where idFile=%i)"
+                          " + (select count(*) from episode where idFile=%i)"
+                          " + (select count(*) from musicvideo where idFile=%i)", idExisting, idExisting, idExisting);
+      if (!m_pDS->query(strSQL.c_str()))
+        return false;
+      bool inLibrary = !m_pDS->eof() && m_pDS->fv(0).get_asInt() > 0;
+      m_pDS->close();
+      if (inLibrary)
+        return false; // the file is already in the library under its own path
+    }
+
+    strSQL = PrepareSQL("select files.idFile,path.strPath,files.strFileName from files"
+                        " join path on files.idPath=path.idPath"
+                        " join %s on %s.idFile=files.idFile"
+                        " where files.strFingerprint='%s'", type.c_str(), type.c_str(), fingerprint.c_str());
+    if (type == "episode" && idShow >= 0)
+      strSQL += PrepareSQL(" and episode.idShow=%i", idShow);
+    if (!m_pDS->query(strSQL.c_str()))
+      return false;
+
+    vector< pair<int, CStdString> > candidates;
+    while (!m_pDS->eof())
+    {
+      CStdString oldPath;
+      ConstructPath(oldPath, m_pDS->fv(1).get_asString(), m_pDS->fv(2).get_asString());
+      candidates.push_back(make_pair(m_pDS->fv(0).get_asInt(), oldPath));
+      m_pDS->next();
+    }
+    m_pDS->close();
+    if (candidates.empty())
+      return false;
+
+    // the folders content was set on, which the library's files were scanned from
+    vector<CStdString> roots;
+    if (!m_pDS->query("select strPath from path where strContent != '' and strPath not like 'multipath://%'"))
+      return false;
+    while (!m_pDS->eof())
+    {
+      roots.push_back(m_pDS->fv(0).get_asString());
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    // a file with the same contents is only taken to have moved here if it is gone from where it was.
+    // a missing file in a source that can't be reached (e.g. an offline share) hasn't moved.
+    int idFile = -1;
+    CStdString oldPath;
+    for (vector< pair<int, CStdString> >::const_iterator i = candidates.begin(); i != candidates.end() && idFile < 0; ++i)
+    {
+      CStdString root;
+      for (vector<CStdString>::const_iterator j = roots.begin(); j != roots.end(); ++j)
+      {
+        if (j->size() > root.size() && URIUtils::IsInPath(i->second, *j))
+          root = *j;
+      }
+      if (root.IsEmpty() || !CDirectory::Exists(root))
+        continue;
+      if (!CFile::Exists(i->second, false))
+      {
+        idFile = i->first;
+        oldPath = i->second;
+      }
+    }
+    if (idFile < 0)
+      return false;
+
+    CStdString strPath, strFileName;
+    SplitPath(strFileNameAndPath, strPath, strFileName);
+
+    CFileItem item(strFileNameAndPath, false);
+    CStdString basePath = item.GetBaseMoviePath(LookupByFolders(strPath));
+
+    BeginTransaction();
+    int idPath = AddPath(strPath);
+    int idParentPath = AddPath(URIUtils::GetParentPath(basePath));
+    if (idPath < 0 || idParentPath < 0)
+    {
+      RollbackTransaction();
+      return false;
+    }
+    if (idExisting >= 0)
+    {
+      m_pDS->exec(PrepareSQL("delete from streamdetails where idFile=%i", idExisting));
+      m_pDS->exec(PrepareSQL("delete from bookmark where idFile=%i", idExisting));
+      m_pDS->exec(PrepareSQL("delete from settings where idFile=%i", idExisting));
+      m_pDS->exec(PrepareSQL("delete from stacktimes where idFile=%i", idExisting));
+      m_pDS->exec(PrepareSQL("delete from files where idFile=%i", idExisting));
+    }
+    strSQL = PrepareSQL("update files set idPath=%i, strFileName='%s' where idFile=%i", idPath, strFileName.c_str(), idFile);
+    m_pDS->exec(strSQL.c_str());
+    strSQL = PrepareSQL("update %s set c%02d='%s', c%02d=%i where idFile=%i", type.c_str(), basePathColumn, basePath.c_str(), parentPathColumn, idParentPath, idFile);
+    m_pDS->exec(strSQL.c_str());
+    CommitTransaction();
+
+    CLog::Log(LOGDEBUG, "%s relinked %s from %s to %s", __FUNCTION__, type.c_str(), oldPath.c_str(), strFileNameAndPath.c_str());
+    return true;
+  }
+  catch (...)
+  {
+    RollbackTransaction();
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, strSQL.c_str());
+  }
+  return false;
+}
+
 bool CVideoDatabase::GetPathsForTvShow(int idShow, set<int>& paths)
 {
   CStdString strSQL;
@@ -1248,6 +1468,21 @@ int CVideoDatabase::AddToTable(const CStdString& table, const CStdString& firstF
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
 
+    // values are matched case insensitively (LIKE), so key the cache the same way
+    CStdString key(value);
+    key.ToLower();
+    std::map<CStdString, int> *cache = m_lookupCacheActive ? &m_lookupCache[table] : NULL;
+    if (cache)
+    {
+      std::map<CStdString, int>::const_iterator it = cache->find(key);
+      if (it != cache->end())
+      {
+        m_cacheHits++;
+        return it->second;
+      }
+      m_cacheMisses++;
+    }
+
     CStdString strSQL = PrepareSQL("select %s from %s where %s like '%s'", firstField.c_str(), table.c_str(), secondField.c_str(), value.c_str());
     m_pDS->query(strSQL.c_str());
     if (m_pDS->num_rows() == 0)
@@ -1257,12 +1492,16 @@ int CVideoDatabase::AddToTable(const CStdString& table, const CStdString& firstF
       strSQL = PrepareSQL("insert into %s (%s, %s) values(NULL, '%s')", table.c_str(), firstField.c_str(), secondField.c_str(), value.c_str());      
       m_pDS->exec(strSQL.c_str());
       int id = (int)m_pDS->lastinsertid();
+      if (cache)
+        cache->insert(make_pair(key, id));
       return id;
     }
     else
     {
       int id = m_pDS->fv(firstField).get_asInt();
       m_pDS->close();
+      if (cache)
+        cache->insert(make_pair(key, id));
       return id;
     }
   }
@@ -1303,6 +1542,59 @@ int CVideoDatabase::AddCountry(const CStdString& strCountry)
   return AddToTable("country", "idCountry", "strCountry", strCountry);
 }
 
+void CVideoDatabase::EmptyCache()
+{
+  if (m_cacheHits || m_cacheMisses)
+    CLog::Log(LOGDEBUG, "%s - lookup cache: %u hits, %u misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
+  m_cacheHits = m_cacheMisses = 0;
+  m_lookupCache.clear();
+  m_lookupCacheActive = false;
+}
+
+void CVideoDatabase::PreloadCaches()
+{
+  static const struct { const char *table; const char *idField; const char *valueField; } lookups[] =
+  { { "actors",  "idActor",   "strActor"   },
+    { "genre",   "idGenre",   "strGenre"   },
+    { "studio",  "idStudio",  "strStudio"  },
+    { "country", "idCountry", "strCountry" },
+    { "sets",    "idSet",     "strSet"     },
+    { "tag",     "idTag",     "strTag"     } };
+
+  try
+  {
+    if (NULL == m_pDB.get()) return;
+    if (NULL == m_pDS.get()) return;
+
+    unsigned int time = XbmcThreads::SystemClockMillis();
+    unsigned int count = 0;
+    m_lookupCache.clear();
+    m_lookupCacheActive = true;
+    for (unsigned int i = 0; i < sizeof(lookups) / sizeof(lookups[0]); i++)
+    {
+      CStdString sql = PrepareSQL("select %s, %s from %s", lookups[i].idField, lookups[i].valueField, lookups[i].table);
+      if (!m_pDS->query(sql.c_str()))
+        continue;
+      std::map<CStdString, int> &cache = m_lookupCache[lookups[i].table];
+      while (!m_pDS->eof())
+      {
+        CStdString key = m_pDS->fv(1).get_asString();
+        key.ToLower();
+        cache.insert(make_pair(key, m_pDS->fv(0).get_asInt()));
+        m_pDS->next();
+      }
+      m_pDS->close();
+      count += cache.size();
+    }
+    CLog::Log(LOGDEBUG, "%s - preloaded %u lookup entries in %u ms", __FUNCTION__, count, XbmcThreads::SystemClockMillis() - time);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    EmptyCache();
+  }
+}
+
 int CVideoDatabase::AddActor(const CStdString& strActor, const CStdString& thumbURLs, const CStdString &thumb)
 {
   try
@@ -1310,26 +1602,45 @@ int CVideoDatabase::AddActor(const CStdString& strActor, const CStdString& thumb
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
     int idActor = -1;
-    CStdString strSQL=PrepareSQL("select idActor from actors where strActor like '%s'", strActor.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    bool added = false;
+    CStdString strSQL;
+    CStdString key(strActor);
+    key.ToLower();
+    std::map<CStdString, int> *cache = m_lookupCacheActive ? &m_lookupCache["actors"] : NULL;
+    std::map<CStdString, int>::const_iterator it;
+    if (cache && (it = cache->find(key)) != cache->end())
     {
-      m_pDS->close();
-      // doesnt exists, add it
-      strSQL=PrepareSQL("insert into actors (idActor, strActor, strThumb) values( NULL, '%s','%s')", strActor.c_str(),thumbURLs.c_str());
-      m_pDS->exec(strSQL.c_str());
-      idActor = (int)m_pDS->lastinsertid();
+      m_cacheHits++;
+      idActor = it->second;
     }
     else
     {
-      idActor = m_pDS->fv("idActor").get_asInt();
-      m_pDS->close();
-      // update the thumb url's
-      if (!thumbURLs.IsEmpty())
+      if (cache)
+        m_cacheMisses++;
+      strSQL=PrepareSQL("select idActor from actors where strActor like '%s'", strActor.c_str());
+      m_pDS->query(strSQL.c_str());
+      if (m_pDS->num_rows() == 0)
       {
-        strSQL=PrepareSQL("update actors set strThumb='%s' where idActor=%i",thumbURLs.c_str(),idActor);
+        m_pDS->close();
+        // doesnt exists, add it
+        strSQL=PrepareSQL("insert into actors (idActor, strActor, strThumb) values( NULL, '%s','%s')", strActor.c_str(),thumbURLs.c_str());
         m_pDS->exec(strSQL.c_str());
+        idActor = (int)m_pDS->lastinsertid();
+        added = true;
+      }
+      else
+      {
+        idActor = m_pDS->fv("idActor").get_asInt();
+        m_pDS->close();
       }
+      if (cache)
+        cache->insert(make_pair(key, idActor));
+    }
+    // update the thumb url's
+    if (!added && !thumbURLs.IsEmpty())
+    {
+      strSQL=PrepareSQL("update actors set strThumb='%s' where idActor=%i",thumbURLs.c_str(),idActor);
+      m_pDS->exec(strSQL.c_str());
     }
     // add artwork
     if (!thumb.IsEmpty())
@@ -1426,6 +1737,7 @@ void CVideoDatabase::AddTagToItem(int idMovie, int idTag, const std::string &typ
     return;
 
   AddToLinkTable("taglinks", "idTag", idTag, "idMedia", idMovie, "media_type", type.c_str());
+  BumpSearchIndexGeneration();
 }
 
 void CVideoDatabase::RemoveTagFromItem(int idMovie, int idTag, const std::string &type)
@@ -1434,6 +1746,7 @@ void CVideoDatabase::RemoveTagFromItem(int idMovie, int idTag, const std::string
     return;
 
   RemoveFromLinkTable("taglinks", "idTag", idTag, "idMedia", idMovie, "media_type", type.c_str());
+  BumpSearchIndexGeneration();
 }
 
 //****Actors****
@@ -1963,7 +2276,7 @@ int CVideoDatabase::SetDetailsForMovie(const CStdString& strFilenameAndPath, con
     for (unsigned int i = 0; i < details.m_tags.size(); i++)
     {
       int idTag = AddTag(details.m_tags[i]);
-      AddTagToItem(idMovie, idTag, "movie");
+      AddToLinkTable("taglinks", "idTag", idTag, "idMedia", idMovie, "media_type", "movie");
     }
 
     // add countries...
@@ -1980,8 +2293,11 @@ int CVideoDatabase::SetDetailsForMovie(const CStdString& strFilenameAndPath, con
     CStdString sql = "update movie set " + GetValueString(details, VIDEODB_ID_MIN, VIDEODB_ID_MAX, DbMovieOffsets);
     sql += PrepareSQL(" where idMovie=%i", idMovie);
     m_pDS->exec(sql.c_str());
+    int generation = BumpSearchIndexGeneration();
     CommitTransaction();
 
+    UpdateSearchIndex(SEARCH_INDEX_MOVIE, idMovie, details, generation);
+
     return idMovie;
   }
   catch (...)
@@ -2056,9 +2372,12 @@ int CVideoDatabase::SetDetailsForTvShow(const CStdString& strPath, const CVideoI
     CStdString sql = "update tvshow set " + GetValueString(details, VIDEODB_ID_TV_MIN, VIDEODB_ID_TV_MAX, DbTvShowOffsets);
     sql += PrepareSQL("where idShow=%i", idTvShow);
     m_pDS->exec(sql.c_str());
+    int generation = BumpSearchIndexGeneration();
 
     CommitTransaction();
 
+    UpdateSearchIndex(SEARCH_INDEX_TVSHOW, idTvShow, details, generation);
+
     return idTvShow;
   }
   catch (...)
@@ -2131,8 +2450,11 @@ int CVideoDatabase::SetDetailsForEpisode(const CStdString& strFilenameAndPath, c
     CStdString sql = "update episode set " + GetValueString(details, VIDEODB_ID_EPISODE_MIN, VIDEODB_ID_EPISODE_MAX, DbEpisodeOffsets);
     sql += PrepareSQL("where idEpisode=%i", idEpisode);
     m_pDS->exec(sql.c_str());
+    int generation = BumpSearchIndexGeneration();
     CommitTransaction();
 
+    UpdateSearchIndex(SEARCH_INDEX_EPISODE, idEpisode, details, generation);
+
     return idEpisode;
   }
   catch (...)
@@ -2229,8 +2551,11 @@ int CVideoDatabase::SetDetailsForMusicVideo(const CStdString& strFilenameAndPath
     CStdString sql = "update musicvideo set " + GetValueString(details, VIDEODB_ID_MUSICVIDEO_MIN, VIDEODB_ID_MUSICVIDEO_MAX, DbMusicVideoOffsets);
     sql += PrepareSQL(" where idMVideo=%i", idMVideo);
     m_pDS->exec(sql.c_str());
+    int generation = BumpSearchIndexGeneration();
     CommitTransaction();
 
+    UpdateSearchIndex(SEARCH_INDEX_MUSICVIDEO, idMVideo, details, generation);
+
     return idMVideo;
   }
   catch (...)
@@ -2680,10 +3005,14 @@ void CVideoDatabase::DeleteMovie(const CStdString& strFilenameAndPath, bool bKee
     CStdString strPath, strFileName;
     SplitPath(strFilenameAndPath,strPath,strFileName);
     InvalidatePathHash(strPath);
+    int generation = bKeepId ? -1 : BumpSearchIndexGeneration();
     CommitTransaction();
 
     if (!bKeepId)
+    {
+      RemoveFromSearchIndex(SEARCH_INDEX_MOVIE, vector<int>(1, idMovie), generation);
       AnnounceRemove("movie", idMovie);
+    }
   }
   catch (...)
   {
@@ -2748,11 +3077,15 @@ void CVideoDatabase::DeleteTvShow(const CStdString& strPath, bool bKeepId /* = f
     }
 
     InvalidatePathHash(strPath);
+    int generation = bKeepId ? -1 : BumpSearchIndexGeneration();
 
     CommitTransaction();
 
     if (!bKeepId)
+    {
+      RemoveFromSearchIndex(SEARCH_INDEX_TVSHOW, vector<int>(1, idTvShow), generation);
       AnnounceRemove("tvshow", idTvShow);
+    }
   }
   catch (...)
   {
@@ -2809,7 +3142,10 @@ void CVideoDatabase::DeleteEpisode(const CStdString& strFilenameAndPath, int idE
     }
 
     if (!bKeepId)
+    {
+      RemoveFromSearchIndex(SEARCH_INDEX_EPISODE, vector<int>(1, idEpisode), BumpSearchIndexGeneration());
       AnnounceRemove("episode", idEpisode);
+    }
   }
   catch (...)
   {
@@ -2871,10 +3207,14 @@ void CVideoDatabase::DeleteMusicVideo(const CStdString& strFilenameAndPath, bool
     CStdString strPath, strFileName;
     SplitPath(strFilenameAndPath,strPath,strFileName);
     InvalidatePathHash(strPath);
+    int generation = bKeepId ? -1 : BumpSearchIndexGeneration();
     CommitTransaction();
 
     if (!bKeepId)
+    {
+      RemoveFromSearchIndex(SEARCH_INDEX_MUSICVIDEO, vector<int>(1, idMVideo), generation);
       AnnounceRemove("musicvideo", idMVideo);
+    }
   }
   catch (...)
   {
@@ -2897,6 +3237,7 @@ void CVideoDatabase::DeleteSet(int idSet)
     CStdString strSQL;
     strSQL=PrepareSQL("delete from sets where idSet=%i", idSet);
     m_pDS->exec(strSQL.c_str());
+    m_lookupCache.erase("sets");
     strSQL=PrepareSQL("delete from setlinkmovie where idSet=%i", idSet);
     m_pDS->exec(strSQL.c_str());
   }
@@ -2923,7 +3264,9 @@ void CVideoDatabase::DeleteTag(int idTag, const std::string &mediaType)
     {
       strSQL = PrepareSQL("DELETE FROM tag WHERE idTag = %i", idTag);
       m_pDS->exec(strSQL.c_str());
+      m_lookupCache.erase("tag");
     }
+    BumpSearchIndexGeneration();
   }
   catch (...)
   {
@@ -4012,6 +4355,16 @@ bool CVideoDatabase::UpdateOldVersion(int iVersion)
     m_pDS->exec("CREATE UNIQUE INDEX ix_taglinks_2 ON taglinks (idMedia, media_type(20), idTag)");
     m_pDS->exec("CREATE INDEX ix_taglinks_3 ON taglinks (media_type(20))");
   }
+  if (iVersion < 68)
+  { // content fingerprints, to follow files that are moved or renamed
+    m_pDS->exec("ALTER TABLE files ADD strFingerprint text");
+    m_pDS->exec("CREATE INDEX ix_files_fingerprint ON files ( strFingerprint(255) )");
+  }
+  if (iVersion < 69)
+  { // counts the changes to indexed items, so the search index knows when it's out of date
+    m_pDS->exec("CREATE TABLE searchgeneration (idGeneration integer)");
+    m_pDS->exec("INSERT INTO searchgeneration (idGeneration) VALUES (0)");
+  }
   // always recreate the view after any table change
   CreateViews();
   return true;
@@ -4314,11 +4667,15 @@ void CVideoDatabase::UpdateMovieTitle(int idMovie, const CStdString& strNewMovie
     {
       CLog::Log(LOGINFO, "Changing Movie set:id:%i New Title:%s", idMovie, strNewMovieTitle.c_str());
       strSQL = PrepareSQL("UPDATE sets SET strSet='%s' WHERE idSet=%i", strNewMovieTitle.c_str(), idMovie );
+      m_lookupCache.erase("sets");
     }
     m_pDS->exec(strSQL.c_str());
 
     if (content.size() > 0)
+    {
+      BumpSearchIndexGeneration();
       AnnounceUpdate(content, idMovie);
+    }
   }
   catch (...)
   {
@@ -6911,6 +7268,205 @@ int CVideoDatabase::GetMatchingMusicVideo(const CStdString& strArtist, const CSt
   return -1;
 }
 
+bool CVideoDatabase::BuildSearchIndex()
+{
+  static const struct
+  {
+    int type;
+    const char *table;
+    const char *idField;
+    int title;
+    int altTitle;
+    int plot;
+    const char *peopleLink;
+    const char *personField;
+    const char *media;
+  } sources[] =
+  { { SEARCH_INDEX_MOVIE,      "movie",      "idMovie",   VIDEODB_ID_TITLE,            VIDEODB_ID_ORIGINALTITLE,    VIDEODB_ID_PLOT,            "actorlinkmovie",       "idActor",  "movie"      },
+    { SEARCH_INDEX_TVSHOW,     "tvshow",     "idShow",    VIDEODB_ID_TV_TITLE,         VIDEODB_ID_TV_ORIGINALTITLE, VIDEODB_ID_TV_PLOT,         "actorlinktvshow",      "idActor",  "tvshow"     },
+    { SEARCH_INDEX_EPISODE,    "episode",    "idEpisode", VIDEODB_ID_EPISODE_TITLE,    -1,                          VIDEODB_ID_EPISODE_PLOT,    "actorlinkepisode",     "idActor",  "episode"    },
+    { SEARCH_INDEX_MUSICVIDEO, "musicvideo", "idMVideo",  VIDEODB_ID_MUSICVIDEO_TITLE, VIDEODB_ID_MUSICVIDEO_ALBUM, VIDEODB_ID_MUSICVIDEO_PLOT, "artistlinkmusicvideo", "idArtist", "musicvideo" } };
+
+  CSearchIndex &index = GetVideoSearchIndex();
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    // the state of the tables is taken before they're read, so that
+    // anything changed while we build has the index rebuilt next time
+    CSingleLock lock(index.GetBuildSection());
+    CStdString source = GetSearchIndexSource();
+    if (source.IsEmpty())
+      return false;
+    if (index.IsBuiltFrom(source))
+      return true;
+
+    index.Clear();
+    unsigned int time = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+    {
+      // gather the cast and tags of every item first, so each item is indexed once
+      map<int, CStdString> people;
+      CStdString sql = PrepareSQL("select %s.%s, actors.strActor from %s join actors on actors.idActor=%s.%s",
+                                  sources[i].peopleLink, sources[i].idField, sources[i].peopleLink, sources[i].peopleLink, sources[i].personField);
+      if (!m_pDS->query(sql.c_str())) return false;
+      while (!m_pDS->eof())
+      {
+        people[m_pDS->fv(0).get_asInt()] += " " + m_pDS->fv(1).get_asString();
+        m_pDS->next();
+      }
+      m_pDS->close();
+
+      map<int, CStdString> tags;
+      sql = PrepareSQL("select taglinks.idMedia, tag.strTag from taglinks join tag on tag.idTag=taglinks.idTag where taglinks.media_type='%s'", sources[i].media);
+      if (!m_pDS->query(sql.c_str())) return false;
+      while (!m_pDS->eof())
+      {
+        tags[m_pDS->fv(0).get_asInt()] += " " + m_pDS->fv(1).get_asString();
+        m_pDS->next();
+      }
+      m_pDS->close();
+
+      CStdString altTitle = "NULL";
+      if (sources[i].altTitle >= 0)
+        altTitle.Format("c%02d", sources[i].altTitle);
+      sql = PrepareSQL("select %s, c%02d, %s, c%02d from %s", sources[i].idField, sources[i].title, altTitle.c_str(), sources[i].plot, sources[i].table);
+      if (!m_pDS->query(sql.c_str())) return false;
+      while (!m_pDS->eof())
+      {
+        int id = m_pDS->fv(0).get_asInt();
+        CSearchIndex::Fields fields;
+        fields.push_back(CSearchIndex::Field(m_pDS->fv(1).get_asString(), 1.0f));
+        fields.push_back(CSearchIndex::Field(m_pDS->fv(2).get_asString(), 0.8f));
+        fields.push_back(CSearchIndex::Field(people[id], 0.5f));
+        fields.push_back(CSearchIndex::Field(tags[id], 0.5f));
+        fields.push_back(CSearchIndex::Field(m_pDS->fv(3).get_asString(), 0.2f));
+        index.AddDocument(sources[i].type, id, fields);
+        m_pDS->next();
+      }
+      m_pDS->close();
+    }
+
+    index.SetBuilt(source);
+    CLog::Log(LOGDEBUG, "%s - indexed %u items in %u ms", __FUNCTION__, index.Size(), XbmcThreads::SystemClockMillis() - time);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  index.Clear();
+  return false;
+}
+
+CStdString CVideoDatabase::GetSearchIndexSource()
+{
+  if (!m_pDS->query("select idGeneration from searchgeneration"))
+    return "";
+  if (m_pDS->eof())
+  {
+    m_pDS->close();
+    return "";
+  }
+  int generation = m_pDS->fv(0).get_asInt();
+  m_pDS->close();
+  return GetSearchIndexSource(generation);
+}
+
+CStdString CVideoDatabase::GetSearchIndexSource(int generation)
+{
+  // the profile and database, and the number of changes made to the indexed items, so that the
+  // index is rebuilt after a profile switch, or after items are changed by anyone else, such as
+  // another client of a shared mysql database
+  CStdString source;
+  source.Format("%s|%s|%s|%i", g_settings.GetCurrentProfile().getDirectory().c_str(),
+                m_pDB->getHostName(), m_pDB->getDatabase(), generation);
+  return source;
+}
+
+int CVideoDatabase::BumpSearchIndexGeneration()
+{
+  // called within the write, so the change and its generation are committed together
+  m_pDS->exec("update searchgeneration set idGeneration=idGeneration+1");
+  if (!m_pDS->query("select idGeneration from searchgeneration"))
+    return -1;
+  int generation = m_pDS->eof() ? -1 : m_pDS->fv(0).get_asInt();
+  m_pDS->close();
+  return generation;
+}
+
+void CVideoDatabase::UpdateSearchIndex(int type, int id, const CVideoInfoTag &details, int generation)
+{
+  // only an index holding every change before this one can take it; any other is rebuilt
+  // on the next search. An index being built is left alone, as the build reads the generation
+  // committed before this change.
+  CSearchIndex &index = GetVideoSearchIndex();
+  CSingleTryLock lock(index.GetBuildSection());
+  if (!lock.IsOwner() || generation < 1 || !index.IsBuiltFrom(GetSearchIndexSource(generation - 1)))
+    return;
+
+  CStdString people;
+  if (type == SEARCH_INDEX_MUSICVIDEO)
+    people = StringUtils::Join(details.m_artist, " ");
+  for (CVideoInfoTag::iCast it = details.m_cast.begin(); it != details.m_cast.end(); ++it)
+    people += " " + it->strName;
+
+  CSearchIndex::Fields fields;
+  fields.push_back(CSearchIndex::Field(details.m_strTitle, 1.0f));
+  fields.push_back(CSearchIndex::Field(type == SEARCH_INDEX_MUSICVIDEO ? details.m_strAlbum : details.m_strOriginalTitle, 0.8f));
+  fields.push_back(CSearchIndex::Field(people, 0.5f));
+  fields.push_back(CSearchIndex::Field(StringUtils::Join(details.m_tags, " "), 0.5f));
+  fields.push_back(CSearchIndex::Field(details.m_strPlot, 0.2f));
+  index.AddDocument(type, id, fields);
+  index.SetBuilt(GetSearchIndexSource(generation));
+}
+
+void CVideoDatabase::RemoveFromSearchIndex(int type, const std::vector<int> &ids, int generation)
+{
+  CSearchIndex &index = GetVideoSearchIndex();
+  CSingleTryLock lock(index.GetBuildSection());
+  if (!lock.IsOwner() || generation < 1 || !index.IsBuiltFrom(GetSearchIndexSource(generation - 1)))
+    return;
+
+  for (std::vector<int>::const_iterator i = ids.begin(); i != ids.end(); ++i)
+    index.RemoveDocument(type, *i);
+  index.SetBuilt(GetSearchIndexSource(generation));
+}
+
+bool CVideoDatabase::SearchIndex(const CStdString& search, int type, std::vector<CSearchIndex::Result> &results, unsigned int limit)
+{
+  if (!g_advancedSettings.m_bVideoLibrarySearchIndex || !BuildSearchIndex())
+    return false;
+
+  unsigned int time = XbmcThreads::SystemClockMillis();
+  GetVideoSearchIndex().Search(search, type, results, limit);
+  CLog::Log(LOGDEBUG, "%s - '%s' matched %u items in %u ms", __FUNCTION__, search.c_str(), (unsigned int)results.size(), XbmcThreads::SystemClockMillis() - time);
+  return true;
+}
+
+bool CVideoDatabase::GetSearchIndexFilter(const CStdString& search, int type, const CStdString& idField, const CStdString& textField, CStdString& filter, std::vector<int> &order)
+{
+  std::vector<CSearchIndex::Result> results;
+  if (!SearchIndex(search, type, results, SEARCH_INDEX_LIMIT))
+  {
+    // no index, so fall back to scanning the titles
+    filter = PrepareSQL("%s like '%%%s%%'", textField.c_str(), search.c_str());
+    return true;
+  }
+  if (results.empty())
+    return false;
+
+  filter = idField + " in (";
+  for (std::vector<CSearchIndex::Result>::const_iterator i = results.begin(); i != results.end(); ++i)
+  {
+    filter.AppendFormat("%s%i", i == results.begin() ? "" : ",", i->id);
+    order.push_back(i->id);
+  }
+  filter += ")";
+  return true;
+}
+
 void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList& items)
 {
   CStdString strSQL;
@@ -6920,12 +7476,18 @@ void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList&
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter;
+    std::vector<int> order;
+    if (!GetSearchIndexFilter(strSearch, SEARCH_INDEX_MOVIE, "movie.idMovie", PrepareSQL("movie.c%02d", VIDEODB_ID_TITLE), filter, order))
+      return;
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and ",VIDEODB_ID_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d from movie where movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d from movie where ",VIDEODB_ID_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -6946,11 +7508,17 @@ void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList&
         path.Format("videodb://1/7/%i/%i",m_pDS2->fv(0).get_asInt(),movieId);
       pItem->SetPath(path);
       pItem->m_bIsFolder=false;
-      items.Add(pItem);
+      fetched.push_back(make_pair(movieId, pItem));
       m_pDS2->close();
       m_pDS->next();
     }
     m_pDS->close();
+
+    // the rows come back in the database's order rather than by relevance
+    if (!order.empty())
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      items.Add(fetched[i].second);
   }
   catch (...)
   {
@@ -6958,7 +7526,7 @@ void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList&
   }
 }
 
-void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList& items)
+void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList& items, bool useSearchIndex /* = false */)
 {
   CStdString strSQL;
 
@@ -6967,12 +7535,18 @@ void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter = PrepareSQL("tvshow.c%02d like '%%%s%%'", VIDEODB_ID_TV_TITLE, strSearch.c_str());
+    std::vector<int> order;
+    if (useSearchIndex && !GetSearchIndexFilter(strSearch, SEARCH_INDEX_TVSHOW, "tvshow.idShow", PrepareSQL("tvshow.c%02d", VIDEODB_ID_TV_TITLE), filter, order))
+      return;
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and ",VIDEODB_ID_TV_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where ",VIDEODB_ID_TV_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -6989,10 +7563,16 @@ void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList
       pItem->SetPath("videodb://"+ strDir);
       pItem->m_bIsFolder=true;
       pItem->GetVideoInfoTag()->m_iDbId = m_pDS->fv("tvshow.idShow").get_asInt();
-      items.Add(pItem);
+      fetched.push_back(make_pair(m_pDS->fv("tvshow.idShow").get_asInt(), pItem));
       m_pDS->next();
     }
     m_pDS->close();
+
+    // the rows come back in the database's order rather than by relevance
+    if (!order.empty())
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      items.Add(fetched[i].second);
   }
   catch (...)
   {
@@ -7009,12 +7589,18 @@ void CVideoDatabase::GetEpisodesByName(const CStdString& strSearch, CFileItemLis
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter;
+    std::vector<int> order;
+    if (!GetSearchIndexFilter(strSearch, SEARCH_INDEX_EPISODE, "episode.idEpisode", PrepareSQL("episode.c%02d", VIDEODB_ID_EPISODE_TITLE), filter, order))
+      return;
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and episode.idShow=tvshow.idShow and files.idPath=path.idPath and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and episode.idShow=tvshow.idShow and files.idPath=path.idPath and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -7028,10 +7614,16 @@ void CVideoDatabase::GetEpisodesByName(const CStdString& strSearch, CFileItemLis
       CStdString path; path.Format("videodb://2/2/%ld/%ld/%ld",m_pDS->fv("episode.idShow").get_asInt(),m_pDS->fv(2).get_asInt(),m_pDS->fv(0).get_asInt());
       pItem->SetPath(path);
       pItem->m_bIsFolder=false;
-      items.Add(pItem);
+      fetched.push_back(make_pair(m_pDS->fv(0).get_asInt(), pItem));
       m_pDS->next();
     }
     m_pDS->close();
+
+    // the rows come back in the database's order rather than by relevance
+    if (!order.empty())
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      items.Add(fetched[i].second);
   }
   catch (...)
   {
@@ -7052,12 +7644,18 @@ void CVideoDatabase::GetMusicVideosByName(const CStdString& strSearch, CFileItem
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    CStdString filter;
+    std::vector<int> order;
+    if (!GetSearchIndexFilter(strSearch, SEARCH_INDEX_MUSICVIDEO, "musicvideo.idMVideo", PrepareSQL("musicvideo.c%02d", VIDEODB_ID_MUSICVIDEO_TITLE), filter, order))
+      return;
+
     if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and ",VIDEODB_ID_MUSICVIDEO_TITLE) + filter;
     else
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where ",VIDEODB_ID_MUSICVIDEO_TITLE) + filter;
     m_pDS->query( strSQL.c_str() );
 
+    std::vector<std::pair<int, CFileItemPtr> > fetched;
     while (!m_pDS->eof())
     {
       if (g_settings.GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
@@ -7073,10 +7671,16 @@ void CVideoDatabase::GetMusicVideosByName(const CStdString& strSearch, CFileItem
 
       pItem->SetPath("videodb://"+ strDir);
       pItem->m_bIsFolder=false;
-      items.Add(pItem);
+      fetched.push_back(make_pair(m_pDS->fv("musicvideo.idMVideo").get_asInt(), pItem));
       m_pDS->next();
     }
     m_pDS->close();
+
+    // the rows come back in the database's order rather than by relevance
+    if (!order.empty())
+      CSearchIndex::SortByOrder(order, fetched);
+    for (unsigned int i = 0; i < fetched.size(); i++)
+      items.Add(fetched[i].second);
   }
   catch (...)
   {
@@ -7328,6 +7932,7 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const s
     }
     else
       sql = "select * from files, path where files.idPath = path.idPath";
+    sql += " order by path.idPath";
 
     m_pDS->query(sql.c_str());
     if (m_pDS->num_rows() == 0) return;
@@ -7363,12 +7968,15 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const s
     std::vector<int> episodeIDs;
     std::vector<int> musicVideoIDs;
 
-    int total = m_pDS->num_rows();
-    int current = 0;
-
     bool bIsSource;
     VECSOURCES *pShares = g_settings.GetSourcesFromType("video");
 
+    // a full clean that is cancelled picks up where it left off next time
+    CStdString cursorFile;
+    if (!paths)
+      URIUtils::AddFileToFolder(g_settings.GetDatabaseFolder(), CStdString(GetBaseDBName()) + "CleanCursor.xml", cursorFile);
+    CFileExistenceChecker checker(cursorFile);
+
     while (!m_pDS->eof())
     {
       CStdString path = m_pDS->fv("path.strPath").get_asString();
@@ -7380,41 +7988,44 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const s
       if (URIUtils::IsStack(fullPath))
         fullPath = CStackDirectory::GetFirstStackedFile(fullPath);
 
-      // check if we have a internet related file that is part of a media source
-      if (URIUtils::IsInternetStream(fullPath, true) && CUtil::GetMatchingSource(fullPath, *pShares, bIsSource) > -1)
-      {
-        if (!CFile::Exists(fullPath, false))
-          filesToDelete += m_pDS->fv("files.idFile").get_asString() + ",";
-      }
+      // remove optical and internet related files, unless the latter are part of a media source.
+      // anything else is removed if it no longer exists, which will also remove entries from
+      // previously existing media sources
+      if (URIUtils::IsOnDVD(fullPath) ||
+         (URIUtils::IsInternetStream(fullPath, true) && CUtil::GetMatchingSource(fullPath, *pShares, bIsSource) < 0))
+        filesToDelete += m_pDS->fv("files.idFile").get_asString() + ",";
       else
-      {
-        // remove optical, internet related and non-existing files
-        // note: this will also remove entries from previously existing media sources
-        if (URIUtils::IsOnDVD(fullPath) || URIUtils::IsInternetStream(fullPath, true) || !CFile::Exists(fullPath, false))
-          filesToDelete += m_pDS->fv("files.idFile").get_asString() + ",";
-      }
+        checker.AddFile(m_pDS->fv("path.idPath").get_asInt(), path, m_pDS->fv("files.idFile").get_asInt(), fullPath);
 
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    // check the files a directory at a time, and each source in parallel.
+    // files found missing before a cancel are still removed, so that the check can resume.
+    checker.Start(*pShares);
+    while (!checker.Wait(100))
+    {
+      unsigned int current, total;
+      checker.GetProgress(current, total);
       if (!pObserver)
       {
         if (progress)
         {
-          progress->SetPercentage(current * 100 / total);
+          progress->SetPercentage(total ? current * 100 / total : 0);
           progress->Progress();
           if (progress->IsCanceled())
-          {
-            progress->Close();
-            m_pDS->close();
-            return;
-          }
+            checker.Stop();
         }
       }
       else
         pObserver->OnSetProgress(current,total);
-
-      m_pDS->next();
-      current++;
     }
-    m_pDS->close();
+
+    std::vector<int> missing;
+    checker.GetMissing(missing);
+    for (std::vector<int>::const_iterator i = missing.begin(); i != missing.end(); ++i)
+      filesToDelete.AppendFormat("%i,", *i);
 
     // Add any files that don't have a valid idPath entry to the filesToDelete list.
     sql = "select files.idFile from files where idPath not in (select idPath from path)";
@@ -7573,10 +8184,18 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const s
     m_pDS->exec(sql.c_str());
 
     CLog::Log(LOGDEBUG, "%s: Cleaning tvshow table", __FUNCTION__);
+    std::vector<int> tvshowIDs;
+    sql = "select idShow from tvshow where idShow not in (select idShow from tvshowlinkpath)";
+    m_pDS->query(sql.c_str());
+    while (!m_pDS->eof())
+    {
+      tvshowIDs.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
     sql = "delete from tvshow where idShow not in (select idShow from tvshowlinkpath)";
     m_pDS->exec(sql.c_str());
 
-    std::vector<int> tvshowIDs;
     CStdString showsToDelete;
     sql = "select tvshow.idShow from tvshow "
             "join tvshowlinkpath on tvshow.idShow=tvshowlinkpath.idShow "
@@ -7672,8 +8291,17 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const s
     sql = "delete from sets where idSet not in (select distinct idSet from setlinkmovie)";
     m_pDS->exec(sql.c_str());
 
+    // a generation per type, applied to the index in the same order below
+    int movieGeneration = BumpSearchIndexGeneration();
+    int episodeGeneration = BumpSearchIndexGeneration();
+    int tvshowGeneration = BumpSearchIndexGeneration();
+    int musicVideoGeneration = BumpSearchIndexGeneration();
+
     CommitTransaction();
 
+    // the lookup tables may have lost entries, so drop our cached ids
+    m_lookupCache.clear();
+
     if (pObserver)
       pObserver->OnStateChanged(COMPRESSING_DATABASE);
 
@@ -7684,15 +8312,19 @@ void CVideoDatabase::CleanDatabase(IVideoInfoScannerObserver* pObserver, const s
     time = XbmcThreads::SystemClockMillis() - time;
     CLog::Log(LOGNOTICE, "%s: Cleaning videodatabase done. Operation took %s", __FUNCTION__, StringUtils::SecondsToTimeString(time / 1000).c_str());
 
+    RemoveFromSearchIndex(SEARCH_INDEX_MOVIE, movieIDs, movieGeneration);
     for (unsigned int i = 0; i < movieIDs.size(); i++)
       AnnounceRemove("movie", movieIDs[i]);
 
+    RemoveFromSearchIndex(SEARCH_INDEX_EPISODE, episodeIDs, episodeGeneration);
     for (unsigned int i = 0; i < episodeIDs.size(); i++)
       AnnounceRemove("episode", episodeIDs[i]);
 
+    RemoveFromSearchIndex(SEARCH_INDEX_TVSHOW, tvshowIDs, tvshowGeneration);
     for (unsigned int i = 0; i < tvshowIDs.size(); i++)
       AnnounceRemove("tvshow", tvshowIDs[i]);
 
+    RemoveFromSearchIndex(SEARCH_INDEX_MUSICVIDEO, musicVideoIDs, musicVideoGeneration);
     for (unsigned int i = 0; i < musicVideoIDs.size(); i++)
       AnnounceRemove("musicvideo", musicVideoIDs[i]);
   }
@@ -24,6 +24,7 @@
 #include "addons/Scraper.h"
 #include "Bookmark.h"
 #include "utils/SortUtils.h"
+#include "utils/SearchIndex.h"
 
 #include <memory>
 #include <set>
@@ -527,6 +528,25 @@ public:
   bool GetPaths(std::set<CStdString> &paths);
   bool GetPathsForTvShow(int idShow, std::set<int>& paths);
 
+  // content fingerprints of files, to follow them when moved or renamed.
+  // an empty fingerprint marks a file that can never be fingerprinted, which isn't returned again.
+  void SetFileFingerprint(const CStdString &strFileNameAndPath, const CStdString &fingerprint);
+  bool GetFilesWithoutFingerprint(std::vector<CStdString> &files, unsigned int limit);
+
+  /*! \brief Move the library entry of a file that has been moved or renamed to its new path.
+   The entry is that of a file with the same fingerprint which no longer exists at its old path, so
+   the file keeps its details, art, watched state and bookmarks rather than being scraped as new.
+   Files in a source that can't be reached are left where they are.
+   A file entry already at the new path that isn't in the library (e.g. one kept for a bookmark from
+   playing the file) is replaced by the moved one.
+   \param strFileNameAndPath the new path of the file.
+   \param fingerprint the fingerprint of the file, as given by CFileUtils::GetFingerprint.
+   \param type the type of entry to look for - "movie", "episode" or "musicvideo".
+   \param idShow the show an episode must belong to, or -1 for any.
+   \return true if an entry was moved to the file.
+   */
+  bool RelinkMovedFile(const CStdString &strFileNameAndPath, const CStdString &fingerprint, const CStdString &type, int idShow = -1);
+
   /*! \brief retrieve subpaths of a given path.  Assumes a heirarchical folder structure
    \param basepath the root path to retrieve subpaths for
    \param subpaths the returned subpaths
@@ -562,7 +582,11 @@ public:
   void GetMusicVideoDirectorsByName(const CStdString& strSearch, CFileItemList& items);
 
   void GetMoviesByName(const CStdString& strSearch, CFileItemList& items);
-  void GetTvShowsByName(const CStdString& strSearch, CFileItemList& items);
+  /*! \brief Get the tv shows whose title contains strSearch.
+   \param useSearchIndex rank the shows matching the words of strSearch in the full text index
+   instead, as for a user's search. Lookups by title (eg. of a movie's show links) shouldn't set this.
+   */
+  void GetTvShowsByName(const CStdString& strSearch, CFileItemList& items, bool useSearchIndex = false);
   void GetEpisodesByName(const CStdString& strSearch, CFileItemList& items);
   void GetMusicVideosByName(const CStdString& strSearch, CFileItemList& items);
 
@@ -605,6 +629,38 @@ public:
 
   void CleanDatabase(VIDEO::IVideoInfoScannerObserver* pObserver=NULL, const std::set<int>* paths=NULL);
 
+  /*! \brief Bulk load the actor, genre, studio, country, set and tag lookup caches.
+   Used at the start of a scan so that AddActor and AddToTable can resolve
+   existing entries without a query per item.
+   \sa EmptyCache
+   */
+  void PreloadCaches();
+
+  /*! \brief Clear the lookup caches, logging their hit rate, and stop using them
+   until PreloadCaches() is called again.
+   */
+  void EmptyCache();
+
+  enum SearchIndexType
+  {
+    SEARCH_INDEX_MOVIE = 0,
+    SEARCH_INDEX_TVSHOW,
+    SEARCH_INDEX_EPISODE,
+    SEARCH_INDEX_MUSICVIDEO
+  };
+
+  /*! \brief Search the library's full text index of titles, cast, tags and plots.
+   Every word of the search must match the start of a word in the item. The index is
+   built on first use, kept current by the SetDetailsFor* and Delete* methods, and rebuilt
+   when the library has been changed by anything else.
+   \param search the words to search for.
+   \param type a SearchIndexType to restrict the search to, or -1 for all types.
+   \param results [out] the matching items, best match first.
+   \param limit maximum number of results (0 for no limit).
+   \return false if the index is disabled or couldn't be built.
+   */
+  bool SearchIndex(const CStdString& search, int type, std::vector<CSearchIndex::Result> &results, unsigned int limit = 0);
+
   /*! \brief Add a file to the database, if necessary
    If the file is already in the database, we simply return its id.
    \param url - full path of the file to add.
@@ -766,6 +822,19 @@ protected:
   void GetDetailsFromDB(const dbiplus::sql_record* const record, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
   CStdString GetValueString(const CVideoInfoTag &details, int min, int max, const SDbTableOffsets *offsets) const;
 
+  bool BuildSearchIndex();
+  CStdString GetSearchIndexSource();
+  CStdString GetSearchIndexSource(int generation);
+  int BumpSearchIndexGeneration();
+  void UpdateSearchIndex(int type, int id, const CVideoInfoTag &details, int generation);
+  void RemoveFromSearchIndex(int type, const std::vector<int> &ids, int generation);
+  bool GetSearchIndexFilter(const CStdString& search, int type, const CStdString& idField, const CStdString& textField, CStdString& filter, std::vector<int> &order);
+
+  std::map<CStdString, std::map<CStdString, int> > m_lookupCache; ///< lowercased value -> id, per lookup table
+  bool m_lookupCacheActive;   ///< m_lookupCache is used only between PreloadCaches() and EmptyCache()
+  unsigned int m_cacheHits;   ///< number of lookups served from m_lookupCache
+  unsigned int m_cacheMisses; ///< number of lookups that needed a query
+
 private:
   virtual bool CreateTables();
   virtual bool UpdateOldVersion(int version);
@@ -807,7 +876,7 @@ private:
    */
   bool LookupByFolders(const CStdString &path, bool shows = false);
 
-  virtual int GetMinVersion() const { return 67; };
+  virtual int GetMinVersion() const { return 69; };
   virtual int GetExportVersion() const { return 1; };
   const char *GetBaseDBName() const { return "MyVideos"; };
 
@@ -44,10 +44,12 @@
 #include "utils/TimeUtils.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
+#include "utils/FileUtils.h"
 #include "utils/Variant.h"
 #include "ThumbLoader.h"
 #include "TextureCache.h"
 #include "URL.h"
+#include "threads/SingleLock.h"
 
 using namespace std;
 using namespace XFILE;
@@ -56,7 +58,7 @@ using namespace ADDON;
 namespace VIDEO
 {
 
-  CVideoInfoScanner::CVideoInfoScanner() : CThread("CVideoInfoScanner")
+  CVideoInfoScanner::CVideoInfoScanner() : CThread("CVideoInfoScanner"), m_lookupWorker(this)
   {
     m_bRunning = false;
     m_pObserver = NULL;
@@ -65,6 +67,8 @@ namespace VIDEO
     m_itemCount = 0;
     m_bClean = false;
     m_scanAll = false;
+    m_existsSaved = 0;
+    m_pinned = 0;
   }
 
   CVideoInfoScanner::~CVideoInfoScanner()
@@ -76,6 +80,7 @@ namespace VIDEO
     try
     {
       unsigned int tick = XbmcThreads::SystemClockMillis();
+      CRegExp::CacheStats regExpStats = CRegExp::GetCacheStats();
 
       m_database.Open();
 
@@ -89,6 +94,7 @@ namespace VIDEO
       // Reset progress vars
       m_currentItem = 0;
       m_itemCount = -1;
+      m_existsSaved = 0;
 
       SetPriority(GetMinPriority());
 
@@ -97,6 +103,9 @@ namespace VIDEO
       // result in unexpected behaviour.
       m_bCanInterrupt = false;
 
+      // resolve existing actors, genres, studios etc. from memory while scanning
+      m_database.PreloadCaches();
+
       bool bCancelled = false;
       while (!bCancelled && m_pathsToScan.size())
       {
@@ -113,6 +122,27 @@ namespace VIDEO
 
       if (!bCancelled)
       {
+        // fingerprint some of the files added before fingerprints were kept, so they can be followed if moved
+        vector<CStdString> files;
+        m_database.GetFilesWithoutFingerprint(files, 500);
+        set<CStdString> failedFolders;
+        for (vector<CStdString>::const_iterator i = files.begin(); i != files.end() && !m_bStop; ++i)
+        {
+          CStdString folder;
+          URIUtils::GetDirectory(*i, folder);
+          if (failedFolders.find(folder) != failedFolders.end())
+            continue;
+
+          // files that can never be fingerprinted are marked with an empty one so they aren't tried again.
+          // those that couldn't be read are left for the next scan, along with the rest of their folder.
+          CStdString fingerprint;
+          bool unsupported;
+          if (CFileUtils::GetFingerprint(*i, fingerprint, &unsupported) || unsupported)
+            m_database.SetFileFingerprint(*i, fingerprint);
+          else
+            failedFolders.insert(folder);
+        }
+
         if (m_bClean)
           CleanDatabase(m_pObserver,&m_pathsToClean);
         else
@@ -123,8 +153,11 @@ namespace VIDEO
         }
       }
 
+      m_database.EmptyCache();
       m_database.Close();
 
+      CRegExp::LogCacheStats(regExpStats, "VideoInfoScanner");
+      CLog::Log(LOGDEBUG, "VideoInfoScanner: %u checks for local files answered from folder listings", m_existsSaved);
       tick = XbmcThreads::SystemClockMillis() - tick;
       CLog::Log(LOGNOTICE, "VideoInfoScanner: Finished scan. Scanning for video info took %s", StringUtils::SecondsToTimeString(tick / 1000).c_str());
       ANNOUNCEMENT::CAnnouncementManager::Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanFinished");
@@ -193,12 +226,28 @@ namespace VIDEO
 
   bool CVideoInfoScanner::DoScan(const CStdString& strDirectory)
   {
-    if (m_pObserver)
+    vector<DirectoryToScan*> directories;
+    EnumerateDirectory(strDirectory, directories);
+
+    StartLookups(directories);
+    for (vector<DirectoryToScan*>::iterator i = directories.begin(); i != directories.end(); ++i)
     {
-      m_pObserver->OnDirectoryChanged(strDirectory);
-      m_pObserver->OnSetTitle(g_localizeStrings.Get(20415));
+      if (!m_bStop)
+        ScanDirectory(**i);
+      if ((*i)->pinned)
+      {
+        m_existsSaved += g_directoryCache.UnpinDirectory((*i)->path);
+        m_pinned--;
+      }
+      delete *i;
     }
+    StopLookups();
 
+    return !m_bStop;
+  }
+
+  void CVideoInfoScanner::EnumerateDirectory(const CStdString& strDirectory, vector<DirectoryToScan*> &directories)
+  {
     /*
      * Remove this path from the list we're processing. This must be done prior to
      * the check for file or folder exclusion to prevent an infinite while loop
@@ -208,11 +257,7 @@ namespace VIDEO
     if (it != m_pathsToScan.end())
       m_pathsToScan.erase(it);
 
-    // load subfolder
-    CFileItemList items;
     bool foundDirectly = false;
-    bool bSkip = false;
-
     SScanSettings settings;
     ScraperPtr info = m_database.GetScraperForPath(strDirectory, settings, foundDirectly);
     CONTENT_TYPE content = info ? info->Content() : CONTENT_NONE;
@@ -222,18 +267,24 @@ namespace VIDEO
                                                          : g_advancedSettings.m_moviesExcludeFromScanRegExps;
 
     if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
-      return true;
+      return;
 
     bool ignoreFolder = !m_scanAll && settings.noupdate;
     if (content == CONTENT_NONE || ignoreFolder)
-      return true;
-
-    CStdString hash, dbHash;
+      return;
+
+    DirectoryToScan *directory = new DirectoryToScan;
+    directory->path = strDirectory;
+    directory->settings = settings;
+    directory->content = content;
+    directories.push_back(directory);
+
+    CFileItemList &items = directory->items;
+    CStdString &hash = directory->hash;
+    CStdString &dbHash = directory->dbHash;
+    bool &bSkip = directory->skip;
     if (content == CONTENT_MOVIES ||content == CONTENT_MUSICVIDEOS)
     {
-      if (m_pObserver)
-        m_pObserver->OnStateChanged(content == CONTENT_MOVIES ? FETCHING_MOVIE_INFO : FETCHING_MUSICVIDEO_INFO);
-
       CStdString fastHash = GetFastHash(strDirectory);
       if (m_database.GetPathHash(strDirectory, dbHash) && !fastHash.IsEmpty() && fastHash == dbHash)
       { // fast hashes match - no need to process anything
@@ -264,8 +315,6 @@ namespace VIDEO
           else
             CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' due to no change", strDirectory.c_str());
           bSkip = true;
-          if (m_pObserver)
-            m_pObserver->OnDirectoryScanned(strDirectory);
         }
         // update the hash to a fast hash if needed
         if (CanFastHash(items) && !fastHash.IsEmpty())
@@ -274,9 +323,6 @@ namespace VIDEO
     }
     else if (content == CONTENT_TVSHOWS)
     {
-      if (m_pObserver)
-        m_pObserver->OnStateChanged(FETCHING_TVSHOW_INFO);
-
       if (foundDirectly && !settings.parent_name_root)
       {
         CDirectory::GetDirectory(strDirectory, items, g_settings.m_videoExtensions);
@@ -285,7 +331,7 @@ namespace VIDEO
         bSkip = true;
         if (!m_database.GetPathHash(strDirectory, dbHash) || dbHash != hash)
         {
-          m_database.SetPathHash(strDirectory, hash);
+          directory->setHashFirst = true;
           bSkip = false;
         }
         else
@@ -301,13 +347,58 @@ namespace VIDEO
       }
     }
 
-    if (!bSkip)
+    // keep the folder's full listing, just read, until it has been scanned, so the lookups and looking for
+    // local nfo files and art need no further trips to the filesystem. the number pinned is bounded to
+    // limit the memory held for a large tree; files in the folders after those go to the filesystem.
+    static const unsigned int max_pinned_dirs = 200;
+    if (!bSkip && m_pinned < max_pinned_dirs && g_directoryCache.PinDirectory(strDirectory))
+    {
+      directory->pinned = true;
+      m_pinned++;
+    }
+
+    for (int i = 0; i < items.Size(); ++i)
+    {
+      CFileItemPtr pItem = items[i];
+
+      if (m_bStop)
+        break;
+
+      // if we have a directory item (non-playlist) we then recurse into that folder
+      // do not recurse for tv shows - we have already looked recursively for episodes
+      if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList() && settings.recurse > 0 && content != CONTENT_TVSHOWS)
+        EnumerateDirectory(pItem->GetPath(), directories);
+    }
+
+    // unchanged folders don't need their items beyond this point
+    if (bSkip)
+      items.Clear();
+  }
+
+  void CVideoInfoScanner::ScanDirectory(DirectoryToScan &directory)
+  {
+    const CStdString &strDirectory = directory.path;
+    CONTENT_TYPE content = directory.content;
+    if (m_pObserver)
+    {
+      m_pObserver->OnDirectoryChanged(strDirectory);
+      m_pObserver->OnSetTitle(g_localizeStrings.Get(20415));
+      if (content == CONTENT_TVSHOWS)
+        m_pObserver->OnStateChanged(FETCHING_TVSHOW_INFO);
+      else
+        m_pObserver->OnStateChanged(content == CONTENT_MOVIES ? FETCHING_MOVIE_INFO : FETCHING_MUSICVIDEO_INFO);
+    }
+
+    if (directory.setHashFirst)
+      m_database.SetPathHash(strDirectory, directory.hash);
+
+    if (!directory.skip)
     {
-      if (RetrieveVideoInfo(items, settings.parent_name_root, content))
+      if (RetrieveVideoInfo(directory.items, directory.settings.parent_name_root, content))
       {
         if (!m_bStop && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
         {
-          m_database.SetPathHash(strDirectory, hash);
+          m_database.SetPathHash(strDirectory, directory.hash);
           m_pathsToClean.insert(m_database.GetPathId(strDirectory));
           CLog::Log(LOGDEBUG, "VideoInfoScanner: Finished adding information from dir %s", strDirectory.c_str());
         }
@@ -318,32 +409,148 @@ namespace VIDEO
         CLog::Log(LOGDEBUG, "VideoInfoScanner: No (new) information was found in dir %s", strDirectory.c_str());
       }
     }
-    else if (hash != dbHash && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
+    else if (directory.hash != directory.dbHash && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
     { // update the hash either way - we may have changed the hash to a fast version
-      m_database.SetPathHash(strDirectory, hash);
+      m_database.SetPathHash(strDirectory, directory.hash);
     }
 
     if (m_pObserver)
       m_pObserver->OnDirectoryScanned(strDirectory);
+  }
 
-    for (int i = 0; i < items.Size(); ++i)
+  void CVideoInfoScanner::StartLookups(const vector<DirectoryToScan*> &directories)
+  {
+    if (g_advancedSettings.m_iVideoScannerLookups <= 1)
+      return;
+
+    // queue a lookup for each movie and music video that RetrieveVideoInfo() would look up
+    for (vector<DirectoryToScan*>::const_iterator i = directories.begin(); i != directories.end(); ++i)
     {
-      CFileItemPtr pItem = items[i];
+      const DirectoryToScan &directory = **i;
+      if (directory.skip || (directory.content != CONTENT_MOVIES && directory.content != CONTENT_MUSICVIDEOS))
+        continue;
 
-      if (m_bStop)
-        break;
+      for (int j = 0; j < directory.items.Size(); ++j)
+      {
+        CFileItemPtr pItem = directory.items[j];
+        if (pItem->m_bIsFolder || !pItem->IsVideo() || pItem->IsNFO() ||
+           (pItem->IsPlayList() && !URIUtils::GetExtension(pItem->GetPath()).Equals(".strm")))
+          continue;
+        if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), g_advancedSettings.m_moviesExcludeFromScanRegExps))
+          continue;
 
-      // if we have a directory item (non-playlist) we then recurse into that folder
-      // do not recurse for tv shows - we have already looked recursively for episodes
-      if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList() && settings.recurse > 0 && content != CONTENT_TVSHOWS)
+        ScraperPtr scraper = m_database.GetScraperForPath(directory.items.GetPath());
+        if (!scraper)
+          continue;
+        if (scraper->Content() == CONTENT_MOVIES)
+        {
+          if (m_database.HasMovieInfo(pItem->GetPath()) || RelinkMovedFile(*pItem, "movie"))
+            continue;
+        }
+        else if (scraper->Content() == CONTENT_MUSICVIDEOS)
+        {
+          if (m_database.HasMusicVideoInfo(pItem->GetPath()) || RelinkMovedFile(*pItem, "musicvideo"))
+            continue;
+        }
+        else
+          continue;
+
+        // clear our scraper cache before we start filling it
+        if (m_lookupScrapers.insert(scraper->ID()).second)
+          scraper->ClearCache();
+
+        VideoLookup *lookup = new VideoLookup;
+        lookup->item = pItem;
+        lookup->scraper = scraper;
+        lookup->bDirNames = directory.settings.parent_name_root;
+        m_lookups.push_back(lookup);
+        m_lookupItems[pItem.get()] = lookup;
+      }
+    }
+
+    if (m_lookups.empty())
+      return;
+
+    unsigned int threads = min(m_lookups.size(), (size_t)g_advancedSettings.m_iVideoScannerLookups);
+    CLog::Log(LOGDEBUG, "VideoInfoScanner: Looking up %u items on %u threads", (unsigned int)m_lookups.size(), threads);
+    for (unsigned int i = 0; i < threads; i++)
+    {
+      CThread *thread = new CThread(&m_lookupWorker, "CVideoInfoScanner");
+      thread->Create();
+      thread->SetPriority(thread->GetMinPriority());
+      m_lookupThreads.push_back(thread);
+    }
+  }
+
+  void CVideoInfoScanner::StopLookups()
+  {
+    {
+      // stop handing out lookups, and let those running finish
+      CSingleLock lock(m_lookupSection);
+      for (vector<VideoLookup*>::iterator i = m_lookups.begin(); i != m_lookups.end(); ++i)
+        (*i)->started = true;
+    }
+    for (vector<CThread*>::iterator i = m_lookupThreads.begin(); i != m_lookupThreads.end(); ++i)
+    {
+      (*i)->StopThread();
+      delete *i;
+    }
+    m_lookupThreads.clear();
+
+    for (vector<VideoLookup*>::iterator i = m_lookups.begin(); i != m_lookups.end(); ++i)
+      delete *i;
+    m_lookups.clear();
+    m_lookupItems.clear();
+    m_lookupsRunning.clear();
+    m_lookupScrapers.clear();
+  }
+
+  // This function is run by the lookup threads
+  void CVideoInfoScanner::LookupVideos()
+  {
+    CNfoFile nfoReader;
+    while (!m_bStop)
+    {
+      // take the first lookup not yet started whose scraper isn't at its limit
+      VideoLookup *lookup = NULL;
+      bool remaining = false;
       {
-        if (!DoScan(pItem->GetPath()))
+        CSingleLock lock(m_lookupSection);
+        for (vector<VideoLookup*>::iterator i = m_lookups.begin(); i != m_lookups.end(); ++i)
         {
-          m_bStop = true;
+          if ((*i)->started)
+            continue;
+          remaining = true;
+          int &running = m_lookupsRunning[(*i)->scraper->ID()];
+          if ((*i)->scraper->MaxLookups() > 0 && running >= (*i)->scraper->MaxLookups())
+            continue;
+          lookup = *i;
+          lookup->started = true;
+          running++;
+          break;
         }
       }
+      if (!remaining)
+        break;
+      if (!lookup)
+      {
+        m_lookupEvent.WaitMSec(100);
+        continue;
+      }
+
+      // the scraper may be replaced by the one in a .nfo file
+      CStdString scraperID = lookup->scraper->ID();
+      nfoReader.Close();
+      INFO_RET result = LookupVideo(lookup->item.get(), lookup->bDirNames, lookup->scraper, true, NULL, nfoReader, NULL);
+
+      {
+        CSingleLock lock(m_lookupSection);
+        lookup->result = result;
+        lookup->done = true;
+        m_lookupsRunning[scraperID]--;
+      }
+      m_lookupEvent.Set();
     }
-    return !m_bStop;
   }
 
   bool CVideoInfoScanner::RetrieveVideoInfo(CFileItemList& items, bool bDirNames, CONTENT_TYPE content, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress)
@@ -391,11 +598,15 @@ namespace VIDEO
 
       }
 
-      // clear our scraper cache
-      info2->ClearCache();
+      // clear our scraper cache, unless lookups running in the background are filling it
+      if (m_lookupScrapers.find(info2->ID()) == m_lookupScrapers.end())
+        info2->ClearCache();
 
       INFO_RET ret = INFO_CANCELLED;
-      if (info2->Content() == CONTENT_TVSHOWS)
+      map<const CFileItem*, VideoLookup*>::iterator lookup = m_lookupItems.find(pItem.get());
+      if (lookup != m_lookupItems.end())
+        ret = AddLookedUpVideo(*lookup->second, useLocal);
+      else if (info2->Content() == CONTENT_TVSHOWS)
         ret = RetrieveInfoForTvShow(pItem, bDirNames, info2, useLocal, pURL, fetchEpisodes, pDlgProgress);
       else if (info2->Content() == CONTENT_MOVIES)
         ret = RetrieveInfoForMovie(pItem, bDirNames, info2, useLocal, pURL, pDlgProgress);
@@ -525,41 +736,16 @@ namespace VIDEO
     if (ProgressCancelled(pDlgProgress, 198, pItem->GetLabel()))
       return INFO_CANCELLED;
 
-    if (m_database.HasMovieInfo(pItem->GetPath()))
+    if (m_database.HasMovieInfo(pItem->GetPath()) || RelinkMovedFile(*pItem, "movie"))
       return INFO_HAVE_ALREADY;
 
-    CNfoFile::NFOResult result=CNfoFile::NO_NFO;
-    CScraperUrl scrUrl;
-    // handle .nfo files
-    if (useLocal)
-      result = CheckForNFOFile(pItem.get(), bDirNames, info2, scrUrl);
-    if (result == CNfoFile::FULL_NFO)
-    {
-      pItem->GetVideoInfoTag()->Reset();
-      m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
-
-      if (AddVideo(pItem.get(), info2->Content(), bDirNames, true) < 0)
-        return INFO_ERROR;
-      return INFO_ADDED;
-    }
-    if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
-      pURL = &scrUrl;
-
-    CScraperUrl url;
-    int retVal = 0;
-    if (pURL)
-      url = *pURL;
-    else if ((retVal = FindVideo(pItem->GetMovieName(bDirNames), info2, url, pDlgProgress)) <= 0)
-      return retVal < 0 ? INFO_CANCELLED : INFO_NOT_FOUND;
+    INFO_RET ret = LookupVideo(pItem.get(), bDirNames, info2, useLocal, pURL, m_nfoReader, pDlgProgress);
+    if (ret != INFO_ADDED)
+      return ret;
 
-    if (GetDetails(pItem.get(), url, info2, result == CNfoFile::COMBINED_NFO ? &m_nfoReader : NULL, pDlgProgress))
-    {
-      if (AddVideo(pItem.get(), info2->Content(), bDirNames, useLocal) < 0)
-        return INFO_ERROR;
-      return INFO_ADDED;
-    }
-    // TODO: This is not strictly correct as we could fail to download information here or error, or be cancelled
-    return INFO_NOT_FOUND;
+    if (AddVideo(pItem.get(), info2->Content(), bDirNames, useLocal) < 0)
+      return INFO_ERROR;
+    return INFO_ADDED;
   }
 
   INFO_RET CVideoInfoScanner::RetrieveInfoForMusicVideo(CFileItemPtr pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress)
@@ -571,21 +757,41 @@ namespace VIDEO
     if (ProgressCancelled(pDlgProgress, 20394, pItem->GetLabel()))
       return INFO_CANCELLED;
 
-    if (m_database.HasMusicVideoInfo(pItem->GetPath()))
+    if (m_database.HasMusicVideoInfo(pItem->GetPath()) || RelinkMovedFile(*pItem, "musicvideo"))
       return INFO_HAVE_ALREADY;
 
+    INFO_RET ret = LookupVideo(pItem.get(), bDirNames, info2, useLocal, pURL, m_nfoReader, pDlgProgress);
+    if (ret != INFO_ADDED)
+      return ret;
+
+    if (AddVideo(pItem.get(), info2->Content(), bDirNames, useLocal) < 0)
+      return INFO_ERROR;
+    return INFO_ADDED;
+  }
+
+  bool CVideoInfoScanner::RelinkMovedFile(CFileItem &item, const CStdString &type, int idShow /* = -1 */)
+  {
+    CStdString fingerprint = item.GetProperty("fingerprint").asString();
+    if (fingerprint.IsEmpty())
+    {
+      if (!CFileUtils::GetFingerprint(item.GetPath(), fingerprint))
+        return false;
+      item.SetProperty("fingerprint", fingerprint);
+    }
+    return m_database.RelinkMovedFile(item.GetPath(), fingerprint, type, idShow);
+  }
+
+  INFO_RET CVideoInfoScanner::LookupVideo(CFileItem *pItem, bool bDirNames, ScraperPtr &info2, bool useLocal, CScraperUrl* pURL, CNfoFile &nfoReader, CGUIDialogProgress* pDlgProgress)
+  {
     CNfoFile::NFOResult result=CNfoFile::NO_NFO;
     CScraperUrl scrUrl;
     // handle .nfo files
     if (useLocal)
-      result = CheckForNFOFile(pItem.get(), bDirNames, info2, scrUrl);
+      result = CheckForNFOFile(pItem, bDirNames, info2, scrUrl, nfoReader);
     if (result == CNfoFile::FULL_NFO)
     {
       pItem->GetVideoInfoTag()->Reset();
-      m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
-
-      if (AddVideo(pItem.get(), info2->Content(), bDirNames, true) < 0)
-        return INFO_ERROR;
+      nfoReader.GetDetails(*pItem->GetVideoInfoTag());
       return INFO_ADDED;
     }
     if (result == CNfoFile::URL_NFO || result == CNfoFile::COMBINED_NFO)
@@ -598,16 +804,36 @@ namespace VIDEO
     else if ((retVal = FindVideo(pItem->GetMovieName(bDirNames), info2, url, pDlgProgress)) <= 0)
       return retVal < 0 ? INFO_CANCELLED : INFO_NOT_FOUND;
 
-    if (GetDetails(pItem.get(), url, info2, result == CNfoFile::COMBINED_NFO ? &m_nfoReader : NULL, pDlgProgress))
-    {
-      if (AddVideo(pItem.get(), info2->Content(), bDirNames, useLocal) < 0)
-        return INFO_ERROR;
+    if (GetDetails(pItem, url, info2, result == CNfoFile::COMBINED_NFO ? &nfoReader : NULL, pDlgProgress))
       return INFO_ADDED;
-    }
+
     // TODO: This is not strictly correct as we could fail to download information here or error, or be cancelled
     return INFO_NOT_FOUND;
   }
 
+  INFO_RET CVideoInfoScanner::AddLookedUpVideo(VideoLookup &lookup, bool useLocal)
+  {
+    // wait for the lookup threads to get to it
+    while (true)
+    {
+      {
+        CSingleLock lock(m_lookupSection);
+        if (lookup.done)
+          break;
+      }
+      if (m_bStop)
+        return INFO_CANCELLED;
+      m_lookupEvent.WaitMSec(100);
+    }
+
+    if (lookup.result != INFO_ADDED)
+      return lookup.result;
+
+    if (AddVideo(lookup.item.get(), lookup.scraper->Content(), lookup.bDirNames, useLocal) < 0)
+      return INFO_ERROR;
+    return INFO_ADDED;
+  }
+
   INFO_RET CVideoInfoScanner::RetrieveInfoForEpisodes(CFileItemPtr item, long showID, const ADDON::ScraperPtr &scraper, bool useLocal, CGUIDialogProgress *progress)
   {
     // enumerate episodes
@@ -1044,6 +1270,18 @@ namespace VIDEO
     if (m_pObserver)
       m_pObserver->OnSetTitle(strTitle);
 
+    // remember what the file holds, so its entry can be moved with it if it is moved or renamed
+    // one that can't be read now is left for the backfill at the end of a scan to try again
+    CStdString fingerprint;
+    bool storeFingerprint = !pItem->m_bIsFolder;
+    if (storeFingerprint)
+    {
+      fingerprint = pItem->GetProperty("fingerprint").asString();
+      bool unsupported;
+      if (fingerprint.IsEmpty() && !CFileUtils::GetFingerprint(pItem->GetPath(), fingerprint, &unsupported))
+        storeFingerprint = unsupported;
+    }
+
     CLog::Log(LOGDEBUG, "VideoInfoScanner: Adding new item to %s:%s", TranslateContent(content).c_str(), pItem->GetPath().c_str());
     long lResult = -1;
 
@@ -1102,6 +1340,9 @@ namespace VIDEO
       movieDetails.m_iDbId = lResult;
     }
 
+    if (lResult > -1 && storeFingerprint)
+      m_database.SetFileFingerprint(pItem->GetPath(), fingerprint);
+
     if (g_advancedSettings.m_bVideoLibraryImportWatchedState || libraryImport)
       m_database.SetPlayCount(*pItem, movieDetails.m_playCount, movieDetails.m_lastPlayed);
 
@@ -1225,16 +1466,17 @@ namespace VIDEO
       if ((pDlgProgress && pDlgProgress->IsCanceled()) || m_bStop)
         return INFO_CANCELLED;
 
-      if (m_database.GetEpisodeId(file->strPath, file->iEpisode, file->iSeason) > -1)
+      CFileItem item;
+      item.SetPath(file->strPath);
+
+      if (m_database.GetEpisodeId(file->strPath, file->iEpisode, file->iSeason) > -1 ||
+         (RelinkMovedFile(item, "episode", idShow) && m_database.GetEpisodeId(file->strPath, file->iEpisode, file->iSeason) > -1))
       {
         if (m_pObserver)
           m_pObserver->OnSetTitle(g_localizeStrings.Get(20415));
         continue;
       }
 
-      CFileItem item;
-      item.SetPath(file->strPath);
-
       // handle .nfo files
       CNfoFile::NFOResult result=CNfoFile::NO_NFO;
       CScraperUrl scrUrl;
@@ -1461,7 +1703,8 @@ namespace VIDEO
       CStdString strPath = item->GetPath();
       if (!item->m_bIsFolder)
         URIUtils::GetDirectory(item->GetPath(), strPath);
-      if (dir.GetDirectory(strPath, items, ".nfo") && items.Size())
+      // while scanning, the folder's listing is usually cached (and pinned) already
+      if (dir.GetDirectory(strPath, items, ".nfo", m_bRunning ? DIR_FLAG_READ_CACHE : DIR_FLAG_DEFAULTS) && items.Size())
       {
         int numNFO = -1;
         for (int i = 0; i < items.Size(); i++)
@@ -1624,6 +1867,11 @@ namespace VIDEO
   }
 
   CNfoFile::NFOResult CVideoInfoScanner::CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ScraperPtr& info, CScraperUrl& scrUrl)
+  {
+    return CheckForNFOFile(pItem, bGrabAny, info, scrUrl, m_nfoReader);
+  }
+
+  CNfoFile::NFOResult CVideoInfoScanner::CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ScraperPtr& info, CScraperUrl& scrUrl, CNfoFile& nfoReader)
   {
     CStdString strNfoFile;
     if (info->Content() == CONTENT_MOVIES || info->Content() == CONTENT_MUSICVIDEOS
@@ -1635,7 +1883,7 @@ namespace VIDEO
     CNfoFile::NFOResult result=CNfoFile::NO_NFO;
     if (!strNfoFile.IsEmpty() && CFile::Exists(strNfoFile))
     {
-      result = m_nfoReader.Create(strNfoFile,info,pItem->GetVideoInfoTag()->m_iEpisode);
+      result = nfoReader.Create(strNfoFile,info,pItem->GetVideoInfoTag()->m_iEpisode);
 
       CStdString type;
       switch(result)
@@ -1660,18 +1908,18 @@ namespace VIDEO
       if (result == CNfoFile::FULL_NFO)
       {
         if (info->Content() == CONTENT_TVSHOWS)
-          info = m_nfoReader.GetScraperInfo();
+          info = nfoReader.GetScraperInfo();
       }
       else if (result != CNfoFile::NO_NFO && result != CNfoFile::ERROR_NFO)
       {
-        scrUrl = m_nfoReader.ScraperUrl();
-        info = m_nfoReader.GetScraperInfo();
+        scrUrl = nfoReader.ScraperUrl();
+        info = nfoReader.GetScraperInfo();
 
         CLog::Log(LOGDEBUG, "VideoInfoScanner: Fetching url '%s' using %s scraper (content: '%s')",
           scrUrl.m_url[0].m_url.c_str(), info->Name().c_str(), TranslateContent(info->Content()).c_str());
 
         if (result == CNfoFile::COMBINED_NFO)
-          m_nfoReader.GetDetails(*pItem->GetVideoInfoTag());
+          nfoReader.GetDetails(*pItem->GetVideoInfoTag());
       }
     }
     else
@@ -1711,7 +1959,13 @@ namespace VIDEO
     MOVIELIST movielist;
     CVideoInfoDownloader imdb(scraper);
     int returncode = imdb.FindMovie(videoName, movielist, progress);
-    if (returncode < 0 || (returncode == 0 && !DownloadFailed(progress)))
+    if (returncode == 0)
+    { // ask just once when lookups running together fail
+      CSingleLock lock(m_errorSection);
+      if (m_bStop || !DownloadFailed(progress))
+        returncode = -1;
+    }
+    if (returncode < 0)
     { // scraper reported an error, or we had an error and user wants to cancel the scan
       m_bStop = true;
       return -1; // cancelled
@@ -20,6 +20,8 @@
  *
  */
 #include "threads/Thread.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "VideoDatabase.h"
 #include "addons/Scraper.h"
 #include "NfoFile.h"
@@ -117,6 +119,7 @@ namespace VIDEO
     static void ApplyThumbToFolder(const CStdString &folder, const CStdString &imdbThumb);
     static bool DownloadFailed(CGUIDialogProgress* pDlgProgress);
     CNfoFile::NFOResult CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ADDON::ScraperPtr& scraper, CScraperUrl& scrUrl);
+    CNfoFile::NFOResult CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ADDON::ScraperPtr& scraper, CScraperUrl& scrUrl, CNfoFile& nfoReader);
 
     /*! \brief Retrieve any artwork associated with an item
      \param pItem item to find artwork for.
@@ -136,13 +139,80 @@ namespace VIDEO
 
   protected:
     virtual void Process();
+
+    /*! \brief Scan a folder and its subfolders.
+     The folders are enumerated and hashed first, then the movies and music videos in the
+     changed folders are looked up on a pool of threads while the folders are added to the
+     database in order, as their lookups complete.
+     \return false if the scan was cancelled.
+     */
     bool DoScan(const CStdString& strDirectory);
 
+    struct DirectoryToScan
+    {
+      DirectoryToScan() : content(CONTENT_NONE), skip(false), setHashFirst(false), pinned(false) {};
+      CStdString path;
+      SScanSettings settings;
+      CONTENT_TYPE content;
+      CFileItemList items;
+      CStdString hash;
+      CStdString dbHash;
+      bool skip;          ///< whether the directory is unchanged
+      bool setHashFirst;  ///< whether the hash is saved before the directory is scanned (tvshows)
+      bool pinned;        ///< whether the listing is pinned in the directory cache from enumeration until the directory is scanned, for finding local nfo files and art
+    };
+
+    void EnumerateDirectory(const CStdString& strDirectory, std::vector<DirectoryToScan*> &directories);
+    void ScanDirectory(DirectoryToScan &directory);
+
+    /*! \brief Details looked up for a movie or music video on a lookup thread
+     */
+    struct VideoLookup
+    {
+      VideoLookup() : bDirNames(false), result(INFO_CANCELLED), started(false), done(false) {};
+      CFileItemPtr item;
+      ADDON::ScraperPtr scraper;
+      bool bDirNames;
+      INFO_RET result;
+      bool started;
+      bool done;
+    };
+
+    class CLookupWorker : public IRunnable
+    {
+    public:
+      CLookupWorker(CVideoInfoScanner *scanner) : m_scanner(scanner) {};
+      virtual void Run() { m_scanner->LookupVideos(); };
+    private:
+      CVideoInfoScanner *m_scanner;
+    };
+    friend class CLookupWorker;
+
+    void StartLookups(const std::vector<DirectoryToScan*> &directories);
+    void StopLookups();
+    void LookupVideos();
+    INFO_RET AddLookedUpVideo(VideoLookup &lookup, bool useLocal);
+
+    /*! \brief Find the details for a movie or music video, from its .nfo file and/or online.
+     Safe to run on a lookup thread, as it doesn't touch the database.
+     \return INFO_ADDED if the details were put in the item's video info tag, ready to add to the
+     database, INFO_NOT_FOUND if none were found, or INFO_CANCELLED.
+     */
+    INFO_RET LookupVideo(CFileItem *pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CNfoFile &nfoReader, CGUIDialogProgress* pDlgProgress);
+
     INFO_RET RetrieveInfoForTvShow(CFileItemPtr pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, bool fetchEpisodes, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForMovie(CFileItemPtr pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForMusicVideo(CFileItemPtr pItem, bool bDirNames, ADDON::ScraperPtr &scraper, bool useLocal, CScraperUrl* pURL, CGUIDialogProgress* pDlgProgress);
     INFO_RET RetrieveInfoForEpisodes(CFileItemPtr item, long showID, const ADDON::ScraperPtr &scraper, bool useLocal, CGUIDialogProgress *progress = NULL);
 
+    /*! \brief Move the library entry of a file that was moved or renamed to it, found by its fingerprint.
+     The fingerprint is kept in the item's "fingerprint" property for AddVideo().
+     \param type the type of entry to look for - "movie", "episode" or "musicvideo".
+     \param idShow the show an episode must belong to, or -1 for any.
+     \return true if the file now has an entry in the library.
+     */
+    bool RelinkMovedFile(CFileItem &item, const CStdString &type, int idShow = -1);
+
     /*! \brief Update the progress bar with the heading and line and check for cancellation
      \param progress CGUIDialogProgress bar
      \param heading string id of heading
@@ -252,6 +322,18 @@ namespace VIDEO
     std::set<CStdString> m_pathsToCount;
     std::set<int> m_pathsToClean;
     CNfoFile m_nfoReader;
+    unsigned int m_existsSaved; ///< file existence checks answered from pinned directory listings
+    unsigned int m_pinned;      ///< directory listings pinned by EnumerateDirectory() and not yet scanned
+
+    std::vector<VideoLookup*> m_lookups;                    ///< lookups in the order they are added to the database
+    std::map<const CFileItem*, VideoLookup*> m_lookupItems; ///< the lookup for each item
+    std::map<CStdString, int> m_lookupsRunning;             ///< lookups running against each scraper
+    std::set<CStdString> m_lookupScrapers;                  ///< scrapers with lookups queued
+    std::vector<CThread*> m_lookupThreads;
+    CLookupWorker m_lookupWorker;
+    CCriticalSection m_lookupSection;
+    CEvent m_lookupEvent; ///< set when a lookup completes
+    CCriticalSection m_errorSection;
   };
 }
 
@@ -546,7 +546,7 @@ void CGUIWindowVideoNav::DoSearch(const CStdString& strSearch, CFileItemList& it
   m_database.GetEpisodesByName(strSearch, tempItems);
   AppendAndClearSearchItems(tempItems, "[" + g_localizeStrings.Get(20359) + "] ", items);
 
-  m_database.GetTvShowsByName(strSearch, tempItems);
+  m_database.GetTvShowsByName(strSearch, tempItems, true);
   AppendAndClearSearchItems(tempItems, "[" + g_localizeStrings.Get(20364) + "] ", items);
 
   m_database.GetMusicVideosByName(strSearch, tempItems);